@@ -4,10 +4,14 @@ set -e # fail script if any individual commands fail
 
 function build_and_run() {
   cmake -E make_directory "$1"
-  cmake -E chdir "$1" cmake -DCMAKE_BUILD_TYPE="$2" -DGRPCW_BUILD_TESTS=ON -DGRPCW_USE_DEV_FLAGS=ON ..
+  cmake -E chdir "$1" cmake -DCMAKE_BUILD_TYPE="$2" -DGRPCW_BUILD_TESTS=ON -DGRPCW_USE_DEV_FLAGS=ON "${@:3}" ..
   cmake -E chdir "$1" cmake --build . --parallel
 }
 
 build_and_run cmake-build-debug Debug
 cmake -E chdir cmake-build-debug cmake --build . --target test_grpc_wrapper_coverage --parallel
 build_and_run cmake-build-release Release
+
+# The coroutine server only exists in C++20 builds
+build_and_run cmake-build-coroutines Debug -DLTB_BUILD_TESTS=ON -DLTB_GRPCW_ENABLE_COROUTINES=ON
+cmake -E chdir cmake-build-coroutines ctest --output-on-failure
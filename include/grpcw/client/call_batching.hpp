@@ -0,0 +1,45 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// standard
+#include <chrono>
+#include <cstddef>
+
+namespace grpcw {
+namespace client {
+
+///
+/// \brief Settings for sending many small unary calls to the server as one batch rpc.
+///
+/// A batch is sent once 'max_batch_size' calls are waiting or 'max_delay' has passed since
+/// the first one was made, whichever happens first. A zero 'max_delay' sends every call right
+/// away (in a batch of one).
+///
+struct CallBatching {
+    std::size_t max_batch_size = 64;
+    std::chrono::microseconds max_delay = std::chrono::milliseconds(1);
+};
+
+} // namespace client
+} // namespace grpcw
@@ -0,0 +1,78 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// grpcw
+#include "grpcw/util/latency_histogram.hpp"
+
+// third-party
+#include <grpc++/support/status_code_enum.h>
+
+// standard
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace grpcw {
+namespace client {
+
+/**
+ * @brief What a client measured for the calls of one method
+ *
+ * Latencies are in microseconds and measured from the start of a call. For unary calls the first
+ * message is the response, for streams it is the first message read from the server.
+ */
+struct MethodMetrics {
+    /// Latencies up to a day are kept with two significant digits
+    static constexpr std::uint64_t highest_latency_us = 86'400'000'000u;
+    static constexpr int latency_digits = 2;
+
+    std::string method; ///< "/package.Service/method"
+    std::uint64_t calls_started = 0u;
+    std::int64_t calls_in_flight = 0;
+    std::map<grpc::StatusCode, std::uint64_t> calls_finished; ///< By status code
+    util::LatencyHistogram first_message_latency{highest_latency_us, latency_digits};
+    util::LatencyHistogram total_latency{highest_latency_us, latency_digits}; ///< Until the call's status
+};
+
+///
+/// \brief Write 'metrics' in the Prometheus text exposition format.
+///
+/// Every method is labelled with method="/package.Service/method" and finished calls with their
+/// status code as well. Latencies are written as histograms in seconds whose '_sum' is estimated
+/// from the recorded values.
+///
+void write_prometheus_metrics(std::ostream& os, const std::vector<MethodMetrics>& metrics);
+
+///
+/// \brief Replace the file at 'path' with 'metrics' in the Prometheus text format.
+///
+/// The file is written next to 'path' and renamed so readers (like node_exporter's textfile
+/// collector) never see half a file. Throws std::runtime_error if it can't be written.
+///
+void write_prometheus_metrics_file(const std::string& path, const std::vector<MethodMetrics>& metrics);
+
+} // namespace client
+} // namespace grpcw
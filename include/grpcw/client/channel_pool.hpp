@@ -0,0 +1,57 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// standard
+#include <chrono>
+
+namespace grpcw {
+namespace client {
+
+/// \brief How calls are spread over the channels of a pool
+enum class ChannelSelection {
+    round_robin, ///< Each call uses the next channel in turn
+    least_loaded, ///< Each call uses the channel with the fewest calls in flight
+    power_of_two_choices, ///< The better of two random channels, scored by calls in flight and average latency
+};
+
+/**
+ * @brief Open several channels so calls are not limited to a single connection or server
+ *
+ * Each channel gets its own subchannels (and so its own HTTP/2 connection) which avoids the
+ * per-connection limit on concurrent streams and spreads the socket work over more threads.
+ * 'size' channels are opened to every address given to the client.
+ *
+ * Calls only go to channels that are connected. A channel whose calls fail with UNAVAILABLE,
+ * DEADLINE_EXCEEDED or RESOURCE_EXHAUSTED 'failures_before_ejection' times in a row is skipped
+ * for 'ejection_time' unless every connected channel has been ejected.
+ */
+struct ChannelPool {
+    int size = 1; ///< The number of channels to open per address
+    ChannelSelection selection = ChannelSelection::round_robin;
+    int failures_before_ejection = 5; ///< Zero never ejects channels
+    std::chrono::milliseconds ejection_time = std::chrono::seconds(10);
+};
+
+} // namespace client
+} // namespace grpcw
@@ -0,0 +1,79 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// standard
+#include <chrono>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace grpcw {
+namespace client {
+
+enum class CircuitState {
+    closed, ///< Calls are sent
+    open, ///< Calls fail right away with UNAVAILABLE
+    half_open, ///< A few trial calls are sent to find out if the server recovered
+};
+
+inline std::string to_string(const CircuitState& state) {
+    switch (state) {
+    case CircuitState::closed:
+        return "closed";
+    case CircuitState::open:
+        return "open";
+    case CircuitState::half_open:
+        return "half_open";
+    }
+    throw std::invalid_argument("Invalid CircuitState");
+}
+
+inline ::std::ostream& operator<<(::std::ostream& os, const CircuitState& state) {
+    return os << to_string(state);
+}
+
+/**
+ * @brief When a client stops sending unary calls to a failing server
+ *
+ * Every method has a circuit per server address. The outcomes of the calls made over the last
+ * 'window' are kept and once there are at least 'minimum_calls' of them the circuit opens if
+ * 'failure_rate' of them failed (UNAVAILABLE, DEADLINE_EXCEEDED or RESOURCE_EXHAUSTED) or
+ * 'slow_call_rate' of them took 'slow_call_duration' or longer.
+ *
+ * An open circuit fails calls right away with UNAVAILABLE. After 'open_time' it lets
+ * 'half_open_calls' trial calls through: it closes again if they all succeed in time and opens
+ * for another 'open_time' as soon as one of them doesn't.
+ */
+struct CircuitBreaking {
+    std::chrono::milliseconds window = std::chrono::seconds(10);
+    int minimum_calls = 20;
+    double failure_rate = 0.5;
+    std::chrono::milliseconds slow_call_duration = std::chrono::milliseconds(0); ///< Zero never counts calls as slow
+    double slow_call_rate = 1.0;
+    std::chrono::milliseconds open_time = std::chrono::seconds(5);
+    int half_open_calls = 3;
+};
+
+} // namespace client
+} // namespace grpcw
@@ -0,0 +1,189 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// grpcw
+#include "grpcw/util/atomic_data.hpp"
+
+// third-party
+#include <grpc++/alarm.h>
+#include <grpc++/client_context.h>
+#include <grpc++/completion_queue.h>
+#include <grpc++/support/async_unary_call.h>
+
+// standard
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace grpcw {
+namespace client {
+namespace detail {
+
+/**
+ * @brief A call (or timer) started on one of the 'AsyncCallQueues'. Its address is the completion queue tag.
+ */
+class AsyncCall {
+public:
+    virtual ~AsyncCall() = 0;
+
+    ///
+    /// \brief Invoked on a queue thread when the call's operation completes.
+    ///
+    /// The call is finished, and deleted, unless it starts another operation with 'AsyncCallQueues::resume'.
+    ///
+    virtual void on_complete(bool call_ok) = 0;
+
+    /// \brief Make the call complete as soon as possible (safe to call from any thread until it completes)
+    virtual void cancel() = 0;
+
+private:
+    friend class AsyncCallQueues;
+
+    std::size_t queue_index_ = 0u;
+    bool resumed_ = false; ///< Only used on the queue's thread
+};
+
+/**
+ * @brief An asynchronous unary call that hands its result to a callback
+ */
+template <typename Response>
+class UnaryAsyncCall : public AsyncCall {
+public:
+    using OnDone = std::function<void(grpc::Status, Response)>;
+
+    explicit UnaryAsyncCall(OnDone on_done);
+    ~UnaryAsyncCall() override = default;
+
+    void on_complete(bool call_ok) override;
+    void cancel() override;
+
+    grpc::ClientContext context;
+    std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> reader;
+    Response response;
+    grpc::Status status;
+
+private:
+    OnDone on_done_;
+};
+
+/**
+ * @brief A timer that invokes a callback when it fires ('fired' is false if it was cancelled first)
+ */
+class AsyncAlarm : public AsyncCall {
+public:
+    using OnFire = std::function<void(bool fired)>;
+
+    explicit AsyncAlarm(OnFire on_fire);
+    ~AsyncAlarm() override = default;
+
+    void on_complete(bool call_ok) override;
+    void cancel() override;
+
+    grpc::Alarm alarm;
+
+private:
+    OnFire on_fire_;
+};
+
+/**
+ * @brief Completion queues for a client's asynchronous calls, each drained by its own thread
+ *
+ * Calls are spread across the queues round-robin so no lock is shared between all the calls.
+ */
+class AsyncCallQueues {
+public:
+    /// \brief Throws std::invalid_argument if 'thread_count' is less than one
+    explicit AsyncCallQueues(int thread_count);
+
+    /// \brief Cancels the calls that are still in flight and waits for all of their callbacks
+    ~AsyncCallQueues();
+
+    ///
+    /// \brief Track 'call' until it completes and start it on one of the queues with 'start_call'.
+    ///
+    /// Returns false, without invoking 'start_call', once the queues are being destroyed. The caller
+    /// still owns 'call' in that case. Otherwise the queue owns it and deletes it after 'on_complete'.
+    ///
+    bool start(AsyncCall* call, const std::function<void(grpc::CompletionQueue*)>& start_call);
+
+    ///
+    /// \brief Same as 'start' but always on the queue at 'queue_index' (see 'next_queue_index').
+    ///
+    /// Calls started with the same index complete on the same thread, one callback at a time.
+    ///
+    bool start(AsyncCall* call,
+               std::size_t queue_index,
+               const std::function<void(grpc::CompletionQueue*)>& start_call);
+
+    /// \brief The queue the next call goes to when the round-robin order is used
+    std::size_t next_queue_index();
+
+    ///
+    /// \brief Start the next operation of a call (a stream read for example) from the call's 'on_complete'.
+    ///
+    /// 'start_operation' must use the call as its tag. Returns false, without invoking 'start_operation',
+    /// once the queues are being destroyed. The call is then finished when 'on_complete' returns.
+    ///
+    bool resume(AsyncCall* call, const std::function<void()>& start_operation);
+
+private:
+    struct InFlight {
+        std::unordered_set<AsyncCall*> calls;
+        bool stopping = false; ///< No more calls can be started
+    };
+
+    struct Queue {
+        grpc::CompletionQueue queue;
+        util::AtomicData<InFlight> in_flight;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::atomic<std::size_t> next_queue_{0u};
+
+    static void run(Queue* queue);
+};
+
+template <typename Response>
+UnaryAsyncCall<Response>::UnaryAsyncCall(OnDone on_done) : on_done_(std::move(on_done)) {}
+
+template <typename Response>
+void UnaryAsyncCall<Response>::on_complete(bool /*call_ok*/) {
+    // 'Finish' always completes with 'call_ok' set to true and reports failures through 'status'
+    if (on_done_) {
+        on_done_(std::move(status), std::move(response));
+    }
+}
+
+template <typename Response>
+void UnaryAsyncCall<Response>::cancel() {
+    context.TryCancel();
+}
+
+} // namespace detail
+} // namespace client
+} // namespace grpcw
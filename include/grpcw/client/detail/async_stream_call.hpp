@@ -0,0 +1,175 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// grpcw
+#include "grpcw/client/detail/async_call_queues.hpp"
+#include "grpcw/client/detail/update_batcher.hpp"
+#include "grpcw/util/atomic_data.hpp"
+#include "grpcw/util/delta_encoding.hpp"
+
+// third-party
+#include <grpc++/client_context.h>
+#include <grpc++/support/async_stream.h>
+
+// standard
+#include <functional>
+#include <memory>
+
+namespace grpcw {
+namespace client {
+namespace detail {
+
+/**
+ * @brief What a client stream shares with the calls that read it
+ */
+template <typename Return>
+struct AsyncStreamState {
+    std::function<void(Return&&)> on_update;
+    std::function<void(const grpc::Status&)> on_finish;
+    std::shared_ptr<UpdateBatcher<Return>> batcher = nullptr; ///< Replaces 'on_update', only read when a call is made
+    bool delta_decoding = false; ///< Only read when a call is created
+
+    ///
+    /// Every call of the stream runs on this queue. When the stream restarts, the old call's last
+    /// callbacks (its 'on_finish' and final batch) run on the same thread as the new call's, and
+    /// before them since the old call is cancelled first.
+    ///
+    std::size_t queue_index = 0u;
+
+    util::AtomicData<AsyncCall*> reading_call{nullptr}; ///< The call reading the stream right now (if any)
+};
+
+/**
+ * @brief Reads a server stream one message at a time on one of the 'AsyncCallQueues'
+ *
+ * The call starts, reads until the server finishes the stream (or it's cancelled) and then
+ * reports the final status. Only one operation is in flight at a time so updates arrive in order.
+ */
+template <typename Return>
+class AsyncStreamCall : public AsyncCall {
+public:
+    AsyncStreamCall(AsyncCallQueues* queues, std::shared_ptr<AsyncStreamState<Return>> state);
+    ~AsyncStreamCall() override = default;
+
+    void on_complete(bool call_ok) override;
+    void cancel() override;
+
+    bool delta_decoding() const;
+
+    grpc::ClientContext context;
+    std::unique_ptr<grpc::ClientAsyncReader<Return>> reader;
+
+private:
+    enum class Step {
+        starting,
+        reading,
+        finishing,
+    };
+
+    AsyncCallQueues* queues_;
+    std::shared_ptr<AsyncStreamState<Return>> state_;
+
+    const std::shared_ptr<UpdateBatcher<Return>> batcher_;
+    const bool delta_decoding_;
+
+    Step step_ = Step::starting;
+    Return update_;
+    Return current_state_; ///< The last full update (only used when decoding deltas)
+    grpc::Status status_;
+
+    void finish(const grpc::Status& status);
+};
+
+template <typename Return>
+AsyncStreamCall<Return>::AsyncStreamCall(AsyncCallQueues* queues, std::shared_ptr<AsyncStreamState<Return>> state)
+    : queues_(queues),
+      state_(std::move(state)),
+      batcher_(state_->batcher),
+      delta_decoding_(state_->delta_decoding) {}
+
+template <typename Return>
+void AsyncStreamCall<Return>::on_complete(bool call_ok) {
+    if (step_ == Step::finishing) {
+        finish(status_);
+        return;
+    }
+
+    if (step_ == Step::reading and call_ok) {
+        if (delta_decoding_) {
+            util::apply_delta(update_, &current_state_);
+            update_ = current_state_;
+        }
+
+        if (batcher_) {
+            batcher_->add(std::move(update_));
+        } else if (state_->on_update) {
+            state_->on_update(std::move(update_));
+        }
+    }
+
+    // 'call_ok' is false once the stream has ended (or failed to start) and 'Finish' has the reason
+    bool started;
+    if (call_ok) {
+        step_ = Step::reading;
+        started = queues_->resume(this, [this] { reader->Read(&update_, this); });
+    } else {
+        step_ = Step::finishing;
+        started = queues_->resume(this, [this] { reader->Finish(&status_, this); });
+    }
+
+    if (not started) {
+        finish({grpc::StatusCode::CANCELLED, "The client is shutting down"});
+    }
+}
+
+template <typename Return>
+void AsyncStreamCall<Return>::cancel() {
+    context.TryCancel();
+}
+
+template <typename Return>
+bool AsyncStreamCall<Return>::delta_decoding() const {
+    return delta_decoding_;
+}
+
+template <typename Return>
+void AsyncStreamCall<Return>::finish(const grpc::Status& status) {
+    // A newer call may already be reading the stream
+    state_->reading_call.use_safely([this](AsyncCall*& call) {
+        if (call == this) {
+            call = nullptr;
+        }
+    });
+
+    if (batcher_) {
+        batcher_->flush();
+    }
+    if (state_->on_finish) {
+        state_->on_finish(status);
+    }
+}
+
+} // namespace detail
+} // namespace client
+} // namespace grpcw
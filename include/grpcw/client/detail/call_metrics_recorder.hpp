@@ -0,0 +1,117 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// grpcw
+#include "grpcw/client/call_metrics.hpp"
+#include "grpcw/util/atomic_data.hpp"
+#include "grpcw/util/atomic_shared_ptr.hpp"
+
+// third-party
+#include <grpcpp/support/client_interceptor.h>
+
+// standard
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace grpcw {
+namespace client {
+namespace detail {
+
+/**
+ * @brief The calls of one method, updated by every call without a shared lock
+ *
+ * Counters are relaxed atomics and the latencies of a call are added to the histograms with a
+ * single short lock once it finishes.
+ */
+struct MethodRecorder {
+    /// One counter per status code, unknown codes are counted as UNKNOWN
+    static constexpr std::size_t status_code_count = 17u;
+
+    struct Latencies {
+        util::LatencyHistogram first_message{MethodMetrics::highest_latency_us, MethodMetrics::latency_digits};
+        util::LatencyHistogram total{MethodMetrics::highest_latency_us, MethodMetrics::latency_digits};
+    };
+
+    std::string method;
+    std::atomic<std::uint64_t> calls_started{0u};
+    std::atomic<std::int64_t> calls_in_flight{0};
+    std::array<std::atomic<std::uint64_t>, status_code_count> calls_finished = {};
+    util::AtomicData<Latencies> latencies;
+
+    explicit MethodRecorder(std::string method_name);
+};
+
+/**
+ * @brief The metrics of every method called by a client
+ */
+class CallMetricsRecorder {
+public:
+    /// \brief The recorder of 'method', created the first time it's called
+    std::shared_ptr<MethodRecorder> method(const char* method);
+
+    /// \brief A copy of what was recorded so far, sorted by method
+    std::vector<MethodMetrics> snapshot() const;
+
+private:
+    /// \brief Every method seen so far, replaced by a copy whenever a method is added
+    struct Methods {
+        std::map<std::string, std::shared_ptr<MethodRecorder>> by_name;
+
+        /// Generated stubs pass the same static string for every call so most lookups don't build a string
+        std::unordered_map<const char*, std::shared_ptr<MethodRecorder>> by_pointer;
+    };
+
+    /// Loaded by every call without a lock
+    util::AtomicSharedPtr<const Methods> methods_{std::make_shared<const Methods>()};
+
+    /// Only taken to add a method so two new methods don't replace each other's copy
+    std::mutex add_mutex_;
+};
+
+/**
+ * @brief Records the calls made on one channel
+ *
+ * No interceptor is created while 'recorder' is empty so calls aren't slowed down when metrics are off.
+ */
+class CallMetricsInterceptorFactory : public grpc::experimental::ClientInterceptorFactoryInterface {
+public:
+    explicit CallMetricsInterceptorFactory(std::shared_ptr<const util::AtomicSharedPtr<CallMetricsRecorder>> recorder);
+
+    grpc::experimental::Interceptor* CreateClientInterceptor(grpc::experimental::ClientRpcInfo* info) override;
+
+private:
+    std::shared_ptr<const util::AtomicSharedPtr<CallMetricsRecorder>> recorder_;
+};
+
+} // namespace detail
+} // namespace client
+} // namespace grpcw
@@ -0,0 +1,51 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// third-party
+#include <grpc++/support/status.h>
+
+namespace grpcw {
+namespace client {
+namespace detail {
+
+/// \brief The message of the calls failed by an open circuit without being sent
+constexpr const char* circuit_open_message = "The circuit breaker is open";
+
+/// \brief The status an open circuit fails a call with. Its details hold a marker that is random per
+/// process so no server can send a status that passes for a rejection.
+grpc::Status circuit_rejection();
+
+/// \brief Codes that say the server is unhealthy rather than the call being wrong (used for ejection and circuits)
+inline bool is_backend_failure(grpc::StatusCode code) {
+    return code == grpc::StatusCode::UNAVAILABLE or code == grpc::StatusCode::DEADLINE_EXCEEDED
+        or code == grpc::StatusCode::RESOURCE_EXHAUSTED;
+}
+
+/// \brief True for calls an open circuit failed before they reached a server
+bool is_circuit_rejection(const grpc::Status& status);
+
+} // namespace detail
+} // namespace client
+} // namespace grpcw
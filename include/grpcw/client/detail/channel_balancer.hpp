@@ -0,0 +1,115 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// grpcw
+#include "grpcw/client/channel_pool.hpp"
+
+// third-party
+#include <grpc++/support/status.h>
+
+// standard
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace grpcw {
+namespace client {
+namespace detail {
+
+/**
+ * @brief Picks the channel for each call made through a client's channel pool
+ *
+ * Every method is safe to call from any thread without a lock. Statistics are updated with
+ * relaxed atomics so concurrent updates can occasionally overwrite each other, which only makes
+ * the averages slightly less exact.
+ */
+class ChannelBalancer {
+public:
+    ChannelBalancer(std::size_t channel_count, const ChannelPool& options);
+
+    /// \brief Only ready channels are picked for calls
+    void set_ready(std::size_t index, bool ready);
+    bool is_ready(std::size_t index) const;
+
+    /// \brief Pick a ready channel for a call (false if there isn't one). It is in flight until released.
+    bool acquire(std::size_t* index);
+
+    /// \brief Like 'acquire' but prefer any other ready channel over 'avoid' (for a second copy of a call)
+    bool acquire(std::size_t* index, std::size_t avoid);
+
+    /// \brief Finish a call whose outcome is unknown
+    void release(std::size_t index);
+
+    /// \brief Finish a call and use its outcome for the channel's latency average and ejection
+    /// \note Calls failed by an open circuit never reached the server and are released without an outcome
+    void release(std::size_t index, const grpc::Status& status, std::chrono::nanoseconds latency);
+
+    /// \brief Pick the ready channel with the fewest streams for a new stream (false if there isn't one).
+    /// The stream counts against the channel until it is released.
+    bool acquire_stream(std::size_t* index);
+    void release_stream(std::size_t index);
+
+    int calls_in_flight(std::size_t index) const;
+    int streams(std::size_t index) const;
+    std::chrono::nanoseconds average_latency(std::size_t index) const;
+    bool is_ejected(std::size_t index) const;
+
+private:
+    struct ChannelStats {
+        std::atomic_bool ready{false};
+        std::atomic_int calls_in_flight{0};
+        std::atomic_int streams{0};
+        std::atomic<std::int64_t> average_latency_ns{0};
+        std::atomic_int consecutive_failures{0};
+        std::atomic<std::int64_t> ejected_until_ns{0}; ///< steady_clock time
+    };
+
+    std::size_t channel_count_;
+    ChannelPool options_;
+    std::unique_ptr<ChannelStats[]> channels_;
+    std::atomic<std::size_t> next_index_{0u};
+
+    /// \brief 'avoid' is ignored when it's not a valid index
+    bool acquire_avoiding(std::size_t avoid, std::size_t* index);
+
+    bool is_eligible(std::size_t index, bool allow_ejected, std::int64_t now_ns) const;
+
+    /// \brief The next eligible channel in turn, only allowing ejected channels when every ready one is
+    bool first_eligible(std::int64_t now_ns, bool* allow_ejected, std::size_t* index);
+
+    /// \brief The first eligible channel at or after 'start' (wrapping around)
+    bool next_eligible(std::size_t start, bool allow_ejected, std::int64_t now_ns, std::size_t* index) const;
+
+    /// \brief The eligible channel with the lowest 'load' (the first one found on ties)
+    std::size_t pick_least_loaded(std::size_t first,
+                                  bool allow_ejected,
+                                  std::int64_t now_ns,
+                                  std::atomic_int ChannelStats::*load) const;
+    std::size_t pick_power_of_two_choices(bool allow_ejected, std::int64_t now_ns) const;
+};
+
+} // namespace detail
+} // namespace client
+} // namespace grpcw
@@ -0,0 +1,153 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// grpcw
+#include "grpcw/client/circuit_breaking.hpp"
+#include "grpcw/util/atomic_data.hpp"
+#include "grpcw/util/atomic_shared_ptr.hpp"
+
+// third-party
+#include <grpc++/support/status.h>
+#include <grpcpp/support/client_interceptor.h>
+
+// standard
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace grpcw {
+namespace client {
+namespace detail {
+
+/**
+ * @brief The circuit of one method on one server
+ *
+ * Every method is safe to call from any thread. The time is passed in so the state changes
+ * can be tested without waiting.
+ */
+class CircuitBreaker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// \brief Throws std::invalid_argument if 'options' has a negative or out of range value
+    explicit CircuitBreaker(const CircuitBreaking& options);
+
+    ///
+    /// \brief Check if a call can be sent (false while the circuit is open).
+    ///
+    /// 'trial' is set for the calls let through by a half-open circuit and has to be passed back to
+    /// 'record'. 'half_opened' is set when this call found the open circuit ready for trial calls.
+    ///
+    bool try_acquire(Clock::time_point now, bool* trial, bool* half_opened);
+
+    /// \brief Count the outcome of a call let through by 'try_acquire' (true if it changed the state to 'state')
+    bool record(const grpc::Status& status,
+                std::chrono::nanoseconds latency,
+                bool trial,
+                Clock::time_point now,
+                CircuitState* state);
+
+    CircuitState state() const;
+
+private:
+    static constexpr std::size_t bucket_count = 10u;
+
+    /// \brief The outcomes of the calls that finished during one tenth of the window
+    struct Bucket {
+        std::int64_t index = -1; ///< Which tenth of the window since the clock's epoch
+        int calls = 0;
+        int failures = 0;
+        int slow_calls = 0;
+    };
+
+    struct State {
+        CircuitState state = CircuitState::closed;
+        std::array<Bucket, bucket_count> buckets = {};
+        Clock::time_point opened_at = {};
+        int trials_started = 0;
+        int trials_succeeded = 0;
+    };
+
+    CircuitBreaking options_;
+    Clock::duration bucket_width_;
+    util::AtomicData<State> state_;
+
+    void open(State* state, Clock::time_point now) const;
+};
+
+/**
+ * @brief All the circuits of a client, created the first time a method is called on a server
+ *
+ * Replaced as a whole when the client's circuit breaking changes so every circuit starts closed.
+ */
+class CircuitBreakers {
+public:
+    using OnChange = std::function<void(const std::string& method, const std::string& backend, CircuitState state)>;
+
+    /// \brief Throws std::invalid_argument if 'options' has a negative or out of range value
+    CircuitBreakers(const CircuitBreaking& options, OnChange on_change);
+
+    std::shared_ptr<CircuitBreaker> circuit(const std::string& method, const std::string& backend);
+
+    /// \brief The state of a circuit (closed if no call was made yet)
+    CircuitState state(const std::string& method, const std::string& backend) const;
+
+    /// \brief Report a state change, never called while a circuit is locked
+    void notify(const std::string& method, const std::string& backend, CircuitState state) const;
+
+private:
+    CircuitBreaking options_;
+    OnChange on_change_;
+
+    mutable std::mutex mutex_;
+    std::map<std::pair<std::string, std::string>, std::shared_ptr<CircuitBreaker>> circuits_;
+};
+
+/**
+ * @brief Adds the client's circuit breakers to the unary calls made on one channel
+ *
+ * 'backend' is the address the channel connects to. No interceptor is created while
+ * 'circuit_breakers' is empty so calls aren't slowed down when circuit breaking is off.
+ */
+class CircuitBreakerInterceptorFactory : public grpc::experimental::ClientInterceptorFactoryInterface {
+public:
+    CircuitBreakerInterceptorFactory(std::shared_ptr<const util::AtomicSharedPtr<CircuitBreakers>> circuit_breakers,
+                                     std::string backend);
+
+    grpc::experimental::Interceptor* CreateClientInterceptor(grpc::experimental::ClientRpcInfo* info) override;
+
+private:
+    std::shared_ptr<const util::AtomicSharedPtr<CircuitBreakers>> circuit_breakers_;
+    std::string backend_;
+};
+
+} // namespace detail
+} // namespace client
+} // namespace grpcw
@@ -0,0 +1,263 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// grpcw
+#include "grpcw/client/detail/async_call_queues.hpp"
+#include "grpcw/client/detail/channel_balancer.hpp"
+#include "grpcw/client/hedging_policy.hpp"
+#include "grpcw/util/atomic_data.hpp"
+#include "grpcw/util/latency_histogram.hpp"
+
+// third-party
+#include <grpc++/support/status.h>
+
+// standard
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace grpcw {
+namespace client {
+namespace detail {
+
+/**
+ * @brief The hedge budget, hedge delay and statistics shared by all of a client's hedged calls
+ */
+class HedgingTracker {
+public:
+    /// \brief Throws std::invalid_argument if 'policy' has a negative or out of range value
+    explicit HedgingTracker(const HedgingPolicy& policy);
+
+    /// \brief Count a new call and get how long to wait before hedging it (false if it can't be hedged yet)
+    bool start_call(std::chrono::nanoseconds* hedge_delay);
+
+    /// \brief Take a token from the budget for a hedge (false if there isn't one)
+    bool try_send_hedge();
+
+    /// \brief The latency of a copy that finished first (used for the percentile delay)
+    void record_latency(std::chrono::nanoseconds latency);
+
+    void record_hedge_won();
+    void record_cancelled();
+
+    HedgingStats stats() const;
+
+private:
+    HedgingPolicy policy_;
+
+    std::atomic<std::uint64_t> calls_{0u};
+    std::atomic<std::uint64_t> hedges_sent_{0u};
+    std::atomic<std::uint64_t> hedges_won_{0u};
+    std::atomic<std::uint64_t> cancelled_{0u};
+
+    std::atomic<double> tokens_{0.0};
+
+    util::AtomicData<util::LatencyHistogram> recent_latencies_; ///< Microseconds
+    std::atomic<std::int64_t> percentile_delay_ns_{0}; ///< Zero until enough latencies have been seen
+};
+
+/**
+ * @brief The copies of one hedged call. The first copy to finish completes the call.
+ */
+template <typename Response>
+class HedgedCall {
+public:
+    using OnDone = std::function<void(grpc::Status, Response)>;
+
+    HedgedCall(OnDone on_done, std::shared_ptr<HedgingTracker> tracker);
+
+    ///
+    /// \brief Track a copy so it can be cancelled when another copy finishes first.
+    ///
+    /// Call this before the copy is started since it can finish as soon as it is. A copy cancelled
+    /// before it starts fails right away. Returns false, and the copy must not be started, if the call
+    /// has already finished.
+    ///
+    bool add_copy(AsyncCall* copy);
+
+    /// \brief Track the timer that sends the hedge, like 'add_copy'
+    bool add_timer(AsyncCall* timer);
+
+    /// \brief The timer completed. Returns true if it fired before the call finished.
+    bool timer_done(bool fired);
+
+    ///
+    /// \brief A copy completed. Returns true if its result is the call's result.
+    ///
+    /// The first successful copy wins. A failed copy only wins if no other copy is still in flight.
+    /// Everything else is cancelled once a copy wins.
+    ///
+    bool finish(AsyncCall* copy, bool succeeded);
+
+    /// \brief Hand the result of the winning copy to the user
+    void complete(grpc::Status status, Response response);
+
+    HedgingTracker& tracker();
+
+private:
+    struct State {
+        bool done = false;
+        std::vector<AsyncCall*> copies; ///< Copies that are still in flight
+        AsyncCall* timer = nullptr;
+    };
+
+    util::AtomicData<State> state_;
+    OnDone on_done_;
+    std::shared_ptr<HedgingTracker> tracker_;
+};
+
+/**
+ * @brief One copy of a hedged call, sent on one of the client's channels
+ */
+template <typename Response>
+class HedgedCopy : public UnaryAsyncCall<Response> {
+public:
+    HedgedCopy(std::shared_ptr<HedgedCall<Response>> call,
+               std::shared_ptr<ChannelBalancer> balancer,
+               std::size_t channel,
+               bool is_hedge);
+    ~HedgedCopy() override = default;
+
+    void on_complete(bool call_ok) override;
+
+private:
+    std::shared_ptr<HedgedCall<Response>> call_;
+    std::shared_ptr<ChannelBalancer> balancer_;
+    std::size_t channel_;
+    bool is_hedge_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+template <typename Response>
+HedgedCall<Response>::HedgedCall(OnDone on_done, std::shared_ptr<HedgingTracker> tracker)
+    : on_done_(std::move(on_done)), tracker_(std::move(tracker)) {}
+
+template <typename Response>
+bool HedgedCall<Response>::add_copy(AsyncCall* copy) {
+    return state_.use_safely([&](State& state) {
+        if (state.done) {
+            tracker_->record_cancelled();
+            return false;
+        }
+        state.copies.emplace_back(copy);
+        return true;
+    });
+}
+
+template <typename Response>
+bool HedgedCall<Response>::add_timer(AsyncCall* timer) {
+    return state_.use_safely([&](State& state) {
+        if (state.done) {
+            return false;
+        }
+        state.timer = timer;
+        return true;
+    });
+}
+
+template <typename Response>
+bool HedgedCall<Response>::timer_done(bool fired) {
+    return state_.use_safely([fired](State& state) {
+        state.timer = nullptr;
+        return fired and not state.done;
+    });
+}
+
+template <typename Response>
+bool HedgedCall<Response>::finish(AsyncCall* copy, bool succeeded) {
+    return state_.use_safely([&](State& state) {
+        state.copies.erase(std::remove(state.copies.begin(), state.copies.end(), copy), state.copies.end());
+        if (state.done or (not succeeded and not state.copies.empty())) {
+            return false;
+        }
+        state.done = true;
+
+        // Nothing is deleted while it's tracked because every copy and timer removes itself while locked
+        for (auto* other : state.copies) {
+            other->cancel();
+            tracker_->record_cancelled();
+        }
+        if (state.timer) {
+            state.timer->cancel();
+        }
+        return true;
+    });
+}
+
+template <typename Response>
+void HedgedCall<Response>::complete(grpc::Status status, Response response) {
+    if (on_done_) {
+        on_done_(std::move(status), std::move(response));
+    }
+}
+
+template <typename Response>
+HedgingTracker& HedgedCall<Response>::tracker() {
+    return *tracker_;
+}
+
+template <typename Response>
+HedgedCopy<Response>::HedgedCopy(std::shared_ptr<HedgedCall<Response>> call,
+                                 std::shared_ptr<ChannelBalancer> balancer,
+                                 std::size_t channel,
+                                 bool is_hedge)
+    : UnaryAsyncCall<Response>(nullptr),
+      call_(std::move(call)),
+      balancer_(std::move(balancer)),
+      channel_(channel),
+      is_hedge_(is_hedge),
+      start_(std::chrono::steady_clock::now()) {}
+
+template <typename Response>
+void HedgedCopy<Response>::on_complete(bool /*call_ok*/) {
+    auto latency = std::chrono::steady_clock::now() - start_;
+    auto& status = this->status;
+
+    if (not call_->finish(this, status.ok())) {
+        // Copies cancelled by the winner say nothing about their channel
+        if (status.error_code() == grpc::StatusCode::CANCELLED) {
+            balancer_->release(channel_);
+        } else {
+            balancer_->release(channel_, status, latency);
+        }
+        return;
+    }
+
+    balancer_->release(channel_, status, latency);
+    if (status.ok()) {
+        call_->tracker().record_latency(latency);
+    }
+    if (is_hedge_) {
+        call_->tracker().record_hedge_won();
+    }
+    call_->complete(std::move(status), std::move(this->response));
+}
+
+} // namespace detail
+} // namespace client
+} // namespace grpcw
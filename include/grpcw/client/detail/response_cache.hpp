@@ -0,0 +1,104 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// grpcw
+#include "grpcw/client/response_caching.hpp"
+#include "grpcw/util/atomic_data.hpp"
+
+// third-party
+#include <google/protobuf/message.h>
+
+// standard
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace grpcw {
+namespace client {
+namespace detail {
+
+/**
+ * @brief The responses of a client's cached unary calls, dropped least recently used first
+ */
+class ResponseCache {
+public:
+    /// \brief Throws std::invalid_argument if 'caching' has no room for responses or a non-positive age
+    explicit ResponseCache(const ResponseCaching& caching);
+
+    /// \brief The key for 'request' sent to the method at 'method_path' (equal requests get equal keys)
+    static std::string make_key(const std::string& method_path, const google::protobuf::Message& request);
+
+    ///
+    /// \brief The cached response for 'key' or null if there isn't one.
+    ///
+    /// On a miss 'generation' is set to the value 'insert' expects. A response fetched while
+    /// something was invalidated is not cached since it may already be out of date.
+    ///
+    std::shared_ptr<const google::protobuf::Message> find(const std::string& key, std::uint64_t* generation);
+
+    /// \brief Cache 'response' for 'key' so it is dropped by invalidating 'invalidation_key'
+    void insert(const std::string& key,
+                const std::string& invalidation_key,
+                std::shared_ptr<const google::protobuf::Message> response,
+                std::uint64_t generation);
+
+    /// \brief Drop every response cached with 'invalidation_key' (an empty key drops everything)
+    void invalidate(const std::string& invalidation_key);
+
+    ResponseCacheStats stats() const;
+
+private:
+    struct Entry;
+    using Entries = std::list<Entry>; ///< Most recently used first
+    using Group = std::list<Entries::iterator>; ///< The entries sharing an invalidation key
+
+    struct Entry {
+        std::string key;
+        std::string invalidation_key;
+        std::shared_ptr<const google::protobuf::Message> response;
+        std::size_t bytes;
+        std::chrono::steady_clock::time_point expires;
+        Group::iterator group_position;
+    };
+
+    struct State {
+        Entries entries;
+        std::unordered_map<std::string, Entries::iterator> by_key;
+        std::unordered_map<std::string, Group> by_invalidation_key; ///< Entries with an empty key aren't grouped
+        std::uint64_t generation = 0u; ///< Incremented by every invalidation
+        ResponseCacheStats stats;
+    };
+
+    ResponseCaching caching_;
+    util::AtomicData<State> state_;
+
+    static void erase(State* state, Entries::iterator entry);
+};
+
+} // namespace detail
+} // namespace client
+} // namespace grpcw
@@ -0,0 +1,161 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// grpcw
+#include "grpcw/client/detail/async_call_queues.hpp"
+#include "grpcw/client/update_batching.hpp"
+#include "grpcw/util/atomic_data.hpp"
+
+// standard
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace grpcw {
+namespace client {
+namespace detail {
+
+/**
+ * @brief Collects a stream's updates (or a 'UnaryCallBatcher's calls) and hands them over in batches
+ *
+ * Batches are delivered while the batcher is locked so they always arrive in order, either
+ * from the thread adding to the batch or, when 'max_delay' expires, from a queue thread.
+ */
+template <typename Return>
+class UpdateBatcher : public std::enable_shared_from_this<UpdateBatcher<Return>> {
+public:
+    using OnUpdateBatch = std::function<void(std::vector<Return>&&)>;
+
+    /// \brief Throws std::invalid_argument if 'batching.max_batch_size' is zero
+    UpdateBatcher(OnUpdateBatch on_update_batch, UpdateBatching batching, AsyncCallQueues* timer_queues);
+
+    /// \brief Add an update to the batch and deliver it if it's full
+    void add(Return&& update);
+
+    /// \brief Deliver the updates that are still waiting (when the stream ends)
+    void flush();
+
+private:
+    struct Batch {
+        std::vector<Return> updates;
+        AsyncCall* timer = nullptr; ///< Delivers the batch when 'max_delay' expires
+        std::uint64_t timer_id = 0u; ///< Identifies the current timer so stale ones are ignored
+    };
+
+    OnUpdateBatch on_update_batch_;
+    UpdateBatching batching_;
+    AsyncCallQueues* timer_queues_;
+    util::AtomicData<Batch> batch_;
+
+    /// \brief Call while 'batch_' is locked
+    void deliver(Batch& batch);
+    void start_timer(Batch& batch);
+};
+
+template <typename Return>
+UpdateBatcher<Return>::UpdateBatcher(OnUpdateBatch on_update_batch,
+                                     UpdateBatching batching,
+                                     AsyncCallQueues* timer_queues)
+    : on_update_batch_(std::move(on_update_batch)), batching_(batching), timer_queues_(timer_queues) {
+    if (batching_.max_batch_size == 0u) {
+        throw std::invalid_argument("An update batch needs room for at least one update");
+    }
+}
+
+template <typename Return>
+void UpdateBatcher<Return>::add(Return&& update) {
+    batch_.use_safely([&](Batch& batch) {
+        batch.updates.emplace_back(std::move(update));
+
+        if (batch.updates.size() >= batching_.max_batch_size or batching_.max_delay.count() <= 0) {
+            deliver(batch);
+        } else if (batch.updates.size() == 1u) {
+            start_timer(batch);
+        }
+    });
+}
+
+template <typename Return>
+void UpdateBatcher<Return>::flush() {
+    batch_.use_safely([this](Batch& batch) { deliver(batch); });
+}
+
+template <typename Return>
+void UpdateBatcher<Return>::deliver(Batch& batch) {
+    if (batch.timer) {
+        // The timer can't be deleted yet because it has to lock 'batch_' before it finishes
+        batch.timer->cancel();
+        batch.timer = nullptr;
+    }
+
+    if (batch.updates.empty()) {
+        return;
+    }
+
+    std::vector<Return> updates;
+    updates.reserve(batching_.max_batch_size);
+    std::swap(updates, batch.updates);
+
+    if (on_update_batch_) {
+        on_update_batch_(std::move(updates));
+    }
+}
+
+template <typename Return>
+void UpdateBatcher<Return>::start_timer(Batch& batch) {
+    auto timer_id = ++batch.timer_id;
+
+    auto timer = std::make_unique<AsyncAlarm>([batcher = this->shared_from_this(), timer_id](bool fired) {
+        batcher->batch_.use_safely([&](Batch& batch) {
+            if (batch.timer_id != timer_id or not batch.timer) {
+                return; // Cancelled when its batch was delivered
+            }
+            batch.timer = nullptr;
+            if (fired) {
+                batcher->deliver(batch);
+            }
+        });
+    });
+
+    auto deadline = std::chrono::system_clock::now()
+        + std::chrono::duration_cast<std::chrono::system_clock::duration>(batching_.max_delay);
+
+    bool started = timer_queues_->start(timer.get(), [&](grpc::CompletionQueue* queue) {
+        timer->alarm.Set(queue, deadline, timer.get());
+    });
+
+    if (started) {
+        // Owned by the queue like any other call
+        batch.timer = timer.release();
+    } else {
+        // The client is shutting down so there is no reason to wait
+        deliver(batch);
+    }
+}
+
+} // namespace detail
+} // namespace client
+} // namespace grpcw
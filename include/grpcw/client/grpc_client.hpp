@@ -23,20 +23,47 @@
 #pragma once
 
 // grpcw
+#include "grpcw/client/call_batching.hpp"
+#include "grpcw/client/call_metrics.hpp"
+#include "grpcw/client/channel_pool.hpp"
+#include "grpcw/client/circuit_breaking.hpp"
+#include "grpcw/client/detail/async_call_queues.hpp"
+#include "grpcw/client/detail/call_metrics_recorder.hpp"
+#include "grpcw/client/detail/channel_balancer.hpp"
+#include "grpcw/client/detail/circuit_breaker.hpp"
+#include "grpcw/client/detail/hedged_call.hpp"
+#include "grpcw/client/detail/response_cache.hpp"
 #include "grpcw/client/grpc_client_state.hpp"
 #include "grpcw/client/grpc_client_stream.hpp"
+#include "grpcw/client/hedging_policy.hpp"
+#include "grpcw/client/reconnect_backoff.hpp"
+#include "grpcw/client/response_caching.hpp"
+#include "grpcw/client/unary_call_batcher.hpp"
+#include "grpcw/client/update_batching.hpp"
 #include "grpcw/forward_declarations.hpp"
 #include "grpcw/util/atomic_data.hpp"
+#include "grpcw/util/atomic_shared_ptr.hpp"
+#include "grpcw/util/batch_fields.hpp"
+#include "grpcw/util/method_path.hpp"
 
 // third-party
 #include <grpc++/channel.h>
 #include <grpc++/completion_queue.h>
 #include <grpc++/create_channel.h>
 #include <grpc++/server.h>
+#include <grpc++/server_context.h>
 
 // standard
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <random>
+#include <string>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 namespace grpcw {
 namespace client {
@@ -60,35 +87,91 @@ inline GrpcClientState to_cnc_client_state(grpc_connectivity_state state) {
 
 auto default_channel_arguments() -> grpc::ChannelArguments;
 
+/// \brief 'default_channel_arguments' for channel 'index' of a pool (never shares subchannels with other channels)
+auto pooled_channel_arguments(int index) -> grpc::ChannelArguments;
+
+/// \brief Set the reconnect delays of 'backoff' on channel 'arguments'
+void apply_reconnect_backoff(const ReconnectBackoff& backoff, grpc::ChannelArguments* arguments);
+
+/// \brief A blocking unary call on a generated stub (&Service::Stub::method)
+template <typename Service, typename Request, typename Response>
+using StubUnaryFunc = grpc::Status (Service::Stub::*)(grpc::ClientContext*, const Request&, Response*);
+
+/// \brief The synchronous service implementation of the same call (&Service::Service::method)
+template <typename Service, typename Request, typename Response>
+using ServiceUnaryFunc = grpc::Status (Service::Service::*)(grpc::ServerContext*, const Request*, Response*);
+
+/// \brief An asynchronous unary call on a generated stub (&Service::Stub::Asyncmethod)
+template <typename Service, typename Request, typename Response>
+using StubAsyncUnaryFunc = std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> (Service::Stub::*)(
+    grpc::ClientContext*, const Request&, grpc::CompletionQueue*);
+
+/// \brief Invoked on one of the client's queue threads when an asynchronous unary call finishes
+template <typename Response>
+using OnCallDone = typename detail::UnaryAsyncCall<Response>::OnDone;
+
+/// \brief The outcome of an asynchronous unary call
+template <typename Response>
+struct CallResult {
+    grpc::Status status;
+    Response response;
+};
+
 template <typename Service>
 class GrpcClient {
     template <typename Result>
     using StreamInitFunc = typename GrpcClientStream<Service, Result>::InitFunc;
 
+    template <typename Result>
+    using AsyncStreamInitFunc = typename GrpcClientAsyncStream<Service, Result>::InitFunc;
+
     template <typename Result>
     using StreamOnUpdate = typename GrpcClientStream<Service, Result>::OnUpdate;
 
+    template <typename Result>
+    using StreamOnUpdateBatch = typename GrpcClientStream<Service, Result>::OnUpdateBatch;
+
     template <typename Result>
     using StreamOnFinish = typename GrpcClientStream<Service, Result>::OnFinish;
 
     using ConnectionChangeCallback = std::function<void(GrpcClientState)>;
+    using CircuitChangeCallback
+        = std::function<void(const std::string& method, const std::string& address, CircuitState state)>;
 
     template <typename Result>
     class GrpcClientStreamCallbackSetter;
 
 public:
-    explicit GrpcClient() = default;
+    /// \brief 'async_threads' completion queue threads are started by the first 'call_async'
+    explicit GrpcClient(int async_threads = 1);
     ~GrpcClient();
 
     ///
     /// \brief Attempt to connect to a host address in the form "server:port".
     ///
+    /// Servers on the same host can also be reached through a unix domain socket with
+    /// "unix:/path/to/socket" or "unix-abstract:name". Abstract sockets are Linux only and
+    /// need gRPC 1.34 or newer (older releases fail to resolve the address).
+    ///
     /// The client will attempt to connect and as the connection state changes the
     /// 'connection_change_callback' will be invoked to inform the user of the changes.
     ///
     /// NOTE: The callback will be invoked from a separate thread.
     ///
-    void change_server(const std::string& address, ConnectionChangeCallback connection_change_callback);
+    void change_server(const std::string& address,
+                       ConnectionChangeCallback connection_change_callback,
+                       ChannelPool channel_pool = {});
+
+    ///
+    /// \brief Spread calls over several servers that provide the same service.
+    ///
+    /// 'channel_pool' channels are opened to every address and each call goes to a connected
+    /// channel picked by 'channel_pool.selection'. The client is connected while any channel is.
+    /// Each registered stream goes to the connected channel with the fewest streams.
+    ///
+    void change_server(const std::vector<std::string>& addresses,
+                       ConnectionChangeCallback connection_change_callback,
+                       ChannelPool channel_pool = {});
 
     ///
     /// \brief Create a direct channel to a server running in the same process.
@@ -97,17 +180,99 @@ public:
     ///
     void change_server(std::shared_ptr<grpc::Channel> in_process_channel);
 
+    ///
+    /// \brief Connect to a server in the same process and bypass the channel for unary calls.
+    ///
+    /// Unary calls made with 'call' invoke 'in_process_service' directly so messages are never
+    /// serialized or framed. Streams and 'use_stub' still go through 'in_process_channel'.
+    /// 'in_process_service' must be a 'Service::Service' (throws std::invalid_argument otherwise)
+    /// and must stay alive until the client changes servers or is destroyed.
+    ///
+    void change_server(std::shared_ptr<grpc::Channel> in_process_channel, grpc::Service* in_process_service);
+
     ///
     /// \brief Add an RPC call that will return a stream of data
     ///
     template <typename Result>
     GrpcClientStreamCallbackSetter<Result> register_stream(StreamInitFunc<Result> init_func);
 
+    ///
+    /// \brief Add a stream that is read asynchronously on the client's queue threads.
+    ///
+    /// 'init_func' prepares the call without starting it (return 'stub.PrepareAsyncmethod(context, request, queue)').
+    /// Unlike the blocking version no thread is started per stream, which matters with thousands of streams.
+    ///
+    template <typename Result>
+    GrpcClientStreamCallbackSetter<Result> register_stream(AsyncStreamInitFunc<Result> init_func);
+
+    ///
+    /// \brief Drop cached responses when the server says they changed.
+    ///
+    /// Every message received on the stream opened by 'init_func' (blocking or asynchronous, like
+    /// 'register_stream') invalidates the responses cached with the key returned by 'key_of'. An
+    /// empty key invalidates everything, and so does the stream ending since invalidations may
+    /// have been missed until it restarts.
+    ///
+    template <typename Result, typename InitFunc>
+    void register_cache_invalidation_stream(InitFunc init_func, std::function<std::string(const Result&)> key_of);
+
     ///
     /// \brief Stop all connection attempts or disconnect (if already connected)
     ///
     void kill_streams_and_channel();
 
+    ///
+    /// \brief Block until every channel to the server is connected or 'deadline' passes.
+    ///
+    /// 'change_server' starts connecting every channel of the pool at once but returns right away.
+    /// Waiting here moves the connection setup out of the first calls. Returns false if a channel
+    /// was still not connected at 'deadline' (calls can still use the ones that are).
+    ///
+    template <typename TimePoint>
+    bool connect_and_wait(const TimePoint& deadline);
+
+    ///
+    /// \brief Change how the client reconnects (throws std::invalid_argument for invalid delays).
+    ///
+    /// The delays apply to the channels opened by the next 'change_server' and the stream restart
+    /// window to the next time the client connects.
+    ///
+    void set_reconnect_backoff(const ReconnectBackoff& backoff);
+
+    ///
+    /// \brief Stop sending unary calls to a server while they keep failing or taking too long.
+    ///
+    /// Every method gets a circuit per server address (see 'CircuitBreaking') and calls on an open
+    /// circuit fail right away with UNAVAILABLE. Throws std::invalid_argument for invalid settings.
+    /// Setting it again (or turning it off with 'disable_circuit_breaking') closes every circuit.
+    /// Calls to an in-process server are never stopped.
+    ///
+    /// 'circuit_change_callback' is invoked with the method ("/package.Service/method"), the
+    /// server address and the new state whenever a circuit changes state.
+    ///
+    /// NOTE: The callback will be invoked from the thread that makes or finishes the call.
+    ///
+    void set_circuit_breaking(const CircuitBreaking& options, CircuitChangeCallback circuit_change_callback = nullptr);
+    void disable_circuit_breaking();
+
+    /// \brief The state of 'method' ("/package.Service/method") on server 'address'
+    CircuitState get_circuit_state(const std::string& method, const std::string& address) const;
+
+    ///
+    /// \brief Measure every call made through the client's channels (restarts the measurements if already on).
+    ///
+    /// Calls, status codes, calls in flight and latencies are kept per method, see 'MethodMetrics'.
+    /// This covers 'use_stub' and streams as well as the call functions. Calls to an in-process
+    /// server are not measured.
+    ///
+    void enable_call_metrics();
+
+    /// \brief What was measured since 'enable_call_metrics' (nothing if it wasn't called)
+    std::vector<MethodMetrics> call_metrics() const;
+
+    /// \brief Replace the file at 'path' with 'call_metrics' in the Prometheus text format (throws std::runtime_error)
+    void write_call_metrics(const std::string& path) const;
+
     const std::string& get_server_address() const;
     GrpcClientState get_state();
     bool is_using_in_process_server() const;
@@ -115,43 +280,240 @@ public:
     ///
     /// \brief Safely use the service stub to make RPC calls.
     ///
-    /// If the client is not connected this function will return false and 'usage_func' will not be invoked
+    /// If the client is not connected this function will return false and 'usage_func' will not be invoked.
+    /// No lock is held while 'usage_func' runs so any number of threads can make calls at the same time.
     ///
     template <typename UsageFunc>
     bool use_stub(const UsageFunc& usage_func);
 
+    ///
+    /// \brief Make a blocking unary call.
+    ///
+    /// Uses the direct in-process path when the client was connected with
+    /// 'change_server(channel, service)' and 'stub_func' otherwise. Returns UNAVAILABLE
+    /// if the client is not connected.
+    ///
+    template <typename Request, typename Response>
+    grpc::Status call(StubUnaryFunc<Service, Request, Response> stub_func,
+                      ServiceUnaryFunc<Service, Request, Response> service_func,
+                      const Request& request,
+                      Response* response);
+
+    ///
+    /// \brief Start a unary call without blocking.
+    ///
+    /// 'on_done' is invoked from one of the client's queue threads once the call finishes. If the
+    /// client is not connected it is invoked right away, on this thread, with UNAVAILABLE.
+    /// Calls still in flight when the client is destroyed are cancelled.
+    ///
+    template <typename Request, typename Response>
+    void call_async(StubAsyncUnaryFunc<Service, Request, Response> stub_func,
+                    const Request& request,
+                    OnCallDone<Response> on_done);
+
+    /// \brief Start a unary call without blocking and get the result through a future
+    template <typename Request, typename Response>
+    std::future<CallResult<Response>> call_async(StubAsyncUnaryFunc<Service, Request, Response> stub_func,
+                                                 const Request& request);
+
+    /// \brief Hedge the calls made with 'call_hedged' (throws std::invalid_argument for an invalid policy)
+    void set_hedging_policy(const HedgingPolicy& policy);
+
+    /// \brief What the hedging policy has done since it was set
+    HedgingStats hedging_stats() const;
+
+    ///
+    /// \brief Start an idempotent unary call that is sent a second time if it's slow.
+    ///
+    /// Works like 'call_async'. Once the call has run for the hedging policy's delay, and the budget
+    /// allows it, a copy is sent on another channel when there is one. The first successful copy
+    /// is used and the other is cancelled. Without a hedging policy this is the same as 'call_async'.
+    ///
+    template <typename Request, typename Response>
+    void call_hedged(StubAsyncUnaryFunc<Service, Request, Response> stub_func,
+                     const Request& request,
+                     OnCallDone<Response> on_done);
+
+    /// \brief Start a hedged call and get the result through a future
+    template <typename Request, typename Response>
+    std::future<CallResult<Response>> call_hedged(StubAsyncUnaryFunc<Service, Request, Response> stub_func,
+                                                  const Request& request);
+
+    ///
+    /// \brief Send single unary calls to the server in batches through the batch rpc 'batch_func'.
+    ///
+    /// 'BatchRequest' and 'BatchResponse' must each have one repeated field of 'Request' and 'Response'
+    /// (throws std::invalid_argument otherwise). The server answers the requests in order, see
+    /// 'GrpcAsyncServer::register_async_batch'. Batches are sent like 'call_async' calls.
+    ///
+    /// Each call gets its own status when 'BatchResponse' has a repeated status field (see
+    /// 'util::batch_status_field'), otherwise every call in a failed batch gets the batch's status.
+    /// A response without any statuses counts as every call succeeding.
+    ///
+    template <typename Request, typename Response, typename BatchRequest, typename BatchResponse>
+    UnaryCallBatcher<Request, Response> batch_calls(StubAsyncUnaryFunc<Service, BatchRequest, BatchResponse> batch_func,
+                                                    CallBatching batching = {});
+
+    /// \brief Cache the responses of 'call_cached' (throws std::invalid_argument for invalid settings)
+    void enable_response_cache(const ResponseCaching& caching = {});
+
+    /// \brief What the response cache has done since it was enabled
+    ResponseCacheStats response_cache_stats() const;
+
+    /// \brief Drop the responses cached with 'invalidation_key' (everything if it's empty)
+    void invalidate_cache(const std::string& invalidation_key = "");
+
+    ///
+    /// \brief Make a blocking unary call that is answered from the response cache when possible.
+    ///
+    /// Successful responses are cached by method and request, and dropped once they are too old or
+    /// 'invalidation_key' is invalidated. Only use this for calls that read data, a cached response
+    /// is returned without reaching the server. Without a response cache this is the same as 'call'.
+    ///
+    /// 'method_name' is the name of the rpc made by 'stub_func' ("echo" for '&Stub::echo'). It keys the
+    /// cache so throws std::invalid_argument unless the service has a unary method of that name with
+    /// these request and response types.
+    ///
+    template <typename Request, typename Response>
+    grpc::Status call_cached(const std::string& method_name,
+                             StubUnaryFunc<Service, Request, Response> stub_func,
+                             ServiceUnaryFunc<Service, Request, Response> service_func,
+                             const Request& request,
+                             Response* response,
+                             const std::string& invalidation_key = "");
+
 private:
+    /// \brief One of the client's channels and the last state it reported
+    struct PooledChannel {
+        std::shared_ptr<grpc::Channel> channel = nullptr;
+        std::shared_ptr<typename Service::Stub> stub = nullptr;
+        grpc_connectivity_state state = GRPC_CHANNEL_IDLE;
+    };
+
     /// \brief All the data shared between threads
     struct SharedData {
-        grpc_connectivity_state connection_state = GRPC_CHANNEL_IDLE;
-        std::shared_ptr<grpc::Channel> channel = nullptr;
-        std::unique_ptr<typename Service::Stub> stub = nullptr;
+        grpc_connectivity_state connection_state = GRPC_CHANNEL_IDLE; ///< The most connected state of any channel
+        std::vector<PooledChannel> channels;
+        std::shared_ptr<detail::ChannelBalancer> balancer = nullptr;
+        typename Service::Service* direct_service = nullptr; ///< Set when unary calls skip the channel
         std::unordered_map<void*, std::unique_ptr<GrpcClientStreamInterface<Service>>> streams;
+        std::unordered_map<void*, std::size_t> stream_channels; ///< The channel each running stream was started on
+        ReconnectBackoff reconnect_backoff;
+        std::uint64_t connection_epoch = 0u; ///< Changes whenever the client connects or disconnects
+    };
+
+    /// \brief Streams to stop and start, decided while 'shared_data_' is locked and applied once it isn't
+    struct StreamChanges {
+        std::vector<GrpcClientStreamInterface<Service>*> stops; ///< Applied before the starts
+        std::vector<std::pair<GrpcClientStreamInterface<Service>*, std::shared_ptr<typename Service::Stub>>> starts;
+    };
+
+    /// \brief What calls need from 'SharedData', only published while the client is connected
+    struct Connection {
+        std::vector<std::shared_ptr<typename Service::Stub>> stubs; ///< Indexed like 'SharedData::channels'
+        typename Service::Service* direct_service = nullptr;
+        std::shared_ptr<detail::ChannelBalancer> balancer = nullptr;
     };
 
     /// Use atomic access to manipulate the shared data
     util::AtomicData<SharedData> shared_data_;
 
+    /// Held while streams are changed, started or stopped (and locked before 'shared_data_') so
+    /// 'shared_data_' is never held while a blocking stream starts or joins its thread
+    std::mutex streams_mutex_;
+
+    /// A snapshot of the connection so calls never wait on 'shared_data_' (or on each other)
+    util::AtomicSharedPtr<const Connection> connection_;
+
     bool using_in_process_server_ = false;
     std::string server_address_;
 
-    /// Used as a label in 'queue_' so we know when the state changed.
-    void* connection_change_tag = reinterpret_cast<void*>(0x1);
-
     // These are pointers so they can be reused after calling 'Shutdown' and 'join' respectively.
     std::unique_ptr<grpc::CompletionQueue> queue_;
     std::unique_ptr<std::thread> run_thread_;
 
+    int async_threads_;
+    std::once_flag async_queues_started_;
+    std::unique_ptr<detail::AsyncCallQueues> async_queues_; ///< Reset by the destructor so no callback outlives it
+
+    util::AtomicSharedPtr<detail::HedgingTracker> hedging_;
+    util::AtomicSharedPtr<detail::ResponseCache> response_cache_;
+
+    /// Shared with the interceptors of every channel, empty while call metrics are off
+    std::shared_ptr<util::AtomicSharedPtr<detail::CallMetricsRecorder>> call_metrics_
+        = std::make_shared<util::AtomicSharedPtr<detail::CallMetricsRecorder>>();
+
+    /// Shared with the interceptors of every channel, empty while circuit breaking is off
+    std::shared_ptr<util::AtomicSharedPtr<detail::CircuitBreakers>> circuit_breakers_
+        = std::make_shared<util::AtomicSharedPtr<detail::CircuitBreakers>>();
+
     void run(const std::function<void(const GrpcClientState&)>& connection_change_callback);
 
+    /// \brief Restart 'streams' at random times over 'window' unless the client reconnects or disconnects first
+    void schedule_stream_restarts(const std::vector<void*>& streams,
+                                  std::uint64_t connection_epoch,
+                                  std::chrono::milliseconds window,
+                                  std::minstd_rand* random);
+
+    /// \brief The queues for asynchronous calls, started the first time they are needed
+    detail::AsyncCallQueues& async_queues();
+
+    /// \brief Send a copy of a hedged call on channel 'index' (which must already be acquired)
+    template <typename Request, typename Response>
+    static void start_hedged_copy(detail::AsyncCallQueues* queues,
+                                  const std::shared_ptr<const Connection>& connection,
+                                  std::size_t index,
+                                  bool is_hedge,
+                                  StubAsyncUnaryFunc<Service, Request, Response> stub_func,
+                                  const Request& request,
+                                  const std::shared_ptr<detail::HedgedCall<Response>>& hedged);
+
+    /// \brief Replace the 'connection_' snapshot (call while 'shared_data_' is locked)
+    void publish_connection(const SharedData& data);
+
+    /// \brief The labels used in 'queue_' so we know which channel's state changed
+    static void* channel_tag(std::size_t index);
+    static std::size_t channel_index(void* tag);
+
+    static grpc_connectivity_state best_state(const std::vector<PooledChannel>& channels);
+
+    /// \brief Pick the ready channel for the stream registered as 'key' (if there is one) and add it to 'changes'
+    static void
+    start_stream(SharedData& data, void* key, GrpcClientStreamInterface<Service>& stream, StreamChanges* changes);
+
+    /// \brief Release the channel of the stream registered as 'key' and add the stream to 'changes'
+    static void
+    stop_stream(SharedData& data, void* key, GrpcClientStreamInterface<Service>& stream, StreamChanges* changes);
+
+    /// \brief Stop and start streams (call while 'streams_mutex_' is locked and 'shared_data_' is not)
+    static void apply_stream_changes(const StreamChanges& changes);
+
+    /// \brief Add a stream and start it if the client is connected
+    void add_stream(std::unique_ptr<GrpcClientStreamInterface<Service>> stream);
+
+    /// \brief Invoke 'func' with the blocking or asynchronous stream registered as 'key'
+    template <typename Result, typename Func>
+    void use_stream(void* key, const Func& func);
+
+    /// \brief Restart the stream registered as 'key' if it is running so it picks up new settings
+    void restart_stream(void* key);
+
     /// \brief Sets the `OnUpdate` callback for the given stream
     template <typename Result>
     void on_stream_update(void* key, StreamOnUpdate<Result> on_update);
 
+    /// \brief Sets the `OnUpdateBatch` callback for the given stream
+    template <typename Result>
+    void on_stream_update_batch(void* key, StreamOnUpdateBatch<Result> on_update_batch, UpdateBatching batching);
+
     /// \brief Sets the `OnFinish` callback for the given stream
     template <typename Result>
     void on_stream_finish(void* key, StreamOnFinish<Result> on_finish);
 
+    /// \brief Enables delta decoding for the given stream (restarting it if it is running)
+    template <typename Result>
+    void enable_stream_delta_decoding(void* key);
+
     /// \brief Allows callbacks to be set for `GrpcClientStream`s
     /// \tparam Result is the stream's result type
     template <typename Result>
@@ -165,32 +527,77 @@ private:
             return *this;
         }
 
+        ///
+        /// \brief Receive this stream's updates in batches instead of one 'on_update' call per message.
+        ///
+        /// Batches are invoked from the thread reading the stream or, once 'batching.max_delay' expires,
+        /// from one of the client's queue threads. They are never invoked at the same time.
+        /// A stream that is already running is restarted so it never reads while the batcher changes.
+        ///
+        GrpcClientStreamCallbackSetter<Result>& on_update_batch(StreamOnUpdateBatch<Result> on_update_batch,
+                                                                UpdateBatching batching = {}) {
+            client_.on_stream_update_batch<Result>(stream_, std::move(on_update_batch), batching);
+            return *this;
+        }
+
         /// \brief Set the OnFinish callback for this stream
         GrpcClientStreamCallbackSetter<Result>& on_finish(StreamOnFinish<Result> on_finish) {
             client_.on_stream_finish<Result>(stream_, std::move(on_finish));
             return *this;
         }
 
+        ///
+        /// \brief Ask the server for delta encoded updates and rebuild the full messages.
+        ///
+        /// A stream that is already running is restarted so the server learns about it.
+        ///
+        GrpcClientStreamCallbackSetter<Result>& enable_delta_decoding() {
+            client_.enable_stream_delta_decoding<Result>(stream_);
+            return *this;
+        }
+
     private:
         GrpcClient<Service>& client_;
         void* stream_;
     };
 };
 
+template <typename Service>
+GrpcClient<Service>::GrpcClient(int async_threads) : async_threads_(async_threads) {}
+
 template <typename Service>
 GrpcClient<Service>::~GrpcClient() {
     kill_streams_and_channel();
+    async_queues_ = nullptr;
 }
 
 template <typename Service>
 void GrpcClient<Service>::change_server(const std::string& address,
-                                        ConnectionChangeCallback connection_change_callback) {
+                                        ConnectionChangeCallback connection_change_callback,
+                                        ChannelPool channel_pool) {
+    change_server(std::vector<std::string>{address}, std::move(connection_change_callback), channel_pool);
+}
+
+template <typename Service>
+void GrpcClient<Service>::change_server(const std::vector<std::string>& addresses,
+                                        ConnectionChangeCallback connection_change_callback,
+                                        ChannelPool channel_pool) {
+    if (addresses.empty()) {
+        throw std::invalid_argument("At least one server address is needed");
+    }
+    if (channel_pool.size < 1) {
+        throw std::invalid_argument("A channel pool needs at least one channel");
+    }
+
     // Disconnect from the previous server
     kill_streams_and_channel();
 
     // Set the non-shared data
     using_in_process_server_ = false;
-    server_address_ = address;
+    server_address_ = addresses.front();
+    for (auto i = 1u; i < addresses.size(); ++i) {
+        server_address_ += "," + addresses[i];
+    }
     queue_ = std::make_unique<grpc::CompletionQueue>();
 
     bool state_changed = false;
@@ -198,23 +605,48 @@ void GrpcClient<Service>::change_server(const std::string& address,
 
     // Update the shared data
     shared_data_.use_safely([&](SharedData& data) {
-        // Create new channel to establish a connection
-        data.channel = grpc::CreateCustomChannel(server_address_,
-                                                 grpc::InsecureChannelCredentials(),
-                                                 client::default_channel_arguments());
-        data.stub = Service::NewStub(data.channel);
+        auto channel_count = addresses.size() * static_cast<std::size_t>(channel_pool.size);
+        ++data.connection_epoch;
+        data.balancer = std::make_shared<detail::ChannelBalancer>(channel_count, channel_pool);
+
+        // Create new channels to establish connections
+        for (const auto& address : addresses) {
+            for (int i = 0; i < channel_pool.size; ++i) {
+                auto index = data.channels.size();
+
+                auto arguments = (channel_count == 1u) ? client::default_channel_arguments()
+                                                       : client::pooled_channel_arguments(static_cast<int>(index));
+                apply_reconnect_backoff(data.reconnect_backoff, &arguments);
+
+                // Metrics come first so they also count the calls failed by an open circuit
+                std::vector<std::unique_ptr<grpc::experimental::ClientInterceptorFactoryInterface>> interceptors;
+                interceptors.emplace_back(std::make_unique<detail::CallMetricsInterceptorFactory>(call_metrics_));
+                interceptors.emplace_back(
+                    std::make_unique<detail::CircuitBreakerInterceptorFactory>(circuit_breakers_, address));
+
+                PooledChannel pooled;
+                pooled.channel = grpc::experimental::CreateCustomChannelWithInterceptors(
+                    address, grpc::InsecureChannelCredentials(), arguments, std::move(interceptors));
+                pooled.stub = Service::NewStub(pooled.channel);
+                pooled.state = pooled.channel->GetState(true);
+                data.balancer->set_ready(index, pooled.state == GRPC_CHANNEL_READY);
+
+                // Ask the channel to notify us when state changes by updating 'queue_'
+                auto deadline = std::chrono::system_clock::now() + std::chrono::seconds(15);
+                pooled.channel->NotifyOnStateChange(pooled.state, deadline, queue_.get(), channel_tag(index));
+
+                data.channels.emplace_back(std::move(pooled));
+            }
+        }
 
         // Get the current connection state and check if it has changed
-        auto new_state = data.channel->GetState(true);
+        auto new_state = best_state(data.channels);
 
         cnc_client_state = to_cnc_client_state(new_state);
         state_changed = (cnc_client_state != to_cnc_client_state(data.connection_state));
 
         data.connection_state = new_state;
-
-        // Ask the channel to notify us when state changes by updating 'queue_'
-        auto deadline = std::chrono::system_clock::now() + std::chrono::seconds(15);
-        data.channel->NotifyOnStateChange(data.connection_state, deadline, queue_.get(), connection_change_tag);
+        publish_connection(data);
     });
 
     if (state_changed) {
@@ -233,47 +665,105 @@ void GrpcClient<Service>::change_server(std::shared_ptr<grpc::Channel> in_proces
     using_in_process_server_ = true;
     server_address_ = "In-Process";
 
-    shared_data_.use_safely([in_process_channel = std::move(in_process_channel)](SharedData& data) {
-        data.channel = in_process_channel;
-        data.stub = Service::NewStub(data.channel);
+    std::lock_guard<std::mutex> streams_lock(streams_mutex_);
+
+    StreamChanges stream_changes;
+    shared_data_.use_safely([&](SharedData& data) {
+        PooledChannel pooled;
+        pooled.channel = in_process_channel;
+        pooled.stub = Service::NewStub(pooled.channel);
 
         // No connectivity updates need to happen because the server is running in the same process
+        pooled.state = GRPC_CHANNEL_READY;
+        data.channels.emplace_back(std::move(pooled));
+
+        data.balancer = std::make_shared<detail::ChannelBalancer>(1u, ChannelPool{});
+        data.balancer->set_ready(0u, true);
+
         data.connection_state = GRPC_CHANNEL_READY;
+        publish_connection(data);
+
+        // Connected right away so start the streams that were registered first
+        for (auto& stream_pair : data.streams) {
+            start_stream(data, stream_pair.first, *stream_pair.second, &stream_changes);
+        }
+    });
+    shared_data_.notify_all();
+
+    apply_stream_changes(stream_changes);
+}
+
+template <typename Service>
+void GrpcClient<Service>::change_server(std::shared_ptr<grpc::Channel> in_process_channel,
+                                        grpc::Service* in_process_service) {
+    auto* direct_service = dynamic_cast<typename Service::Service*>(in_process_service);
+    if (not direct_service) {
+        throw std::invalid_argument("The in-process service does not implement this client's service");
+    }
+
+    change_server(std::move(in_process_channel));
+
+    shared_data_.use_safely([this, direct_service](SharedData& data) {
+        data.direct_service = direct_service;
+        publish_connection(data);
     });
 }
 
 template <typename Service>
 template <typename Result>
 auto GrpcClient<Service>::register_stream(StreamInitFunc<Result> init_func) -> GrpcClientStreamCallbackSetter<Result> {
-    void* key;
-
-    shared_data_.use_safely([init_func = std::move(init_func), &key](SharedData& data) {
-        auto stream = std::make_unique<GrpcClientStream<Service, Result>>(std::move(init_func));
+    auto stream = std::make_unique<GrpcClientStream<Service, Result>>(std::move(init_func));
+    void* key = stream.get();
 
-        // Start the stream if the channel is already connected
-        if (data.channel and data.connection_state == GRPC_CHANNEL_READY) {
-            stream->start_stream(*data.stub);
-        }
+    add_stream(std::move(stream));
+    return {*this, key};
+}
 
-        key = stream.get();
-        data.streams.emplace(key, std::move(stream));
-    });
+template <typename Service>
+template <typename Result>
+auto GrpcClient<Service>::register_stream(AsyncStreamInitFunc<Result> init_func)
+    -> GrpcClientStreamCallbackSetter<Result> {
+    auto stream = std::make_unique<GrpcClientAsyncStream<Service, Result>>(std::move(init_func), &async_queues());
+    void* key = stream.get();
 
+    add_stream(std::move(stream));
     return {*this, key};
 }
 
 template <typename Service>
-void GrpcClient<Service>::kill_streams_and_channel() {
-    shared_data_.use_safely([](SharedData& data) {
-        for (auto& stream_pair : data.streams) {
-            stream_pair.second->stop_stream();
-        }
+template <typename Result, typename InitFunc>
+void GrpcClient<Service>::register_cache_invalidation_stream(InitFunc init_func,
+                                                             std::function<std::string(const Result&)> key_of) {
+    register_stream<Result>(std::move(init_func))
+        .on_update([this, key_of = std::move(key_of)](Result&& result) { invalidate_cache(key_of(result)); })
+        .on_finish([this](const grpc::Status&) { invalidate_cache(); });
+}
 
-        // Delete the stub and channel first to trigger the shutdown events in the channel.
-        // ('data.stub' has a shared pointer to channel so it needs to be deleted too)
-        data.stub = nullptr;
-        data.channel = nullptr;
-    });
+template <typename Service>
+void GrpcClient<Service>::kill_streams_and_channel() {
+    {
+        // Held until the channels are gone so the run thread can't start the streams again
+        std::lock_guard<std::mutex> streams_lock(streams_mutex_);
+
+        StreamChanges stream_changes;
+        shared_data_.use_safely([&stream_changes](SharedData& data) {
+            ++data.connection_epoch;
+            for (auto& stream_pair : data.streams) {
+                stop_stream(data, stream_pair.first, *stream_pair.second, &stream_changes);
+            }
+        });
+        apply_stream_changes(stream_changes);
+
+        shared_data_.use_safely([this](SharedData& data) {
+            // Delete the stubs and channels first to trigger the shutdown events in the channels.
+            // (the stubs have a shared pointer to their channel so they need to be deleted too,
+            // calls that are still in flight hold their own reference until they finish)
+            data.channels.clear();
+            data.balancer = nullptr;
+            data.direct_service = nullptr;
+            publish_connection(data);
+        });
+    }
 
     // Tell the queue to exit once all its current items have been popped
     if (queue_) {
@@ -286,6 +776,66 @@ void GrpcClient<Service>::kill_streams_and_channel() {
     }
 }
 
+template <typename Service>
+template <typename TimePoint>
+bool GrpcClient<Service>::connect_and_wait(const TimePoint& deadline) {
+    auto all_connected = [](const SharedData& data) {
+        return not data.channels.empty()
+            and std::all_of(data.channels.begin(), data.channels.end(), [](const PooledChannel& pooled) {
+                   return pooled.state == GRPC_CHANNEL_READY;
+               });
+    };
+    return shared_data_.wait_to_use_safely_until(deadline, all_connected, [](const SharedData&) {});
+}
+
+template <typename Service>
+void GrpcClient<Service>::set_reconnect_backoff(const ReconnectBackoff& backoff) {
+    if (backoff.initial_backoff.count() <= 0 or backoff.min_connect_timeout.count() <= 0) {
+        throw std::invalid_argument("Reconnect delays must be positive");
+    }
+    if (backoff.max_backoff < backoff.initial_backoff) {
+        throw std::invalid_argument("The max reconnect backoff can't be less than the initial backoff");
+    }
+    if (backoff.stream_restart_window.count() < 0) {
+        throw std::invalid_argument("The stream restart window can't be negative");
+    }
+
+    shared_data_.use_safely([&backoff](SharedData& data) { data.reconnect_backoff = backoff; });
+}
+
+template <typename Service>
+void GrpcClient<Service>::set_circuit_breaking(const CircuitBreaking& options,
+                                               CircuitChangeCallback circuit_change_callback) {
+    circuit_breakers_->store(std::make_shared<detail::CircuitBreakers>(options, std::move(circuit_change_callback)));
+}
+
+template <typename Service>
+void GrpcClient<Service>::disable_circuit_breaking() {
+    circuit_breakers_->store(nullptr);
+}
+
+template <typename Service>
+CircuitState GrpcClient<Service>::get_circuit_state(const std::string& method, const std::string& address) const {
+    auto circuit_breakers = circuit_breakers_->load();
+    return circuit_breakers ? circuit_breakers->state(method, address) : CircuitState::closed;
+}
+
+template <typename Service>
+void GrpcClient<Service>::enable_call_metrics() {
+    call_metrics_->store(std::make_shared<detail::CallMetricsRecorder>());
+}
+
+template <typename Service>
+std::vector<MethodMetrics> GrpcClient<Service>::call_metrics() const {
+    auto recorder = call_metrics_->load();
+    return recorder ? recorder->snapshot() : std::vector<MethodMetrics>{};
+}
+
+template <typename Service>
+void GrpcClient<Service>::write_call_metrics(const std::string& path) const {
+    write_prometheus_metrics_file(path, call_metrics());
+}
+
 template <typename Service>
 const std::string& GrpcClient<Service>::get_server_address() const {
     return server_address_;
@@ -306,16 +856,452 @@ bool GrpcClient<Service>::is_using_in_process_server() const {
 template <typename Service>
 template <typename UsageFunc>
 bool GrpcClient<Service>::use_stub(const UsageFunc& usage_func) {
-    bool stub_valid = false;
+    auto connection = connection_.load();
+    std::size_t index;
 
-    shared_data_.use_safely([&](const SharedData& data) {
-        if (data.connection_state == GRPC_CHANNEL_READY) {
-            stub_valid = true;
-            usage_func(*data.stub);
+    if (not connection or not connection->balancer->acquire(&index)) {
+        return false;
+    }
+
+    try {
+        usage_func(*connection->stubs[index]);
+    } catch (...) {
+        connection->balancer->release(index);
+        throw;
+    }
+    connection->balancer->release(index);
+    return true;
+}
+
+template <typename Service>
+template <typename Request, typename Response>
+grpc::Status GrpcClient<Service>::call(StubUnaryFunc<Service, Request, Response> stub_func,
+                                       ServiceUnaryFunc<Service, Request, Response> service_func,
+                                       const Request& request,
+                                       Response* response) {
+    auto connection = connection_.load();
+    std::size_t index;
+
+    if (connection and connection->direct_service) {
+        // The handler runs on this thread so direct calls never wait on each other
+        grpc::ServerContext context;
+        try {
+            return (connection->direct_service->*service_func)(&context, &request, response);
+        } catch (const std::exception& e) {
+            // Match what a gRPC server reports when a handler throws
+            return {grpc::StatusCode::UNKNOWN, e.what()};
+        }
+    }
+
+    if (not connection or not connection->balancer->acquire(&index)) {
+        return {grpc::StatusCode::UNAVAILABLE, "Client is not connected to a server"};
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    grpc::ClientContext context;
+    auto status = ((*connection->stubs[index]).*stub_func)(&context, request, response);
+
+    connection->balancer->release(index, status, std::chrono::steady_clock::now() - start);
+    return status;
+}
+
+template <typename Service>
+template <typename Request, typename Response>
+void GrpcClient<Service>::call_async(StubAsyncUnaryFunc<Service, Request, Response> stub_func,
+                                     const Request& request,
+                                     OnCallDone<Response> on_done) {
+    auto connection = connection_.load();
+    std::size_t index;
+
+    if (not connection or not connection->balancer->acquire(&index)) {
+        if (on_done) {
+            on_done({grpc::StatusCode::UNAVAILABLE, "Client is not connected to a server"}, Response{});
+        }
+        return;
+    }
+
+    // The balancer is kept alive by the callback so the call can be released from its channel
+    auto on_finish = [balancer = connection->balancer,
+                      index,
+                      start = std::chrono::steady_clock::now(),
+                      on_done = std::move(on_done)](grpc::Status status, Response response) {
+        balancer->release(index, status, std::chrono::steady_clock::now() - start);
+        if (on_done) {
+            on_done(std::move(status), std::move(response));
+        }
+    };
+
+    auto call = std::make_unique<detail::UnaryAsyncCall<Response>>(std::move(on_finish));
+
+    bool started = async_queues().start(call.get(), [&](grpc::CompletionQueue* queue) {
+        call->reader = ((*connection->stubs[index]).*stub_func)(&call->context, request, queue);
+        call->reader->Finish(&call->response, &call->status, call.get());
+    });
+
+    if (started) {
+        // Owned by the queue from here on and deleted after 'on_done' is invoked
+        call.release();
+    } else {
+        call->status = {grpc::StatusCode::CANCELLED, "The client is shutting down"};
+        call->on_complete(false);
+    }
+}
+
+template <typename Service>
+template <typename Request, typename Response>
+std::future<CallResult<Response>>
+GrpcClient<Service>::call_async(StubAsyncUnaryFunc<Service, Request, Response> stub_func, const Request& request) {
+    auto promise = std::make_shared<std::promise<CallResult<Response>>>();
+    auto future = promise->get_future();
+
+    call_async(stub_func, request, [promise](grpc::Status status, Response response) {
+        promise->set_value({std::move(status), std::move(response)});
+    });
+
+    return future;
+}
+
+template <typename Service>
+void GrpcClient<Service>::set_hedging_policy(const HedgingPolicy& policy) {
+    hedging_.store(std::make_shared<detail::HedgingTracker>(policy));
+}
+
+template <typename Service>
+HedgingStats GrpcClient<Service>::hedging_stats() const {
+    auto tracker = hedging_.load();
+    return tracker ? tracker->stats() : HedgingStats{};
+}
+
+template <typename Service>
+template <typename Request, typename Response>
+void GrpcClient<Service>::call_hedged(StubAsyncUnaryFunc<Service, Request, Response> stub_func,
+                                      const Request& request,
+                                      OnCallDone<Response> on_done) {
+    auto tracker = hedging_.load();
+    if (not tracker) {
+        call_async(stub_func, request, std::move(on_done));
+        return;
+    }
+
+    auto connection = connection_.load();
+    std::size_t index;
+
+    if (not connection or not connection->balancer->acquire(&index)) {
+        if (on_done) {
+            on_done({grpc::StatusCode::UNAVAILABLE, "Client is not connected to a server"}, Response{});
+        }
+        return;
+    }
+
+    auto* queues = &async_queues();
+    std::chrono::nanoseconds hedge_delay;
+    bool can_hedge = tracker->start_call(&hedge_delay);
+
+    auto hedged = std::make_shared<detail::HedgedCall<Response>>(std::move(on_done), tracker);
+    start_hedged_copy(queues, connection, index, false, stub_func, request, hedged);
+
+    if (not can_hedge) {
+        return;
+    }
+
+    // The timer doesn't use the client, only the connection snapshot. The queues cancel it before they're destroyed.
+    auto send_hedge = [queues, connection, index, stub_func, request, hedged](bool fired) {
+        std::size_t hedge_index;
+
+        if (not hedged->timer_done(fired) or not connection->balancer->acquire(&hedge_index, index)) {
+            return;
+        }
+        if (not hedged->tracker().try_send_hedge()) {
+            connection->balancer->release(hedge_index);
+            return;
         }
+        start_hedged_copy(queues, connection, hedge_index, true, stub_func, request, hedged);
+    };
+    auto timer = std::make_unique<detail::AsyncAlarm>(std::move(send_hedge));
+
+    auto deadline = std::chrono::system_clock::now()
+        + std::chrono::duration_cast<std::chrono::system_clock::duration>(hedge_delay);
+
+    // Tracked first because the timer can fire (and be deleted) as soon as it's set
+    if (not hedged->add_timer(timer.get())) {
+        return;
+    }
+
+    bool started = queues->start(timer.get(), [&](grpc::CompletionQueue* queue) {
+        timer->alarm.Set(queue, deadline, timer.get());
     });
 
-    return stub_valid;
+    if (started) {
+        // Owned by the queue like the calls
+        timer.release();
+    } else {
+        // Forgotten before it's deleted
+        hedged->timer_done(false);
+    }
+}
+
+template <typename Service>
+template <typename Request, typename Response>
+std::future<CallResult<Response>>
+GrpcClient<Service>::call_hedged(StubAsyncUnaryFunc<Service, Request, Response> stub_func, const Request& request) {
+    auto promise = std::make_shared<std::promise<CallResult<Response>>>();
+    auto future = promise->get_future();
+
+    call_hedged(stub_func, request, [promise](grpc::Status status, Response response) {
+        promise->set_value({std::move(status), std::move(response)});
+    });
+
+    return future;
+}
+
+template <typename Service>
+template <typename Request, typename Response, typename BatchRequest, typename BatchResponse>
+UnaryCallBatcher<Request, Response>
+GrpcClient<Service>::batch_calls(StubAsyncUnaryFunc<Service, BatchRequest, BatchResponse> batch_func,
+                                 CallBatching batching) {
+    using PendingCall = typename UnaryCallBatcher<Request, Response>::PendingCall;
+
+    const auto* request_field = util::batch_field(*BatchRequest::descriptor(), *Request::descriptor());
+    const auto* response_field = util::batch_field(*BatchResponse::descriptor(), *Response::descriptor());
+    const auto* status_field = util::batch_status_field(*BatchResponse::descriptor());
+
+    auto send_batch = [this, batch_func, request_field, response_field, status_field](
+                          std::vector<PendingCall>&& calls) {
+        BatchRequest batch;
+        std::vector<OnCallDone<Response>> on_dones;
+        on_dones.reserve(calls.size());
+
+        for (auto& call : calls) {
+            *util::add_batch_item<Request>(&batch, request_field) = std::move(call.request);
+            on_dones.emplace_back(std::move(call.on_done));
+        }
+
+        auto on_batch_done = [response_field, status_field, on_dones = std::move(on_dones)](grpc::Status status,
+                                                                                              BatchResponse response) {
+            auto responses = util::batch_size(response, response_field);
+            auto statuses = status_field ? util::batch_size(response, status_field) : 0;
+
+            if (status.ok() and static_cast<std::size_t>(responses) != on_dones.size()) {
+                status = {grpc::StatusCode::INTERNAL,
+                          "The batch response has " + std::to_string(responses) + " responses for "
+                              + std::to_string(on_dones.size()) + " requests"};
+            } else if (status.ok() and statuses != 0 and static_cast<std::size_t>(statuses) != on_dones.size()) {
+                status = {grpc::StatusCode::INTERNAL,
+                          "The batch response has " + std::to_string(statuses) + " statuses for "
+                              + std::to_string(on_dones.size()) + " requests"};
+            }
+
+            for (auto i = 0u; i < on_dones.size(); ++i) {
+                if (not on_dones[i]) {
+                    continue;
+                }
+                auto index = static_cast<int>(i);
+
+                auto item_status = status;
+                if (status.ok() and statuses != 0) {
+                    item_status = util::batch_status(response, status_field, index);
+                }
+
+                Response item;
+                if (item_status.ok()) {
+                    item = std::move(*util::mutable_batch_item<Response>(&response, response_field, index));
+                }
+                on_dones[i](item_status, std::move(item));
+            }
+        };
+
+        call_async(batch_func, batch, std::move(on_batch_done));
+    };
+
+    return {std::move(send_batch), batching, &async_queues()};
+}
+
+template <typename Service>
+void GrpcClient<Service>::enable_response_cache(const ResponseCaching& caching) {
+    response_cache_.store(std::make_shared<detail::ResponseCache>(caching));
+}
+
+template <typename Service>
+ResponseCacheStats GrpcClient<Service>::response_cache_stats() const {
+    auto cache = response_cache_.load();
+    return cache ? cache->stats() : ResponseCacheStats{};
+}
+
+template <typename Service>
+void GrpcClient<Service>::invalidate_cache(const std::string& invalidation_key) {
+    if (auto cache = response_cache_.load()) {
+        cache->invalidate(invalidation_key);
+    }
+}
+
+template <typename Service>
+template <typename Request, typename Response>
+grpc::Status GrpcClient<Service>::call_cached(const std::string& method_name,
+                                              StubUnaryFunc<Service, Request, Response> stub_func,
+                                              ServiceUnaryFunc<Service, Request, Response> service_func,
+                                              const Request& request,
+                                              Response* response,
+                                              const std::string& invalidation_key) {
+    // Checked even without a cache so a wrong name is found right away
+    auto method = util::method_path(Service::service_full_name(),
+                                    method_name,
+                                    Request::descriptor(),
+                                    Response::descriptor(),
+                                    false);
+
+    auto cache = response_cache_.load();
+    if (not cache) {
+        return call(stub_func, service_func, request, response);
+    }
+
+    // The path identifies the method (and so the response type) the same way in every build
+    auto key = detail::ResponseCache::make_key(method, request);
+
+    std::uint64_t generation;
+    if (auto cached = cache->find(key, &generation)) {
+        response->CopyFrom(static_cast<const Response&>(*cached));
+        return grpc::Status::OK;
+    }
+
+    auto status = call(stub_func, service_func, request, response);
+    if (status.ok()) {
+        cache->insert(key, invalidation_key, std::make_shared<const Response>(*response), generation);
+    }
+    return status;
+}
+
+template <typename Service>
+detail::AsyncCallQueues& GrpcClient<Service>::async_queues() {
+    std::call_once(async_queues_started_, [this] {
+        async_queues_ = std::make_unique<detail::AsyncCallQueues>(async_threads_);
+    });
+    return *async_queues_;
+}
+
+template <typename Service>
+template <typename Request, typename Response>
+void GrpcClient<Service>::start_hedged_copy(detail::AsyncCallQueues* queues,
+                                            const std::shared_ptr<const Connection>& connection,
+                                            std::size_t index,
+                                            bool is_hedge,
+                                            StubAsyncUnaryFunc<Service, Request, Response> stub_func,
+                                            const Request& request,
+                                            const std::shared_ptr<detail::HedgedCall<Response>>& hedged) {
+    auto copy = std::make_unique<detail::HedgedCopy<Response>>(hedged, connection->balancer, index, is_hedge);
+
+    // Tracked first because the copy can finish (and be deleted) as soon as it's started
+    if (not hedged->add_copy(copy.get())) {
+        connection->balancer->release(index);
+        return;
+    }
+
+    bool started = queues->start(copy.get(), [&](grpc::CompletionQueue* queue) {
+        copy->reader = ((*connection->stubs[index]).*stub_func)(&copy->context, request, queue);
+        copy->reader->Finish(&copy->response, &copy->status, copy.get());
+    });
+
+    if (started) {
+        copy.release();
+    } else {
+        // Releases the channel and, if no other copy is in flight, finishes the call
+        copy->status = {grpc::StatusCode::CANCELLED, "The client is shutting down"};
+        copy->on_complete(false);
+    }
+}
+
+template <typename Service>
+void GrpcClient<Service>::publish_connection(const SharedData& data) {
+    // In-process clients stay 'ready' after the channel is killed so check the channels too
+    if (data.channels.empty() or data.connection_state != GRPC_CHANNEL_READY) {
+        connection_.store(nullptr);
+        return;
+    }
+
+    auto connection = std::make_shared<Connection>();
+    for (const auto& pooled : data.channels) {
+        connection->stubs.emplace_back(pooled.stub);
+    }
+    connection->direct_service = data.direct_service;
+    connection->balancer = data.balancer;
+
+    connection_.store(std::move(connection));
+}
+
+template <typename Service>
+void* GrpcClient<Service>::channel_tag(std::size_t index) {
+    // Offset by one so no tag is null
+    return reinterpret_cast<void*>(index + 1u);
+}
+
+template <typename Service>
+std::size_t GrpcClient<Service>::channel_index(void* tag) {
+    return reinterpret_cast<std::uintptr_t>(tag) - 1u;
+}
+
+template <typename Service>
+grpc_connectivity_state GrpcClient<Service>::best_state(const std::vector<PooledChannel>& channels) {
+    // From least to most connected
+    auto rank = [](grpc_connectivity_state state) {
+        switch (state) {
+        case GRPC_CHANNEL_SHUTDOWN:
+            return 0;
+        case GRPC_CHANNEL_IDLE:
+            return 1;
+        case GRPC_CHANNEL_TRANSIENT_FAILURE:
+            return 2;
+        case GRPC_CHANNEL_CONNECTING:
+            return 3;
+        case GRPC_CHANNEL_READY:
+            return 4;
+        }
+        return 0;
+    };
+
+    auto best = GRPC_CHANNEL_SHUTDOWN;
+    for (const auto& pooled : channels) {
+        if (rank(pooled.state) > rank(best)) {
+            best = pooled.state;
+        }
+    }
+    return best;
+}
+
+template <typename Service>
+void GrpcClient<Service>::start_stream(SharedData& data,
+                                       void* key,
+                                       GrpcClientStreamInterface<Service>& stream,
+                                       StreamChanges* changes) {
+    // Not started at all without a ready channel, it is started again when one connects
+    std::size_t index;
+    if (data.stream_channels.count(key) > 0u or not data.balancer or not data.balancer->acquire_stream(&index)) {
+        return;
+    }
+    data.stream_channels.emplace(key, index);
+    changes->starts.emplace_back(&stream, data.channels[index].stub);
+}
+
+template <typename Service>
+void GrpcClient<Service>::stop_stream(SharedData& data,
+                                      void* key,
+                                      GrpcClientStreamInterface<Service>& stream,
+                                      StreamChanges* changes) {
+    auto channel = data.stream_channels.find(key);
+    if (channel != data.stream_channels.end()) {
+        data.balancer->release_stream(channel->second);
+        data.stream_channels.erase(channel);
+    }
+    changes->stops.emplace_back(&stream);
+}
+
+template <typename Service>
+void GrpcClient<Service>::apply_stream_changes(const StreamChanges& changes) {
+    for (auto* stream : changes.stops) {
+        stream->stop_stream();
+    }
+    for (const auto& start : changes.starts) {
+        start.first->start_stream(*start.second);
+    }
 }
 
 // This function is run from the 'run_thread_' thread
@@ -324,34 +1310,76 @@ void GrpcClient<Service>::run(const std::function<void(const GrpcClientState&)>&
 
     GrpcClientState cnc_client_state;
 
+    // Picks when each stream is restarted
+    std::minstd_rand random(std::random_device{}());
+
     void* current_tag; // A label so se can identify the current update
     bool result_ok; // Set to false if the queue receives updates due to cancellation (like hitting our deadline)
 
     while (queue_->Next(&current_tag, &result_ok)) {
 
-        // The queue is currently only set up to receive connection changes
-        assert(current_tag == connection_change_tag);
+        // The queue is only set up to receive connection changes, tagged with the channel's index
+        auto index = channel_index(current_tag);
 
         bool state_changed = false;
 
+        std::vector<void*> streams_to_restart;
+        std::uint64_t connection_epoch = 0u;
+        std::chrono::milliseconds restart_window{0};
+
+        std::unique_lock<std::mutex> streams_lock(streams_mutex_);
+
+        StreamChanges stream_changes;
         shared_data_.use_safely([&](SharedData& data) {
-            if (data.channel) { // not shutdown yet
+            if (index < data.channels.size()) { // not shutdown yet
+                auto& pooled = data.channels[index];
 
                 if (result_ok) {
+                    pooled.state = pooled.channel->GetState(true);
+                    data.balancer->set_ready(index, pooled.state == GRPC_CHANNEL_READY);
+
                     auto old_client_state = to_cnc_client_state(data.connection_state);
-                    data.connection_state = data.channel->GetState(true);
+                    data.connection_state = best_state(data.channels);
                     cnc_client_state = to_cnc_client_state(data.connection_state);
 
                     state_changed = (cnc_client_state != old_client_state);
 
                     if (state_changed) {
-                        if (data.connection_state == GRPC_CHANNEL_READY) {
+                        publish_connection(data);
+                        connection_epoch = ++data.connection_epoch;
+                        restart_window = data.reconnect_backoff.stream_restart_window;
+
+                        if (data.connection_state == GRPC_CHANNEL_READY and restart_window.count() > 0) {
+                            // Restarted later, and one at a time, so reconnecting clients don't all restart at once
+                            for (auto& stream_pair : data.streams) {
+                                streams_to_restart.emplace_back(stream_pair.first);
+                            }
+                        } else if (data.connection_state == GRPC_CHANNEL_READY) {
                             for (auto& stream_pair : data.streams) {
-                                stream_pair.second->start_stream(*data.stub);
+                                start_stream(data, stream_pair.first, *stream_pair.second, &stream_changes);
                             }
                         } else {
                             for (auto& stream_pair : data.streams) {
-                                stream_pair.second->stop_stream();
+                                stop_stream(data, stream_pair.first, *stream_pair.second, &stream_changes);
+                            }
+                        }
+
+                    } else if (pooled.state != GRPC_CHANNEL_READY and data.connection_state == GRPC_CHANNEL_READY) {
+                        // Another channel is still ready so move the streams that were using this one
+                        connection_epoch = data.connection_epoch;
+                        restart_window = data.reconnect_backoff.stream_restart_window;
+
+                        for (auto& stream_pair : data.streams) {
+                            auto channel = data.stream_channels.find(stream_pair.first);
+                            if (channel == data.stream_channels.end() or channel->second != index) {
+                                continue;
+                            }
+
+                            stop_stream(data, stream_pair.first, *stream_pair.second, &stream_changes);
+                            if (restart_window.count() > 0) {
+                                streams_to_restart.emplace_back(stream_pair.first);
+                            } else {
+                                start_stream(data, stream_pair.first, *stream_pair.second, &stream_changes);
                             }
                         }
                     }
@@ -359,7 +1387,7 @@ void GrpcClient<Service>::run(const std::function<void(const GrpcClientState&)>&
 
                 // Tell the channel to keep sending connection updates using this same queue
                 auto deadline = std::chrono::high_resolution_clock::now() + std::chrono::seconds(60);
-                data.channel->NotifyOnStateChange(data.connection_state, deadline, queue_.get(), connection_change_tag);
+                pooled.channel->NotifyOnStateChange(pooled.state, deadline, queue_.get(), channel_tag(index));
 
             } else if (to_cnc_client_state(data.connection_state) != GrpcClientState::not_connected) {
                 // The channel has been shutdown but the state is not set so do not disconnected yet.
@@ -370,6 +1398,16 @@ void GrpcClient<Service>::run(const std::function<void(const GrpcClientState&)>&
             }
         });
 
+        // Wake up 'connect_and_wait'
+        shared_data_.notify_all();
+
+        apply_stream_changes(stream_changes);
+        streams_lock.unlock();
+
+        if (not streams_to_restart.empty()) {
+            schedule_stream_restarts(streams_to_restart, connection_epoch, restart_window, &random);
+        }
+
         // Do the callback outside the locked code to prevent the user from deadlocking the program.
         if (state_changed) {
             connection_change_callback(cnc_client_state);
@@ -378,33 +1416,131 @@ void GrpcClient<Service>::run(const std::function<void(const GrpcClientState&)>&
 }
 
 template <typename Service>
-template <typename Result>
-void GrpcClient<Service>::on_stream_update(void* key, StreamOnUpdate<Result> on_update) {
-    shared_data_.use_safely([on_update = std::move(on_update), &key](SharedData& data) {
+void GrpcClient<Service>::schedule_stream_restarts(const std::vector<void*>& streams,
+                                                   std::uint64_t connection_epoch,
+                                                   std::chrono::milliseconds window,
+                                                   std::minstd_rand* random) {
+    std::uniform_int_distribution<std::chrono::microseconds::rep> delay_us(
+        0, std::chrono::duration_cast<std::chrono::microseconds>(window).count());
+    auto now = std::chrono::system_clock::now();
+
+    for (void* key : streams) {
+        // The queues cancel the timers before the client is destroyed
+        auto restart = [this, key, connection_epoch](bool fired) {
+            if (not fired) {
+                return;
+            }
+            std::lock_guard<std::mutex> streams_lock(streams_mutex_);
+
+            StreamChanges stream_changes;
+            shared_data_.use_safely([&](SharedData& data) {
+                auto iter = data.streams.find(key);
+                if (data.connection_epoch == connection_epoch and iter != data.streams.end()) {
+                    start_stream(data, key, *iter->second, &stream_changes);
+                }
+            });
+            apply_stream_changes(stream_changes);
+        };
+        auto timer = std::make_unique<detail::AsyncAlarm>(std::move(restart));
+
+        auto deadline = now + std::chrono::microseconds(delay_us(*random));
+
+        bool started = async_queues().start(timer.get(), [&](grpc::CompletionQueue* queue) {
+            timer->alarm.Set(queue, deadline, timer.get());
+        });
+
+        if (started) {
+            // Owned by the queue like the calls
+            timer.release();
+        }
+    }
+}
+
+template <typename Service>
+void GrpcClient<Service>::add_stream(std::unique_ptr<GrpcClientStreamInterface<Service>> stream) {
+    std::lock_guard<std::mutex> streams_lock(streams_mutex_);
+
+    StreamChanges stream_changes;
+    shared_data_.use_safely([&](SharedData& data) {
+        void* key = stream.get();
+
+        // Start the stream if the channel is already connected
+        if (data.connection_state == GRPC_CHANNEL_READY) {
+            start_stream(data, key, *stream, &stream_changes);
+        }
+
+        data.streams.emplace(key, std::move(stream));
+    });
+    apply_stream_changes(stream_changes);
+}
+
+template <typename Service>
+template <typename Result, typename Func>
+void GrpcClient<Service>::use_stream(void* key, const Func& func) {
+    std::lock_guard<std::mutex> streams_lock(streams_mutex_);
+
+    shared_data_.use_safely([key, &func](SharedData& data) {
         auto iter = data.streams.find(key);
         if (iter == data.streams.end()) {
             return;
         }
-        auto* stream = dynamic_cast<GrpcClientStream<Service, Result>*>(iter->second.get());
+
+        if (auto* stream = dynamic_cast<GrpcClientStream<Service, Result>*>(iter->second.get())) {
+            func(*stream);
+            return;
+        }
+        auto* stream = dynamic_cast<GrpcClientAsyncStream<Service, Result>*>(iter->second.get());
         assert(stream);
 
-        stream->on_update(std::move(on_update));
+        func(*stream);
     });
 }
 
 template <typename Service>
-template <typename Result>
-void GrpcClient<Service>::on_stream_finish(void* key, StreamOnFinish<Result> on_finish) {
-    shared_data_.use_safely([on_finish = std::move(on_finish), &key](SharedData& data) {
+void GrpcClient<Service>::restart_stream(void* key) {
+    std::lock_guard<std::mutex> streams_lock(streams_mutex_);
+
+    StreamChanges stream_changes;
+    shared_data_.use_safely([key, &stream_changes](SharedData& data) {
         auto iter = data.streams.find(key);
-        if (iter == data.streams.end()) {
+        if (iter == data.streams.end() or data.stream_channels.count(key) == 0u) {
             return;
         }
-        auto* stream = dynamic_cast<GrpcClientStream<Service, Result>*>(iter->second.get());
-        assert(stream);
 
-        stream->on_finish(std::move(on_finish));
+        stop_stream(data, key, *iter->second, &stream_changes);
+        start_stream(data, key, *iter->second, &stream_changes);
     });
+    apply_stream_changes(stream_changes);
+}
+
+template <typename Service>
+template <typename Result>
+void GrpcClient<Service>::on_stream_update(void* key, StreamOnUpdate<Result> on_update) {
+    use_stream<Result>(key, [&on_update](auto& stream) { stream.on_update(std::move(on_update)); });
+}
+
+template <typename Service>
+template <typename Result>
+void GrpcClient<Service>::on_stream_update_batch(void* key,
+                                                 StreamOnUpdateBatch<Result> on_update_batch,
+                                                 UpdateBatching batching) {
+    auto* queues = &async_queues();
+    use_stream<Result>(key,
+                       [&](auto& stream) { stream.on_update_batch(std::move(on_update_batch), batching, queues); });
+    restart_stream(key);
+}
+
+template <typename Service>
+template <typename Result>
+void GrpcClient<Service>::on_stream_finish(void* key, StreamOnFinish<Result> on_finish) {
+    use_stream<Result>(key, [&on_finish](auto& stream) { stream.on_finish(std::move(on_finish)); });
+}
+
+template <typename Service>
+template <typename Result>
+void GrpcClient<Service>::enable_stream_delta_decoding(void* key) {
+    use_stream<Result>(key, [](auto& stream) { stream.enable_delta_decoding(); });
+    restart_stream(key);
 }
 
 } // namespace client
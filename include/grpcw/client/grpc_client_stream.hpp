@@ -22,12 +22,20 @@
 // ///////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 
+// grpcw
+#include "grpcw/client/detail/async_stream_call.hpp"
+#include "grpcw/client/detail/update_batcher.hpp"
+#include "grpcw/client/update_batching.hpp"
+#include "grpcw/util/delta_encoding.hpp"
+
 // third-party
 #include <grpc++/client_context.h>
 
 // standard
 #include <functional>
+#include <memory>
 #include <thread>
+#include <vector>
 
 namespace grpcw {
 namespace client {
@@ -44,12 +52,16 @@ public:
 template <typename Service>
 GrpcClientStreamInterface<Service>::~GrpcClientStreamInterface() = default;
 
+/**
+ * @brief A server stream read by its own thread with a blocking 'ClientReader'
+ */
 template <typename Service, typename Return>
 class GrpcClientStream : public GrpcClientStreamInterface<Service> {
 public:
     using InitFunc = std::function<std::unique_ptr<grpc_impl::ClientReader<Return>>(typename Service::Stub&,
                                                                                     grpc::ClientContext*)>;
     using OnUpdate = std::function<void(Return&&)>;
+    using OnUpdateBatch = std::function<void(std::vector<Return>&&)>;
     using OnFinish = std::function<void(const grpc::Status&)>;
 
     explicit GrpcClientStream(InitFunc init_func);
@@ -62,6 +74,15 @@ public:
     GrpcClientStream<Service, Return>& on_update(OnUpdate on_update);
     GrpcClientStream<Service, Return>& on_finish(OnFinish on_finish);
 
+    /// \brief Deliver updates in batches instead of calling `OnUpdate` ('timer_queues' enforce 'max_delay')
+    /// \note Only applies to streams started afterwards
+    GrpcClientStream<Service, Return>&
+    on_update_batch(OnUpdateBatch on_update_batch, UpdateBatching batching, detail::AsyncCallQueues* timer_queues);
+
+    /// \brief Ask the server for delta encoded updates and rebuild full messages before invoking `OnUpdate`
+    /// \note Only applies to streams started afterwards
+    GrpcClientStream<Service, Return>& enable_delta_decoding();
+
 private:
     std::unique_ptr<grpc::ClientContext> context_ = nullptr;
     std::unique_ptr<grpc_impl::ClientReader<Return>> reader_ = nullptr;
@@ -70,6 +91,53 @@ private:
     InitFunc init_func_;
     OnUpdate on_update_;
     OnFinish on_finish_;
+    std::shared_ptr<detail::UpdateBatcher<Return>> batcher_ = nullptr; ///< Only read when the stream starts
+
+    bool delta_decoding_ = false; ///< Only read when the stream starts
+    Return current_state_; ///< The last full update (only used when decoding deltas)
+};
+
+/**
+ * @brief A server stream read with a 'ClientAsyncReader' on the client's shared completion queues
+ *
+ * No thread is started per stream so any number of streams only use the client's queue threads.
+ * 'stop_stream' cancels the stream without waiting: 'OnFinish' is invoked from a queue thread once
+ * the cancellation completes.
+ */
+template <typename Service, typename Return>
+class GrpcClientAsyncStream : public GrpcClientStreamInterface<Service> {
+public:
+    /// \brief Creates a stream that is not started yet (&Service::Stub::PrepareAsyncmethod)
+    using InitFunc = std::function<std::unique_ptr<grpc::ClientAsyncReader<Return>>(
+        typename Service::Stub&, grpc::ClientContext*, grpc::CompletionQueue*)>;
+    using OnUpdate = typename GrpcClientStream<Service, Return>::OnUpdate;
+    using OnUpdateBatch = typename GrpcClientStream<Service, Return>::OnUpdateBatch;
+    using OnFinish = typename GrpcClientStream<Service, Return>::OnFinish;
+
+    GrpcClientAsyncStream(InitFunc init_func, detail::AsyncCallQueues* queues);
+    ~GrpcClientAsyncStream() override;
+
+    void start_stream(typename Service::Stub& stub) override;
+    void stop_stream() override;
+    bool streaming() override;
+
+    GrpcClientAsyncStream<Service, Return>& on_update(OnUpdate on_update);
+    GrpcClientAsyncStream<Service, Return>& on_finish(OnFinish on_finish);
+
+    /// \brief Deliver updates in batches instead of calling `OnUpdate` ('timer_queues' enforce 'max_delay')
+    /// \note Only applies to streams started afterwards
+    GrpcClientAsyncStream<Service, Return>&
+    on_update_batch(OnUpdateBatch on_update_batch, UpdateBatching batching, detail::AsyncCallQueues* timer_queues);
+
+    /// \brief Ask the server for delta encoded updates and rebuild full messages before invoking `OnUpdate`
+    /// \note Only applies to streams started afterwards
+    GrpcClientAsyncStream<Service, Return>& enable_delta_decoding();
+
+private:
+    InitFunc init_func_;
+    detail::AsyncCallQueues* queues_;
+    std::shared_ptr<detail::AsyncStreamState<Return>> state_;
+    bool streaming_ = false;
 };
 
 template <typename Service, typename Return>
@@ -82,18 +150,38 @@ void GrpcClientStream<Service, Return>::start_stream(typename Service::Stub& stu
     }
 
     context_ = std::make_unique<grpc::ClientContext>();
+
+    // The server only sends deltas to clients that ask for them
+    bool delta_decoding = delta_decoding_;
+    if (delta_decoding) {
+        context_->AddMetadata(util::delta_encoding_metadata_key, "1");
+    }
+
     reader_ = init_func_(stub, context_.get());
 
-    stream_thread_ = std::make_unique<std::thread>([this] {
+    // A new stream always starts with a full update
+    current_state_.Clear();
+
+    stream_thread_ = std::make_unique<std::thread>([this, delta_decoding, batcher = batcher_] {
         Return update;
 
         while (reader_->Read(&update)) {
-            if (on_update_) {
+            if (delta_decoding) {
+                util::apply_delta(update, &current_state_);
+                update = current_state_;
+            }
+
+            if (batcher) {
+                batcher->add(std::move(update));
+            } else if (on_update_) {
                 on_update_(std::move(update));
             }
         }
 
         grpc::Status status = reader_->Finish();
+        if (batcher) {
+            batcher->flush();
+        }
         if (on_finish_) {
             on_finish_(status);
         }
@@ -128,5 +216,104 @@ GrpcClientStream<Service, Return>& GrpcClientStream<Service, Return>::on_finish(
     return *this;
 }
 
+template <typename Service, typename Return>
+GrpcClientStream<Service, Return>& GrpcClientStream<Service, Return>::on_update_batch(
+    OnUpdateBatch on_update_batch, UpdateBatching batching, detail::AsyncCallQueues* timer_queues) {
+    batcher_ = std::make_shared<detail::UpdateBatcher<Return>>(std::move(on_update_batch), batching, timer_queues);
+    return *this;
+}
+
+template <typename Service, typename Return>
+GrpcClientStream<Service, Return>& GrpcClientStream<Service, Return>::enable_delta_decoding() {
+    delta_decoding_ = true;
+    return *this;
+}
+
+template <typename Service, typename Return>
+GrpcClientAsyncStream<Service, Return>::GrpcClientAsyncStream(InitFunc init_func, detail::AsyncCallQueues* queues)
+    : init_func_(std::move(init_func)), queues_(queues), state_(std::make_shared<detail::AsyncStreamState<Return>>()) {
+    state_->queue_index = queues_->next_queue_index();
+}
+
+template <typename Service, typename Return>
+GrpcClientAsyncStream<Service, Return>::~GrpcClientAsyncStream() {
+    stop_stream();
+}
+
+template <typename Service, typename Return>
+void GrpcClientAsyncStream<Service, Return>::start_stream(typename Service::Stub& stub) {
+    if (streaming()) {
+        return;
+    }
+    streaming_ = true;
+
+    auto call = std::make_unique<detail::AsyncStreamCall<Return>>(queues_, state_);
+
+    // The server only sends deltas to clients that ask for them
+    if (call->delta_decoding()) {
+        call->context.AddMetadata(util::delta_encoding_metadata_key, "1");
+    }
+
+    // Set before the call starts because it can finish right away
+    state_->reading_call.use_safely([&call](detail::AsyncCall*& reading_call) { reading_call = call.get(); });
+
+    bool started = queues_->start(call.get(), state_->queue_index, [&](grpc::CompletionQueue* queue) {
+        call->reader = init_func_(stub, &call->context, queue);
+        call->reader->StartCall(call.get());
+    });
+
+    if (started) {
+        // Owned by the queue until the stream finishes
+        call.release();
+    } else {
+        call->on_complete(false);
+    }
+}
+
+template <typename Service, typename Return>
+void GrpcClientAsyncStream<Service, Return>::stop_stream() {
+    if (not streaming()) {
+        return;
+    }
+    streaming_ = false;
+
+    state_->reading_call.use_safely([](detail::AsyncCall* reading_call) {
+        if (reading_call) {
+            reading_call->cancel();
+        }
+    });
+}
+
+template <typename Service, typename Return>
+bool GrpcClientAsyncStream<Service, Return>::streaming() {
+    return streaming_;
+}
+
+template <typename Service, typename Return>
+GrpcClientAsyncStream<Service, Return>& GrpcClientAsyncStream<Service, Return>::on_update(OnUpdate on_update) {
+    state_->on_update = std::move(on_update);
+    return *this;
+}
+
+template <typename Service, typename Return>
+GrpcClientAsyncStream<Service, Return>& GrpcClientAsyncStream<Service, Return>::on_finish(OnFinish on_finish) {
+    state_->on_finish = std::move(on_finish);
+    return *this;
+}
+
+template <typename Service, typename Return>
+GrpcClientAsyncStream<Service, Return>& GrpcClientAsyncStream<Service, Return>::on_update_batch(
+    OnUpdateBatch on_update_batch, UpdateBatching batching, detail::AsyncCallQueues* timer_queues) {
+    state_->batcher
+        = std::make_shared<detail::UpdateBatcher<Return>>(std::move(on_update_batch), batching, timer_queues);
+    return *this;
+}
+
+template <typename Service, typename Return>
+GrpcClientAsyncStream<Service, Return>& GrpcClientAsyncStream<Service, Return>::enable_delta_decoding() {
+    state_->delta_decoding = true;
+    return *this;
+}
+
 } // namespace client
 } // namespace grpcw
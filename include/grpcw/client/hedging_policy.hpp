@@ -0,0 +1,60 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// standard
+#include <chrono>
+#include <cstdint>
+
+namespace grpcw {
+namespace client {
+
+/**
+ * @brief When a client sends a second copy of a slow unary call
+ *
+ * Only use hedging for idempotent calls: both copies may reach a server. The hedge goes to a
+ * different channel when there is one and whichever copy finishes first is used. The other
+ * copy is cancelled.
+ *
+ * Every call adds 'budget' to a token bucket that holds at most 'max_tokens' and each hedge
+ * uses one token, so over time at most 'budget' hedges are sent per call.
+ */
+struct HedgingPolicy {
+    /// Send a hedge once a call has taken this long. Zero uses 'delay_percentile' of recent calls instead.
+    std::chrono::milliseconds delay = std::chrono::milliseconds(0);
+    double delay_percentile = 95.0; ///< Percentile of the last 'delay_window' call latencies
+    int delay_window = 1000; ///< No hedges are sent until 100 latencies (or 'delay_window') have been seen
+    double budget = 0.05;
+    double max_tokens = 10.0;
+};
+
+/// \brief Counts of what a client's hedging policy has done so far
+struct HedgingStats {
+    std::uint64_t calls = 0u; ///< Calls made with 'call_hedged'
+    std::uint64_t hedges_sent = 0u;
+    std::uint64_t hedges_won = 0u; ///< Hedges that finished before the original call
+    std::uint64_t cancelled = 0u; ///< Copies (original or hedge) cancelled because the other finished first
+};
+
+} // namespace client
+} // namespace grpcw
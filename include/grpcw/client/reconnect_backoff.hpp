@@ -0,0 +1,50 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// standard
+#include <chrono>
+
+namespace grpcw {
+namespace client {
+
+/**
+ * @brief How a client reconnects after losing its server
+ *
+ * Failed connection attempts are retried after 'initial_backoff', growing 1.6 times per attempt
+ * up to 'max_backoff'. gRPC randomizes every delay by +/-20% so clients that lost the same
+ * server don't all retry at once. Each attempt gets at least 'min_connect_timeout'.
+ *
+ * Once the client is connected again its streams are restarted at random times spread over
+ * 'stream_restart_window' instead of all at once. Zero restarts them right away, which is only
+ * worth it for clients with a handful of streams.
+ */
+struct ReconnectBackoff {
+    std::chrono::milliseconds initial_backoff = std::chrono::seconds(1);
+    std::chrono::milliseconds max_backoff = std::chrono::seconds(120);
+    std::chrono::milliseconds min_connect_timeout = std::chrono::seconds(20);
+    std::chrono::milliseconds stream_restart_window = std::chrono::milliseconds(100);
+};
+
+} // namespace client
+} // namespace grpcw
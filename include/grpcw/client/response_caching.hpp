@@ -0,0 +1,56 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// standard
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace grpcw {
+namespace client {
+
+///
+/// \brief Settings for serving repeated unary calls from a client-side cache.
+///
+/// Responses are kept until they are 'max_age' old, until the cache needs room for newer ones
+/// (least recently used first) or until they are invalidated. 'max_bytes' bounds the memory
+/// used by the cached responses and their keys.
+///
+struct ResponseCaching {
+    std::size_t max_bytes = 16u * 1024u * 1024u;
+    std::chrono::milliseconds max_age = std::chrono::seconds(60);
+};
+
+/// \brief What a client's response cache has done so far and what it holds now
+struct ResponseCacheStats {
+    std::uint64_t hits = 0u;
+    std::uint64_t misses = 0u;
+    std::uint64_t evictions = 0u; ///< Responses dropped to stay within 'max_bytes' or because they were too old
+    std::uint64_t invalidations = 0u; ///< Responses dropped by an invalidation
+    std::size_t entries = 0u;
+    std::size_t bytes = 0u;
+};
+
+} // namespace client
+} // namespace grpcw
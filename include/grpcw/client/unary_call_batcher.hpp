@@ -0,0 +1,125 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// grpcw
+#include "grpcw/client/call_batching.hpp"
+#include "grpcw/client/detail/update_batcher.hpp"
+#include "grpcw/forward_declarations.hpp"
+
+// third-party
+#include <grpc++/support/status.h>
+
+// standard
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace grpcw {
+namespace client {
+
+/**
+ * @brief Collects single unary calls and sends them to the server together in one batch rpc
+ *
+ * Created by 'GrpcClient::batch_calls' and must be destroyed before the client. Calls that are
+ * still waiting when it is destroyed are sent right away.
+ */
+template <typename Request, typename Response>
+class UnaryCallBatcher {
+public:
+    using OnDone = std::function<void(grpc::Status, Response)>;
+
+    /// \brief A call waiting for its batch to be sent
+    struct PendingCall {
+        Request request;
+        OnDone on_done;
+    };
+
+    using SendBatch = std::function<void(std::vector<PendingCall>&&)>;
+
+    /// \brief Throws std::invalid_argument if 'batching.max_batch_size' is zero
+    UnaryCallBatcher(SendBatch send_batch, CallBatching batching, detail::AsyncCallQueues* timer_queues);
+    ~UnaryCallBatcher();
+
+    UnaryCallBatcher(UnaryCallBatcher&&) noexcept = default;
+    UnaryCallBatcher& operator=(UnaryCallBatcher&&) noexcept = default;
+
+    ///
+    /// \brief Add a call to the next batch.
+    ///
+    /// 'on_done' is invoked from one of the client's queue threads with this call's part of the
+    /// batch response. If the batch rpc fails every call in it gets the batch's status.
+    ///
+    void call(Request request, OnDone on_done);
+
+    /// \brief Add a call to the next batch and get the result through a future
+    std::future<CallResult<Response>> call(Request request);
+
+    /// \brief Send the calls that are waiting without waiting for the batch to fill up
+    void flush();
+
+private:
+    std::shared_ptr<detail::UpdateBatcher<PendingCall>> batcher_;
+};
+
+template <typename Request, typename Response>
+UnaryCallBatcher<Request, Response>::UnaryCallBatcher(SendBatch send_batch,
+                                                      CallBatching batching,
+                                                      detail::AsyncCallQueues* timer_queues)
+    : batcher_(std::make_shared<detail::UpdateBatcher<PendingCall>>(std::move(send_batch),
+                                                                    UpdateBatching{batching.max_batch_size,
+                                                                                   batching.max_delay},
+                                                                    timer_queues)) {}
+
+template <typename Request, typename Response>
+UnaryCallBatcher<Request, Response>::~UnaryCallBatcher() {
+    if (batcher_) {
+        batcher_->flush();
+    }
+}
+
+template <typename Request, typename Response>
+void UnaryCallBatcher<Request, Response>::call(Request request, OnDone on_done) {
+    batcher_->add({std::move(request), std::move(on_done)});
+}
+
+template <typename Request, typename Response>
+std::future<CallResult<Response>> UnaryCallBatcher<Request, Response>::call(Request request) {
+    auto promise = std::make_shared<std::promise<CallResult<Response>>>();
+    auto future = promise->get_future();
+
+    call(std::move(request), [promise](grpc::Status status, Response response) {
+        promise->set_value({std::move(status), std::move(response)});
+    });
+
+    return future;
+}
+
+template <typename Request, typename Response>
+void UnaryCallBatcher<Request, Response>::flush() {
+    batcher_->flush();
+}
+
+} // namespace client
+} // namespace grpcw
@@ -48,7 +48,13 @@ class GrpcClientStreamInterface;
 template <typename Service, typename Return>
 class GrpcClientStream;
 
+template <typename Service, typename Return>
+class GrpcClientAsyncStream;
+
 enum class GrpcClientState;
 
+template <typename Response>
+struct CallResult;
+
 } // namespace client
 } // namespace grpcw
@@ -0,0 +1,67 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// third-party
+#include <grpc++/server_context.h>
+#include <grpc/compression.h>
+
+// standard
+#include <cstddef>
+
+namespace grpcw {
+namespace server {
+
+///
+/// \brief Per-registration compression settings for an RPC.
+///
+/// If 'level' is set it takes precedence over 'algorithm' and gRPC picks an
+/// algorithm the client has advertised support for. Messages smaller than
+/// 'min_message_size' bytes are always sent uncompressed.
+///
+struct CompressionOptions {
+    grpc_compression_algorithm algorithm = GRPC_COMPRESS_NONE;
+    grpc_compression_level level = GRPC_COMPRESS_LEVEL_NONE;
+    std::size_t min_message_size = 0;
+};
+
+/// \brief True if 'options' requests any kind of compression
+bool compression_enabled(const CompressionOptions& options);
+
+/// \brief True if a serialized message of 'message_size' bytes should be compressed
+bool should_compress(const CompressionOptions& options, std::size_t message_size);
+
+/// \brief Set the call level compression on 'context' (must happen before initial metadata is sent)
+/// \tparam ServerContext is any kind of server context (async or callback api)
+template <typename ServerContext>
+void apply_compression(const CompressionOptions& options, ServerContext* context) {
+    if (options.level != GRPC_COMPRESS_LEVEL_NONE) {
+        context->set_compression_level(options.level);
+
+    } else if (options.algorithm != GRPC_COMPRESS_NONE) {
+        context->set_compression_algorithm(options.algorithm);
+    }
+}
+
+} // namespace server
+} // namespace grpcw
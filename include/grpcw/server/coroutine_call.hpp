@@ -0,0 +1,229 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Only available when compiling with C++20 coroutine support (see LTB_GRPCW_ENABLE_COROUTINES)
+#ifdef __cpp_impl_coroutine
+
+// grpcw
+#include "grpcw/util/task.hpp"
+
+// third-party
+#include <grpc++/alarm.h>
+#include <grpc++/client_context.h>
+#include <grpc++/completion_queue.h>
+#include <grpc++/server_context.h>
+#include <grpc++/support/async_stream.h>
+#include <grpc++/support/async_unary_call.h>
+
+// standard
+#include <coroutine>
+#include <memory>
+#include <type_traits>
+
+namespace grpcw {
+namespace server {
+
+/**
+ * @brief The function signature for a stub's non-streaming calls (`Stub::PrepareAsync<method>`)
+ */
+template <typename Stub, typename Request, typename Response>
+using PrepareAsyncUnaryFunc = std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> (Stub::*)(
+    grpc::ClientContext*, const Request&, grpc::CompletionQueue*);
+
+namespace detail {
+
+/**
+ * @brief Every tag placed on a `GrpcCoroutineServer` queue points to one of these
+ */
+class CompletionHandler {
+public:
+    virtual ~CompletionHandler() = default;
+    virtual void on_completion(bool ok) = 0;
+};
+
+/**
+ * @brief Suspends the awaiting coroutine until the queue operation started by 'Start' completes
+ *
+ * 'Start' is called with the tag to use for the operation. The coroutine is resumed on the
+ * queue thread that receives the tag and `co_await` returns the queue's 'ok' value.
+ */
+template <typename Start>
+class QueueOperation : public CompletionHandler {
+public:
+    explicit QueueOperation(Start start) : start_(std::move(start)) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        handle_ = handle;
+
+        // The operation can complete on another queue thread, which resumes the coroutine and destroys
+        // this awaiter, before 'start' returns. Nothing in 'this' can be used once it has been called.
+        auto start = std::move(start_);
+        start(static_cast<CompletionHandler*>(this));
+    }
+
+    bool await_resume() const noexcept { return ok_; }
+
+    void on_completion(bool ok) override {
+        ok_ = ok;
+        handle_.resume();
+    }
+
+private:
+    Start start_;
+    std::coroutine_handle<> handle_ = nullptr;
+    bool ok_ = false;
+};
+
+template <typename Start>
+QueueOperation<Start> queue_operation(Start start) {
+    return QueueOperation<Start>(std::move(start));
+}
+
+} // namespace detail
+
+/**
+ * @brief The server side of a single rpc call handled by a coroutine
+ *
+ * Everything returned by these functions has to be `co_await`ed right away.
+ */
+class CoroutineCall {
+public:
+    CoroutineCall(grpc::ServerContext& context, grpc::CompletionQueue& queue);
+
+    grpc::ServerContext& context();
+    grpc::CompletionQueue& queue();
+
+    /// \brief Resumes at 'deadline' (true) or earlier if the server is shutting down (false)
+    template <typename TimePoint>
+    util::Task<bool> alarm(TimePoint deadline);
+
+    /// \brief Calls a non-streaming method on another service without blocking a thread
+    template <typename Stub, typename Request, typename Response>
+    util::Task<grpc::Status> unary(Stub& stub,
+                                   PrepareAsyncUnaryFunc<Stub, Request, Response> prepare_func,
+                                   grpc::ClientContext* client_context,
+                                   std::type_identity_t<Request> request,
+                                   Response* response);
+
+private:
+    grpc::ServerContext& context_;
+    grpc::CompletionQueue& queue_;
+};
+
+/**
+ * @brief A server-side-streaming call handled by a coroutine
+ */
+template <typename Response>
+class CoroutineWriter : public CoroutineCall {
+public:
+    CoroutineWriter(grpc::ServerContext& context,
+                    grpc::CompletionQueue& queue,
+                    grpc::ServerAsyncWriter<Response>& writer);
+
+    /// \brief Resumes once 'update' has been sent. False means the client is gone.
+    auto write(const Response& update, grpc::WriteOptions write_options = {});
+
+private:
+    grpc::ServerAsyncWriter<Response>& writer_;
+};
+
+/**
+ * @brief A bidirectional-streaming call handled by a coroutine
+ */
+template <typename Response, typename Request>
+class CoroutineReaderWriter : public CoroutineCall {
+public:
+    CoroutineReaderWriter(grpc::ServerContext& context,
+                          grpc::CompletionQueue& queue,
+                          grpc::ServerAsyncReaderWriter<Response, Request>& stream);
+
+    /// \brief Resumes once a message has been read. False means the client is done writing.
+    auto read(Request* request);
+
+    /// \brief Resumes once 'update' has been sent. False means the client is gone.
+    auto write(const Response& update, grpc::WriteOptions write_options = {});
+
+private:
+    grpc::ServerAsyncReaderWriter<Response, Request>& stream_;
+};
+
+template <typename TimePoint>
+util::Task<bool> CoroutineCall::alarm(TimePoint deadline) {
+    grpc::Alarm alarm;
+    co_return co_await detail::queue_operation([&](void* tag) { alarm.Set(&queue_, deadline, tag); });
+}
+
+template <typename Stub, typename Request, typename Response>
+util::Task<grpc::Status> CoroutineCall::unary(Stub& stub,
+                                              PrepareAsyncUnaryFunc<Stub, Request, Response> prepare_func,
+                                              grpc::ClientContext* client_context,
+                                              std::type_identity_t<Request> request,
+                                              Response* response) {
+    std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> reader
+        = (stub.*prepare_func)(client_context, request, &queue_);
+    reader->StartCall();
+
+    grpc::Status status;
+    co_await detail::queue_operation([&](void* tag) { reader->Finish(response, &status, tag); });
+    co_return status;
+}
+
+template <typename Response>
+CoroutineWriter<Response>::CoroutineWriter(grpc::ServerContext& context,
+                                           grpc::CompletionQueue& queue,
+                                           grpc::ServerAsyncWriter<Response>& writer)
+    : CoroutineCall(context, queue), writer_(writer) {}
+
+template <typename Response>
+auto CoroutineWriter<Response>::write(const Response& update, grpc::WriteOptions write_options) {
+    return detail::queue_operation([this, &update, write_options](void* tag) {
+        writer_.Write(update, write_options, tag);
+    });
+}
+
+template <typename Response, typename Request>
+CoroutineReaderWriter<Response, Request>::CoroutineReaderWriter(
+    grpc::ServerContext& context,
+    grpc::CompletionQueue& queue,
+    grpc::ServerAsyncReaderWriter<Response, Request>& stream)
+    : CoroutineCall(context, queue), stream_(stream) {}
+
+template <typename Response, typename Request>
+auto CoroutineReaderWriter<Response, Request>::read(Request* request) {
+    return detail::queue_operation([this, request](void* tag) { stream_.Read(request, tag); });
+}
+
+template <typename Response, typename Request>
+auto CoroutineReaderWriter<Response, Request>::write(const Response& update, grpc::WriteOptions write_options) {
+    return detail::queue_operation([this, &update, write_options](void* tag) {
+        stream_.Write(update, write_options, tag);
+    });
+}
+
+} // namespace server
+} // namespace grpcw
+
+#endif // __cpp_impl_coroutine
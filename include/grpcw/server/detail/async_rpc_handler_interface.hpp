@@ -50,6 +50,16 @@ using AsyncServerStreamFunc = void (Service::*)(grpc::ServerContext* context,
                                                 grpc::ServerCompletionQueue*,
                                                 void*);
 
+/**
+ * @brief The function signature for a service's bidirectional-streaming calls
+ */
+template <typename Service, typename Request, typename Response>
+using AsyncBidiStreamFunc = void (Service::*)(grpc::ServerContext* context,
+                                              grpc::ServerAsyncReaderWriter<Response, Request>*,
+                                              grpc::CompletionQueue*,
+                                              grpc::ServerCompletionQueue*,
+                                              void*);
+
 namespace detail {
 
 class AsyncRpcHandlerInterface {
@@ -0,0 +1,58 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// grpcw
+#include "grpcw/util/blocking_queue.hpp"
+
+// standard
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace grpcw {
+namespace server {
+namespace detail {
+
+/**
+ * @brief Threads that help the queue thread handle the items of a batch rpc
+ */
+class BatchWorkers {
+public:
+    /// \brief Throws std::invalid_argument if 'parallelism' (the calling thread included) is less than one
+    explicit BatchWorkers(int parallelism);
+    ~BatchWorkers();
+
+    /// \brief Invoke 'handle_item' for every index in [0, 'item_count') and return once they have all finished
+    /// \note The calling thread (a server's queue thread) handles items too and is blocked until the last one is done
+    void run(std::size_t item_count, const std::function<void(std::size_t)>& handle_item);
+
+private:
+    util::BlockingQueue<std::function<void()>> jobs_; ///< An empty job stops a thread
+    std::vector<std::thread> threads_;
+};
+
+} // namespace detail
+} // namespace server
+} // namespace grpcw
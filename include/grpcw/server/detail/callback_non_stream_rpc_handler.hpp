@@ -0,0 +1,144 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Only available when the callback server is enabled (see LTB_GRPCW_ENABLE_CALLBACK_SERVER)
+#ifdef LTB_GRPCW_ENABLE_CALLBACK_SERVER
+
+// grpcw
+#include "grpcw/server/compression_options.hpp"
+#include "grpcw/server/detail/callback_rpc_handler_interface.hpp"
+
+// third-party
+#include <grpc++/impl/codegen/proto_utils.h>
+
+namespace grpcw {
+namespace server {
+namespace detail {
+
+/**
+ * @brief Handles non-streaming gRPC responses for a single rpc call using the callback api
+ * @tparam Request is the Protobuf request type
+ * @tparam Response is the Protobuf response type
+ * @tparam Callback is the implementation of this rpc call (signature: <grpc::Status(const Request&, Response*)>)
+ *
+ * 'Callback' is run on one of gRPC's threads and can be called for several clients at once.
+ */
+template <typename Request, typename Response, typename Callback>
+class CallbackNonStreamRpcHandler : public CallbackRpcHandlerInterface {
+public:
+    explicit CallbackNonStreamRpcHandler(Callback callback, CompressionOptions compression = {});
+    ~CallbackNonStreamRpcHandler() override = default;
+
+    /**
+     * @see CallbackRpcHandlerInterface::create_reactor()
+     */
+    grpc::ServerGenericBidiReactor* create_reactor(grpc::GenericCallbackServerContext* context) override;
+
+private:
+    Callback callback_; ///< The server specific implementation of this RPC call
+    CompressionOptions compression_; ///< How (and when) responses should be compressed
+
+    /// Reads the single request, runs the callback, and writes the response
+    class Reactor : public grpc::ServerGenericBidiReactor {
+    public:
+        Reactor(CallbackNonStreamRpcHandler* handler, grpc::GenericCallbackServerContext* context);
+
+        void OnReadDone(bool ok) override;
+        void OnDone() override;
+
+    private:
+        CallbackNonStreamRpcHandler* handler_;
+        grpc::GenericCallbackServerContext* context_;
+        grpc::ByteBuffer request_buffer_;
+        grpc::ByteBuffer response_buffer_;
+    };
+};
+
+template <typename Request, typename Response, typename Callback>
+CallbackNonStreamRpcHandler<Request, Response, Callback>::CallbackNonStreamRpcHandler(Callback callback,
+                                                                                      CompressionOptions compression)
+    : callback_(std::move(callback)), compression_(compression) {}
+
+template <typename Request, typename Response, typename Callback>
+grpc::ServerGenericBidiReactor*
+CallbackNonStreamRpcHandler<Request, Response, Callback>::create_reactor(grpc::GenericCallbackServerContext* context) {
+    return new Reactor(this, context);
+}
+
+template <typename Request, typename Response, typename Callback>
+CallbackNonStreamRpcHandler<Request, Response, Callback>::Reactor::Reactor(CallbackNonStreamRpcHandler* handler,
+                                                                           grpc::GenericCallbackServerContext* context)
+    : handler_(handler), context_(context) {
+    StartRead(&request_buffer_);
+}
+
+template <typename Request, typename Response, typename Callback>
+void CallbackNonStreamRpcHandler<Request, Response, Callback>::Reactor::OnReadDone(bool ok) {
+    if (not ok) {
+        Finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "No request received"));
+        return;
+    }
+
+    Request request;
+    grpc::Status status = grpc::SerializationTraits<Request>::Deserialize(&request_buffer_, &request);
+
+    if (not status.ok()) {
+        Finish(status);
+        return;
+    }
+
+    Response response;
+    status = handler_->callback_(request, &response);
+
+    if (not status.ok()) {
+        Finish(status);
+        return;
+    }
+
+    // Small responses are not worth the CPU so only enable compression for large ones
+    if (should_compress(handler_->compression_, response.ByteSizeLong())) {
+        apply_compression(handler_->compression_, context_);
+    }
+
+    bool own_buffer;
+    status = grpc::SerializationTraits<Response>::Serialize(response, &response_buffer_, &own_buffer);
+
+    if (not status.ok()) {
+        Finish(status);
+        return;
+    }
+
+    StartWriteAndFinish(&response_buffer_, grpc::WriteOptions(), grpc::Status::OK);
+}
+
+template <typename Request, typename Response, typename Callback>
+void CallbackNonStreamRpcHandler<Request, Response, Callback>::Reactor::OnDone() {
+    delete this;
+}
+
+} // namespace detail
+} // namespace server
+} // namespace grpcw
+
+#endif // LTB_GRPCW_ENABLE_CALLBACK_SERVER
@@ -0,0 +1,65 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Only available when the callback server is enabled (see LTB_GRPCW_ENABLE_CALLBACK_SERVER)
+#ifdef LTB_GRPCW_ENABLE_CALLBACK_SERVER
+
+// grpcw
+#include "grpcw/server/detail/callback_rpc_handler_interface.hpp"
+#include "grpcw/util/atomic_data.hpp"
+
+// third-party
+#include <grpc++/generic/async_generic_service.h>
+
+// standard
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace grpcw {
+namespace server {
+namespace detail {
+
+/**
+ * @brief Passes every incoming call to the handler registered for its method
+ *
+ * Calls to methods without a handler are finished with UNIMPLEMENTED.
+ */
+class CallbackRpcDispatcher : public grpc::CallbackGenericService {
+public:
+    /// \brief Throws std::invalid_argument if 'method_path' already has a handler
+    void add_handler(const std::string& method_path, std::unique_ptr<CallbackRpcHandlerInterface> handler);
+
+    grpc::ServerGenericBidiReactor* CreateReactor(grpc::GenericCallbackServerContext* context) override;
+
+private:
+    using HandlerMap = std::unordered_map<std::string, std::unique_ptr<CallbackRpcHandlerInterface>>;
+    util::AtomicData<HandlerMap> handlers_;
+};
+
+} // namespace detail
+} // namespace server
+} // namespace grpcw
+
+#endif // LTB_GRPCW_ENABLE_CALLBACK_SERVER
@@ -0,0 +1,51 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Only available when the callback server is enabled (see LTB_GRPCW_ENABLE_CALLBACK_SERVER)
+#ifdef LTB_GRPCW_ENABLE_CALLBACK_SERVER
+
+// third-party
+#include <grpc++/generic/async_generic_service.h>
+
+namespace grpcw {
+namespace server {
+namespace detail {
+
+class CallbackRpcHandlerInterface {
+public:
+    virtual ~CallbackRpcHandlerInterface() = default;
+
+    /**
+     * @brief Creates the reactor that handles a single call to this rpc
+     *
+     * The reactor is owned by gRPC and deletes itself once the call is done.
+     */
+    virtual grpc::ServerGenericBidiReactor* create_reactor(grpc::GenericCallbackServerContext* context) = 0;
+};
+
+} // namespace detail
+} // namespace server
+} // namespace grpcw
+
+#endif // LTB_GRPCW_ENABLE_CALLBACK_SERVER
@@ -0,0 +1,487 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Only available when the callback server is enabled (see LTB_GRPCW_ENABLE_CALLBACK_SERVER)
+#ifdef LTB_GRPCW_ENABLE_CALLBACK_SERVER
+
+// grpcw
+#include "grpcw/forward_declarations.hpp"
+#include "grpcw/server/compression_options.hpp"
+#include "grpcw/server/detail/callback_rpc_handler_interface.hpp"
+#include "grpcw/server/detail/stream_rpc_handler.hpp"
+#include "grpcw/util/atomic_data.hpp"
+#include "grpcw/util/subscriber_index.hpp"
+
+// third-party
+#include <grpc++/impl/codegen/proto_utils.h>
+
+// standard
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace grpcw {
+namespace server {
+namespace detail {
+
+/**
+ * @brief Handles every client connected to a server-side-streaming rpc using the callback api
+ * @tparam Request is the Protobuf request type
+ * @tparam Response is the Protobuf response type
+ *
+ * Unlike `StreamRpcHandler`, `write` does not wait for previous updates to be sent. Each
+ * connection queues its updates and sends them in order. Updates sent to several clients
+ * are only serialized once.
+ *
+ * A client that already has `max_pending_updates` waiting does not receive the update and the
+ * write returns false (see `limit_pending_updates`).
+ */
+template <typename Request, typename Response>
+class CallbackStreamRpcHandler : public CallbackRpcHandlerInterface, public StreamInterface<Response> {
+public:
+    using ConnectionCallback = std::function<void(const Request&, ClientID)>;
+    using DeletionCallback = std::function<void(const Request&, ClientID)>;
+    using SubscriptionCallback = std::function<std::vector<std::string>(const Request&)>;
+
+    explicit CallbackStreamRpcHandler(CompressionOptions compression = {});
+    ~CallbackStreamRpcHandler() override = default;
+
+    CallbackStreamRpcHandler<Request, Response>& on_connect(ConnectionCallback connection_callback);
+    CallbackStreamRpcHandler<Request, Response>& on_delete(DeletionCallback deletion_callback);
+
+    /**
+     * @brief Maps the request of each new connection to the topics it receives from `publish`
+     */
+    CallbackStreamRpcHandler<Request, Response>& on_subscribe(SubscriptionCallback subscription_callback);
+
+    /**
+     * @brief The number of updates each client can have waiting to be sent (1024 by default)
+     *
+     * Throws std::invalid_argument if `max_pending_updates` is zero.
+     */
+    CallbackStreamRpcHandler<Request, Response>& limit_pending_updates(std::size_t max_pending_updates);
+
+    /**
+     * @see CallbackRpcHandlerInterface::create_reactor()
+     */
+    grpc::ServerGenericBidiReactor* create_reactor(grpc::GenericCallbackServerContext* context) override;
+
+    bool write(const Response& update) override;
+    bool write(const Response& update, ClientID client) override;
+    bool publish(const std::string& topic, const Response& update) override;
+    bool finish(const grpc::Status& status) override;
+    bool finish(const grpc::Status& status, ClientID client) override;
+
+private:
+    class Reactor;
+
+    CompressionOptions compression_;
+    ConnectionCallback connection_callback_;
+    DeletionCallback deletion_callback_;
+    SubscriptionCallback subscription_callback_;
+    std::atomic<std::size_t> max_pending_updates_{1024u};
+
+    struct Connections {
+        std::unordered_map<ClientID, Reactor*> active;
+        util::SubscriberIndex<ClientID> subscribers; ///< Only used when 'on_subscribe' is set
+    };
+    util::AtomicData<Connections> connections_;
+
+    /// \brief Serializes 'update' once. Returns false if serialization fails.
+    bool serialize(const Response& update,
+                   std::shared_ptr<const grpc::ByteBuffer>* buffer,
+                   grpc::WriteOptions* write_options) const;
+
+    void add_connection(Reactor* reactor);
+    void remove_connection(Reactor* reactor);
+
+    /// A single client's stream. Deletes itself when the call is done.
+    class Reactor : public grpc::ServerGenericBidiReactor {
+    public:
+        Reactor(CallbackStreamRpcHandler* handler, grpc::GenericCallbackServerContext* context);
+
+        const Request& request() const;
+
+        /// \brief Returns false if the stream has already been finished or too many updates are waiting
+        bool write(std::shared_ptr<const grpc::ByteBuffer> update, grpc::WriteOptions write_options);
+        bool finish(const grpc::Status& status);
+
+        void OnReadDone(bool ok) override;
+        void OnWriteDone(bool ok) override;
+        void OnCancel() override;
+        void OnDone() override;
+
+    private:
+        struct PendingWrite {
+            std::shared_ptr<const grpc::ByteBuffer> update = nullptr;
+            grpc::WriteOptions write_options;
+        };
+
+        struct WriteState {
+            PendingWrite current; ///< The write gRPC is working on (if 'update' is not null)
+            std::deque<PendingWrite> pending;
+            std::unique_ptr<grpc::Status> finish_status = nullptr;
+            bool finish_started = false;
+        };
+
+        /// The write or finish chosen by 'next_operation', started once 'state_' is unlocked
+        struct Operation {
+            const grpc::ByteBuffer* update = nullptr;
+            grpc::WriteOptions write_options;
+            std::unique_ptr<grpc::Status> finish_status = nullptr;
+        };
+
+        CallbackStreamRpcHandler* handler_;
+        grpc::ByteBuffer request_buffer_;
+        Request request_;
+        bool connected_ = false;
+
+        util::AtomicData<WriteState> state_;
+
+        /// \brief Picks the next write (or the finish once all writes are done) if gRPC is idle
+        Operation next_operation(WriteState* state);
+
+        /**
+         * @brief Passes 'operation' to gRPC. Must be called without holding 'state_'.
+         *
+         * The reactor can be deleted as soon as the finish is started so nothing may use it afterwards.
+         */
+        void start(Operation operation);
+    };
+};
+
+template <typename Request, typename Response>
+CallbackStreamRpcHandler<Request, Response>::CallbackStreamRpcHandler(CompressionOptions compression)
+    : compression_(compression) {}
+
+template <typename Request, typename Response>
+CallbackStreamRpcHandler<Request, Response>&
+CallbackStreamRpcHandler<Request, Response>::on_connect(ConnectionCallback connection_callback) {
+    connections_.use_safely([&](const Connections&) { connection_callback_ = std::move(connection_callback); });
+    return *this;
+}
+
+template <typename Request, typename Response>
+CallbackStreamRpcHandler<Request, Response>&
+CallbackStreamRpcHandler<Request, Response>::on_delete(DeletionCallback deletion_callback) {
+    connections_.use_safely([&](const Connections&) { deletion_callback_ = std::move(deletion_callback); });
+    return *this;
+}
+
+template <typename Request, typename Response>
+CallbackStreamRpcHandler<Request, Response>&
+CallbackStreamRpcHandler<Request, Response>::on_subscribe(SubscriptionCallback subscription_callback) {
+    connections_.use_safely([&](const Connections&) { subscription_callback_ = std::move(subscription_callback); });
+    return *this;
+}
+
+template <typename Request, typename Response>
+CallbackStreamRpcHandler<Request, Response>&
+CallbackStreamRpcHandler<Request, Response>::limit_pending_updates(std::size_t max_pending_updates) {
+    if (max_pending_updates == 0u) {
+        throw std::invalid_argument("max_pending_updates must be at least 1");
+    }
+    max_pending_updates_ = max_pending_updates;
+    return *this;
+}
+
+template <typename Request, typename Response>
+grpc::ServerGenericBidiReactor*
+CallbackStreamRpcHandler<Request, Response>::create_reactor(grpc::GenericCallbackServerContext* context) {
+    return new Reactor(this, context);
+}
+
+template <typename Request, typename Response>
+bool CallbackStreamRpcHandler<Request, Response>::write(const Response& update) {
+    return write(update, nullptr);
+}
+
+template <typename Request, typename Response>
+bool CallbackStreamRpcHandler<Request, Response>::write(const Response& update, ClientID client) {
+    std::shared_ptr<const grpc::ByteBuffer> buffer;
+    grpc::WriteOptions write_options;
+
+    if (not serialize(update, &buffer, &write_options)) {
+        return false;
+    }
+
+    return connections_.use_safely([&](const Connections& connections) {
+        if (client) {
+            auto iter = connections.active.find(client);
+            return iter != connections.active.end() and iter->second->write(buffer, write_options);
+        }
+
+        bool written = true;
+        for (const auto& connection_pair : connections.active) {
+            written &= connection_pair.second->write(buffer, write_options);
+        }
+        return written;
+    });
+}
+
+template <typename Request, typename Response>
+bool CallbackStreamRpcHandler<Request, Response>::publish(const std::string& topic, const Response& update) {
+    std::shared_ptr<const grpc::ByteBuffer> buffer;
+    grpc::WriteOptions write_options;
+
+    if (not serialize(update, &buffer, &write_options)) {
+        return false;
+    }
+
+    return connections_.use_safely([&](const Connections& connections) {
+        bool written = true;
+        connections.subscribers.for_each_subscriber(
+            topic, [&](ClientID client) { written &= connections.active.at(client)->write(buffer, write_options); });
+        return written;
+    });
+}
+
+template <typename Request, typename Response>
+bool CallbackStreamRpcHandler<Request, Response>::finish(const grpc::Status& status) {
+    return finish(status, nullptr);
+}
+
+template <typename Request, typename Response>
+bool CallbackStreamRpcHandler<Request, Response>::finish(const grpc::Status& status, ClientID client) {
+    return connections_.use_safely([&](const Connections& connections) {
+        if (client) {
+            auto iter = connections.active.find(client);
+            return iter != connections.active.end() and iter->second->finish(status);
+        }
+
+        for (const auto& connection_pair : connections.active) {
+            connection_pair.second->finish(status);
+        }
+        return true;
+    });
+}
+
+template <typename Request, typename Response>
+bool CallbackStreamRpcHandler<Request, Response>::serialize(const Response& update,
+                                                            std::shared_ptr<const grpc::ByteBuffer>* buffer,
+                                                            grpc::WriteOptions* write_options) const {
+    // Serialize once and share the buffer with every client
+    auto serialized = std::make_shared<grpc::ByteBuffer>();
+    bool own_buffer;
+
+    if (not grpc::SerializationTraits<Response>::Serialize(update, serialized.get(), &own_buffer).ok()) {
+        return false;
+    }
+    *buffer = std::move(serialized);
+
+    // The size (and therefore the compression decision) is the same for every client
+    if (not should_compress(compression_, update.ByteSizeLong())) {
+        write_options->set_no_compression();
+    }
+    return true;
+}
+
+template <typename Request, typename Response>
+void CallbackStreamRpcHandler<Request, Response>::add_connection(Reactor* reactor) {
+    connections_.use_safely([&](Connections& connections) {
+        connections.active.emplace(reactor, reactor);
+
+        if (connection_callback_) {
+            connection_callback_(reactor->request(), reactor);
+        }
+
+        if (subscription_callback_) {
+            connections.subscribers.subscribe(reactor, subscription_callback_(reactor->request()));
+        }
+    });
+}
+
+template <typename Request, typename Response>
+void CallbackStreamRpcHandler<Request, Response>::remove_connection(Reactor* reactor) {
+    connections_.use_safely([&](Connections& connections) {
+        connections.active.erase(reactor);
+        connections.subscribers.unsubscribe(reactor);
+
+        if (deletion_callback_) {
+            deletion_callback_(reactor->request(), reactor);
+        }
+    });
+}
+
+template <typename Request, typename Response>
+CallbackStreamRpcHandler<Request, Response>::Reactor::Reactor(CallbackStreamRpcHandler* handler,
+                                                              grpc::GenericCallbackServerContext* context)
+    : handler_(handler) {
+    // Has to be set before the first write sends the initial metadata
+    apply_compression(handler_->compression_, context);
+
+    StartRead(&request_buffer_);
+}
+
+template <typename Request, typename Response>
+const Request& CallbackStreamRpcHandler<Request, Response>::Reactor::request() const {
+    return request_;
+}
+
+template <typename Request, typename Response>
+bool CallbackStreamRpcHandler<Request, Response>::Reactor::write(std::shared_ptr<const grpc::ByteBuffer> update,
+                                                                 grpc::WriteOptions write_options) {
+    Operation operation;
+
+    bool written = state_.use_safely([&](WriteState& state) {
+        if (state.finish_status or state.pending.size() >= handler_->max_pending_updates_) {
+            return false;
+        }
+        state.pending.push_back({std::move(update), write_options});
+        operation = next_operation(&state);
+        return true;
+    });
+
+    start(std::move(operation));
+    return written;
+}
+
+template <typename Request, typename Response>
+bool CallbackStreamRpcHandler<Request, Response>::Reactor::finish(const grpc::Status& status) {
+    Operation operation;
+
+    bool finished = state_.use_safely([&](WriteState& state) {
+        if (state.finish_status) {
+            return false;
+        }
+        state.finish_status = std::make_unique<grpc::Status>(status);
+        operation = next_operation(&state);
+        return true;
+    });
+
+    start(std::move(operation));
+    return finished;
+}
+
+template <typename Request, typename Response>
+void CallbackStreamRpcHandler<Request, Response>::Reactor::OnReadDone(bool ok) {
+    if (not ok) {
+        finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "No request received"));
+        return;
+    }
+
+    grpc::Status status = grpc::SerializationTraits<Request>::Deserialize(&request_buffer_, &request_);
+
+    if (not status.ok()) {
+        finish(status);
+        return;
+    }
+
+    connected_ = true;
+    handler_->add_connection(this);
+}
+
+template <typename Request, typename Response>
+void CallbackStreamRpcHandler<Request, Response>::Reactor::OnWriteDone(bool ok) {
+    Operation operation;
+
+    state_.use_safely([&](WriteState& state) {
+        state.current = {};
+
+        // The client is gone so the remaining updates can't be sent
+        if (not ok) {
+            state.pending.clear();
+
+            if (not state.finish_status) {
+                state.finish_status = std::make_unique<grpc::Status>(grpc::Status::CANCELLED);
+            }
+        }
+
+        operation = next_operation(&state);
+    });
+
+    start(std::move(operation));
+}
+
+template <typename Request, typename Response>
+void CallbackStreamRpcHandler<Request, Response>::Reactor::OnCancel() {
+    Operation operation;
+
+    state_.use_safely([&](WriteState& state) {
+        state.pending.clear();
+
+        if (not state.finish_status) {
+            state.finish_status = std::make_unique<grpc::Status>(grpc::Status::CANCELLED);
+        }
+
+        operation = next_operation(&state);
+    });
+
+    start(std::move(operation));
+}
+
+template <typename Request, typename Response>
+void CallbackStreamRpcHandler<Request, Response>::Reactor::OnDone() {
+    if (connected_) {
+        handler_->remove_connection(this);
+    }
+    delete this;
+}
+
+template <typename Request, typename Response>
+auto CallbackStreamRpcHandler<Request, Response>::Reactor::next_operation(WriteState* state) -> Operation {
+    Operation operation;
+
+    if (state->current.update or state->finish_started) {
+        return operation;
+    }
+
+    if (not state->pending.empty()) {
+        state->current = std::move(state->pending.front());
+        state->pending.pop_front();
+
+        // 'current' keeps the buffer alive until OnWriteDone. Queued updates are not buffer hinted. A hinted
+        // write does not complete until a later write flushes it, and the next write only starts once this
+        // one completes.
+        operation.update = state->current.update.get();
+        operation.write_options = state->current.write_options;
+
+    } else if (state->finish_status) {
+        state->finish_started = true;
+        operation.finish_status = std::make_unique<grpc::Status>(*state->finish_status);
+    }
+    return operation;
+}
+
+template <typename Request, typename Response>
+void CallbackStreamRpcHandler<Request, Response>::Reactor::start(Operation operation) {
+    // Only one operation is chosen at a time so gRPC never sees two writes (or a write and the finish) at once
+    if (operation.update) {
+        StartWrite(operation.update, operation.write_options);
+
+    } else if (operation.finish_status) {
+        Finish(*operation.finish_status);
+    }
+}
+
+} // namespace detail
+} // namespace server
+} // namespace grpcw
+
+#endif // LTB_GRPCW_ENABLE_CALLBACK_SERVER
@@ -0,0 +1,111 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Only available when the callback server is enabled (see LTB_GRPCW_ENABLE_CALLBACK_SERVER)
+#ifdef LTB_GRPCW_ENABLE_CALLBACK_SERVER
+
+// grpcw
+#include "callback_stream_rpc_handler.hpp"
+
+namespace grpcw {
+namespace server {
+namespace detail {
+
+/// \brief Allows callbacks to be set for `CallbackStreamRpcHandler`s
+template <typename Request, typename Response>
+class CallbackStreamRpcHandlerCallbackSetter {
+
+    using StreamConnectionCallback = typename detail::CallbackStreamRpcHandler<Request, Response>::ConnectionCallback;
+    using StreamDeletionCallback = typename detail::CallbackStreamRpcHandler<Request, Response>::DeletionCallback;
+    using StreamSubscriptionCallback =
+        typename detail::CallbackStreamRpcHandler<Request, Response>::SubscriptionCallback;
+
+public:
+    // NOLINTNEXTLINE(google-explicit-constructor,hicpp-explicit-conversions)
+    CallbackStreamRpcHandlerCallbackSetter(detail::CallbackStreamRpcHandler<Request, Response>* stream);
+
+    /// \brief Set the ConnectionCallback function for this stream
+    CallbackStreamRpcHandlerCallbackSetter<Request, Response>& on_connect(StreamConnectionCallback connection_callback);
+
+    /// \brief Set the DeletionCallback function for this stream
+    CallbackStreamRpcHandlerCallbackSetter<Request, Response>& on_delete(StreamDeletionCallback deletion_callback);
+
+    /// \brief Set the topics each new connection receives from `StreamInterface::publish`
+    CallbackStreamRpcHandlerCallbackSetter<Request, Response>&
+    on_subscribe(StreamSubscriptionCallback subscription_callback);
+
+    /// \brief Set how many updates each client can have waiting (see `CallbackStreamRpcHandler`)
+    CallbackStreamRpcHandlerCallbackSetter<Request, Response>& limit_pending_updates(std::size_t max_pending_updates);
+
+    /// \brief Return the stream used to send updates to the clients
+    StreamInterface<Response>* stream();
+
+private:
+    CallbackStreamRpcHandler<Request, Response>* stream_;
+};
+
+template <typename Request, typename Response>
+CallbackStreamRpcHandlerCallbackSetter<Request, Response>::CallbackStreamRpcHandlerCallbackSetter(
+    detail::CallbackStreamRpcHandler<Request, Response>* stream)
+    : stream_(stream) {}
+
+template <typename Request, typename Response>
+CallbackStreamRpcHandlerCallbackSetter<Request, Response>&
+CallbackStreamRpcHandlerCallbackSetter<Request, Response>::on_connect(StreamConnectionCallback connection_callback) {
+    stream_->on_connect(std::move(connection_callback));
+    return *this;
+}
+
+template <typename Request, typename Response>
+CallbackStreamRpcHandlerCallbackSetter<Request, Response>&
+CallbackStreamRpcHandlerCallbackSetter<Request, Response>::on_delete(StreamDeletionCallback deletion_callback) {
+    stream_->on_delete(std::move(deletion_callback));
+    return *this;
+}
+
+template <typename Request, typename Response>
+CallbackStreamRpcHandlerCallbackSetter<Request, Response>&
+CallbackStreamRpcHandlerCallbackSetter<Request, Response>::on_subscribe(
+    StreamSubscriptionCallback subscription_callback) {
+    stream_->on_subscribe(std::move(subscription_callback));
+    return *this;
+}
+
+template <typename Request, typename Response>
+CallbackStreamRpcHandlerCallbackSetter<Request, Response>&
+CallbackStreamRpcHandlerCallbackSetter<Request, Response>::limit_pending_updates(std::size_t max_pending_updates) {
+    stream_->limit_pending_updates(max_pending_updates);
+    return *this;
+}
+
+template <typename Request, typename Response>
+StreamInterface<Response>* CallbackStreamRpcHandlerCallbackSetter<Request, Response>::stream() {
+    return stream_;
+}
+
+} // namespace detail
+} // namespace server
+} // namespace grpcw
+
+#endif // LTB_GRPCW_ENABLE_CALLBACK_SERVER
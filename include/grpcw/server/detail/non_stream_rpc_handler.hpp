@@ -22,7 +22,9 @@
 // ///////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 
+#include "grpcw/server/compression_options.hpp"
 #include "grpcw/server/detail/async_rpc_handler_interface.hpp"
+#include "grpcw/server/detail/queue_lag_monitor.hpp"
 #include "grpcw/server/detail/stream_rpc_handler.hpp"
 #include "grpcw/server/detail/tag.hpp"
 #include "grpcw/util/atomic_data.hpp"
@@ -63,7 +65,9 @@ public:
     explicit NonStreamRpcHandler(Service& service,
                                  grpc::ServerCompletionQueue& server_queue,
                                  AsyncNoStreamFunc<Service, Request, Response> stream_func,
-                                 Callback callback);
+                                 Callback callback,
+                                 CompressionOptions compression = {},
+                                 const QueueLagMonitor* lag_monitor = nullptr);
 
     ~NonStreamRpcHandler() override;
 
@@ -77,6 +81,8 @@ private:
     grpc::ServerCompletionQueue& server_queue_; ///< The queue that handles server updates
     AsyncNoStreamFunc<Service, Request, Response> stream_func_; ///< The service function used to update the queue
     Callback callback_; ///< The server specific implementation of this RPC call
+    CompressionOptions compression_; ///< How (and when) responses should be compressed
+    const QueueLagMonitor* lag_monitor_; ///< Rejects calls while the server is overloaded (optional)
     grpc::CompletionQueue queue_; ///< Internal queue used to handle responses (required for async api)
 
     /// All the data needed to handle the RPC call when a client make a request
@@ -88,8 +94,15 @@ NonStreamRpcHandler<Service, Request, Response, Callback>::NonStreamRpcHandler(
     Service& service,
     grpc::ServerCompletionQueue& server_queue,
     AsyncNoStreamFunc<Service, Request, Response> stream_func,
-    Callback callback)
-    : service_(service), server_queue_(server_queue), stream_func_(stream_func), callback_(std::move(callback)) {}
+    Callback callback,
+    CompressionOptions compression,
+    const QueueLagMonitor* lag_monitor)
+    : service_(service),
+      server_queue_(server_queue),
+      stream_func_(stream_func),
+      callback_(std::move(callback)),
+      compression_(compression),
+      lag_monitor_(lag_monitor) {}
 
 template <typename Service, typename Request, typename Response, typename Callback>
 NonStreamRpcHandler<Service, Request, Response, Callback>::~NonStreamRpcHandler() {
@@ -104,10 +117,37 @@ NonStreamRpcHandler<Service, Request, Response, Callback>::~NonStreamRpcHandler(
 
 template <typename Service, typename Request, typename Response, typename Callback>
 void NonStreamRpcHandler<Service, Request, Response, Callback>::activate_next() {
-    if (connection_) {
+    // The call that just arrived (if any)
+    auto connection = std::move(connection_);
+
+    // Request the next call before answering this one. Once a client has its response the server
+    // can be shut down, and requesting a call after that is an error.
+    connection_ = std::make_unique<NonStreamRpcConnection<Request, Response>>();
+
+    (service_.*stream_func_)(&connection_->context,
+                             &connection_->request,
+                             &connection_->responder,
+                             &queue_,
+                             &server_queue_,
+                             this);
+
+    if (connection) {
         Response response;
-        grpc::Status status = callback_(connection_->request, &response);
-        connection_->responder.Finish(response, status, &response);
+
+        if (lag_monitor_ and lag_monitor_->overloaded()) {
+            // Turn new calls away so the ones already admitted still finish on time
+            connection->responder.FinishWithError(grpc::Status(grpc::StatusCode::UNAVAILABLE,
+                                                               "Server is overloaded, try again later"),
+                                                  &response);
+        } else {
+            grpc::Status status = callback_(connection->request, &response);
+
+            // Small responses are not worth the CPU so only enable compression for large ones
+            if (should_compress(compression_, response.ByteSizeLong())) {
+                apply_compression(compression_, &connection->context);
+            }
+            connection->responder.Finish(response, status, &response);
+        }
 
         void* recv_tag;
         bool call_ok;
@@ -119,16 +159,6 @@ void NonStreamRpcHandler<Service, Request, Response, Callback>::activate_next()
             assert(false);
         }
     }
-
-    // Add a new connection that is waiting to be activated
-    connection_ = std::make_unique<NonStreamRpcConnection<Request, Response>>();
-
-    (service_.*stream_func_)(&connection_->context,
-                             &connection_->request,
-                             &connection_->responder,
-                             &queue_,
-                             &server_queue_,
-                             this);
 }
 
 } // namespace detail
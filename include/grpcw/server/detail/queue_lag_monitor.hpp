@@ -0,0 +1,86 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// grpcw
+#include "grpcw/server/load_shedding.hpp"
+#include "grpcw/util/atomic_data.hpp"
+
+// third-party
+#include <grpc++/alarm.h>
+#include <grpc++/completion_queue.h>
+
+// standard
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace grpcw {
+namespace server {
+namespace detail {
+
+/**
+ * @brief Periodically measures how long completed events wait in a completion queue
+ *
+ * The thread reading the queue passes every tag to 'is_probe' and hands probes to
+ * 'on_probe' instead of treating them as rpc tags.
+ */
+class QueueLagMonitor {
+public:
+    /// \brief Start probing 'queue' (throws std::invalid_argument if the monitor is already running)
+    void start(grpc::CompletionQueue* queue, LoadShedding options);
+
+    /// \brief Stop probing. A pending probe is returned by the queue with 'call_ok' set to false.
+    void stop();
+
+    bool is_probe(void* tag) const;
+
+    /// \brief Record the lag of the probe that was just handled and schedule the next one
+    void on_probe(bool call_ok);
+
+    /// \brief The lag measured by the last probe
+    std::chrono::nanoseconds queue_lag() const;
+
+    /// \brief True if new calls should be rejected
+    bool overloaded() const;
+
+private:
+    struct State {
+        grpc::CompletionQueue* queue = nullptr;
+        bool stopped = false;
+        LoadShedding options = {};
+        std::chrono::system_clock::time_point deadline = {};
+    };
+
+    util::AtomicData<State> state_;
+    grpc::Alarm probe_alarm_; ///< Only set or cancelled while 'state_' is locked
+
+    std::atomic<std::int64_t> lag_nanoseconds_{0};
+    std::atomic_bool overloaded_{false};
+
+    void schedule_probe(State* state);
+};
+
+} // namespace detail
+} // namespace server
+} // namespace grpcw
@@ -24,13 +24,26 @@
 
 // grpcw
 #include "grpcw/forward_declarations.hpp"
+#include "grpcw/server/compression_options.hpp"
 #include "grpcw/server/detail/async_rpc_handler_interface.hpp"
 #include "grpcw/server/detail/tag.hpp"
 #include "grpcw/util/atomic_data.hpp"
+#include "grpcw/util/delta_encoding.hpp"
+#include "grpcw/util/mpsc_queue.hpp"
+#include "grpcw/util/subscriber_index.hpp"
+
+// third-party
+#include <grpc++/alarm.h>
 
 // standard
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <stdexcept>
+#include <string>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
@@ -44,6 +57,7 @@ public:
     virtual ~StreamInterface() = 0;
     virtual bool write(const Response& update) = 0;
     virtual bool write(const Response& update, ClientID client) = 0;
+    virtual bool publish(const std::string& topic, const Response& update) = 0;
     virtual bool finish(const grpc::Status& status) = 0;
     virtual bool finish(const grpc::Status& status, ClientID client) = 0;
 };
@@ -51,6 +65,32 @@ public:
 template <typename Response>
 StreamInterface<Response>::~StreamInterface() = default;
 
+///
+/// \brief Settings for queueing stream writes and sending them in batches.
+///
+/// Queued updates are flushed once 'max_batch_size' updates are waiting or 'max_delay'
+/// has passed since the first one was queued, whichever happens first.
+///
+/// gRPC only allows one write in flight per stream, so each update is still sent as its own
+/// message unless 'merge_updates' is set. Batching then only spares 'write' from waiting until
+/// every client has received the previous update.
+///
+struct WriteBatching {
+    std::size_t max_batch_size = 64;
+    std::chrono::microseconds max_delay = std::chrono::milliseconds(1);
+
+    /// 'write' blocks while any client has this many updates waiting to be sent (at least 1)
+    std::size_t max_pending_updates = 1024;
+
+    ///
+    /// Send all the updates waiting for a client as one message combined with 'MergeFrom'.
+    ///
+    /// Only for envelope messages that hold their updates in repeated fields (for example
+    /// 'repeated Update updates = 1'). Singular fields would only keep the latest value.
+    ///
+    bool merge_updates = false;
+};
+
 namespace detail {
 
 template <typename Request, typename Response>
@@ -58,6 +98,10 @@ struct StreamConnection {
     grpc::ServerContext context;
     Request request;
     grpc::ServerAsyncWriter<Response> responder;
+    bool delta_encoding = false; ///< Enabled on the handler and requested by the client
+    std::unique_ptr<Response> last_update = nullptr; ///< Only used when delta encoding is enabled
+    std::deque<std::shared_ptr<const Response>> pending; ///< Only used when write batching is enabled
+    bool done = false; ///< The call ended while a write or finish was still being processed
 
     StreamConnection() : responder(&context) {}
 };
@@ -67,22 +111,63 @@ class StreamRpcHandler : public AsyncRpcHandlerInterface, public StreamInterface
 public:
     using ConnectionCallback = std::function<void(const Request&, ClientID)>;
     using DeletionCallback = std::function<void(const Request&, ClientID)>;
+    using SubscriptionCallback = std::function<std::vector<std::string>(const Request&)>;
 
     explicit StreamRpcHandler(Service& service,
                               grpc::ServerCompletionQueue& server_queue,
-                              AsyncServerStreamFunc<Service, Request, Response> stream_func);
+                              AsyncServerStreamFunc<Service, Request, Response> stream_func,
+                              CompressionOptions compression = {});
 
     ~StreamRpcHandler() override;
 
     StreamRpcHandler<Service, Request, Response>& on_connect(ConnectionCallback connection_callback);
     StreamRpcHandler<Service, Request, Response>& on_delete(DeletionCallback deletion_callback);
 
+    /**
+     * @brief Maps the request of each new connection to the topics it receives from `publish`
+     */
+    StreamRpcHandler<Service, Request, Response>& on_subscribe(SubscriptionCallback subscription_callback);
+
+    /**
+     * @brief Only send the fields that changed since the last update each client received
+     *
+     * Only clients that send the `util::delta_encoding_metadata_key` metadata receive deltas. They
+     * must decode the updates with `util::apply_delta` (see `GrpcClientStream`).
+     */
+    StreamRpcHandler<Service, Request, Response>& enable_delta_encoding();
+
+    /**
+     * @brief Queue writes and send them in batches instead of one at a time
+     *
+     * `write` no longer waits for the previous update to be sent, only for clients that have
+     * `max_pending_updates` waiting. Leave this disabled for latency sensitive streams.
+     * Throws std::invalid_argument if `max_pending_updates` is zero.
+     */
+    StreamRpcHandler<Service, Request, Response>& enable_write_batching(WriteBatching batching);
+
+    /**
+     * @brief Hand updates to the handler's thread through a lock-free queue
+     *
+     * `write` and `publish` never block or take the connections lock. The updates are matched to
+     * clients later on the handler's thread and are sent as soon as that thread wakes up unless write
+     * batching is also enabled. `write(update, client)` still returns false if 'client' is not
+     * connected (it checks a separate set of clients).
+     *
+     * Both sides are bounded by `WriteBatching::max_pending_updates` (the default `WriteBatching`
+     * unless batching is enabled). `write` and `publish` return false without queueing the update
+     * while that many submissions are waiting for the handler's thread. A client that already has
+     * that many updates waiting loses its oldest one, or has the new one merged into its newest
+     * one when `merge_updates` is set.
+     */
+    StreamRpcHandler<Service, Request, Response>& enable_submission_queue();
+
     /**
      * @see AsyncRpcHandlerInterface::activate_next()
      */
     void activate_next() override;
     bool write(const Response& update) override;
     bool write(const Response& update, ClientID client) override;
+    bool publish(const std::string& topic, const Response& update) override;
     bool finish(const grpc::Status& status) override;
     bool finish(const grpc::Status& status, ClientID client) override;
 
@@ -90,14 +175,20 @@ private:
     Service& service_;
     grpc::ServerCompletionQueue& server_queue_;
     AsyncServerStreamFunc<Service, Request, Response> stream_func_;
+    CompressionOptions compression_;
     ConnectionCallback connection_callback_;
     DeletionCallback deletion_callback_;
+    SubscriptionCallback subscription_callback_;
 
     struct Connections {
         std::unique_ptr<StreamConnection<Request, Response>> next = nullptr;
         std::unordered_map<void*, std::unique_ptr<StreamConnection<Request, Response>>> active = {};
         std::unordered_set<void*> processing = {};
         std::unordered_map<void*, std::unique_ptr<Tag>> tags;
+        util::SubscriberIndex<void*> subscribers; ///< Only used when 'on_subscribe' is set
+
+        std::size_t batched_updates = 0; ///< Updates queued since the last flush
+        bool flush_scheduled = false;
     };
 
     grpcw::util::AtomicData<Connections> connections_;
@@ -106,21 +197,75 @@ private:
 
     std::thread sync_thread_;
 
+    bool delta_encoding_ = false;
+
+    std::atomic_bool batching_enabled_{false};
+    WriteBatching batching_;
+    grpc::Alarm flush_alarm_;
+
+    /// An update waiting in the submission queue
+    struct Submission {
+        std::shared_ptr<const Response> update = nullptr;
+        ClientID client = nullptr;
+        std::string topic = {};
+        bool publish = false;
+    };
+
+    std::atomic_bool submission_queue_enabled_{false};
+    util::MpscQueue<Submission> submissions_; ///< Only popped while 'connections_' is locked
+    std::atomic<std::size_t> queued_submissions_{0u}; ///< Pushed but not yet popped from 'submissions_'
+    util::AtomicData<std::unordered_set<ClientID>> connected_clients_; ///< Only changed while 'connections_' is locked
+    std::atomic_bool wake_scheduled_{false};
+    grpc::Alarm wake_alarm_; ///< Wakes the sync thread when there are submissions (uses itself as the tag)
+
+    /// The connections an update is sent to: a single client, every subscriber of a topic, or everyone
+    struct Target {
+        ClientID client = nullptr;
+        const std::string* topic = nullptr;
+    };
+
     void run_synchronization();
+
+    /// \brief Calls 'func(key, connection)' for each connection in 'target'. False if 'client' is not active.
+    template <typename Func>
+    static bool for_each_target(Connections* connections, const Target& target, const Func& func);
+
+    bool write_to_target(const Response& update, const Target& target);
+    void remove_connection(void* key, Connections* connections);
+
+    bool queue_batched_update(const Response& update, const Target& target);
+    void schedule_batches(std::size_t new_updates, Connections* connections);
+
+    /// \brief Returns false if the submission queue is full
+    bool submit(const Response& update, const Target& target);
+    void drain_submissions(Connections* connections);
+    void flush_batches(Connections* connections);
+    void write_next_batched_update(void* key,
+                                   StreamConnection<Request, Response>* connection,
+                                   Connections* connections);
+
+    void write_to_connection(const Response& update,
+                             const grpc::WriteOptions& write_options,
+                             void* key,
+                             StreamConnection<Request, Response>* connection,
+                             Connections* connections);
 };
 
 template <typename Service, typename Request, typename Response>
 StreamRpcHandler<Service, Request, Response>::StreamRpcHandler(
     Service& service,
     grpc::ServerCompletionQueue& server_queue,
-    AsyncServerStreamFunc<Service, Request, Response> stream_func)
-    : service_(service), server_queue_(server_queue), stream_func_(stream_func) {
+    AsyncServerStreamFunc<Service, Request, Response> stream_func,
+    CompressionOptions compression)
+    : service_(service), server_queue_(server_queue), stream_func_(stream_func), compression_(compression) {
 
     sync_thread_ = std::thread(&StreamRpcHandler<Service, Request, Response>::run_synchronization, this);
 }
 
 template <typename Service, typename Request, typename Response>
 StreamRpcHandler<Service, Request, Response>::~StreamRpcHandler() {
+    flush_alarm_.Cancel();
+    wake_alarm_.Cancel();
     queue_.Shutdown();
     sync_thread_.join();
 }
@@ -139,16 +284,64 @@ StreamRpcHandler<Service, Request, Response>::on_delete(DeletionCallback deletio
     return *this;
 }
 
+template <typename Service, typename Request, typename Response>
+StreamRpcHandler<Service, Request, Response>&
+StreamRpcHandler<Service, Request, Response>::on_subscribe(SubscriptionCallback subscription_callback) {
+    connections_.use_safely(
+        [&](const Connections&) { subscription_callback_ = std::move(subscription_callback); });
+    return *this;
+}
+
+template <typename Service, typename Request, typename Response>
+StreamRpcHandler<Service, Request, Response>& StreamRpcHandler<Service, Request, Response>::enable_delta_encoding() {
+    connections_.use_safely([this](const Connections&) { delta_encoding_ = true; });
+    return *this;
+}
+
+template <typename Service, typename Request, typename Response>
+StreamRpcHandler<Service, Request, Response>&
+StreamRpcHandler<Service, Request, Response>::enable_write_batching(WriteBatching batching) {
+    if (batching.max_pending_updates == 0u) {
+        throw std::invalid_argument("WriteBatching::max_pending_updates must be at least 1");
+    }
+
+    connections_.use_safely([&](const Connections&) { batching_ = batching; });
+    batching_enabled_ = true;
+    return *this;
+}
+
+template <typename Service, typename Request, typename Response>
+StreamRpcHandler<Service, Request, Response>& StreamRpcHandler<Service, Request, Response>::enable_submission_queue() {
+    submission_queue_enabled_ = true;
+    return *this;
+}
+
 template <typename Service, typename Request, typename Response>
 void StreamRpcHandler<Service, Request, Response>::activate_next() {
     connections_.use_safely([this](Connections& connections) {
         if (connections.next) {
             void* key = connections.next.get();
 
+            // Before the callback since it can write to the client right away
+            connected_clients_.use_safely([key](std::unordered_set<ClientID>& clients) { clients.emplace(key); });
+
             if (connection_callback_) {
                 connection_callback_(connections.next->request, key);
             }
 
+            if (subscription_callback_) {
+                connections.subscribers.subscribe(key, subscription_callback_(connections.next->request));
+            }
+
+            // Has to be set before the first write sends the initial metadata
+            apply_compression(compression_, &connections.next->context);
+
+            // Other clients would not know how to rebuild the full updates
+            const auto& client_metadata = connections.next->context.client_metadata();
+            connections.next->delta_encoding
+                = delta_encoding_
+                  and client_metadata.find(util::delta_encoding_metadata_key) != client_metadata.end();
+
             // 'next' is now an active connection
             connections.active.emplace(key, std::move(connections.next));
             connections.next = nullptr; // just in case because the data was moved
@@ -176,9 +369,32 @@ bool StreamRpcHandler<Service, Request, Response>::write(const Response& update)
 
 template <typename Service, typename Request, typename Response>
 bool StreamRpcHandler<Service, Request, Response>::write(const Response& update, ClientID client) {
+    return write_to_target(update, Target{client, nullptr});
+}
+
+template <typename Service, typename Request, typename Response>
+bool StreamRpcHandler<Service, Request, Response>::publish(const std::string& topic, const Response& update) {
+    return write_to_target(update, Target{nullptr, &topic});
+}
+
+template <typename Service, typename Request, typename Response>
+bool StreamRpcHandler<Service, Request, Response>::finish(const grpc::Status& status) {
+    return finish(status, nullptr);
+}
+
+template <typename Service, typename Request, typename Response>
+bool StreamRpcHandler<Service, Request, Response>::finish(const grpc::Status& status, ClientID client) {
 
     auto previous_updates_processed = [](const Connections& connections) { return connections.processing.empty(); };
 
+    // Send everything still waiting in a batch or the submission queue before finishing
+    if (batching_enabled_ or submission_queue_enabled_) {
+        connections_.use_safely([this](Connections& connections) {
+            drain_submissions(&connections);
+            flush_batches(&connections);
+        });
+    }
+
     bool notify;
     bool result = true;
 
@@ -190,7 +406,7 @@ bool StreamRpcHandler<Service, Request, Response>::write(const Response& update,
             if (connections.active.find(client) != connections.active.end()) {
                 std::unique_ptr<StreamConnection<Request, Response>>& connection = connections.active.at(client);
 
-                connection->responder.Write(update, detail::make_tag(client, TagLabel::writing, &connections.tags));
+                connection->responder.Finish(status, detail::make_tag(client, TagLabel::writing, &connections.tags));
                 connections.processing.emplace(client); // mark as being processed
             } else {
                 result = false;
@@ -201,7 +417,7 @@ bool StreamRpcHandler<Service, Request, Response>::write(const Response& update,
                 void* key = active_pair.first;
                 std::unique_ptr<StreamConnection<Request, Response>>& connection = active_pair.second;
 
-                connection->responder.Write(update, detail::make_tag(key, TagLabel::writing, &connections.tags));
+                connection->responder.Finish(status, detail::make_tag(key, TagLabel::writing, &connections.tags));
                 connections.processing.emplace(key); // mark as being processed
             }
         }
@@ -215,50 +431,290 @@ bool StreamRpcHandler<Service, Request, Response>::write(const Response& update,
 }
 
 template <typename Service, typename Request, typename Response>
-bool StreamRpcHandler<Service, Request, Response>::finish(const grpc::Status& status) {
-    return finish(status, nullptr);
+template <typename Func>
+bool StreamRpcHandler<Service, Request, Response>::for_each_target(Connections* connections,
+                                                                   const Target& target,
+                                                                   const Func& func) {
+    if (target.topic) {
+        // Only visits the subscribers of this topic instead of every connection
+        connections->subscribers.for_each_subscriber(*target.topic,
+                                                     [&](void* key) { func(key, connections->active.at(key).get()); });
+        return true;
+    }
+
+    if (target.client) {
+        auto iter = connections->active.find(target.client);
+        if (iter == connections->active.end()) {
+            return false;
+        }
+        func(iter->first, iter->second.get());
+        return true;
+    }
+
+    for (auto& active_pair : connections->active) {
+        func(active_pair.first, active_pair.second.get());
+    }
+    return true;
 }
 
 template <typename Service, typename Request, typename Response>
-bool StreamRpcHandler<Service, Request, Response>::finish(const grpc::Status& status, ClientID client) {
+bool StreamRpcHandler<Service, Request, Response>::write_to_target(const Response& update, const Target& target) {
+
+    if (submission_queue_enabled_) {
+        // The client can still disconnect before the update is sent, in which case it is dropped
+        if (target.client) {
+            bool connected = connected_clients_.use_safely(
+                [&target](const std::unordered_set<ClientID>& clients) { return clients.count(target.client) > 0; });
+
+            if (not connected) {
+                return false;
+            }
+        }
+
+        return submit(update, target);
+    }
+
+    if (batching_enabled_) {
+        return queue_batched_update(update, target);
+    }
 
     auto previous_updates_processed = [](const Connections& connections) { return connections.processing.empty(); };
 
+    // The size (and therefore the compression decision) is the same for every client
+    grpc::WriteOptions write_options;
+    if (not should_compress(compression_, update.ByteSizeLong())) {
+        write_options.set_no_compression();
+    }
+
     bool notify;
-    bool result = true;
+    bool result;
 
     // Wait until all previous updates have finished processing
     connections_.wait_to_use_safely(previous_updates_processed, [&](Connections& connections) {
-        notify = connections.active.empty();
+        result = for_each_target(&connections,
+                                 target,
+                                 [&](void* key, StreamConnection<Request, Response>* connection) {
+                                     write_to_connection(update, write_options, key, connection, &connections);
+                                 });
+
+        // Nothing was written so the next waiting call can continue right away
+        notify = connections.processing.empty();
+    });
 
-        if (client) {
-            if (connections.active.find(client) != connections.active.end()) {
-                std::unique_ptr<StreamConnection<Request, Response>>& connection = connections.active.at(client);
+    if (notify) {
+        connections_.notify_one();
+    }
 
-                connection->responder.Finish(status, detail::make_tag(client, TagLabel::writing, &connections.tags));
-                connections.processing.emplace(client); // mark as being processed
-            } else {
-                result = false;
-            }
+    return result;
+}
+
+template <typename Service, typename Request, typename Response>
+void StreamRpcHandler<Service, Request, Response>::remove_connection(void* key, Connections* connections) {
+    auto iter = connections->active.find(key);
+
+    // Already removed by an earlier tag
+    if (iter == connections->active.end()) {
+        return;
+    }
+
+    // Before the callback so writes to the client fail once it knows the client is gone
+    connected_clients_.use_safely([key](std::unordered_set<ClientID>& clients) { clients.erase(key); });
+
+    if (deletion_callback_) {
+        deletion_callback_(iter->second->request, key);
+    }
+    connections->subscribers.unsubscribe(key);
+    connections->active.erase(iter);
+}
+
+template <typename Service, typename Request, typename Response>
+void StreamRpcHandler<Service, Request, Response>::write_to_connection(const Response& update,
+                                                                       const grpc::WriteOptions& write_options,
+                                                                       void* key,
+                                                                       StreamConnection<Request, Response>* connection,
+                                                                       Connections* connections) {
+    void* tag = detail::make_tag(key, TagLabel::writing, &connections->tags);
+
+    if (connection->delta_encoding and connection->last_update) {
+        Response delta;
+        util::encode_delta(*connection->last_update, update, &delta);
+
+        // The delta is usually much smaller than the full update so the compression decision can change
+        grpc::WriteOptions delta_write_options = write_options;
+        if (should_compress(compression_, delta.ByteSizeLong())) {
+            delta_write_options.clear_no_compression();
         } else {
-            // Write the update to all active streams
-            for (auto& active_pair : connections.active) {
-                void* key = active_pair.first;
-                std::unique_ptr<StreamConnection<Request, Response>>& connection = active_pair.second;
+            delta_write_options.set_no_compression();
+        }
 
-                connection->responder.Finish(status, detail::make_tag(key, TagLabel::writing, &connections.tags));
-                connections.processing.emplace(key); // mark as being processed
-            }
+        connection->responder.Write(delta, delta_write_options, tag);
+        *connection->last_update = update;
+
+    } else {
+        connection->responder.Write(update, write_options, tag);
+
+        // The first update is always sent in full
+        if (connection->delta_encoding) {
+            connection->last_update = std::make_unique<Response>(update);
+        }
+    }
+
+    connections->processing.emplace(key); // mark as being processed
+}
+
+template <typename Service, typename Request, typename Response>
+bool StreamRpcHandler<Service, Request, Response>::queue_batched_update(const Response& update,
+                                                                        const Target& target) {
+    // Every client shares the same copy of the update
+    auto shared_update = std::make_shared<const Response>(update);
+    bool result;
+
+    // A client that can't keep up holds back every update, like unbatched writes do
+    auto room_for_update = [this](const Connections& connections) {
+        return std::all_of(connections.active.begin(), connections.active.end(), [this](const auto& active_pair) {
+            return active_pair.second->pending.size() < batching_.max_pending_updates;
+        });
+    };
+
+    connections_.wait_to_use_safely(room_for_update, [&](Connections& connections) {
+        result = for_each_target(&connections, target, [&](void*, StreamConnection<Request, Response>* connection) {
+            connection->pending.emplace_back(shared_update);
+        });
+
+        if (result) {
+            schedule_batches(1u, &connections);
         }
     });
 
-    if (notify) {
-        connections_.notify_one();
+    return result;
+}
+
+template <typename Service, typename Request, typename Response>
+void StreamRpcHandler<Service, Request, Response>::schedule_batches(std::size_t new_updates,
+                                                                    Connections* connections) {
+    connections->batched_updates += new_updates;
+
+    if (connections->batched_updates >= batching_.max_batch_size) {
+        flush_batches(connections);
+
+    } else if (not connections->flush_scheduled) {
+        // Make sure the batch is sent even if no more updates arrive
+        auto deadline = std::chrono::system_clock::now() + batching_.max_delay;
+        flush_alarm_.Set(&queue_, deadline, detail::make_tag(this, TagLabel::flush, &connections->tags));
+        connections->flush_scheduled = true;
     }
+}
 
+template <typename Service, typename Request, typename Response>
+bool StreamRpcHandler<Service, Request, Response>::submit(const Response& update, const Target& target) {
+    // Reserve a place before pushing so producers can't get ahead of the handler's thread
+    if (queued_submissions_.fetch_add(1u) >= batching_.max_pending_updates) {
+        --queued_submissions_;
+        return false;
+    }
+
+    Submission submission;
+    submission.update = std::make_shared<const Response>(update);
+    submission.client = target.client;
+
+    if (target.topic) {
+        submission.topic = *target.topic;
+        submission.publish = true;
+    }
+
+    submissions_.push(std::move(submission));
+
+    // Only the first submission since the last wake up has to set the alarm
+    if (not wake_scheduled_.exchange(true)) {
+        // A deadline in the past makes the alarm fire right away
+        wake_alarm_.Set(&queue_, gpr_time_0(GPR_CLOCK_MONOTONIC), &wake_alarm_);
+    }
     return true;
 }
 
+template <typename Service, typename Request, typename Response>
+void StreamRpcHandler<Service, Request, Response>::drain_submissions(Connections* connections) {
+    std::size_t new_updates = 0u;
+    Submission submission;
+
+    while (submissions_.pop(&submission)) {
+        --queued_submissions_;
+        Target target{submission.client, submission.publish ? &submission.topic : nullptr};
+
+        // Updates for clients that are no longer connected are dropped
+        for_each_target(connections, target, [&](void*, StreamConnection<Request, Response>* connection) {
+            auto& pending = connection->pending;
+
+            // A client that can't keep up doesn't get to hold every update in memory
+            if (pending.size() >= batching_.max_pending_updates) {
+                if (batching_.merge_updates) {
+                    auto merged = std::make_shared<Response>(*pending.back());
+                    merged->MergeFrom(*submission.update);
+                    pending.back() = std::move(merged);
+                    return;
+                }
+                pending.pop_front();
+            }
+            pending.emplace_back(submission.update);
+        });
+        ++new_updates;
+    }
+
+    if (new_updates == 0u) {
+        return;
+    }
+
+    if (batching_enabled_) {
+        schedule_batches(new_updates, connections);
+    } else {
+        flush_batches(connections);
+    }
+}
+
+template <typename Service, typename Request, typename Response>
+void StreamRpcHandler<Service, Request, Response>::flush_batches(Connections* connections) {
+    connections->batched_updates = 0;
+
+    for (auto& active_pair : connections->active) {
+        void* key = active_pair.first;
+        std::unique_ptr<StreamConnection<Request, Response>>& connection = active_pair.second;
+
+        // Connections that are still writing will continue with their pending updates when the write completes
+        if (not connection->pending.empty() and connections->processing.find(key) == connections->processing.end()) {
+            write_next_batched_update(key, connection.get(), connections);
+        }
+    }
+}
+
+template <typename Service, typename Request, typename Response>
+void StreamRpcHandler<Service, Request, Response>::write_next_batched_update(
+    void* key,
+    StreamConnection<Request, Response>* connection,
+    Connections* connections) {
+
+    std::shared_ptr<const Response> update = std::move(connection->pending.front());
+    connection->pending.pop_front();
+
+    // Everything waiting goes out in one message instead of one write per update
+    if (batching_.merge_updates and not connection->pending.empty()) {
+        auto merged = std::make_shared<Response>(*update);
+        for (const auto& pending : connection->pending) {
+            merged->MergeFrom(*pending);
+        }
+        connection->pending.clear();
+        update = std::move(merged);
+    }
+
+    // No buffer hint here. Only one write can be in flight per stream and a hinted write is not
+    // completed until something flushes it, so over a real transport the batch would never finish.
+    grpc::WriteOptions write_options;
+    if (not should_compress(compression_, update->ByteSizeLong())) {
+        write_options.set_no_compression();
+    }
+
+    write_to_connection(*update, write_options, key, connection, connections);
+}
+
 template <typename Service, typename Request, typename Response>
 void StreamRpcHandler<Service, Request, Response>::run_synchronization() {
 
@@ -268,6 +724,18 @@ void StreamRpcHandler<Service, Request, Response>::run_synchronization() {
     while (queue_.Next(&recv_tag, &call_ok)) {
         bool all_streams_processed = false;
 
+        // The wake alarm is not in the tag map since producers can't lock 'connections_' to add it
+        if (recv_tag == &wake_alarm_) {
+            if (call_ok) {
+                connections_.use_safely([this](Connections& connections) {
+                    // Reset before draining so a submission racing with the drain sets the alarm again
+                    wake_scheduled_.exchange(false);
+                    drain_submissions(&connections);
+                });
+            }
+            continue;
+        }
+
         connections_.use_safely([&](Connections& connections) {
             Tag tag = detail::get_tag(recv_tag, &connections.tags);
 
@@ -279,33 +747,55 @@ void StreamRpcHandler<Service, Request, Response>::run_synchronization() {
 
                 // Remove the stream if it is finished
                 if (not call_ok) {
+                    remove_connection(tag.data, &connections);
 
-                    if (deletion_callback_) {
-                        deletion_callback_(static_cast<StreamConnection<Request, Response>*>(tag.data)->request,
-                                           tag.data);
+                } else {
+                    auto iter = connections.active.find(tag.data);
+
+                    // The done tag came first, while this tag was still pending
+                    if (iter != connections.active.end() and iter->second->done) {
+                        remove_connection(tag.data, &connections);
+
+                    } else if (iter != connections.active.end() and not iter->second->pending.empty()) {
+                        // Keep sending batched updates until the connection has caught up
+                        write_next_batched_update(tag.data, iter->second.get(), &connections);
                     }
-                    connections.active.erase(tag.data);
                 }
 
                 all_streams_processed = connections.processing.empty();
                 break;
 
+            case TagLabel::flush:
+                connections.flush_scheduled = false;
+
+                // The alarm is cancelled when the handler is destroyed
+                if (call_ok) {
+                    flush_batches(&connections);
+                }
+                break;
+
             case TagLabel::done:
-                // If the stream is not being processed then delete it. Otherwise, it will
-                // be deleted when the queue returns this tag because 'call_ok' will be false.
+                // If the stream is not being processed then delete it. Otherwise, it will be deleted when
+                // the queue returns the writing tag (which can still succeed if it completed before the call ended).
                 if (connections.processing.find(tag.data) == connections.processing.end()) {
-                    if (deletion_callback_) {
-                        deletion_callback_(static_cast<StreamConnection<Request, Response>*>(tag.data)->request,
-                                           tag.data);
+                    remove_connection(tag.data, &connections);
+
+                } else {
+                    auto iter = connections.active.find(tag.data);
+                    if (iter != connections.active.end()) {
+                        iter->second->done = true;
                     }
-                    connections.active.erase(tag.data);
                 }
                 break;
             }
         });
 
-        // Allow the 'write' function to continue since all updates have been processed
-        if (all_streams_processed) {
+        // Batched writes wait for room in the pending updates instead, which any tag can make
+        if (batching_enabled_) {
+            connections_.notify_all();
+
+        } else if (all_streams_processed) {
+            // Allow the 'write' function to continue since all updates have been processed
             connections_.notify_one();
         }
     }
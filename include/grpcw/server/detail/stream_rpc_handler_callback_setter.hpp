@@ -37,6 +37,8 @@ class StreamRpcHandlerCallbackSetter {
     using StreamConnectionCallback =
         typename detail::StreamRpcHandler<BaseService, Request, Response>::ConnectionCallback;
     using StreamDeletionCallback = typename detail::StreamRpcHandler<BaseService, Request, Response>::DeletionCallback;
+    using StreamSubscriptionCallback =
+        typename detail::StreamRpcHandler<BaseService, Request, Response>::SubscriptionCallback;
 
 public:
     // NOLINTNEXTLINE(google-explicit-constructor,hicpp-explicit-conversions)
@@ -49,6 +51,19 @@ public:
     /// \brief Set the DeletionCallback function for this stream
     StreamRpcHandlerCallbackSetter<BaseService, Request, Response>& on_delete(StreamDeletionCallback deletion_callback);
 
+    /// \brief Set the topics each new connection receives from `StreamInterface::publish`
+    StreamRpcHandlerCallbackSetter<BaseService, Request, Response>&
+    on_subscribe(StreamSubscriptionCallback subscription_callback);
+
+    /// \brief Send clients only the fields that changed since their last update
+    StreamRpcHandlerCallbackSetter<BaseService, Request, Response>& enable_delta_encoding();
+
+    /// \brief Queue writes and send them in batches (do not use for latency sensitive streams)
+    StreamRpcHandlerCallbackSetter<BaseService, Request, Response>& enable_write_batching(WriteBatching batching = {});
+
+    /// \brief Never block writing threads. Updates are handed to the stream's thread through a lock-free queue.
+    StreamRpcHandlerCallbackSetter<BaseService, Request, Response>& enable_submission_queue();
+
     /// \brief Return the stream used to send updates to the clients
     StreamInterface<Response>* stream();
 
@@ -76,6 +91,35 @@ StreamRpcHandlerCallbackSetter<BaseService, Request, Response>::on_delete(Stream
     return *this;
 }
 
+template <typename BaseService, typename Request, typename Response>
+StreamRpcHandlerCallbackSetter<BaseService, Request, Response>&
+StreamRpcHandlerCallbackSetter<BaseService, Request, Response>::on_subscribe(
+    StreamSubscriptionCallback subscription_callback) {
+    stream_->on_subscribe(std::move(subscription_callback));
+    return *this;
+}
+
+template <typename BaseService, typename Request, typename Response>
+StreamRpcHandlerCallbackSetter<BaseService, Request, Response>&
+StreamRpcHandlerCallbackSetter<BaseService, Request, Response>::enable_delta_encoding() {
+    stream_->enable_delta_encoding();
+    return *this;
+}
+
+template <typename BaseService, typename Request, typename Response>
+StreamRpcHandlerCallbackSetter<BaseService, Request, Response>&
+StreamRpcHandlerCallbackSetter<BaseService, Request, Response>::enable_write_batching(WriteBatching batching) {
+    stream_->enable_write_batching(batching);
+    return *this;
+}
+
+template <typename BaseService, typename Request, typename Response>
+StreamRpcHandlerCallbackSetter<BaseService, Request, Response>&
+StreamRpcHandlerCallbackSetter<BaseService, Request, Response>::enable_submission_queue() {
+    stream_->enable_submission_queue();
+    return *this;
+}
+
 template <typename BaseService, typename Request, typename Response>
 StreamInterface<Response>* StreamRpcHandlerCallbackSetter<BaseService, Request, Response>::stream() {
     return stream_;
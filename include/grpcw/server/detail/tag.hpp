@@ -34,6 +34,7 @@ namespace detail {
 enum class TagLabel {
     writing,
     done,
+    flush,
 };
 
 struct Tag {
@@ -23,15 +23,23 @@
 #pragma once
 
 // grpcw
+#include "grpcw/server/detail/batch_workers.hpp"
 #include "grpcw/server/detail/non_stream_rpc_handler.hpp"
+#include "grpcw/server/detail/queue_lag_monitor.hpp"
 #include "grpcw/server/detail/stream_rpc_handler_callback_setter.hpp"
 #include "grpcw/util/atomic_data.hpp"
+#include "grpcw/util/batch_fields.hpp"
 
 // third-party
 #include <grpc++/security/server_credentials.h>
 #include <grpc++/server.h>
 #include <grpc++/server_builder.h>
 
+// standard
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
 namespace grpcw {
 namespace server {
 
@@ -41,18 +49,70 @@ using DefaultStreamCallback = void (*)(const Request&);
 template <typename Service>
 class GrpcAsyncServer {
 public:
+    /**
+     * @brief Starts listening on 'address'
+     *
+     * 'address' can be "host:port", "unix:/path/to/socket" or "unix-abstract:name" (Linux only, gRPC 1.34+).
+     * Throws std::runtime_error if the server could not be started on it.
+     */
     explicit GrpcAsyncServer(std::shared_ptr<Service> service, const std::string& address);
     ~GrpcAsyncServer();
 
+    /**
+     * @brief Responses are compressed according to 'compression' (uncompressed by default)
+     */
     template <typename BaseService, typename Request, typename Response, typename Callback>
-    void register_async(AsyncNoStreamFunc<BaseService, Request, Response> no_stream_func, Callback&& callback);
+    void register_async(AsyncNoStreamFunc<BaseService, Request, Response> no_stream_func,
+                        Callback&& callback,
+                        CompressionOptions compression = {});
+
+    /**
+     * @brief Handle a batch rpc by invoking 'callback' for every request in the batch
+     *
+     * 'callback' has the same signature as a 'register_async' callback for a single 'Request'. The
+     * batch request and response must each have one repeated field of 'Request' and 'Response'
+     * (throws std::invalid_argument otherwise). Up to 'parallelism' threads, the queue thread
+     * included, invoke 'callback' at the same time and the responses keep the order of the
+     * requests.
+     *
+     * A batch response with a repeated status field (see 'util::batch_status_field') gets the
+     * status of every request and the batch itself succeeds. Without one, the first failed
+     * request fails the whole batch.
+     *
+     * The queue thread waits for the whole batch so no other call of this server is handled until
+     * the slowest request finishes. Keep batches small enough for that delay.
+     */
+    template <typename Request,
+              typename Response,
+              typename BaseService,
+              typename BatchRequest,
+              typename BatchResponse,
+              typename Callback>
+    void register_async_batch(AsyncNoStreamFunc<BaseService, BatchRequest, BatchResponse> batch_func,
+                              Callback callback,
+                              int parallelism = 4,
+                              CompressionOptions compression = {});
 
     /**
      * @brief StreamInterface* should stop being used before GrpcAsyncServer is destroyed
+     *
+     * Every connection to this stream uses the same 'compression' settings.
      */
     template <typename BaseService, typename Request, typename Response>
     detail::StreamRpcHandlerCallbackSetter<BaseService, Request, Response>
-    register_async_stream(AsyncServerStreamFunc<BaseService, Request, Response> stream_func);
+    register_async_stream(AsyncServerStreamFunc<BaseService, Request, Response> stream_func,
+                          CompressionOptions compression = {});
+
+    /**
+     * @brief Measure the completion queue lag and reject unary calls while it is too high
+     *
+     * The lag is the best overload signal the server has: unary callbacks run on the queue
+     * thread so slow or piled up calls delay every event behind them. Streams are not shed.
+     */
+    void enable_load_shedding(LoadShedding options = {});
+
+    /// \brief The last measured completion queue lag (zero until 'enable_load_shedding' is called)
+    std::chrono::nanoseconds queue_lag() const;
 
     // This is also called in the destructor
     void shutdown_and_wait();
@@ -67,6 +127,8 @@ private:
     std::unique_ptr<grpc::ServerCompletionQueue> server_queue_;
     std::unique_ptr<grpc::Server> server_;
 
+    detail::QueueLagMonitor lag_monitor_; ///< Declared before the handlers since they use it
+
     using RpcMap = std::unordered_map<void*, std::unique_ptr<detail::AsyncRpcHandlerInterface>>;
     util::AtomicData<RpcMap> rpc_handlers_;
 
@@ -84,12 +146,20 @@ GrpcAsyncServer<Service>::GrpcAsyncServer(std::shared_ptr<Service> service, cons
     server_queue_ = builder.AddCompletionQueue();
     server_ = builder.BuildAndStart();
 
+    // Usually an address that is already in use or a socket path that can't be created
+    if (not server_) {
+        throw std::runtime_error("Failed to start a server listening on '" + address + "'");
+    }
+
     run_thread_ = std::thread([&] {
         void* tag;
         bool call_ok;
 
         while (server_queue_->Next(&tag, &call_ok)) {
-            if (call_ok) {
+            if (lag_monitor_.is_probe(tag)) {
+                lag_monitor_.on_probe(call_ok);
+
+            } else if (call_ok) {
                 rpc_handlers_.use_safely([&](RpcMap& rpc_handlers) { rpc_handlers.at(tag)->activate_next(); });
             } else {
                 rpc_handlers_.use_safely([&](RpcMap& rpc_handlers) { rpc_handlers.erase(tag); });
@@ -101,6 +171,7 @@ GrpcAsyncServer<Service>::GrpcAsyncServer(std::shared_ptr<Service> service, cons
 template <typename Service>
 GrpcAsyncServer<Service>::~GrpcAsyncServer() {
     shutdown_and_wait();
+    lag_monitor_.stop();
     server_queue_->Shutdown();
 
     run_thread_.join();
@@ -109,34 +180,109 @@ GrpcAsyncServer<Service>::~GrpcAsyncServer() {
 template <typename Service>
 template <typename BaseService, typename Request, typename Response, typename Callback>
 void GrpcAsyncServer<Service>::register_async(AsyncNoStreamFunc<BaseService, Request, Response> no_stream_func,
-                                              Callback&& callback) {
+                                              Callback&& callback,
+                                              CompressionOptions compression) {
     static_assert(std::is_base_of<BaseService, Service>::value, "BaseService must be a base class of Service");
     auto handler = std::make_unique<
         detail::NonStreamRpcHandler<BaseService, Request, Response, Callback>>(*service_,
                                                                                *server_queue_,
                                                                                no_stream_func,
-                                                                               std::forward<Callback>(callback));
+                                                                               std::forward<Callback>(callback),
+                                                                               compression,
+                                                                               &lag_monitor_);
 
     auto* tag = handler.get();
     rpc_handlers_.use_safely([&](RpcMap& rpc_handlers) { rpc_handlers.emplace(tag, std::move(handler)); });
     tag->activate_next();
 }
 
+template <typename Service>
+template <typename Request,
+          typename Response,
+          typename BaseService,
+          typename BatchRequest,
+          typename BatchResponse,
+          typename Callback>
+void GrpcAsyncServer<Service>::register_async_batch(
+    AsyncNoStreamFunc<BaseService, BatchRequest, BatchResponse> batch_func,
+    Callback callback,
+    int parallelism,
+    CompressionOptions compression) {
+    const auto* request_field = util::batch_field(*BatchRequest::descriptor(), *Request::descriptor());
+    const auto* response_field = util::batch_field(*BatchResponse::descriptor(), *Response::descriptor());
+    const auto* status_field = util::batch_status_field(*BatchResponse::descriptor());
+
+    // Owned by the handler so the threads stop when it is deleted
+    auto workers = std::make_shared<detail::BatchWorkers>(parallelism);
+
+    auto handle_batch = [workers, request_field, response_field, status_field, callback = std::move(callback)](
+                            const BatchRequest& batch_request, BatchResponse* batch_response) {
+        auto size = util::batch_size(batch_request, request_field);
+
+        // Every response is added up front so the threads only touch their own
+        std::vector<Response*> responses;
+        responses.reserve(static_cast<std::size_t>(size));
+        for (int i = 0; i < size; ++i) {
+            responses.emplace_back(util::add_batch_item<Response>(batch_response, response_field));
+        }
+
+        std::vector<grpc::Status> statuses(responses.size());
+
+        workers->run(statuses.size(), [&](std::size_t item) {
+            const auto& request = util::batch_item<Request>(batch_request, request_field, static_cast<int>(item));
+            try {
+                statuses[item] = callback(request, responses[item]);
+            } catch (const std::exception& e) {
+                // Match what a gRPC server reports when a handler throws
+                statuses[item] = {grpc::StatusCode::UNKNOWN, e.what()};
+            }
+        });
+
+        if (status_field) {
+            for (const auto& status : statuses) {
+                util::add_batch_status(batch_response, status_field, status);
+            }
+            return grpc::Status::OK;
+        }
+
+        for (const auto& status : statuses) {
+            if (not status.ok()) {
+                return status;
+            }
+        }
+        return grpc::Status::OK;
+    };
+
+    register_async(batch_func, std::move(handle_batch), compression);
+}
+
 template <typename Service>
 template <typename BaseService, typename Request, typename Response>
-auto GrpcAsyncServer<Service>::register_async_stream(AsyncServerStreamFunc<BaseService, Request, Response> stream_func)
+auto GrpcAsyncServer<Service>::register_async_stream(AsyncServerStreamFunc<BaseService, Request, Response> stream_func,
+                                                     CompressionOptions compression)
     -> detail::StreamRpcHandlerCallbackSetter<BaseService, Request, Response> {
 
     static_assert(std::is_base_of<BaseService, Service>::value, "BaseService must be a base class of Service");
     auto handler = std::make_unique<detail::StreamRpcHandler<BaseService, Request, Response>>(*service_,
                                                                                               *server_queue_,
-                                                                                              stream_func);
+                                                                                              stream_func,
+                                                                                              compression);
     auto* tag = handler.get();
     rpc_handlers_.use_safely([&](RpcMap& rpc_handlers) { rpc_handlers.emplace(tag, std::move(handler)); });
     tag->activate_next();
     return {tag};
 }
 
+template <typename Service>
+void GrpcAsyncServer<Service>::enable_load_shedding(LoadShedding options) {
+    lag_monitor_.start(server_queue_.get(), options);
+}
+
+template <typename Service>
+std::chrono::nanoseconds GrpcAsyncServer<Service>::queue_lag() const {
+    return lag_monitor_.queue_lag();
+}
+
 template <typename Service>
 void GrpcAsyncServer<Service>::shutdown_and_wait() {
     server_->Shutdown();
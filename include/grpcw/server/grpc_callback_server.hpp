@@ -0,0 +1,168 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Only available when the callback server is enabled (see LTB_GRPCW_ENABLE_CALLBACK_SERVER)
+#ifdef LTB_GRPCW_ENABLE_CALLBACK_SERVER
+
+// grpcw
+#include "grpcw/server/detail/callback_non_stream_rpc_handler.hpp"
+#include "grpcw/server/detail/callback_rpc_dispatcher.hpp"
+#include "grpcw/server/detail/callback_stream_rpc_handler_callback_setter.hpp"
+#include "grpcw/util/method_path.hpp"
+
+// third-party
+#include <grpc++/security/server_credentials.h>
+#include <grpc++/server.h>
+#include <grpc++/server_builder.h>
+
+// standard
+#include <stdexcept>
+#include <string>
+
+namespace grpcw {
+namespace server {
+
+/**
+ * @brief An alternative to `GrpcAsyncServer` built on gRPC's callback (reactor) api
+ * @tparam Service is the generated gRPC service class (e.g. `my::package::MyService`)
+ *
+ * Calls are handled on gRPC's own threads so no completion queues or threads are
+ * managed here. Rpcs are registered by the method name used in the service definition, for example:
+ *
+ *     server.register_async<EchoRequest, EchoResponse>("echo", [](const EchoRequest&, EchoResponse*) {...});
+ *
+ * Registration throws std::invalid_argument if 'Service' has no such method or if its request type,
+ * response type or kind of streaming don't match the registration.
+ */
+template <typename Service>
+class GrpcCallbackServer {
+public:
+    /**
+     * @brief Starts listening on 'address' (see GrpcAsyncServer)
+     */
+    explicit GrpcCallbackServer(const std::string& address);
+    ~GrpcCallbackServer();
+
+    /**
+     * @brief Responses are compressed according to 'compression' (uncompressed by default)
+     *
+     * 'callback' (signature: <grpc::Status(const Request&, Response*)>) should not block
+     * since it runs on one of gRPC's threads.
+     */
+    template <typename Request, typename Response, typename Callback>
+    void register_async(const std::string& method_name, Callback&& callback, CompressionOptions compression = {});
+
+    /**
+     * @brief StreamInterface* should stop being used before GrpcCallbackServer is destroyed
+     *
+     * Every connection to this stream uses the same 'compression' settings.
+     */
+    template <typename Request, typename Response>
+    detail::CallbackStreamRpcHandlerCallbackSetter<Request, Response>
+    register_async_stream(const std::string& method_name, CompressionOptions compression = {});
+
+    // This is also called in the destructor
+    void shutdown_and_wait();
+
+    template <typename Duration>
+    void force_shutdown_in(Duration duration);
+
+    grpc::Server& server();
+
+private:
+    detail::CallbackRpcDispatcher dispatcher_;
+    std::unique_ptr<grpc::Server> server_;
+};
+
+template <typename Service>
+GrpcCallbackServer<Service>::GrpcCallbackServer(const std::string& address) {
+    grpc::ServerBuilder builder;
+    builder.RegisterCallbackGenericService(&dispatcher_);
+    builder.AddListeningPort(address, grpc::InsecureServerCredentials());
+    builder.SetMaxMessageSize(std::numeric_limits<int>::max());
+    server_ = builder.BuildAndStart();
+
+    // Usually an address that is already in use or a socket path that can't be created
+    if (not server_) {
+        throw std::runtime_error("Failed to start a server listening on '" + address + "'");
+    }
+}
+
+template <typename Service>
+GrpcCallbackServer<Service>::~GrpcCallbackServer() {
+    shutdown_and_wait();
+}
+
+template <typename Service>
+template <typename Request, typename Response, typename Callback>
+void GrpcCallbackServer<Service>::register_async(const std::string& method_name,
+                                                 Callback&& callback,
+                                                 CompressionOptions compression) {
+    std::string method_path = util::method_path(Service::service_full_name(),
+                                                method_name,
+                                                Request::descriptor(),
+                                                Response::descriptor(),
+                                                false);
+
+    using Handler = detail::CallbackNonStreamRpcHandler<Request, Response, std::decay_t<Callback>>;
+    dispatcher_.add_handler(method_path, std::make_unique<Handler>(std::forward<Callback>(callback), compression));
+}
+
+template <typename Service>
+template <typename Request, typename Response>
+auto GrpcCallbackServer<Service>::register_async_stream(const std::string& method_name, CompressionOptions compression)
+    -> detail::CallbackStreamRpcHandlerCallbackSetter<Request, Response> {
+
+    std::string method_path = util::method_path(Service::service_full_name(),
+                                                method_name,
+                                                Request::descriptor(),
+                                                Response::descriptor(),
+                                                true);
+
+    auto handler = std::make_unique<detail::CallbackStreamRpcHandler<Request, Response>>(compression);
+    auto* stream = handler.get();
+    dispatcher_.add_handler(method_path, std::move(handler));
+    return {stream};
+}
+
+template <typename Service>
+void GrpcCallbackServer<Service>::shutdown_and_wait() {
+    server_->Shutdown();
+}
+
+template <typename Service>
+template <typename Duration>
+void GrpcCallbackServer<Service>::force_shutdown_in(Duration duration) {
+    server_->Shutdown(std::chrono::system_clock::now() + duration);
+}
+
+template <typename Service>
+grpc::Server& GrpcCallbackServer<Service>::server() {
+    return *server_;
+}
+
+} // namespace server
+} // namespace grpcw
+
+#endif // LTB_GRPCW_ENABLE_CALLBACK_SERVER
@@ -0,0 +1,302 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Only available when compiling with C++20 coroutine support (see LTB_GRPCW_ENABLE_COROUTINES)
+#ifdef __cpp_impl_coroutine
+
+// grpcw
+#include "grpcw/server/coroutine_call.hpp"
+#include "grpcw/server/detail/async_rpc_handler_interface.hpp"
+
+// third-party
+#include <grpc++/security/server_credentials.h>
+#include <grpc++/server.h>
+#include <grpc++/server_builder.h>
+
+// standard
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace grpcw {
+namespace server {
+
+/**
+ * @brief An async server where every rpc call is handled by a coroutine
+ * @tparam Service is the generated async service (e.g. `my::package::MyService::AsyncService`)
+ *
+ * Handlers return `util::Task<grpc::Status>` and can `co_await` reads, writes, alarms, and
+ * calls to other services. Suspended calls do not block a thread so a few queue threads can
+ * serve any number of calls. The returned status is used to finish the call.
+ *
+ *     server.register_unary(&Service::Requestecho,
+ *                           [](CoroutineCall& call, const Request& request, Response* response)
+ *                               -> util::Task<grpc::Status> {
+ *                               co_await call.alarm(std::chrono::system_clock::now() + 10ms);
+ *                               ...
+ *                               co_return grpc::Status::OK;
+ *                           });
+ *
+ * Lambda handlers are kept alive by the server so their captures can be used while suspended.
+ */
+template <typename Service>
+class GrpcCoroutineServer {
+public:
+    explicit GrpcCoroutineServer(std::shared_ptr<Service> service,
+                                 const std::string& address,
+                                 unsigned num_queue_threads = 1);
+    ~GrpcCoroutineServer();
+
+    /**
+     * @brief 'handler' signature: <util::Task<grpc::Status>(CoroutineCall&, const Request&, Response*)>
+     */
+    template <typename BaseService, typename Request, typename Response, typename Handler>
+    void register_unary(AsyncNoStreamFunc<BaseService, Request, Response> no_stream_func, Handler&& handler);
+
+    /**
+     * @brief 'handler' signature: <util::Task<grpc::Status>(CoroutineWriter<Response>&, const Request&)>
+     */
+    template <typename BaseService, typename Request, typename Response, typename Handler>
+    void register_server_stream(AsyncServerStreamFunc<BaseService, Request, Response> stream_func, Handler&& handler);
+
+    /**
+     * @brief 'handler' signature: <util::Task<grpc::Status>(CoroutineReaderWriter<Response, Request>&)>
+     */
+    template <typename BaseService, typename Request, typename Response, typename Handler>
+    void register_bidi_stream(AsyncBidiStreamFunc<BaseService, Request, Response> stream_func, Handler&& handler);
+
+    // This is also called in the destructor
+    void shutdown_and_wait();
+
+    template <typename Duration>
+    void force_shutdown_in(Duration duration);
+
+    grpc::Server& server();
+
+private:
+    std::shared_ptr<Service> service_;
+    std::unique_ptr<grpc::ServerCompletionQueue> queue_;
+    std::unique_ptr<grpc::Server> server_;
+
+    std::vector<std::thread> queue_threads_;
+
+    // Each of these waits for a single call then starts waiting for the next one before handling it
+    template <typename BaseService, typename Request, typename Response, typename Handler>
+    util::Task<void> accept_unary(AsyncNoStreamFunc<BaseService, Request, Response> no_stream_func,
+                                  std::shared_ptr<Handler> handler);
+
+    template <typename BaseService, typename Request, typename Response, typename Handler>
+    util::Task<void> accept_server_stream(AsyncServerStreamFunc<BaseService, Request, Response> stream_func,
+                                          std::shared_ptr<Handler> handler);
+
+    template <typename BaseService, typename Request, typename Response, typename Handler>
+    util::Task<void> accept_bidi_stream(AsyncBidiStreamFunc<BaseService, Request, Response> stream_func,
+                                        std::shared_ptr<Handler> handler);
+
+    /// \brief Runs 'handler' and converts any exception it throws into an INTERNAL status
+    template <typename Handler, typename... Args>
+    static util::Task<grpc::Status> run_handler(Handler& handler, Args&&... args);
+};
+
+template <typename Service>
+GrpcCoroutineServer<Service>::GrpcCoroutineServer(std::shared_ptr<Service> service,
+                                                  const std::string& address,
+                                                  unsigned num_queue_threads)
+    : service_(std::move(service)) {
+
+    grpc::ServerBuilder builder;
+    builder.RegisterService(service_.get());
+    builder.AddListeningPort(address, grpc::InsecureServerCredentials());
+    builder.SetMaxMessageSize(std::numeric_limits<int>::max());
+    queue_ = builder.AddCompletionQueue();
+    server_ = builder.BuildAndStart();
+
+    // Usually an address that is already in use or a socket path that can't be created
+    if (not server_) {
+        throw std::runtime_error("Failed to start a server listening on '" + address + "'");
+    }
+
+    for (unsigned i = 0u; i < std::max(num_queue_threads, 1u); ++i) {
+        queue_threads_.emplace_back([this] {
+            void* tag;
+            bool call_ok;
+
+            while (queue_->Next(&tag, &call_ok)) {
+                static_cast<detail::CompletionHandler*>(tag)->on_completion(call_ok);
+            }
+        });
+    }
+}
+
+template <typename Service>
+GrpcCoroutineServer<Service>::~GrpcCoroutineServer() {
+    shutdown_and_wait();
+    queue_->Shutdown();
+
+    for (std::thread& thread : queue_threads_) {
+        thread.join();
+    }
+}
+
+template <typename Service>
+template <typename BaseService, typename Request, typename Response, typename Handler>
+void GrpcCoroutineServer<Service>::register_unary(AsyncNoStreamFunc<BaseService, Request, Response> no_stream_func,
+                                                  Handler&& handler) {
+    static_assert(std::is_base_of<BaseService, Service>::value, "BaseService must be a base class of Service");
+    util::spawn(accept_unary(no_stream_func, std::make_shared<std::decay_t<Handler>>(std::forward<Handler>(handler))));
+}
+
+template <typename Service>
+template <typename BaseService, typename Request, typename Response, typename Handler>
+void GrpcCoroutineServer<Service>::register_server_stream(
+    AsyncServerStreamFunc<BaseService, Request, Response> stream_func,
+    Handler&& handler) {
+    static_assert(std::is_base_of<BaseService, Service>::value, "BaseService must be a base class of Service");
+    util::spawn(
+        accept_server_stream(stream_func, std::make_shared<std::decay_t<Handler>>(std::forward<Handler>(handler))));
+}
+
+template <typename Service>
+template <typename BaseService, typename Request, typename Response, typename Handler>
+void GrpcCoroutineServer<Service>::register_bidi_stream(AsyncBidiStreamFunc<BaseService, Request, Response> stream_func,
+                                                        Handler&& handler) {
+    static_assert(std::is_base_of<BaseService, Service>::value, "BaseService must be a base class of Service");
+    util::spawn(
+        accept_bidi_stream(stream_func, std::make_shared<std::decay_t<Handler>>(std::forward<Handler>(handler))));
+}
+
+template <typename Service>
+void GrpcCoroutineServer<Service>::shutdown_and_wait() {
+    server_->Shutdown();
+}
+
+template <typename Service>
+template <typename Duration>
+void GrpcCoroutineServer<Service>::force_shutdown_in(Duration duration) {
+    server_->Shutdown(std::chrono::system_clock::now() + duration);
+}
+
+template <typename Service>
+grpc::Server& GrpcCoroutineServer<Service>::server() {
+    return *server_;
+}
+
+template <typename Service>
+template <typename BaseService, typename Request, typename Response, typename Handler>
+util::Task<void>
+GrpcCoroutineServer<Service>::accept_unary(AsyncNoStreamFunc<BaseService, Request, Response> no_stream_func,
+                                           std::shared_ptr<Handler> handler) {
+    grpc::ServerContext context;
+    Request request;
+    grpc::ServerAsyncResponseWriter<Response> responder(&context);
+
+    bool call_ok = co_await detail::queue_operation([&](void* tag) {
+        (service_.get()->*no_stream_func)(&context, &request, &responder, queue_.get(), queue_.get(), tag);
+    });
+
+    if (not call_ok) {
+        co_return; // The server is shutting down
+    }
+
+    util::spawn(accept_unary(no_stream_func, handler));
+
+    CoroutineCall call(context, *queue_);
+    Response response;
+    grpc::Status status = co_await run_handler(*handler, call, request, &response);
+
+    co_await detail::queue_operation([&](void* tag) {
+        if (status.ok()) {
+            responder.Finish(response, status, tag);
+        } else {
+            responder.FinishWithError(status, tag);
+        }
+    });
+}
+
+template <typename Service>
+template <typename BaseService, typename Request, typename Response, typename Handler>
+util::Task<void>
+GrpcCoroutineServer<Service>::accept_server_stream(AsyncServerStreamFunc<BaseService, Request, Response> stream_func,
+                                                   std::shared_ptr<Handler> handler) {
+    grpc::ServerContext context;
+    Request request;
+    grpc::ServerAsyncWriter<Response> writer(&context);
+
+    bool call_ok = co_await detail::queue_operation([&](void* tag) {
+        (service_.get()->*stream_func)(&context, &request, &writer, queue_.get(), queue_.get(), tag);
+    });
+
+    if (not call_ok) {
+        co_return; // The server is shutting down
+    }
+
+    util::spawn(accept_server_stream(stream_func, handler));
+
+    CoroutineWriter<Response> call(context, *queue_, writer);
+    grpc::Status status = co_await run_handler(*handler, call, request);
+
+    co_await detail::queue_operation([&](void* tag) { writer.Finish(status, tag); });
+}
+
+template <typename Service>
+template <typename BaseService, typename Request, typename Response, typename Handler>
+util::Task<void>
+GrpcCoroutineServer<Service>::accept_bidi_stream(AsyncBidiStreamFunc<BaseService, Request, Response> stream_func,
+                                                 std::shared_ptr<Handler> handler) {
+    grpc::ServerContext context;
+    grpc::ServerAsyncReaderWriter<Response, Request> stream(&context);
+
+    bool call_ok = co_await detail::queue_operation([&](void* tag) {
+        (service_.get()->*stream_func)(&context, &stream, queue_.get(), queue_.get(), tag);
+    });
+
+    if (not call_ok) {
+        co_return; // The server is shutting down
+    }
+
+    util::spawn(accept_bidi_stream(stream_func, handler));
+
+    CoroutineReaderWriter<Response, Request> call(context, *queue_, stream);
+    grpc::Status status = co_await run_handler(*handler, call);
+
+    co_await detail::queue_operation([&](void* tag) { stream.Finish(status, tag); });
+}
+
+template <typename Service>
+template <typename Handler, typename... Args>
+util::Task<grpc::Status> GrpcCoroutineServer<Service>::run_handler(Handler& handler, Args&&... args) {
+    try {
+        co_return co_await handler(std::forward<Args>(args)...);
+    } catch (const std::exception& e) {
+        co_return grpc::Status(grpc::StatusCode::INTERNAL, e.what());
+    }
+}
+
+} // namespace server
+} // namespace grpcw
+
+#endif // __cpp_impl_coroutine
@@ -30,6 +30,10 @@ namespace server {
 class GrpcServer {
 public:
     /// \brief Builds a grpc::Server with the provided address.
+    ///
+    /// The address can be "host:port", "unix:/path/to/socket" or "unix-abstract:name" (Linux only, gRPC 1.34+).
+    /// An empty address only allows in-process connections. Throws std::runtime_error if the
+    /// server could not be started.
     explicit GrpcServer(std::unique_ptr<grpc::Service> service, const std::string& server_address = "");
     ~GrpcServer();
 
@@ -44,6 +48,9 @@ public:
 
     auto in_process_channel(const grpc::ChannelArguments& channel_arguments = {}) -> std::shared_ptr<grpc::Channel>;
 
+    /// \brief The service implementation (lets in-process clients call it directly)
+    grpc::Service* service();
+
 private:
     std::unique_ptr<grpc::Service> service_;
     std::unique_ptr<grpc::Server> server_;
@@ -0,0 +1,45 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// standard
+#include <chrono>
+
+namespace grpcw {
+namespace server {
+
+///
+/// \brief Completion queue lag measurement and load shedding settings for a server.
+///
+/// A probe is scheduled on the server's completion queue every 'probe_interval'. The time
+/// between the probe's deadline and the moment the queue thread handles it is the queue lag.
+/// New unary calls are rejected with UNAVAILABLE while the last measured lag is above
+/// 'max_queue_lag'. A zero 'max_queue_lag' only measures the lag and never rejects calls.
+///
+struct LoadShedding {
+    std::chrono::milliseconds probe_interval = std::chrono::milliseconds(10);
+    std::chrono::milliseconds max_queue_lag = std::chrono::milliseconds::zero();
+};
+
+} // namespace server
+} // namespace grpcw
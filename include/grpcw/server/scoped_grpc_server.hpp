@@ -47,6 +47,11 @@ public:
      */
     auto in_process_channel(const grpc::ChannelArguments& channel_arguments = {}) -> std::shared_ptr<grpc::Channel>;
 
+    /**
+     * @brief Pass this with 'in_process_channel' to GrpcClient::change_server to skip serialization
+     */
+    grpc::Service* service();
+
 private:
     GrpcServer server_;
     std::thread run_thread_;
@@ -77,6 +77,14 @@ public:
     template <typename Pred, typename Func>
     auto wait_to_use_safely(const Pred& predicate, const Func& func) const;
 
+    ///
+    /// \brief Like 'wait_to_use_safely' but give up at 'deadline'.
+    ///
+    /// Returns false, without invoking 'func', if 'predicate' was still false at 'deadline'.
+    ///
+    template <typename TimePoint, typename Pred, typename Func>
+    bool wait_to_use_safely_until(const TimePoint& deadline, const Pred& predicate, const Func& func);
+
     ///
     /// \brief Allow one 'wait_to_use_safely' function to continue.
     ///
@@ -130,6 +138,17 @@ auto AtomicData<T>::wait_to_use_safely(const Pred& predicate, const Func& func)
     return func(data_);
 }
 
+template <typename T>
+template <typename TimePoint, typename Pred, typename Func>
+bool AtomicData<T>::wait_to_use_safely_until(const TimePoint& deadline, const Pred& predicate, const Func& func) {
+    std::unique_lock<std::mutex> unlockable_lock(lock_);
+    if (not condition_.wait_until(unlockable_lock, deadline, [&] { return predicate(data_); })) {
+        return false;
+    }
+    func(data_);
+    return true;
+}
+
 template <typename T>
 void AtomicData<T>::notify_one() {
     condition_.notify_one();
@@ -0,0 +1,76 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// standard
+#include <atomic>
+#include <memory>
+
+namespace grpcw {
+namespace util {
+
+///
+/// \brief A shared_ptr that any thread can load or replace without taking a shared mutex.
+///
+/// 'load' hands out a new reference so a replaced value stays alive until the last thread
+/// using it lets go (read-copy-update). The pointed-to value should be treated as immutable.
+///
+template <typename T>
+class AtomicSharedPtr {
+public:
+    explicit AtomicSharedPtr(std::shared_ptr<T> ptr = nullptr);
+
+    std::shared_ptr<T> load() const;
+    void store(std::shared_ptr<T> ptr);
+
+private:
+#if defined(__cpp_lib_atomic_shared_ptr)
+    std::atomic<std::shared_ptr<T>> ptr_;
+#else
+    std::shared_ptr<T> ptr_; ///< Only accessed through the std::atomic_* overloads
+#endif
+};
+
+template <typename T>
+AtomicSharedPtr<T>::AtomicSharedPtr(std::shared_ptr<T> ptr) : ptr_(std::move(ptr)) {}
+
+template <typename T>
+std::shared_ptr<T> AtomicSharedPtr<T>::load() const {
+#if defined(__cpp_lib_atomic_shared_ptr)
+    return ptr_.load(std::memory_order_acquire);
+#else
+    return std::atomic_load_explicit(&ptr_, std::memory_order_acquire);
+#endif
+}
+
+template <typename T>
+void AtomicSharedPtr<T>::store(std::shared_ptr<T> ptr) {
+#if defined(__cpp_lib_atomic_shared_ptr)
+    ptr_.store(std::move(ptr), std::memory_order_release);
+#else
+    std::atomic_store_explicit(&ptr_, std::move(ptr), std::memory_order_release);
+#endif
+}
+
+} // namespace util
+} // namespace grpcw
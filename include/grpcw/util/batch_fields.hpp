@@ -0,0 +1,82 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// third-party
+#include <google/protobuf/message.h>
+#include <grpc++/support/status.h>
+
+namespace grpcw {
+namespace util {
+
+///
+/// \brief The repeated field of 'batch' that holds 'item' messages.
+///
+/// Batch rpcs send many requests (or responses) in one message with a field like
+/// 'repeated Item items'. Throws std::invalid_argument unless 'batch' has exactly one.
+///
+auto batch_field(const google::protobuf::Descriptor& batch, const google::protobuf::Descriptor& item)
+    -> const google::protobuf::FieldDescriptor*;
+
+///
+/// \brief The repeated status field of 'batch', or nullptr if it has none.
+///
+/// A batch response can give every item its own status with a 'repeated google.rpc.Status' field
+/// (or any message named 'Status' with the same 'int32 code' and 'string message' fields). It is
+/// found by name so nothing depends on the googleapis protos. Throws std::invalid_argument if
+/// 'batch' has more than one.
+///
+auto batch_status_field(const google::protobuf::Descriptor& batch) -> const google::protobuf::FieldDescriptor*;
+
+/// \brief Add the status of the next item to 'batch' ('field' comes from 'batch_status_field')
+void add_batch_status(google::protobuf::Message* batch,
+                      const google::protobuf::FieldDescriptor* field,
+                      const grpc::Status& status);
+
+grpc::Status
+batch_status(const google::protobuf::Message& batch, const google::protobuf::FieldDescriptor* field, int index);
+
+/// \brief The number of items in 'batch' ('field' comes from 'batch_field')
+inline int batch_size(const google::protobuf::Message& batch, const google::protobuf::FieldDescriptor* field) {
+    return batch.GetReflection()->FieldSize(batch, field);
+}
+
+template <typename Item>
+const Item&
+batch_item(const google::protobuf::Message& batch, const google::protobuf::FieldDescriptor* field, int index) {
+    // 'batch_field' checked the field holds 'Item' messages
+    return static_cast<const Item&>(batch.GetReflection()->GetRepeatedMessage(batch, field, index));
+}
+
+template <typename Item>
+Item* mutable_batch_item(google::protobuf::Message* batch, const google::protobuf::FieldDescriptor* field, int index) {
+    return static_cast<Item*>(batch->GetReflection()->MutableRepeatedMessage(batch, field, index));
+}
+
+template <typename Item>
+Item* add_batch_item(google::protobuf::Message* batch, const google::protobuf::FieldDescriptor* field) {
+    return static_cast<Item*>(batch->GetReflection()->AddMessage(batch, field));
+}
+
+} // namespace util
+} // namespace grpcw
@@ -77,7 +77,7 @@ void BlockingQueue<T>::emplace_back(Args&&... args) {
 template <typename T>
 T BlockingQueue<T>::pop_front() {
     std::unique_lock<std::mutex> lock(mutex_);
-    condition_.wait(lock, [=] { return !queue_.empty(); });
+    condition_.wait(lock, [this] { return !queue_.empty(); });
     T rc(std::move(queue_.front()));
     queue_.pop(); // pop_front
     return rc;
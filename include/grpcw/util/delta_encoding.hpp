@@ -0,0 +1,67 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// third-party
+#include <google/protobuf/message.h>
+
+namespace grpcw {
+namespace util {
+
+///
+/// \brief Field number reserved for delta metadata (the largest valid protobuf field number).
+///
+/// Delta encoded messages carry the numbers of every replaced field in an unknown,
+/// length-delimited field with this number. Messages without it are full updates.
+///
+constexpr int delta_field_number = (1 << 29) - 1;
+
+///
+/// \brief Client metadata key a stream sends when it can decode deltas.
+///
+/// Servers only delta encode the streams of clients that sent it.
+///
+constexpr const char* delta_encoding_metadata_key = "grpcw-delta-encoding";
+
+///
+/// \brief Fill 'delta' with only the fields of 'current' that differ from 'previous'.
+///
+/// 'previous', 'current', and 'delta' must all be the same message type. Changed fields
+/// are replaced as a whole (repeated and message fields included) when the delta is applied.
+///
+void encode_delta(const google::protobuf::Message& previous,
+                  const google::protobuf::Message& current,
+                  google::protobuf::Message* delta);
+
+///
+/// \brief Rebuild the full message by applying 'delta' to the previous state stored in 'message'.
+///
+/// If 'delta' is a full update (not created by 'encode_delta') it replaces 'message' entirely.
+///
+void apply_delta(const google::protobuf::Message& delta, google::protobuf::Message* message);
+
+/// \brief True if 'message' was created by 'encode_delta'
+bool is_delta(const google::protobuf::Message& message);
+
+} // namespace util
+} // namespace grpcw
@@ -0,0 +1,92 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// standard
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace grpcw {
+namespace util {
+
+///
+/// \brief A fixed memory histogram with HdrHistogram's bucket layout.
+///
+/// Every recorded value between 1 and 'highest_trackable_value' is kept with
+/// 'significant_digits' digits of precision. Values outside that range are clamped.
+/// The unit of the values is up to the user (usually microseconds).
+///
+class LatencyHistogram {
+public:
+    /// \brief Throws std::invalid_argument unless 1 <= 'significant_digits' <= 5 and 'highest_trackable_value' >= 2
+    explicit LatencyHistogram(std::uint64_t highest_trackable_value = 3'600'000'000u, int significant_digits = 3);
+
+    void record(std::uint64_t value, std::uint64_t count = 1u);
+
+    /// \brief Add all the values of 'other' (throws std::invalid_argument if the layouts differ)
+    void add(const LatencyHistogram& other);
+
+    void reset();
+
+    std::uint64_t total_count() const;
+    std::uint64_t min() const;
+    std::uint64_t max() const;
+    double mean() const;
+    double standard_deviation() const;
+
+    /// \brief The largest value (within the histogram's precision) that 'percentile' percent of values are below
+    std::uint64_t value_at_percentile(double percentile) const;
+
+    /// \brief How many recorded values are at or below 'value' (within the histogram's precision)
+    std::uint64_t count_at_or_below(std::uint64_t value) const;
+
+    ///
+    /// \brief Write the percentile distribution in HdrHistogram's text (.hgrm) format.
+    ///
+    /// Values are divided by 'value_scale' so, for example, microseconds can be written as milliseconds.
+    ///
+    void write_percentile_distribution(std::ostream& os, double value_scale = 1.0, int ticks_per_half = 5) const;
+
+private:
+    std::uint64_t highest_trackable_value_;
+    int significant_digits_;
+
+    int sub_bucket_half_count_magnitude_;
+    std::uint64_t sub_bucket_count_;
+    std::uint64_t sub_bucket_half_count_;
+    std::uint64_t sub_bucket_mask_;
+    int bucket_count_;
+
+    std::vector<std::uint64_t> counts_;
+    std::uint64_t total_count_ = 0u;
+    std::uint64_t min_ = UINT64_MAX;
+    std::uint64_t max_ = 0u;
+
+    std::size_t counts_index(std::uint64_t value) const;
+    std::uint64_t value_from_index(std::size_t index) const;
+    std::uint64_t highest_equivalent_value(std::uint64_t value) const;
+};
+
+} // namespace util
+} // namespace grpcw
@@ -0,0 +1,48 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// third-party
+#include <google/protobuf/descriptor.h>
+
+// standard
+#include <string>
+
+namespace grpcw {
+namespace util {
+
+/**
+ * @brief Returns the full method path ("/package.Service/method") of an rpc
+ *
+ * The method is looked up by name in the service's descriptor. Throws std::invalid_argument if
+ * the service does not have such a method or if the method does not use the 'request' and
+ * 'response' types with the given kind of response.
+ */
+std::string method_path(const std::string& service_full_name,
+                        const std::string& method_name,
+                        const google::protobuf::Descriptor* request,
+                        const google::protobuf::Descriptor* response,
+                        bool server_streaming);
+
+} // namespace util
+} // namespace grpcw
@@ -0,0 +1,107 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// standard
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace grpcw {
+namespace util {
+
+///
+/// @brief Unbounded lock-free multi-producer single-consumer queue.
+///
+/// Any number of threads can call 'push' at the same time without blocking. Only one
+/// thread at a time may call 'pop' (callers are responsible for that, e.g. by only
+/// popping from a single thread or while holding a lock).
+///
+/// A push that is still in progress can make 'pop' report an empty queue even though
+/// later pushes have finished. The value becomes visible as soon as that push returns.
+///
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue();
+    ~MpscQueue();
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value);
+
+    /// \brief Moves the oldest value into 'value'. Returns false if there is nothing to pop.
+    bool pop(T* value);
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        std::optional<T> value;
+    };
+
+    std::atomic<Node*> head_; ///< The most recently pushed node (producers)
+    Node* tail_; ///< A placeholder node in front of the oldest value (consumer)
+};
+
+template <typename T>
+MpscQueue<T>::MpscQueue() : head_(new Node()), tail_(head_.load(std::memory_order_relaxed)) {}
+
+template <typename T>
+MpscQueue<T>::~MpscQueue() {
+    while (tail_) {
+        Node* next = tail_->next.load(std::memory_order_relaxed);
+        delete tail_;
+        tail_ = next;
+    }
+}
+
+template <typename T>
+void MpscQueue<T>::push(T value) {
+    auto* node = new Node();
+    node->value.emplace(std::move(value));
+
+    // Claim the end of the queue then link the previous node to this one
+    Node* previous = head_.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+}
+
+template <typename T>
+bool MpscQueue<T>::pop(T* value) {
+    Node* next = tail_->next.load(std::memory_order_acquire);
+
+    if (not next) {
+        return false;
+    }
+
+    // 'next' becomes the new placeholder
+    *value = std::move(*next->value);
+    next->value.reset();
+
+    delete tail_;
+    tail_ = next;
+    return true;
+}
+
+} // namespace util
+} // namespace grpcw
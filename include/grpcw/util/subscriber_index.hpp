@@ -0,0 +1,199 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// standard
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace grpcw {
+namespace util {
+
+///
+/// @brief Inverted index from topics to the subscribers interested in them.
+///
+/// Every subscriber is given a dense slot number and each topic stores a bitset of the
+/// slots subscribed to it. Finding the subscribers of a topic only scans that topic's
+/// bitset 64 slots at a time, so the cost depends on the number of slots in use and
+/// the number of matches rather than on the number of topics.
+///
+template <typename Subscriber>
+class SubscriberIndex {
+public:
+    /// \brief Adds 'subscriber' to each of 'topics' (in addition to any existing subscriptions)
+    void subscribe(const Subscriber& subscriber, const std::vector<std::string>& topics);
+
+    /// \brief Removes 'subscriber' from every topic
+    void unsubscribe(const Subscriber& subscriber);
+
+    /// \brief Calls 'func(subscriber)' for every subscriber of 'topic'. 'func' must not modify the index.
+    template <typename Func>
+    void for_each_subscriber(const std::string& topic, const Func& func) const;
+
+    std::size_t subscriber_count(const std::string& topic) const;
+    std::size_t topic_count() const;
+
+private:
+    using Word = std::uint64_t;
+    static constexpr std::size_t bits_per_word = 64u;
+
+    struct SubscriberInfo {
+        std::size_t slot;
+        std::vector<std::string> topics;
+    };
+
+    struct Topic {
+        std::vector<Word> slots; ///< Bit 's' is set if the subscriber in slot 's' is subscribed
+        std::size_t count = 0;
+    };
+
+    std::unordered_map<Subscriber, SubscriberInfo> subscribers_;
+    std::vector<Subscriber> slot_subscribers_; ///< The subscriber using each slot
+    std::vector<std::size_t> free_slots_; ///< Slots that can be reused by new subscribers
+    std::unordered_map<std::string, Topic> topics_;
+
+    static int count_trailing_zeros(Word word);
+};
+
+template <typename Subscriber>
+void SubscriberIndex<Subscriber>::subscribe(const Subscriber& subscriber, const std::vector<std::string>& topics) {
+    auto iter = subscribers_.find(subscriber);
+
+    if (iter == subscribers_.end()) {
+        std::size_t slot;
+
+        // Reuse slots so the bitsets stay as short as possible
+        if (free_slots_.empty()) {
+            slot = slot_subscribers_.size();
+            slot_subscribers_.emplace_back(subscriber);
+        } else {
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+            slot_subscribers_[slot] = subscriber;
+        }
+
+        iter = subscribers_.emplace(subscriber, SubscriberInfo{slot, {}}).first;
+    }
+
+    SubscriberInfo& info = iter->second;
+    std::size_t word_index = info.slot / bits_per_word;
+    Word bit = Word{1} << (info.slot % bits_per_word);
+
+    for (const std::string& topic_name : topics) {
+        Topic& topic = topics_[topic_name];
+
+        if (topic.slots.size() <= word_index) {
+            topic.slots.resize(word_index + 1u, Word{0});
+        }
+
+        // Already subscribed
+        if (topic.slots[word_index] & bit) {
+            continue;
+        }
+
+        topic.slots[word_index] |= bit;
+        ++topic.count;
+        info.topics.emplace_back(topic_name);
+    }
+}
+
+template <typename Subscriber>
+void SubscriberIndex<Subscriber>::unsubscribe(const Subscriber& subscriber) {
+    auto iter = subscribers_.find(subscriber);
+
+    if (iter == subscribers_.end()) {
+        return;
+    }
+
+    const SubscriberInfo& info = iter->second;
+    std::size_t word_index = info.slot / bits_per_word;
+    Word bit = Word{1} << (info.slot % bits_per_word);
+
+    for (const std::string& topic_name : info.topics) {
+        auto topic_iter = topics_.find(topic_name);
+        Topic& topic = topic_iter->second;
+
+        topic.slots[word_index] &= ~bit;
+
+        if (--topic.count == 0u) {
+            topics_.erase(topic_iter);
+        }
+    }
+
+    free_slots_.emplace_back(info.slot);
+    subscribers_.erase(iter);
+}
+
+template <typename Subscriber>
+template <typename Func>
+void SubscriberIndex<Subscriber>::for_each_subscriber(const std::string& topic, const Func& func) const {
+    auto iter = topics_.find(topic);
+
+    if (iter == topics_.end()) {
+        return;
+    }
+
+    const std::vector<Word>& slots = iter->second.slots;
+
+    for (std::size_t word_index = 0u; word_index < slots.size(); ++word_index) {
+        Word word = slots[word_index];
+
+        // Visit each set bit, lowest first
+        while (word != 0u) {
+            auto bit = static_cast<std::size_t>(count_trailing_zeros(word));
+            func(slot_subscribers_[word_index * bits_per_word + bit]);
+            word &= word - 1u;
+        }
+    }
+}
+
+template <typename Subscriber>
+std::size_t SubscriberIndex<Subscriber>::subscriber_count(const std::string& topic) const {
+    auto iter = topics_.find(topic);
+    return iter == topics_.end() ? 0u : iter->second.count;
+}
+
+template <typename Subscriber>
+std::size_t SubscriberIndex<Subscriber>::topic_count() const {
+    return topics_.size();
+}
+
+template <typename Subscriber>
+int SubscriberIndex<Subscriber>::count_trailing_zeros(Word word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int count = 0;
+    while ((word & Word{1}) == 0u) {
+        word >>= 1u;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+} // namespace util
+} // namespace grpcw
@@ -0,0 +1,188 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Only available when compiling with C++20 coroutine support (see LTB_GRPCW_ENABLE_COROUTINES)
+#ifdef __cpp_impl_coroutine
+
+// standard
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace grpcw {
+namespace util {
+
+///
+/// @brief A lazily started coroutine that produces a 'T'.
+///
+/// The coroutine does not run until the Task is awaited. When it completes, the
+/// awaiting coroutine is resumed on the same thread. Exceptions are rethrown in
+/// the awaiting coroutine.
+///
+///     Task<int> answer() { co_return 42; }
+///     Task<void> print() { std::cout << co_await answer() << std::endl; }
+///
+template <typename T>
+class Task;
+
+namespace detail {
+
+template <typename Promise>
+struct TaskFinalAwaiter {
+    bool await_ready() noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+        // Symmetric transfer back to whoever awaited this task
+        if (handle.promise().continuation) {
+            return handle.promise().continuation;
+        }
+        return std::noop_coroutine();
+    }
+
+    void await_resume() noexcept {}
+};
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation = nullptr;
+    std::exception_ptr exception = nullptr;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { exception = std::current_exception(); }
+};
+
+} // namespace detail
+
+template <typename T>
+class Task {
+public:
+    struct promise_type : detail::TaskPromiseBase {
+        std::optional<T> value;
+
+        Task<T> get_return_object() { return Task<T>(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        detail::TaskFinalAwaiter<promise_type> final_suspend() noexcept { return {}; }
+
+        template <typename U>
+        void return_value(U&& result) {
+            value.emplace(std::forward<U>(result));
+        }
+    };
+
+    Task(Task&& other) noexcept;
+    Task& operator=(Task&& other) noexcept;
+    ~Task();
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    bool await_ready() const noexcept;
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept;
+    T await_resume();
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle);
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <>
+class Task<void> {
+public:
+    struct promise_type : detail::TaskPromiseBase {
+        Task<void> get_return_object() { return Task<void>(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        detail::TaskFinalAwaiter<promise_type> final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+    };
+
+    Task(Task&& other) noexcept;
+    Task& operator=(Task&& other) noexcept;
+    ~Task();
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    bool await_ready() const noexcept;
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept;
+    void await_resume();
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle);
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+///
+/// @brief Starts 'task' without waiting for it. The coroutine frame cleans itself up
+///        once the task completes. 'task' must handle its own exceptions.
+///
+void spawn(Task<void> task);
+
+template <typename T>
+Task<T>::Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+template <typename T>
+Task<T>::Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+template <typename T>
+Task<T>& Task<T>::operator=(Task&& other) noexcept {
+    if (this != &other) {
+        if (handle_) {
+            handle_.destroy();
+        }
+        handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+}
+
+template <typename T>
+Task<T>::~Task() {
+    if (handle_) {
+        handle_.destroy();
+    }
+}
+
+template <typename T>
+bool Task<T>::await_ready() const noexcept {
+    return not handle_ or handle_.done();
+}
+
+template <typename T>
+std::coroutine_handle<> Task<T>::await_suspend(std::coroutine_handle<> awaiting) noexcept {
+    handle_.promise().continuation = awaiting;
+    return handle_;
+}
+
+template <typename T>
+T Task<T>::await_resume() {
+    if (handle_.promise().exception) {
+        std::rethrow_exception(handle_.promise().exception);
+    }
+    return std::move(*handle_.promise().value);
+}
+
+} // namespace util
+} // namespace grpcw
+
+#endif // __cpp_impl_coroutine
@@ -0,0 +1,162 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "benchmarks/benchmark_util.hpp"
+
+// grpcw
+#include "grpcw/client/grpc_client.hpp"
+
+// third-party
+#include <grpc++/create_channel.h>
+
+// standard
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace grpcw {
+namespace benchmarks {
+
+namespace {
+
+constexpr auto tcp_address = "127.0.0.1:50100";
+constexpr auto uds_address = "unix:/tmp/bench_ltb_grpcw.sock";
+
+double percentile(const std::vector<double>& sorted_values, double fraction) {
+    auto index = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(sorted_values.size()))) - 1u;
+    return sorted_values[std::min(index, sorted_values.size() - 1u)];
+}
+
+} // namespace
+
+std::string listening_address(Transport transport) {
+    switch (transport) {
+    case Transport::in_process:
+        return "";
+    case Transport::tcp:
+        return tcp_address;
+    case Transport::uds:
+        return uds_address;
+    }
+    throw std::invalid_argument("Invalid Transport");
+}
+
+std::string required_listening_address(Transport transport) {
+    return transport == Transport::uds ? uds_address : tcp_address;
+}
+
+std::shared_ptr<grpc::Channel> make_channel(Transport transport, std::shared_ptr<grpc::Channel> in_process_channel) {
+    if (transport == Transport::in_process) {
+        return in_process_channel;
+    }
+
+    auto arguments = client::default_channel_arguments();
+    // Otherwise gRPC reuses the connection of any channel with the same target and arguments
+    arguments.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+
+    return grpc::CreateCustomChannel(listening_address(transport), grpc::InsecureChannelCredentials(), arguments);
+}
+
+LatencyRecorder::LatencyRecorder(std::size_t expected_samples) {
+    microseconds_.reserve(expected_samples);
+}
+
+void LatencyRecorder::record(std::chrono::steady_clock::duration latency) {
+    microseconds_.emplace_back(std::chrono::duration<double, std::micro>(latency).count());
+}
+
+void LatencyRecorder::report(benchmark::State& state) {
+    if (microseconds_.empty()) {
+        return;
+    }
+    std::sort(microseconds_.begin(), microseconds_.end());
+
+    // Averaged over the benchmark's threads since each thread records its own latencies
+    state.counters["p50_us"] = benchmark::Counter(percentile(microseconds_, 0.50), benchmark::Counter::kAvgThreads);
+    state.counters["p90_us"] = benchmark::Counter(percentile(microseconds_, 0.90), benchmark::Counter::kAvgThreads);
+    state.counters["p99_us"] = benchmark::Counter(percentile(microseconds_, 0.99), benchmark::Counter::kAvgThreads);
+}
+
+StreamSubscribers::StreamSubscribers(const std::shared_ptr<grpc::Channel>& channel, std::size_t count)
+    : updates_received_(0) {
+    auto stub = testing::protocol::Test::NewStub(channel);
+
+    for (std::size_t i = 0u; i < count; ++i) {
+        auto subscriber = std::make_unique<Subscriber>();
+        subscriber->reader = stub->PrepareAsyncserver_echo_stream(&subscriber->context, {}, &queue_);
+        subscriber->reader->StartCall(subscriber.get());
+        subscribers_.emplace_back(std::move(subscriber));
+    }
+
+    run_thread_ = std::thread(&StreamSubscribers::run, this);
+}
+
+StreamSubscribers::~StreamSubscribers() {
+    for (auto& subscriber : subscribers_) {
+        subscriber->context.TryCancel();
+    }
+    run_thread_.join();
+}
+
+void StreamSubscribers::wait_for_updates(std::int64_t total_updates) {
+    updates_received_.wait_to_use_safely([total_updates](std::int64_t received) { return received >= total_updates; },
+                                         [](std::int64_t) {});
+}
+
+// This function is run from the 'run_thread_' thread
+void StreamSubscribers::run() {
+    std::size_t finished = 0u;
+
+    void* tag;
+    bool call_ok;
+
+    while (finished < subscribers_.size() and queue_.Next(&tag, &call_ok)) {
+        auto* subscriber = static_cast<Subscriber*>(tag);
+
+        if (subscriber->finishing) {
+            ++finished;
+            continue;
+        }
+
+        if (not call_ok) {
+            // The stream is over so collect its status before it can be deleted
+            subscriber->finishing = true;
+            subscriber->reader->Finish(&subscriber->status, subscriber);
+            continue;
+        }
+
+        // Every completed operation after the call has started is a new update
+        if (subscriber->started) {
+            updates_received_.use_safely([](std::int64_t& received) { ++received; });
+            updates_received_.notify_all();
+        }
+        subscriber->started = true;
+        subscriber->reader->Read(&subscriber->update, subscriber);
+    }
+
+    queue_.Shutdown();
+    while (queue_.Next(&tag, &call_ok)) {
+    }
+}
+
+} // namespace benchmarks
+} // namespace grpcw
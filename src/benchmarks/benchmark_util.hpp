@@ -0,0 +1,114 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// grpcw
+#include "grpcw/util/atomic_data.hpp"
+
+// generated
+#include <testing.grpc.pb.h>
+
+// third-party
+#include <benchmark/benchmark.h>
+#include <grpc++/channel.h>
+#include <grpc++/completion_queue.h>
+
+// standard
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace grpcw {
+namespace benchmarks {
+
+/// \brief How benchmark clients reach the server
+enum class Transport {
+    in_process,
+    tcp,
+    uds,
+};
+
+/// \brief The address servers listen on ("" for in-process so only the in-process channel can be used)
+std::string listening_address(Transport transport);
+
+/// \brief Like 'listening_address' but for servers that must always listen on a real address
+std::string required_listening_address(Transport transport);
+
+///
+/// \brief Creates a new channel to the benchmark server.
+///
+/// 'in_process_channel' is returned as is for in-process benchmarks. Other channels never share
+/// a connection with previously created channels.
+///
+std::shared_ptr<grpc::Channel> make_channel(Transport transport, std::shared_ptr<grpc::Channel> in_process_channel);
+
+/// \brief Collects per-call latencies and reports percentiles as benchmark counters (in microseconds)
+class LatencyRecorder {
+public:
+    explicit LatencyRecorder(std::size_t expected_samples = 0u);
+
+    void record(std::chrono::steady_clock::duration latency);
+    void report(benchmark::State& state);
+
+private:
+    std::vector<double> microseconds_;
+};
+
+///
+/// \brief Many clients subscribed to 'server_echo_stream' that only count the updates they receive
+///
+/// All the subscribers share one channel and one completion queue thread.
+///
+class StreamSubscribers {
+public:
+    StreamSubscribers(const std::shared_ptr<grpc::Channel>& channel, std::size_t count);
+
+    /// \brief Cancels any stream the server has not finished yet
+    ~StreamSubscribers();
+
+    /// \brief Blocks until at least 'total_updates' have been received across all subscribers
+    void wait_for_updates(std::int64_t total_updates);
+
+private:
+    struct Subscriber {
+        grpc::ClientContext context;
+        testing::protocol::TestMessage update;
+        grpc::Status status;
+        std::unique_ptr<grpc::ClientAsyncReader<testing::protocol::TestMessage>> reader;
+        bool started = false;
+        bool finishing = false;
+    };
+
+    grpc::CompletionQueue queue_;
+    std::vector<std::unique_ptr<Subscriber>> subscribers_;
+    util::AtomicData<std::int64_t> updates_received_;
+    std::thread run_thread_;
+
+    void run();
+};
+
+} // namespace benchmarks
+} // namespace grpcw
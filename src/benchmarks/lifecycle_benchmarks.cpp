@@ -0,0 +1,130 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "benchmarks/benchmark_util.hpp"
+
+// grpcw
+#include "grpcw/client/grpc_client.hpp"
+#include "grpcw/server/grpc_async_server.hpp"
+#include "grpcw/server/scoped_grpc_server.hpp"
+#include "testing/test_service.hpp"
+
+// generated
+#include <testing.grpc.pb.h>
+
+// third-party
+#include <benchmark/benchmark.h>
+
+namespace grpcw {
+namespace benchmarks {
+namespace {
+
+using AsyncService = testing::protocol::Test::AsyncService;
+using TestMessage = testing::protocol::TestMessage;
+
+/// Creating a new channel and completing the first call on it
+void connection_setup(benchmark::State& state, Transport transport) {
+    server::ScopedGrpcServer server(std::make_unique<testing::TestService>(), listening_address(transport));
+
+    TestMessage request, response;
+    request.set_msg("connect");
+
+    LatencyRecorder latencies(static_cast<std::size_t>(state.max_iterations));
+
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+
+        auto channel = make_channel(transport, server.in_process_channel(client::default_channel_arguments()));
+        auto stub = testing::protocol::Test::NewStub(channel);
+
+        grpc::ClientContext context;
+        grpc::Status status = stub->echo(&context, request, &response);
+
+        latencies.record(std::chrono::steady_clock::now() - start);
+
+        if (not status.ok()) {
+            state.SkipWithError(status.error_message().c_str());
+            break;
+        }
+
+        // Tearing the connection down is not part of the setup time
+        state.PauseTiming();
+        stub = nullptr;
+        channel = nullptr;
+        state.ResumeTiming();
+    }
+
+    latencies.report(state);
+}
+
+/// Finishing the open streams and destroying a GrpcAsyncServer (state.range(0) is the number of open streams)
+void server_shutdown(benchmark::State& state, Transport transport) {
+    auto num_streams = static_cast<std::size_t>(state.range(0));
+
+    for (auto _ : state) {
+        state.PauseTiming();
+
+        util::AtomicData<std::size_t> connected(0u);
+
+        auto server = std::make_unique<server::GrpcAsyncServer<AsyncService>>(std::make_shared<AsyncService>(),
+                                                                               required_listening_address(transport));
+        server->register_async(&AsyncService::Requestecho, [](const TestMessage& request, TestMessage* response) {
+            response->CopyFrom(request);
+            return grpc::Status::OK;
+        });
+        auto* stream = server->register_async_stream(&AsyncService::Requestserver_echo_stream)
+                           .on_connect([&connected](const TestMessage&, server::ClientID) {
+                               connected.use_safely([](std::size_t& count) { ++count; });
+                               connected.notify_all();
+                           })
+                           .stream();
+
+        auto channel = make_channel(transport, server->server().InProcessChannel(client::default_channel_arguments()));
+        auto subscribers = std::make_unique<StreamSubscribers>(channel, num_streams);
+
+        connected.wait_to_use_safely([num_streams](std::size_t count) { return count == num_streams; },
+                                     [](std::size_t) {});
+
+        state.ResumeTiming();
+
+        stream->finish(grpc::Status::OK);
+        server = nullptr;
+
+        state.PauseTiming();
+        subscribers = nullptr;
+        channel = nullptr;
+        state.ResumeTiming();
+    }
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(connection_setup, in_process, Transport::in_process)->UseRealTime();
+BENCHMARK_CAPTURE(connection_setup, tcp, Transport::tcp)->UseRealTime();
+BENCHMARK_CAPTURE(connection_setup, uds, Transport::uds)->UseRealTime();
+
+BENCHMARK_CAPTURE(server_shutdown, in_process, Transport::in_process)->Arg(0)->Arg(100)->UseRealTime();
+BENCHMARK_CAPTURE(server_shutdown, tcp, Transport::tcp)->Arg(0)->Arg(100)->UseRealTime();
+BENCHMARK_CAPTURE(server_shutdown, uds, Transport::uds)->Arg(0)->Arg(100)->UseRealTime();
+
+} // namespace benchmarks
+} // namespace grpcw
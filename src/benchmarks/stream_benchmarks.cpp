@@ -0,0 +1,392 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "benchmarks/benchmark_util.hpp"
+
+// grpcw
+#include "grpcw/client/grpc_client.hpp"
+#include "grpcw/server/grpc_async_server.hpp"
+
+// generated
+#include <testing.grpc.pb.h>
+
+// third-party
+#include <benchmark/benchmark.h>
+
+// standard
+#include <algorithm>
+#include <ctime>
+#include <iterator>
+#include <thread>
+#include <utility>
+
+namespace grpcw {
+namespace benchmarks {
+namespace {
+
+using AsyncService = testing::protocol::Test::AsyncService;
+using TestMessage = testing::protocol::TestMessage;
+
+/// A GrpcAsyncServer with one stream that a number of subscribers are connected to
+class StreamFixture {
+public:
+    StreamFixture(Transport transport, std::size_t num_subscribers, bool use_submission_queue)
+        : connected_(0u), server_(std::make_shared<AsyncService>(), required_listening_address(transport)) {
+
+        auto setter = server_.register_async_stream(&AsyncService::Requestserver_echo_stream);
+        setter.on_connect([this](const TestMessage&, server::ClientID) {
+            connected_.use_safely([](std::size_t& connected) { ++connected; });
+            connected_.notify_all();
+        });
+        if (use_submission_queue) {
+            setter.enable_submission_queue();
+        }
+        stream_ = setter.stream();
+
+        auto channel = make_channel(transport, server_.server().InProcessChannel(client::default_channel_arguments()));
+        subscribers_ = std::make_unique<StreamSubscribers>(channel, num_subscribers);
+
+        // Don't start writing until every subscriber will receive the update
+        connected_.wait_to_use_safely([num_subscribers](std::size_t connected) { return connected == num_subscribers; },
+                                      [](std::size_t) {});
+    }
+
+    ~StreamFixture() {
+        stream_->finish(grpc::Status::OK);
+        subscribers_ = nullptr;
+    }
+
+    server::StreamInterface<TestMessage>& stream() { return *stream_; }
+    StreamSubscribers& subscribers() { return *subscribers_; }
+
+private:
+    util::AtomicData<std::size_t> connected_; ///< Declared first since the server's callbacks use it
+    server::GrpcAsyncServer<AsyncService> server_;
+    server::StreamInterface<TestMessage>* stream_ = nullptr;
+    std::unique_ptr<StreamSubscribers> subscribers_;
+};
+
+/// Time for one update to reach every subscriber (state.range(0) is the number of subscribers)
+void stream_fan_out(benchmark::State& state, Transport transport) {
+    auto num_subscribers = static_cast<std::size_t>(state.range(0));
+    StreamFixture fixture(transport, num_subscribers, false);
+
+    TestMessage update;
+    update.set_msg("fan out");
+
+    std::int64_t expected_updates = 0;
+    LatencyRecorder latencies(static_cast<std::size_t>(state.max_iterations));
+
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+
+        fixture.stream().write(update);
+        expected_updates += state.range(0);
+        fixture.subscribers().wait_for_updates(expected_updates);
+
+        latencies.record(std::chrono::steady_clock::now() - start);
+    }
+
+    state.counters["deliveries"] = benchmark::Counter(static_cast<double>(expected_updates),
+                                                      benchmark::Counter::kIsRate);
+    latencies.report(state);
+}
+
+/// Many application threads writing to the same stream at once
+void contended_stream_writes(benchmark::State& state, bool use_submission_queue) {
+    static std::unique_ptr<StreamFixture> fixture;
+
+    if (state.thread_index() == 0) {
+        fixture = std::make_unique<StreamFixture>(Transport::in_process, 1u, use_submission_queue);
+    }
+
+    TestMessage update;
+    update.set_msg("contended");
+
+    for (auto _ : state) {
+        fixture->stream().write(update);
+    }
+
+    state.counters["writes"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+
+    if (state.thread_index() == 0) {
+        // Not timed. Every queued update is delivered before the stream finishes.
+        fixture = nullptr;
+    }
+}
+
+/// Time for one update to reach state.range(0) streams registered on a single GrpcClient
+void grpc_client_stream_fan_out(benchmark::State& state, bool async_streams) {
+    auto num_streams = static_cast<std::size_t>(state.range(0));
+
+    util::AtomicData<std::size_t> connected(0u);
+    util::AtomicData<std::int64_t> updates_received(0);
+
+    server::GrpcAsyncServer<AsyncService> server(std::make_shared<AsyncService>(),
+                                                 required_listening_address(Transport::in_process));
+    auto* stream = server.register_async_stream(&AsyncService::Requestserver_echo_stream)
+                       .on_connect([&connected](const TestMessage&, server::ClientID) {
+                           connected.use_safely([](std::size_t& count) { ++count; });
+                           connected.notify_all();
+                       })
+                       .stream();
+
+    auto on_update = [&updates_received](TestMessage&&) {
+        updates_received.use_safely([](std::int64_t& count) { ++count; });
+        updates_received.notify_all();
+    };
+
+    {
+        client::GrpcClient<testing::protocol::Test> client;
+        client.change_server(server.server().InProcessChannel(client::default_channel_arguments()));
+
+        using Stub = testing::protocol::Test::Stub;
+
+        for (auto i = 0u; i < num_streams; ++i) {
+            if (async_streams) {
+                client
+                    .register_stream<TestMessage>(
+                        [](Stub& stub, grpc::ClientContext* context, grpc::CompletionQueue* queue) {
+                            return stub.PrepareAsyncserver_echo_stream(context, {}, queue);
+                        })
+                    .on_update(on_update);
+            } else {
+                client
+                    .register_stream<TestMessage>([](Stub& stub, grpc::ClientContext* context) {
+                        return stub.server_echo_stream(context, {});
+                    })
+                    .on_update(on_update);
+            }
+        }
+
+        connected.wait_to_use_safely([num_streams](std::size_t count) { return count == num_streams; },
+                                     [](std::size_t) {});
+
+        TestMessage update;
+        update.set_msg("fan out");
+
+        std::int64_t expected_updates = 0;
+        LatencyRecorder latencies(static_cast<std::size_t>(state.max_iterations));
+
+        for (auto _ : state) {
+            auto start = std::chrono::steady_clock::now();
+
+            stream->write(update);
+            expected_updates += state.range(0);
+            updates_received.wait_to_use_safely(
+                [expected_updates](std::int64_t count) { return count >= expected_updates; },
+                [](std::int64_t) {});
+
+            latencies.record(std::chrono::steady_clock::now() - start);
+        }
+
+        state.counters["deliveries"] = benchmark::Counter(static_cast<double>(expected_updates),
+                                                          benchmark::Counter::kIsRate);
+        latencies.report(state);
+    }
+
+    stream->finish(grpc::Status::OK);
+}
+
+/// Updates per second through one client stream into a locked consumer queue, one at a time or in batches
+void grpc_client_stream_consumer(benchmark::State& state, bool batched) {
+    constexpr std::int64_t updates_per_iteration = 1000;
+
+    util::AtomicData<bool> connected(false);
+    util::AtomicData<std::vector<TestMessage>> consumer_queue;
+
+    server::GrpcAsyncServer<AsyncService> server(std::make_shared<AsyncService>(),
+                                                 required_listening_address(Transport::in_process));
+    auto* stream = server.register_async_stream(&AsyncService::Requestserver_echo_stream)
+                       .on_connect([&connected](const TestMessage&, server::ClientID) {
+                           connected.use_safely([](bool& is_connected) { is_connected = true; });
+                           connected.notify_all();
+                       })
+                       .enable_submission_queue()
+                       .stream();
+
+    {
+        client::GrpcClient<testing::protocol::Test> client;
+        client.change_server(server.server().InProcessChannel(client::default_channel_arguments()));
+
+        auto setter = client.register_stream<TestMessage>(
+            [](testing::protocol::Test::Stub& stub, grpc::ClientContext* context, grpc::CompletionQueue* queue) {
+                return stub.PrepareAsyncserver_echo_stream(context, {}, queue);
+            });
+
+        if (batched) {
+            setter.on_update_batch([&consumer_queue](std::vector<TestMessage>&& updates) {
+                consumer_queue.use_safely([&updates](std::vector<TestMessage>& queue) {
+                    std::move(updates.begin(), updates.end(), std::back_inserter(queue));
+                });
+                consumer_queue.notify_all();
+            });
+        } else {
+            setter.on_update([&consumer_queue](TestMessage&& update) {
+                consumer_queue.use_safely([&update](std::vector<TestMessage>& queue) {
+                    queue.emplace_back(std::move(update));
+                });
+                consumer_queue.notify_all();
+            });
+        }
+
+        connected.wait_to_use_safely([](bool is_connected) { return is_connected; }, [](bool) {});
+
+        TestMessage update;
+        update.set_msg("consumed");
+
+        for (auto _ : state) {
+            for (std::int64_t i = 0; i < updates_per_iteration; ++i) {
+                stream->write(update);
+            }
+
+            consumer_queue.wait_to_use_safely(
+                [](const std::vector<TestMessage>& queue) {
+                    return static_cast<std::int64_t>(queue.size()) >= updates_per_iteration;
+                },
+                [](std::vector<TestMessage>& queue) { queue.clear(); });
+        }
+
+        state.counters["updates"] = benchmark::Counter(static_cast<double>(state.iterations() * updates_per_iteration),
+                                                       benchmark::Counter::kIsRate);
+    }
+
+    stream->finish(grpc::Status::OK);
+}
+
+///
+/// Restarts a server that state.range(0) clients with 25 streams each are connected to. Reports how long
+/// after the server is back every stream is restarted, the process CPU used meanwhile and the most streams
+/// restarted within 10ms (the spike the server sees).
+///
+void grpc_client_server_restart(benchmark::State& state, client::ReconnectBackoff backoff) {
+    using Clock = std::chrono::steady_clock;
+    using Stub = testing::protocol::Test::Stub;
+
+    constexpr std::size_t streams_per_client = 25u;
+    constexpr auto downtime = std::chrono::milliseconds(200);
+
+    auto num_streams = static_cast<std::size_t>(state.range(0)) * streams_per_client;
+    util::AtomicData<std::vector<Clock::time_point>> connections;
+
+    auto start_server = [&connections] {
+        auto server = std::make_unique<server::GrpcAsyncServer<AsyncService>>(
+            std::make_shared<AsyncService>(),
+            required_listening_address(Transport::tcp));
+        server->register_async_stream(&AsyncService::Requestserver_echo_stream)
+            .on_connect([&connections](const TestMessage&, server::ClientID) {
+                connections.use_safely([](std::vector<Clock::time_point>& times) { times.emplace_back(Clock::now()); });
+                connections.notify_all();
+            });
+        return server;
+    };
+
+    auto wait_for_streams = [&connections, num_streams] {
+        return connections.wait_to_use_safely(
+            [num_streams](const std::vector<Clock::time_point>& times) { return times.size() >= num_streams; },
+            [](std::vector<Clock::time_point>& times) { return std::exchange(times, {}); });
+    };
+
+    auto server = start_server();
+
+    std::vector<std::unique_ptr<client::GrpcClient<testing::protocol::Test>>> clients;
+    for (auto i = 0; i < state.range(0); ++i) {
+        auto client = std::make_unique<client::GrpcClient<testing::protocol::Test>>();
+        client->set_reconnect_backoff(backoff);
+
+        for (auto j = 0u; j < streams_per_client; ++j) {
+            client->register_stream<TestMessage>(
+                [](Stub& stub, grpc::ClientContext* context, grpc::CompletionQueue* queue) {
+                    return stub.PrepareAsyncserver_echo_stream(context, {}, queue);
+                });
+        }
+        client->change_server(listening_address(Transport::tcp), [](const client::GrpcClientState&) {});
+        clients.emplace_back(std::move(client));
+    }
+    wait_for_streams();
+
+    double cpu_ms = 0.0;
+    double peak_restarts = 0.0;
+
+    for (auto _ : state) {
+        server = nullptr;
+        std::this_thread::sleep_for(downtime);
+
+        auto cpu_start = std::clock();
+        auto start = Clock::now();
+        server = start_server();
+
+        auto times = wait_for_streams();
+        auto end = Clock::now();
+
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+        cpu_ms += 1000.0 * static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+        std::sort(times.begin(), times.end());
+        std::size_t peak = 0u;
+        for (auto first = times.begin(); first != times.end(); ++first) {
+            auto last = std::upper_bound(first, times.end(), *first + std::chrono::milliseconds(10));
+            peak = std::max(peak, static_cast<std::size_t>(std::distance(first, last)));
+        }
+        peak_restarts += static_cast<double>(peak);
+    }
+
+    auto iterations = static_cast<double>(state.iterations());
+    state.counters["cpu_ms"] = cpu_ms / iterations;
+    state.counters["peak_restarts_per_10ms"] = peak_restarts / iterations;
+
+    clients.clear();
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(stream_fan_out, in_process, Transport::in_process)->Arg(1)->Arg(100)->Arg(10000)->UseRealTime();
+BENCHMARK_CAPTURE(stream_fan_out, tcp, Transport::tcp)->Arg(1)->Arg(100)->Arg(10000)->UseRealTime();
+BENCHMARK_CAPTURE(stream_fan_out, uds, Transport::uds)->Arg(1)->Arg(100)->Arg(10000)->UseRealTime();
+
+// Blocking streams start a thread each while asynchronous streams share the client's queue thread
+BENCHMARK_CAPTURE(grpc_client_stream_fan_out, thread_per_stream, false)->Arg(1)->Arg(100)->Arg(1000)->UseRealTime();
+BENCHMARK_CAPTURE(grpc_client_stream_fan_out, async, true)->Arg(1)->Arg(100)->Arg(1000)->UseRealTime();
+
+BENCHMARK_CAPTURE(grpc_client_stream_consumer, per_update, false)->UseRealTime();
+BENCHMARK_CAPTURE(grpc_client_stream_consumer, batched, true)->UseRealTime();
+
+BENCHMARK_CAPTURE(grpc_client_server_restart, default_backoff, client::ReconnectBackoff{})
+    ->Arg(20)
+    ->Iterations(3)
+    ->UseManualTime();
+BENCHMARK_CAPTURE(grpc_client_server_restart,
+                  short_backoff_staggered,
+                  client::ReconnectBackoff{std::chrono::milliseconds(100),
+                                           std::chrono::seconds(1),
+                                           std::chrono::seconds(1),
+                                           std::chrono::milliseconds(200)})
+    ->Arg(20)
+    ->Iterations(3)
+    ->UseManualTime();
+
+// A fixed number of iterations keeps the submission queue's backlog bounded
+BENCHMARK_CAPTURE(contended_stream_writes, locked, false)->Threads(16)->Iterations(5000)->UseRealTime();
+BENCHMARK_CAPTURE(contended_stream_writes, submission_queue, true)->Threads(16)->Iterations(5000)->UseRealTime();
+
+} // namespace benchmarks
+} // namespace grpcw
@@ -0,0 +1,569 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "benchmarks/benchmark_util.hpp"
+
+// grpcw
+#include "grpcw/client/grpc_client.hpp"
+#include "grpcw/server/grpc_async_server.hpp"
+#include "grpcw/server/grpc_callback_server.hpp"
+#include "grpcw/server/scoped_grpc_server.hpp"
+#include "testing/test_service.hpp"
+
+// generated
+#include <testing.grpc.pb.h>
+
+// third-party
+#include <benchmark/benchmark.h>
+
+namespace grpcw {
+namespace benchmarks {
+namespace {
+
+using AsyncService = testing::protocol::Test::AsyncService;
+using TestMessage = testing::protocol::TestMessage;
+
+grpc::Status echo(const TestMessage& request, TestMessage* response) {
+    response->CopyFrom(request);
+    return grpc::Status::OK;
+}
+
+/// Runs one echo call per iteration and records its latency ('stub' is only used once the benchmark loop starts)
+void run_echo_calls(benchmark::State& state,
+                    const std::unique_ptr<testing::protocol::Test::Stub>& stub,
+                    const TestMessage& request) {
+    LatencyRecorder latencies(static_cast<std::size_t>(state.max_iterations));
+    TestMessage response;
+
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+
+        grpc::ClientContext context;
+        grpc::Status status = stub->echo(&context, request, &response);
+
+        latencies.record(std::chrono::steady_clock::now() - start);
+
+        if (not status.ok()) {
+            state.SkipWithError(status.error_message().c_str());
+            break;
+        }
+    }
+
+    state.counters["qps"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+    latencies.report(state);
+}
+
+TestMessage small_request() {
+    TestMessage request;
+    request.set_msg("benchmark");
+    return request;
+}
+
+/// Unary QPS and latency against the synchronous TestService (every thread shares one server and channel)
+void unary_echo(benchmark::State& state, Transport transport) {
+    static std::unique_ptr<server::ScopedGrpcServer> server;
+    static std::unique_ptr<testing::protocol::Test::Stub> stub;
+
+    // Setup and teardown only happen on the first thread. The benchmark loop synchronizes the threads.
+    if (state.thread_index() == 0) {
+        server = std::make_unique<server::ScopedGrpcServer>(std::make_unique<testing::TestService>(),
+                                                            listening_address(transport));
+        stub = testing::protocol::Test::NewStub(
+            make_channel(transport, server->in_process_channel(client::default_channel_arguments())));
+    }
+
+    run_echo_calls(state, stub, small_request());
+
+    if (state.thread_index() == 0) {
+        stub = nullptr;
+        server = nullptr;
+    }
+}
+
+///
+/// Unary QPS through one GrpcClient shared by every thread. Calls only load the client's
+/// connection snapshot so they should scale with threads like 'unary_echo' does.
+///
+void grpc_client_unary_echo(benchmark::State& state, Transport transport, client::ChannelPool channel_pool = {}) {
+    using Client = client::GrpcClient<testing::protocol::Test>;
+
+    static std::unique_ptr<server::ScopedGrpcServer> server;
+    static std::unique_ptr<Client> client;
+
+    if (state.thread_index() == 0) {
+        server = std::make_unique<server::ScopedGrpcServer>(std::make_unique<testing::TestService>(),
+                                                            listening_address(transport));
+        client = std::make_unique<Client>();
+
+        if (transport == Transport::in_process) {
+            client->change_server(server->in_process_channel(client::default_channel_arguments()));
+        } else {
+            client->change_server(listening_address(transport), [](const client::GrpcClientState&) {}, channel_pool);
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (client->get_state() != client::GrpcClientState::connected
+               and std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    LatencyRecorder latencies(static_cast<std::size_t>(state.max_iterations));
+    TestMessage request = small_request();
+    TestMessage response;
+
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+
+        grpc::Status status(grpc::StatusCode::UNAVAILABLE, "Client is not connected to a server");
+        client->use_stub([&](testing::protocol::Test::Stub& stub) {
+            grpc::ClientContext context;
+            status = stub.echo(&context, request, &response);
+        });
+
+        latencies.record(std::chrono::steady_clock::now() - start);
+
+        if (not status.ok()) {
+            state.SkipWithError(status.error_message().c_str());
+            break;
+        }
+    }
+
+    state.counters["qps"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+    latencies.report(state);
+
+    if (state.thread_index() == 0) {
+        client = nullptr;
+        server = nullptr;
+    }
+}
+
+///
+/// Many threads sharing one client over TCP with state.range(0) pooled channels. Loopback only shows
+/// a gain on hosts with enough cores to run several connections' transport threads at once.
+///
+void grpc_client_channel_pool_echo(benchmark::State& state, client::ChannelSelection selection) {
+    client::ChannelPool channel_pool;
+    channel_pool.size = static_cast<int>(state.range(0));
+    channel_pool.selection = selection;
+
+    grpc_client_unary_echo(state, Transport::tcp, channel_pool);
+}
+
+///
+/// One thread keeps state.range(0) calls in flight with GrpcClient::call_async and waits for
+/// the whole batch every iteration (state.range(1) is the number of client queue threads)
+///
+void grpc_client_async_unary_echo(benchmark::State& state, Transport transport) {
+    server::ScopedGrpcServer server(std::make_unique<testing::TestService>(), listening_address(transport));
+
+    client::GrpcClient<testing::protocol::Test> client(static_cast<int>(state.range(1)));
+    if (transport == Transport::in_process) {
+        client.change_server(server.in_process_channel(client::default_channel_arguments()));
+    } else {
+        client.change_server(listening_address(transport), [](const client::GrpcClientState&) {});
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (client.get_state() != client::GrpcClientState::connected and std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    auto batch_size = state.range(0);
+    TestMessage request = small_request();
+    util::AtomicData<std::int64_t> finished(0);
+    std::atomic_bool failed{false};
+
+    for (auto _ : state) {
+        finished.use_safely([](std::int64_t& count) { count = 0; });
+
+        for (std::int64_t i = 0; i < batch_size; ++i) {
+            client.call_async(&testing::protocol::Test::Stub::Asyncecho,
+                              request,
+                              [&finished, &failed, batch_size](grpc::Status status, TestMessage) {
+                                  if (not status.ok()) {
+                                      failed = true;
+                                  }
+                                  auto count = finished.use_safely([](std::int64_t& count) { return ++count; });
+                                  if (count == batch_size) {
+                                      finished.notify_one();
+                                  }
+                              });
+        }
+
+        finished.wait_to_use_safely([batch_size](std::int64_t count) { return count == batch_size; },
+                                    [](std::int64_t) {});
+
+        if (failed) {
+            state.SkipWithError("Asynchronous call failed");
+            break;
+        }
+    }
+
+    state.counters["qps"] = benchmark::Counter(static_cast<double>(state.iterations() * batch_size),
+                                               benchmark::Counter::kIsRate);
+}
+
+///
+/// Repeated reads of the same request with GrpcClient::call_cached. Without a response cache every
+/// call reaches the server, with one only the first does.
+///
+void grpc_client_cached_unary_echo(benchmark::State& state, bool cached) {
+    server::ScopedGrpcServer server(std::make_unique<testing::TestService>(), listening_address(Transport::tcp));
+
+    client::GrpcClient<testing::protocol::Test> client;
+    client.change_server(listening_address(Transport::tcp), [](const client::GrpcClientState&) {});
+    if (cached) {
+        client.enable_response_cache();
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (client.get_state() != client::GrpcClientState::connected and std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    LatencyRecorder latencies(static_cast<std::size_t>(state.max_iterations));
+    TestMessage request = small_request();
+    TestMessage response;
+
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+
+        auto status = client.call_cached("echo",
+                                         &testing::protocol::Test::Stub::echo,
+                                         &testing::protocol::Test::Service::echo,
+                                         request,
+                                         &response);
+
+        latencies.record(std::chrono::steady_clock::now() - start);
+
+        if (not status.ok()) {
+            state.SkipWithError(status.error_message().c_str());
+            break;
+        }
+    }
+
+    state.counters["qps"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+    latencies.report(state);
+}
+
+///
+/// Unary calls over TCP with and without call metrics, to show what recording them costs per call
+///
+void grpc_client_call_metrics_echo(benchmark::State& state, bool call_metrics) {
+    server::ScopedGrpcServer server(std::make_unique<testing::TestService>(), listening_address(Transport::tcp));
+
+    client::GrpcClient<testing::protocol::Test> client;
+    client.change_server(listening_address(Transport::tcp), [](const client::GrpcClientState&) {});
+    if (call_metrics) {
+        client.enable_call_metrics();
+    }
+    client.connect_and_wait(std::chrono::steady_clock::now() + std::chrono::seconds(5));
+
+    LatencyRecorder latencies(static_cast<std::size_t>(state.max_iterations));
+    TestMessage request = small_request();
+    TestMessage response;
+
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+
+        auto status = client.call(&testing::protocol::Test::Stub::echo,
+                                  &testing::protocol::Test::Service::echo,
+                                  request,
+                                  &response);
+
+        latencies.record(std::chrono::steady_clock::now() - start);
+
+        if (not status.ok()) {
+            state.SkipWithError(status.error_message().c_str());
+            break;
+        }
+    }
+
+    state.counters["qps"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+    latencies.report(state);
+}
+
+///
+/// state.range(0) small calls per iteration, each made on its own with GrpcClient::call_async or
+/// collected by a UnaryCallBatcher into batches of state.range(1) (sent through 'echo_batch')
+///
+void grpc_client_batched_unary_echo(benchmark::State& state, bool batched) {
+    server::GrpcAsyncServer<AsyncService> server(std::make_shared<AsyncService>(),
+                                                 required_listening_address(Transport::tcp));
+    server.register_async(&AsyncService::Requestecho, echo);
+    server.register_async_batch<TestMessage, TestMessage>(&AsyncService::Requestecho_batch, echo, 1);
+
+    client::GrpcClient<testing::protocol::Test> client;
+    client.change_server(listening_address(Transport::tcp), [](const client::GrpcClientState&) {});
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (client.get_state() != client::GrpcClientState::connected and std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    auto batcher = client.batch_calls<TestMessage, TestMessage>(
+        &testing::protocol::Test::Stub::Asyncecho_batch,
+        {static_cast<std::size_t>(state.range(1)), std::chrono::milliseconds(1)});
+
+    auto calls = state.range(0);
+    TestMessage request = small_request();
+    std::vector<std::future<client::CallResult<TestMessage>>> results;
+
+    for (auto _ : state) {
+        results.clear();
+        for (std::int64_t i = 0; i < calls; ++i) {
+            results.emplace_back(batched ? batcher.call(request)
+                                         : client.call_async(&testing::protocol::Test::Stub::Asyncecho, request));
+        }
+        batcher.flush();
+
+        for (auto& result : results) {
+            if (not result.get().status.ok()) {
+                state.SkipWithError("Call failed");
+            }
+        }
+    }
+
+    state.counters["qps"] = benchmark::Counter(static_cast<double>(state.iterations() * calls),
+                                               benchmark::Counter::kIsRate);
+}
+
+///
+/// Time from 'change_server' to the first successful call on a new client with state.range(0) channels,
+/// either retrying the call until the client is connected or calling once 'connect_and_wait' returns.
+/// 'first_call_us' is how long the successful call itself took.
+///
+void grpc_client_time_to_first_rpc(benchmark::State& state, bool connect_and_wait) {
+    using Clock = std::chrono::steady_clock;
+
+    server::ScopedGrpcServer server(std::make_unique<testing::TestService>(), listening_address(Transport::tcp));
+
+    client::ChannelPool channel_pool;
+    channel_pool.size = static_cast<int>(state.range(0));
+
+    TestMessage request = small_request();
+    TestMessage response;
+    double first_call_us = 0.0;
+
+    for (auto _ : state) {
+        client::GrpcClient<testing::protocol::Test> client;
+
+        auto start = Clock::now();
+        client.change_server(listening_address(Transport::tcp), [](const client::GrpcClientState&) {}, channel_pool);
+
+        if (connect_and_wait and not client.connect_and_wait(start + std::chrono::seconds(5))) {
+            state.SkipWithError("Timed out connecting");
+            break;
+        }
+
+        grpc::Status status;
+        auto call_start = Clock::now();
+        while (not(status = client.call(&testing::protocol::Test::Stub::echo,
+                                        &testing::protocol::Test::Service::echo,
+                                        request,
+                                        &response))
+                        .ok()
+               and Clock::now() - start < std::chrono::seconds(5)) {
+            call_start = Clock::now();
+        }
+        auto end = Clock::now();
+
+        if (not status.ok()) {
+            state.SkipWithError(status.error_message().c_str());
+            break;
+        }
+
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+        first_call_us += std::chrono::duration<double, std::micro>(end - call_start).count();
+    }
+
+    state.counters["first_call_us"] = first_call_us / static_cast<double>(state.iterations());
+}
+
+///
+/// A server that stopped answering in time: every call takes longer than the client waits for it
+///
+class HangingService : public testing::TestService {
+public:
+    grpc::Status echo(grpc::ServerContext* context, const TestMessage* request, TestMessage* response) override {
+        ++calls;
+        while (not context->IsCancelled()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return testing::TestService::echo(context, request, response);
+    }
+
+    std::atomic_int calls = {0};
+};
+
+///
+/// Calls with a 10ms deadline to a server that never answers in time, with and without circuit
+/// breaking. Once the circuit opens calls fail right away instead of each waiting out its deadline.
+/// 'server_calls' counts the calls that reached the server.
+///
+void grpc_client_hanging_server(benchmark::State& state, bool circuit_breaking) {
+    auto service = std::make_unique<HangingService>();
+    auto* service_ptr = service.get();
+    server::ScopedGrpcServer server(std::move(service), listening_address(Transport::tcp));
+
+    client::GrpcClient<testing::protocol::Test> client;
+    client.change_server(listening_address(Transport::tcp), [](const client::GrpcClientState&) {});
+    if (circuit_breaking) {
+        client.set_circuit_breaking({});
+    }
+    client.connect_and_wait(std::chrono::steady_clock::now() + std::chrono::seconds(5));
+
+    LatencyRecorder latencies(static_cast<std::size_t>(state.max_iterations));
+    TestMessage request = small_request();
+    TestMessage response;
+
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+
+        grpc::Status status;
+        client.use_stub([&](testing::protocol::Test::Stub& stub) {
+            grpc::ClientContext context;
+            context.set_deadline(std::chrono::system_clock::now() + std::chrono::milliseconds(10));
+            status = stub.echo(&context, request, &response);
+        });
+
+        latencies.record(std::chrono::steady_clock::now() - start);
+
+        if (status.ok()) {
+            state.SkipWithError("The server answered in time");
+            break;
+        }
+    }
+
+    state.counters["server_calls"] = service_ptr->calls.load();
+    latencies.report(state);
+}
+
+/// Unary calls handled on the completion queue thread of GrpcAsyncServer
+void async_server_unary_echo(benchmark::State& state, Transport transport) {
+    server::GrpcAsyncServer<AsyncService> server(std::make_shared<AsyncService>(),
+                                                 required_listening_address(transport));
+    server.register_async(&AsyncService::Requestecho, echo);
+
+    auto channel = make_channel(transport, server.server().InProcessChannel(client::default_channel_arguments()));
+    auto stub = testing::protocol::Test::NewStub(channel);
+    run_echo_calls(state, stub, small_request());
+}
+
+#ifdef LTB_GRPCW_ENABLE_CALLBACK_SERVER
+/// The same calls handled on gRPC's threads by GrpcCallbackServer
+void callback_server_unary_echo(benchmark::State& state, Transport transport) {
+    server::GrpcCallbackServer<testing::protocol::Test> server(required_listening_address(transport));
+    server.register_async<TestMessage, TestMessage>("echo", echo);
+
+    auto channel = make_channel(transport, server.server().InProcessChannel(client::default_channel_arguments()));
+    auto stub = testing::protocol::Test::NewStub(channel);
+    run_echo_calls(state, stub, small_request());
+}
+#endif
+
+/// Large, compressible responses with and without compression (state.range(0) is the message size in bytes)
+void compressed_unary_echo(benchmark::State& state, grpc_compression_algorithm algorithm) {
+    server::CompressionOptions compression;
+    compression.algorithm = algorithm;
+
+    server::GrpcAsyncServer<AsyncService> server(std::make_shared<AsyncService>(),
+                                                 required_listening_address(Transport::tcp));
+    server.register_async(&AsyncService::Requestecho, echo, compression);
+
+    auto channel = make_channel(Transport::tcp, nullptr);
+    auto stub = testing::protocol::Test::NewStub(channel);
+
+    std::string text = "Repetitive text compresses well. ";
+    TestMessage request;
+    while (request.msg().size() < static_cast<std::size_t>(state.range(0))) {
+        request.mutable_msg()->append(text);
+    }
+    request.mutable_msg()->resize(static_cast<std::size_t>(state.range(0)));
+
+    run_echo_calls(state, stub, request);
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(unary_echo, in_process, Transport::in_process)->Threads(1)->Threads(8)->UseRealTime();
+BENCHMARK_CAPTURE(unary_echo, tcp, Transport::tcp)->Threads(1)->Threads(8)->UseRealTime();
+BENCHMARK_CAPTURE(unary_echo, uds, Transport::uds)->Threads(1)->Threads(8)->UseRealTime();
+
+BENCHMARK_CAPTURE(grpc_client_unary_echo, in_process, Transport::in_process)
+    ->Threads(1)
+    ->Threads(8)
+    ->Threads(32)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(grpc_client_unary_echo, tcp, Transport::tcp)->Threads(1)->Threads(8)->Threads(32)->UseRealTime();
+
+BENCHMARK_CAPTURE(grpc_client_channel_pool_echo, round_robin, client::ChannelSelection::round_robin)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->Threads(32)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(grpc_client_channel_pool_echo, least_loaded, client::ChannelSelection::least_loaded)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->Threads(32)
+    ->UseRealTime();
+
+BENCHMARK_CAPTURE(grpc_client_async_unary_echo, in_process, Transport::in_process)
+    ->ArgsProduct({{1, 64, 1024}, {1, 4}})
+    ->UseRealTime();
+BENCHMARK_CAPTURE(grpc_client_async_unary_echo, tcp, Transport::tcp)
+    ->ArgsProduct({{1, 64, 1024}, {1, 4}})
+    ->UseRealTime();
+
+BENCHMARK_CAPTURE(grpc_client_cached_unary_echo, uncached, false)->UseRealTime();
+BENCHMARK_CAPTURE(grpc_client_cached_unary_echo, cached, true)->UseRealTime();
+
+BENCHMARK_CAPTURE(grpc_client_call_metrics_echo, no_metrics, false)->UseRealTime();
+BENCHMARK_CAPTURE(grpc_client_call_metrics_echo, metrics, true)->UseRealTime();
+
+BENCHMARK_CAPTURE(grpc_client_batched_unary_echo, individual, false)->Args({1024, 1})->UseRealTime();
+BENCHMARK_CAPTURE(grpc_client_batched_unary_echo, batched, true)
+    ->ArgsProduct({{1024}, {16, 64, 256}})
+    ->UseRealTime();
+
+BENCHMARK_CAPTURE(grpc_client_time_to_first_rpc, retry_call, false)->Arg(1)->Arg(4)->UseManualTime();
+BENCHMARK_CAPTURE(grpc_client_time_to_first_rpc, connect_and_wait, true)->Arg(1)->Arg(4)->UseManualTime();
+
+BENCHMARK_CAPTURE(grpc_client_hanging_server, no_circuit_breaking, false)->Iterations(200)->UseRealTime();
+BENCHMARK_CAPTURE(grpc_client_hanging_server, circuit_breaking, true)->Iterations(200)->UseRealTime();
+
+BENCHMARK_CAPTURE(async_server_unary_echo, in_process, Transport::in_process)->UseRealTime();
+BENCHMARK_CAPTURE(async_server_unary_echo, tcp, Transport::tcp)->UseRealTime();
+BENCHMARK_CAPTURE(async_server_unary_echo, uds, Transport::uds)->UseRealTime();
+#ifdef LTB_GRPCW_ENABLE_CALLBACK_SERVER
+BENCHMARK_CAPTURE(callback_server_unary_echo, in_process, Transport::in_process)->UseRealTime();
+BENCHMARK_CAPTURE(callback_server_unary_echo, tcp, Transport::tcp)->UseRealTime();
+BENCHMARK_CAPTURE(callback_server_unary_echo, uds, Transport::uds)->UseRealTime();
+#endif
+
+BENCHMARK_CAPTURE(compressed_unary_echo, none, GRPC_COMPRESS_NONE)->Arg(1 << 10)->Arg(64 << 10)->UseRealTime();
+BENCHMARK_CAPTURE(compressed_unary_echo, gzip, GRPC_COMPRESS_GZIP)->Arg(1 << 10)->Arg(64 << 10)->UseRealTime();
+
+} // namespace benchmarks
+} // namespace grpcw
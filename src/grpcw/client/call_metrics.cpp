@@ -0,0 +1,203 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/client/call_metrics.hpp"
+
+// standard
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+
+namespace grpcw {
+namespace client {
+namespace {
+
+/// Upper bounds of the buckets of the latency histograms (microseconds)
+constexpr std::array<std::uint64_t, 18> bucket_bounds_us = {100u,
+                                                            250u,
+                                                            500u,
+                                                            1'000u,
+                                                            2'500u,
+                                                            5'000u,
+                                                            10'000u,
+                                                            25'000u,
+                                                            50'000u,
+                                                            100'000u,
+                                                            250'000u,
+                                                            500'000u,
+                                                            1'000'000u,
+                                                            2'500'000u,
+                                                            5'000'000u,
+                                                            10'000'000u,
+                                                            30'000'000u,
+                                                            60'000'000u};
+
+std::string to_string(grpc::StatusCode code) {
+    switch (code) {
+    case grpc::StatusCode::OK:
+        return "OK";
+    case grpc::StatusCode::CANCELLED:
+        return "CANCELLED";
+    case grpc::StatusCode::UNKNOWN:
+        return "UNKNOWN";
+    case grpc::StatusCode::INVALID_ARGUMENT:
+        return "INVALID_ARGUMENT";
+    case grpc::StatusCode::DEADLINE_EXCEEDED:
+        return "DEADLINE_EXCEEDED";
+    case grpc::StatusCode::NOT_FOUND:
+        return "NOT_FOUND";
+    case grpc::StatusCode::ALREADY_EXISTS:
+        return "ALREADY_EXISTS";
+    case grpc::StatusCode::PERMISSION_DENIED:
+        return "PERMISSION_DENIED";
+    case grpc::StatusCode::UNAUTHENTICATED:
+        return "UNAUTHENTICATED";
+    case grpc::StatusCode::RESOURCE_EXHAUSTED:
+        return "RESOURCE_EXHAUSTED";
+    case grpc::StatusCode::FAILED_PRECONDITION:
+        return "FAILED_PRECONDITION";
+    case grpc::StatusCode::ABORTED:
+        return "ABORTED";
+    case grpc::StatusCode::OUT_OF_RANGE:
+        return "OUT_OF_RANGE";
+    case grpc::StatusCode::UNIMPLEMENTED:
+        return "UNIMPLEMENTED";
+    case grpc::StatusCode::INTERNAL:
+        return "INTERNAL";
+    case grpc::StatusCode::UNAVAILABLE:
+        return "UNAVAILABLE";
+    case grpc::StatusCode::DATA_LOSS:
+        return "DATA_LOSS";
+    case grpc::StatusCode::DO_NOT_USE:
+        break;
+    }
+    return std::to_string(static_cast<int>(code));
+}
+
+/// \brief A label value with backslashes, quotes and line feeds escaped
+std::string escaped(const std::string& value) {
+    std::string result;
+    result.reserve(value.size());
+
+    for (char c : value) {
+        if (c == '\\' or c == '"') {
+            result += '\\';
+            result += c;
+        } else if (c == '\n') {
+            result += "\\n";
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+void write_header(std::ostream& os, const std::string& name, const std::string& type, const std::string& help) {
+    os << "# HELP " << name << ' ' << help << '\n';
+    os << "# TYPE " << name << ' ' << type << '\n';
+}
+
+void write_histogram(std::ostream& os,
+                     const std::string& name,
+                     const std::string& help,
+                     const std::vector<MethodMetrics>& metrics,
+                     const std::function<const util::LatencyHistogram&(const MethodMetrics&)>& histogram_of) {
+    write_header(os, name, "histogram", help);
+
+    for (const auto& method : metrics) {
+        const auto& histogram = histogram_of(method);
+        auto label = "method=\"" + escaped(method.method) + "\"";
+
+        for (auto bound : bucket_bounds_us) {
+            os << name << "_bucket{" << label << ",le=\"" << static_cast<double>(bound) / 1e6 << "\"} "
+               << histogram.count_at_or_below(bound) << '\n';
+        }
+        os << name << "_bucket{" << label << ",le=\"+Inf\"} " << histogram.total_count() << '\n';
+        os << name << "_sum{" << label << "} "
+           << histogram.mean() * static_cast<double>(histogram.total_count()) / 1e6 << '\n';
+        os << name << "_count{" << label << "} " << histogram.total_count() << '\n';
+    }
+}
+
+} // namespace
+
+void write_prometheus_metrics(std::ostream& os, const std::vector<MethodMetrics>& metrics) {
+    write_header(os, "grpcw_client_calls_started_total", "counter", "Calls started by the client.");
+    for (const auto& method : metrics) {
+        os << "grpcw_client_calls_started_total{method=\"" << escaped(method.method) << "\"} "
+           << method.calls_started << '\n';
+    }
+
+    write_header(os, "grpcw_client_calls_in_flight", "gauge", "Calls started but not finished yet.");
+    for (const auto& method : metrics) {
+        os << "grpcw_client_calls_in_flight{method=\"" << escaped(method.method) << "\"} " << method.calls_in_flight
+           << '\n';
+    }
+
+    write_header(os, "grpcw_client_calls_finished_total", "counter", "Calls finished with each status code.");
+    for (const auto& method : metrics) {
+        for (const auto& code_and_count : method.calls_finished) {
+            os << "grpcw_client_calls_finished_total{method=\"" << escaped(method.method) << "\",code=\""
+               << to_string(code_and_count.first) << "\"} " << code_and_count.second << '\n';
+        }
+    }
+
+    write_histogram(os,
+                    "grpcw_client_first_message_seconds",
+                    "Time from the start of a call to the first message from the server.",
+                    metrics,
+                    [](const MethodMetrics& method) -> const util::LatencyHistogram& {
+                        return method.first_message_latency;
+                    });
+
+    write_histogram(os,
+                    "grpcw_client_call_seconds",
+                    "Time from the start of a call to its status.",
+                    metrics,
+                    [](const MethodMetrics& method) -> const util::LatencyHistogram& { return method.total_latency; });
+}
+
+void write_prometheus_metrics_file(const std::string& path, const std::vector<MethodMetrics>& metrics) {
+    auto temporary_path = path + ".tmp";
+    {
+        std::ofstream file(temporary_path);
+        if (not file) {
+            throw std::runtime_error("Failed to open '" + temporary_path + "'");
+        }
+        write_prometheus_metrics(file, metrics);
+
+        file.flush();
+        if (not file) {
+            throw std::runtime_error("Failed to write '" + temporary_path + "'");
+        }
+    }
+
+    if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+        std::remove(temporary_path.c_str());
+        throw std::runtime_error("Failed to replace '" + path + "'");
+    }
+}
+
+} // namespace client
+} // namespace grpcw
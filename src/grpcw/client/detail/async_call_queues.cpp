@@ -0,0 +1,132 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/client/detail/async_call_queues.hpp"
+
+// standard
+#include <stdexcept>
+
+namespace grpcw {
+namespace client {
+namespace detail {
+
+AsyncCall::~AsyncCall() = default;
+
+AsyncAlarm::AsyncAlarm(OnFire on_fire) : on_fire_(std::move(on_fire)) {}
+
+void AsyncAlarm::on_complete(bool call_ok) {
+    if (on_fire_) {
+        on_fire_(call_ok);
+    }
+}
+
+void AsyncAlarm::cancel() {
+    alarm.Cancel();
+}
+
+AsyncCallQueues::AsyncCallQueues(int thread_count) {
+    if (thread_count < 1) {
+        throw std::invalid_argument("At least one thread is needed for asynchronous calls");
+    }
+
+    for (int i = 0; i < thread_count; ++i) {
+        queues_.emplace_back(std::make_unique<Queue>());
+        queues_.back()->thread = std::thread(&AsyncCallQueues::run, queues_.back().get());
+    }
+}
+
+AsyncCallQueues::~AsyncCallQueues() {
+    for (auto& queue : queues_) {
+        // The calls still complete (as cancelled) so their callbacks run before the thread exits
+        queue->in_flight.use_safely([](InFlight& in_flight) {
+            in_flight.stopping = true;
+            for (auto* call : in_flight.calls) {
+                call->cancel();
+            }
+        });
+        queue->queue.Shutdown();
+    }
+
+    for (auto& queue : queues_) {
+        queue->thread.join();
+    }
+}
+
+bool AsyncCallQueues::start(AsyncCall* call, const std::function<void(grpc::CompletionQueue*)>& start_call) {
+    return start(call, next_queue_index(), start_call);
+}
+
+bool AsyncCallQueues::start(AsyncCall* call,
+                            std::size_t queue_index,
+                            const std::function<void(grpc::CompletionQueue*)>& start_call) {
+    call->queue_index_ = queue_index % queues_.size();
+    auto& queue = *queues_[call->queue_index_];
+
+    // Started while locked so the call can't be added to a queue that has already been shut down
+    return queue.in_flight.use_safely([&](InFlight& in_flight) {
+        if (in_flight.stopping) {
+            return false;
+        }
+        in_flight.calls.insert(call);
+        start_call(&queue.queue);
+        return true;
+    });
+}
+
+std::size_t AsyncCallQueues::next_queue_index() {
+    return next_queue_.fetch_add(1u, std::memory_order_relaxed) % queues_.size();
+}
+
+bool AsyncCallQueues::resume(AsyncCall* call, const std::function<void()>& start_operation) {
+    return queues_[call->queue_index_]->in_flight.use_safely([&](const InFlight& in_flight) {
+        if (in_flight.stopping) {
+            return false;
+        }
+        start_operation();
+        call->resumed_ = true;
+        return true;
+    });
+}
+
+void AsyncCallQueues::run(Queue* queue) {
+    void* tag;
+    bool call_ok;
+
+    while (queue->queue.Next(&tag, &call_ok)) {
+        auto* call = static_cast<AsyncCall*>(tag);
+
+        call->resumed_ = false;
+        call->on_complete(call_ok);
+
+        if (call->resumed_) {
+            continue;
+        }
+
+        // Forgotten before it's deleted so it's never cancelled after that
+        queue->in_flight.use_safely([call](InFlight& in_flight) { in_flight.calls.erase(call); });
+        delete call;
+    }
+}
+
+} // namespace detail
+} // namespace client
+} // namespace grpcw
@@ -0,0 +1,187 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/client/detail/call_metrics_recorder.hpp"
+
+// standard
+#include <cstring>
+
+namespace grpcw {
+namespace client {
+namespace detail {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::uint64_t microseconds(Clock::duration duration) {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+}
+
+/// \brief Counts one call and measures when its first message and its status arrive
+class CallMetricsInterceptor : public grpc::experimental::Interceptor {
+public:
+    explicit CallMetricsInterceptor(std::shared_ptr<MethodRecorder> recorder) : recorder_(std::move(recorder)) {}
+
+    ~CallMetricsInterceptor() override {
+        // Streams that are dropped without reading their status
+        if (started_ and not finished_) {
+            recorder_->calls_in_flight.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    void Intercept(grpc::experimental::InterceptorBatchMethods* methods) override {
+        using Hook = grpc::experimental::InterceptionHookPoints;
+
+        if (methods->QueryInterceptionHookPoint(Hook::PRE_SEND_INITIAL_METADATA)) {
+            start_ = Clock::now();
+            started_ = true;
+            recorder_->calls_started.fetch_add(1u, std::memory_order_relaxed);
+            recorder_->calls_in_flight.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (methods->QueryInterceptionHookPoint(Hook::POST_RECV_MESSAGE) and not received_message_
+            and methods->GetRecvMessage() != nullptr) {
+            received_message_ = true;
+            first_message_latency_ = Clock::now() - start_;
+        }
+
+        if (methods->QueryInterceptionHookPoint(Hook::POST_RECV_STATUS) and started_) {
+            finish(methods->GetRecvStatus()->error_code());
+        }
+
+        methods->Proceed();
+    }
+
+private:
+    std::shared_ptr<MethodRecorder> recorder_;
+
+    Clock::time_point start_ = {};
+    Clock::duration first_message_latency_ = {};
+    bool started_ = false;
+    bool received_message_ = false;
+    bool finished_ = false;
+
+    void finish(grpc::StatusCode code) {
+        auto total_latency = Clock::now() - start_;
+        finished_ = true;
+
+        auto index = static_cast<std::size_t>(code);
+        if (index >= MethodRecorder::status_code_count) {
+            index = static_cast<std::size_t>(grpc::StatusCode::UNKNOWN);
+        }
+        recorder_->calls_finished[index].fetch_add(1u, std::memory_order_relaxed);
+        recorder_->calls_in_flight.fetch_sub(1, std::memory_order_relaxed);
+
+        recorder_->latencies.use_safely([&](MethodRecorder::Latencies& latencies) {
+            if (received_message_) {
+                latencies.first_message.record(microseconds(first_message_latency_));
+            }
+            latencies.total.record(microseconds(total_latency));
+        });
+    }
+};
+
+} // namespace
+
+MethodRecorder::MethodRecorder(std::string method_name) : method(std::move(method_name)) {}
+
+std::shared_ptr<MethodRecorder> CallMetricsRecorder::method(const char* method) {
+    auto methods = methods_.load();
+
+    // The pointer can be reused for another name once the string it pointed to is gone
+    auto by_pointer = methods->by_pointer.find(method);
+    if (by_pointer != methods->by_pointer.end() and std::strcmp(by_pointer->second->method.c_str(), method) == 0) {
+        return by_pointer->second;
+    }
+
+    // Other strings with a known name aren't added since that would copy the methods on every call
+    auto by_name = methods->by_name.find(method);
+    if (by_name != methods->by_name.end()) {
+        return by_name->second;
+    }
+
+    std::lock_guard<std::mutex> lock(add_mutex_);
+
+    // Another call may have added the method while this one waited
+    auto updated = std::make_shared<Methods>(*methods_.load());
+
+    auto& recorder = updated->by_name[method];
+    if (not recorder) {
+        recorder = std::make_shared<MethodRecorder>(method);
+    }
+    updated->by_pointer[method] = recorder;
+
+    auto result = recorder;
+    methods_.store(std::move(updated));
+    return result;
+}
+
+std::vector<MethodMetrics> CallMetricsRecorder::snapshot() const {
+    auto methods = methods_.load();
+
+    std::vector<std::shared_ptr<MethodRecorder>> recorders;
+    for (const auto& name_and_recorder : methods->by_name) {
+        recorders.emplace_back(name_and_recorder.second);
+    }
+
+    std::vector<MethodMetrics> metrics(recorders.size());
+
+    for (auto i = 0u; i < recorders.size(); ++i) {
+        const auto& recorder = *recorders[i];
+        auto& method = metrics[i];
+
+        method.method = recorder.method;
+        method.calls_started = recorder.calls_started.load(std::memory_order_relaxed);
+        method.calls_in_flight = recorder.calls_in_flight.load(std::memory_order_relaxed);
+
+        for (auto code = 0u; code < MethodRecorder::status_code_count; ++code) {
+            auto count = recorder.calls_finished[code].load(std::memory_order_relaxed);
+            if (count > 0u) {
+                method.calls_finished[static_cast<grpc::StatusCode>(code)] = count;
+            }
+        }
+
+        recorders[i]->latencies.use_safely([&method](const MethodRecorder::Latencies& latencies) {
+            method.first_message_latency = latencies.first_message;
+            method.total_latency = latencies.total;
+        });
+    }
+    return metrics;
+}
+
+CallMetricsInterceptorFactory::CallMetricsInterceptorFactory(
+    std::shared_ptr<const util::AtomicSharedPtr<CallMetricsRecorder>> recorder)
+    : recorder_(std::move(recorder)) {}
+
+grpc::experimental::Interceptor*
+CallMetricsInterceptorFactory::CreateClientInterceptor(grpc::experimental::ClientRpcInfo* info) {
+    auto recorder = recorder_->load();
+    if (not recorder) {
+        return nullptr;
+    }
+    return new CallMetricsInterceptor(recorder->method(info->method()));
+}
+
+} // namespace detail
+} // namespace client
+} // namespace grpcw
@@ -0,0 +1,61 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/client/detail/call_outcome.hpp"
+
+// standard
+#include <random>
+#include <string>
+
+namespace grpcw {
+namespace client {
+namespace detail {
+
+namespace {
+
+const std::string& rejection_marker() {
+    static const std::string marker = [] {
+        std::random_device random;
+        std::uniform_int_distribution<int> byte(0, 255);
+
+        std::string bytes(16u, '\0');
+        for (auto& b : bytes) {
+            b = static_cast<char>(byte(random));
+        }
+        return "grpcw-circuit-rejection:" + bytes;
+    }();
+    return marker;
+}
+
+} // namespace
+
+grpc::Status circuit_rejection() {
+    return {grpc::StatusCode::UNAVAILABLE, circuit_open_message, rejection_marker()};
+}
+
+bool is_circuit_rejection(const grpc::Status& status) {
+    return status.error_code() == grpc::StatusCode::UNAVAILABLE and status.error_details() == rejection_marker();
+}
+
+} // namespace detail
+} // namespace client
+} // namespace grpcw
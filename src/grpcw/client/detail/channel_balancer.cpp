@@ -0,0 +1,252 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/client/detail/channel_balancer.hpp"
+
+// grpcw
+#include "grpcw/client/detail/call_outcome.hpp"
+
+// standard
+#include <random>
+#include <stdexcept>
+
+namespace grpcw {
+namespace client {
+namespace detail {
+
+namespace {
+
+std::int64_t steady_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+std::size_t random_index(std::size_t count) {
+    thread_local std::minstd_rand random(std::random_device{}());
+    return std::uniform_int_distribution<std::size_t>(0u, count - 1u)(random);
+}
+
+} // namespace
+
+ChannelBalancer::ChannelBalancer(std::size_t channel_count, const ChannelPool& options)
+    : channel_count_(channel_count), options_(options), channels_(std::make_unique<ChannelStats[]>(channel_count)) {
+    if (channel_count_ == 0u) {
+        throw std::invalid_argument("A channel balancer needs at least one channel");
+    }
+}
+
+void ChannelBalancer::set_ready(std::size_t index, bool ready) {
+    channels_[index].ready.store(ready, std::memory_order_relaxed);
+}
+
+bool ChannelBalancer::is_ready(std::size_t index) const {
+    return channels_[index].ready.load(std::memory_order_relaxed);
+}
+
+bool ChannelBalancer::acquire(std::size_t* index) {
+    return acquire_avoiding(channel_count_, index);
+}
+
+bool ChannelBalancer::acquire(std::size_t* index, std::size_t avoid) {
+    return acquire_avoiding(avoid, index);
+}
+
+void ChannelBalancer::release(std::size_t index) {
+    if (channel_count_ > 1u) {
+        channels_[index].calls_in_flight.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void ChannelBalancer::release(std::size_t index, const grpc::Status& status, std::chrono::nanoseconds latency) {
+    // The call never reached the server so it says nothing about the channel
+    if (is_circuit_rejection(status)) {
+        release(index);
+        return;
+    }
+    if (channel_count_ == 1u) {
+        return;
+    }
+    auto& channel = channels_[index];
+    channel.calls_in_flight.fetch_sub(1, std::memory_order_relaxed);
+
+    // An exponentially weighted moving average (new samples have a weight of 1/4)
+    auto sample = latency.count();
+    auto average = channel.average_latency_ns.load(std::memory_order_relaxed);
+    channel.average_latency_ns.store((average == 0) ? sample : average + (sample - average) / 4,
+                                     std::memory_order_relaxed);
+
+    if (not is_backend_failure(status.error_code())) {
+        channel.consecutive_failures.store(0, std::memory_order_relaxed);
+        return;
+    }
+
+    auto failures = channel.consecutive_failures.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (options_.failures_before_ejection > 0 and failures >= options_.failures_before_ejection) {
+        auto ejection_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(options_.ejection_time).count();
+        channel.ejected_until_ns.store(steady_now_ns() + ejection_ns, std::memory_order_relaxed);
+        channel.consecutive_failures.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool ChannelBalancer::acquire_stream(std::size_t* index) {
+    bool allow_ejected = false;
+    std::size_t first;
+
+    // Unlike calls, even a single channel is checked since streams are started by the client itself
+    auto now_ns = steady_now_ns();
+    if (not first_eligible(now_ns, &allow_ejected, &first)) {
+        return false;
+    }
+
+    // Streams stay open for much longer than calls so spread them by count alone
+    *index = pick_least_loaded(first, allow_ejected, now_ns, &ChannelStats::streams);
+    channels_[*index].streams.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void ChannelBalancer::release_stream(std::size_t index) {
+    channels_[index].streams.fetch_sub(1, std::memory_order_relaxed);
+}
+
+int ChannelBalancer::calls_in_flight(std::size_t index) const {
+    return channels_[index].calls_in_flight.load(std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds ChannelBalancer::average_latency(std::size_t index) const {
+    return std::chrono::nanoseconds(channels_[index].average_latency_ns.load(std::memory_order_relaxed));
+}
+
+int ChannelBalancer::streams(std::size_t index) const {
+    return channels_[index].streams.load(std::memory_order_relaxed);
+}
+
+bool ChannelBalancer::is_ejected(std::size_t index) const {
+    return channels_[index].ejected_until_ns.load(std::memory_order_relaxed) > steady_now_ns();
+}
+
+bool ChannelBalancer::acquire_avoiding(std::size_t avoid, std::size_t* index) {
+    // A single channel is only used while it's connected so there is nothing to choose or count
+    if (channel_count_ == 1u) {
+        *index = 0u;
+        return true;
+    }
+
+    auto now_ns = steady_now_ns();
+    bool allow_ejected = false;
+    std::size_t first;
+
+    if (not first_eligible(now_ns, &allow_ejected, &first)) {
+        return false;
+    }
+
+    switch (options_.selection) {
+    case ChannelSelection::round_robin:
+        *index = first;
+        break;
+    case ChannelSelection::least_loaded:
+        *index = pick_least_loaded(first, allow_ejected, now_ns, &ChannelStats::calls_in_flight);
+        break;
+    case ChannelSelection::power_of_two_choices:
+        *index = pick_power_of_two_choices(allow_ejected, now_ns);
+        break;
+    }
+
+    // Any other eligible channel will do. 'avoid' is only used if it's the only one left.
+    if (*index == avoid) {
+        next_eligible((avoid + 1u) % channel_count_, allow_ejected, now_ns, index);
+    }
+
+    channels_[*index].calls_in_flight.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool ChannelBalancer::is_eligible(std::size_t index, bool allow_ejected, std::int64_t now_ns) const {
+    const auto& channel = channels_[index];
+    return channel.ready.load(std::memory_order_relaxed)
+        and (allow_ejected or channel.ejected_until_ns.load(std::memory_order_relaxed) <= now_ns);
+}
+
+bool ChannelBalancer::first_eligible(std::int64_t now_ns, bool* allow_ejected, std::size_t* index) {
+    auto start = next_index_.fetch_add(1u, std::memory_order_relaxed) % channel_count_;
+
+    *allow_ejected = false;
+    if (next_eligible(start, *allow_ejected, now_ns, index)) {
+        return true;
+    }
+
+    // Every connected channel has been ejected. Using them is better than failing every call.
+    *allow_ejected = true;
+    return next_eligible(start, *allow_ejected, now_ns, index);
+}
+
+bool ChannelBalancer::next_eligible(std::size_t start,
+                                    bool allow_ejected,
+                                    std::int64_t now_ns,
+                                    std::size_t* index) const {
+    for (auto i = 0u; i < channel_count_; ++i) {
+        auto candidate = (start + i) % channel_count_;
+        if (is_eligible(candidate, allow_ejected, now_ns)) {
+            *index = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t ChannelBalancer::pick_least_loaded(std::size_t first,
+                                               bool allow_ejected,
+                                               std::int64_t now_ns,
+                                               std::atomic_int ChannelStats::*load) const {
+    auto load_of = [this, load](std::size_t index) { return (channels_[index].*load).load(std::memory_order_relaxed); };
+
+    auto best = first;
+    auto best_load = load_of(first);
+
+    for (auto i = 1u; i < channel_count_; ++i) {
+        auto candidate = (first + i) % channel_count_;
+        if (is_eligible(candidate, allow_ejected, now_ns) and load_of(candidate) < best_load) {
+            best = candidate;
+            best_load = load_of(candidate);
+        }
+    }
+    return best;
+}
+
+std::size_t ChannelBalancer::pick_power_of_two_choices(bool allow_ejected, std::int64_t now_ns) const {
+    std::size_t a;
+    std::size_t b;
+
+    // An eligible channel exists so both of these succeed
+    next_eligible(random_index(channel_count_), allow_ejected, now_ns, &a);
+    next_eligible(random_index(channel_count_), allow_ejected, now_ns, &b);
+
+    // Cost grows with both the queue of calls on a channel and how slowly it responds
+    auto cost = [this](std::size_t index) {
+        return static_cast<double>(average_latency(index).count() + 1)
+            * static_cast<double>(calls_in_flight(index) + 1);
+    };
+    return (cost(b) < cost(a)) ? b : a;
+}
+
+} // namespace detail
+} // namespace client
+} // namespace grpcw
@@ -0,0 +1,283 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/client/detail/circuit_breaker.hpp"
+
+// grpcw
+#include "grpcw/client/detail/call_outcome.hpp"
+
+// standard
+#include <stdexcept>
+
+namespace grpcw {
+namespace client {
+namespace detail {
+
+namespace {
+
+void validate(const CircuitBreaking& options) {
+    if (options.window.count() <= 0 or options.open_time.count() <= 0) {
+        throw std::invalid_argument("The circuit breaker window and open time must be positive");
+    }
+    if (options.minimum_calls < 1 or options.half_open_calls < 1) {
+        throw std::invalid_argument("The circuit breaker needs at least one call to decide and one trial call");
+    }
+    if (not(options.failure_rate > 0.0 and options.failure_rate <= 1.0)
+        or not(options.slow_call_rate > 0.0 and options.slow_call_rate <= 1.0)) {
+        throw std::invalid_argument("The circuit breaker failure and slow call rates must be in (0, 1]");
+    }
+    if (options.slow_call_duration.count() < 0) {
+        throw std::invalid_argument("The circuit breaker slow call duration can't be negative");
+    }
+}
+
+/// \brief Fails calls on an open circuit without sending them and records the outcome of the others
+class CircuitBreakerInterceptor : public grpc::experimental::Interceptor {
+public:
+    CircuitBreakerInterceptor(std::shared_ptr<CircuitBreakers> circuit_breakers,
+                              std::string method,
+                              std::string backend)
+        : circuit_breakers_(std::move(circuit_breakers)),
+          method_(std::move(method)),
+          backend_(std::move(backend)),
+          circuit_(circuit_breakers_->circuit(method_, backend_)) {}
+
+    void Intercept(grpc::experimental::InterceptorBatchMethods* methods) override {
+        using Hook = grpc::experimental::InterceptionHookPoints;
+
+        bool starting = methods->QueryInterceptionHookPoint(Hook::PRE_SEND_INITIAL_METADATA);
+
+        if (starting) {
+            bool half_opened = false;
+            start_ = CircuitBreaker::Clock::now();
+            rejected_ = not circuit_->try_acquire(start_, &trial_, &half_opened);
+
+            if (half_opened) {
+                circuit_breakers_->notify(method_, backend_, CircuitState::half_open);
+            }
+        }
+
+        if (rejected_) {
+            // The call was hijacked so this interceptor provides what the server would have sent
+            if (methods->QueryInterceptionHookPoint(Hook::PRE_RECV_MESSAGE)) {
+                methods->FailHijackedRecvMessage();
+            }
+            if (methods->QueryInterceptionHookPoint(Hook::PRE_RECV_STATUS)) {
+                *methods->GetRecvStatus() = circuit_rejection();
+            }
+
+        } else if (methods->QueryInterceptionHookPoint(Hook::POST_RECV_STATUS)) {
+            auto now = CircuitBreaker::Clock::now();
+            CircuitState state;
+
+            if (circuit_->record(*methods->GetRecvStatus(), now - start_, trial_, now, &state)) {
+                circuit_breakers_->notify(method_, backend_, state);
+            }
+        }
+
+        if (starting and rejected_) {
+            methods->Hijack();
+        } else {
+            methods->Proceed();
+        }
+    }
+
+private:
+    std::shared_ptr<CircuitBreakers> circuit_breakers_;
+    std::string method_;
+    std::string backend_;
+    std::shared_ptr<CircuitBreaker> circuit_;
+
+    CircuitBreaker::Clock::time_point start_ = {};
+    bool trial_ = false;
+    bool rejected_ = false;
+};
+
+} // namespace
+
+CircuitBreaker::CircuitBreaker(const CircuitBreaking& options)
+    : options_(options),
+      bucket_width_(std::chrono::duration_cast<Clock::duration>(options.window) / bucket_count) {
+    validate(options_);
+}
+
+bool CircuitBreaker::try_acquire(Clock::time_point now, bool* trial, bool* half_opened) {
+    *trial = false;
+    *half_opened = false;
+
+    return state_.use_safely([&](State& state) {
+        if (state.state == CircuitState::open) {
+            if (now - state.opened_at < options_.open_time) {
+                return false;
+            }
+            state.state = CircuitState::half_open;
+            state.trials_started = 0;
+            state.trials_succeeded = 0;
+            *half_opened = true;
+        }
+
+        if (state.state == CircuitState::half_open) {
+            if (state.trials_started >= options_.half_open_calls) {
+                return false;
+            }
+            ++state.trials_started;
+            *trial = true;
+        }
+        return true;
+    });
+}
+
+bool CircuitBreaker::record(const grpc::Status& status,
+                            std::chrono::nanoseconds latency,
+                            bool trial,
+                            Clock::time_point now,
+                            CircuitState* new_state) {
+    bool failed = is_backend_failure(status.error_code());
+    bool slow = options_.slow_call_duration.count() > 0 and latency >= options_.slow_call_duration;
+
+    return state_.use_safely([&](State& state) {
+        switch (state.state) {
+        case CircuitState::open:
+            // Calls that started before the circuit opened say nothing about the server now
+            return false;
+
+        case CircuitState::half_open:
+            if (not trial) {
+                return false;
+            }
+            if (failed or slow) {
+                open(&state, now);
+            } else if (++state.trials_succeeded < options_.half_open_calls) {
+                return false;
+            } else {
+                state.state = CircuitState::closed;
+                state.buckets = {};
+            }
+            *new_state = state.state;
+            return true;
+
+        case CircuitState::closed:
+            break;
+        }
+
+        auto index = static_cast<std::int64_t>(now.time_since_epoch() / bucket_width_);
+        auto& bucket = state.buckets[static_cast<std::size_t>(index) % bucket_count];
+        if (bucket.index != index) {
+            bucket = Bucket{};
+            bucket.index = index;
+        }
+        ++bucket.calls;
+        bucket.failures += failed ? 1 : 0;
+        bucket.slow_calls += slow ? 1 : 0;
+
+        Bucket window;
+        for (const auto& recent : state.buckets) {
+            if (recent.index > index - static_cast<std::int64_t>(bucket_count)) {
+                window.calls += recent.calls;
+                window.failures += recent.failures;
+                window.slow_calls += recent.slow_calls;
+            }
+        }
+
+        if (window.calls < options_.minimum_calls) {
+            return false;
+        }
+
+        bool too_many_failures = window.failures >= options_.failure_rate * window.calls;
+        bool too_many_slow_calls = options_.slow_call_duration.count() > 0
+            and window.slow_calls >= options_.slow_call_rate * window.calls;
+
+        if (not too_many_failures and not too_many_slow_calls) {
+            return false;
+        }
+        open(&state, now);
+        *new_state = state.state;
+        return true;
+    });
+}
+
+CircuitState CircuitBreaker::state() const {
+    return state_.use_safely([](const State& state) { return state.state; });
+}
+
+void CircuitBreaker::open(State* state, Clock::time_point now) const {
+    state->state = CircuitState::open;
+    state->opened_at = now;
+    state->buckets = {};
+}
+
+CircuitBreakers::CircuitBreakers(const CircuitBreaking& options, OnChange on_change)
+    : options_(options), on_change_(std::move(on_change)) {
+    // Fail here rather than on the first call
+    validate(options_);
+}
+
+std::shared_ptr<CircuitBreaker> CircuitBreakers::circuit(const std::string& method, const std::string& backend) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto& circuit = circuits_[{method, backend}];
+    if (not circuit) {
+        circuit = std::make_shared<CircuitBreaker>(options_);
+    }
+    return circuit;
+}
+
+CircuitState CircuitBreakers::state(const std::string& method, const std::string& backend) const {
+    std::shared_ptr<CircuitBreaker> circuit;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = circuits_.find({method, backend});
+        if (iter == circuits_.end()) {
+            return CircuitState::closed;
+        }
+        circuit = iter->second;
+    }
+    return circuit->state();
+}
+
+void CircuitBreakers::notify(const std::string& method, const std::string& backend, CircuitState state) const {
+    if (on_change_) {
+        on_change_(method, backend, state);
+    }
+}
+
+CircuitBreakerInterceptorFactory::CircuitBreakerInterceptorFactory(
+    std::shared_ptr<const util::AtomicSharedPtr<CircuitBreakers>> circuit_breakers, std::string backend)
+    : circuit_breakers_(std::move(circuit_breakers)), backend_(std::move(backend)) {}
+
+grpc::experimental::Interceptor*
+CircuitBreakerInterceptorFactory::CreateClientInterceptor(grpc::experimental::ClientRpcInfo* info) {
+    // Streams last too long for their outcome to say much about the server's health
+    if (info->type() != grpc::experimental::ClientRpcInfo::Type::UNARY) {
+        return nullptr;
+    }
+
+    auto circuit_breakers = circuit_breakers_->load();
+    if (not circuit_breakers) {
+        return nullptr;
+    }
+    return new CircuitBreakerInterceptor(std::move(circuit_breakers), info->method(), backend_);
+}
+
+} // namespace detail
+} // namespace client
+} // namespace grpcw
@@ -0,0 +1,135 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/client/detail/hedged_call.hpp"
+
+// standard
+#include <stdexcept>
+
+namespace grpcw {
+namespace client {
+namespace detail {
+
+namespace {
+
+// Latencies are kept in microseconds up to a minute, which is plenty for picking a hedge delay
+constexpr std::uint64_t highest_latency_us = 60'000'000u;
+constexpr int latency_digits = 2;
+
+// The percentile delay is first used (and then refreshed) after this many latencies
+constexpr std::uint64_t delay_update_interval = 100u;
+
+} // namespace
+
+HedgingTracker::HedgingTracker(const HedgingPolicy& policy)
+    : policy_(policy), recent_latencies_(highest_latency_us, latency_digits) {
+    if (policy_.delay.count() < 0) {
+        throw std::invalid_argument("The hedge delay can't be negative");
+    }
+    if (not(policy_.delay_percentile > 0.0 and policy_.delay_percentile <= 100.0)) {
+        throw std::invalid_argument("The hedge delay percentile must be in (0, 100]");
+    }
+    if (policy_.delay_window < 1) {
+        throw std::invalid_argument("The hedge delay window needs at least one latency");
+    }
+    if (not(policy_.budget >= 0.0) or not(policy_.max_tokens >= 1.0)) {
+        throw std::invalid_argument("The hedge budget can't be negative and needs room for at least one token");
+    }
+}
+
+bool HedgingTracker::start_call(std::chrono::nanoseconds* hedge_delay) {
+    calls_.fetch_add(1u, std::memory_order_relaxed);
+
+    auto tokens = tokens_.load(std::memory_order_relaxed);
+    while (tokens < policy_.max_tokens
+           and not tokens_.compare_exchange_weak(tokens,
+                                                 std::min(tokens + policy_.budget, policy_.max_tokens),
+                                                 std::memory_order_relaxed)) {
+    }
+
+    if (policy_.delay.count() > 0) {
+        *hedge_delay = policy_.delay;
+        return true;
+    }
+
+    *hedge_delay = std::chrono::nanoseconds(percentile_delay_ns_.load(std::memory_order_relaxed));
+    return hedge_delay->count() > 0;
+}
+
+bool HedgingTracker::try_send_hedge() {
+    auto tokens = tokens_.load(std::memory_order_relaxed);
+    do {
+        if (tokens < 1.0) {
+            return false;
+        }
+    } while (not tokens_.compare_exchange_weak(tokens, tokens - 1.0, std::memory_order_relaxed));
+
+    hedges_sent_.fetch_add(1u, std::memory_order_relaxed);
+    return true;
+}
+
+void HedgingTracker::record_latency(std::chrono::nanoseconds latency) {
+    // Fixed delays don't need the latencies
+    if (policy_.delay.count() > 0) {
+        return;
+    }
+
+    auto latency_us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+
+    recent_latencies_.use_safely([&](util::LatencyHistogram& latencies) {
+        latencies.record(static_cast<std::uint64_t>(std::max<std::int64_t>(latency_us, 1)));
+
+        auto count = latencies.total_count();
+        auto window = static_cast<std::uint64_t>(policy_.delay_window);
+
+        if (count % delay_update_interval == 0u or count >= window) {
+            auto delay_us = latencies.value_at_percentile(policy_.delay_percentile);
+            percentile_delay_ns_.store(static_cast<std::int64_t>(delay_us) * 1000, std::memory_order_relaxed);
+        }
+
+        // Start a new window so the delay follows changes in latency
+        if (count >= window) {
+            latencies.reset();
+        }
+    });
+}
+
+void HedgingTracker::record_hedge_won() {
+    hedges_won_.fetch_add(1u, std::memory_order_relaxed);
+}
+
+void HedgingTracker::record_cancelled() {
+    cancelled_.fetch_add(1u, std::memory_order_relaxed);
+}
+
+HedgingStats HedgingTracker::stats() const {
+    HedgingStats stats;
+    stats.calls = calls_.load(std::memory_order_relaxed);
+    stats.hedges_sent = hedges_sent_.load(std::memory_order_relaxed);
+    stats.hedges_won = hedges_won_.load(std::memory_order_relaxed);
+    stats.cancelled = cancelled_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace detail
+} // namespace client
+} // namespace grpcw
@@ -0,0 +1,174 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/client/detail/response_cache.hpp"
+
+// third-party
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+// standard
+#include <stdexcept>
+
+namespace grpcw {
+namespace client {
+namespace detail {
+
+ResponseCache::ResponseCache(const ResponseCaching& caching) : caching_(caching) {
+    if (caching_.max_bytes == 0u) {
+        throw std::invalid_argument("A response cache needs room for at least one byte");
+    }
+    if (caching_.max_age.count() <= 0) {
+        throw std::invalid_argument("Cached responses need a positive max age");
+    }
+}
+
+std::string ResponseCache::make_key(const std::string& method_path, const google::protobuf::Message& request) {
+    std::string key = method_path;
+    {
+        // Map fields are only serialized in the same order every time when asked to be
+        google::protobuf::io::StringOutputStream stream(&key);
+        google::protobuf::io::CodedOutputStream coded_stream(&stream);
+        coded_stream.SetSerializationDeterministic(true);
+        request.SerializeToCodedStream(&coded_stream);
+    }
+    return key;
+}
+
+std::shared_ptr<const google::protobuf::Message> ResponseCache::find(const std::string& key,
+                                                                     std::uint64_t* generation) {
+    auto now = std::chrono::steady_clock::now();
+
+    return state_.use_safely([&](State& state) -> std::shared_ptr<const google::protobuf::Message> {
+        auto iter = state.by_key.find(key);
+
+        if (iter != state.by_key.end() and iter->second->expires <= now) {
+            erase(&state, iter->second);
+            ++state.stats.evictions;
+            iter = state.by_key.end();
+        }
+
+        if (iter == state.by_key.end()) {
+            ++state.stats.misses;
+            *generation = state.generation;
+            return nullptr;
+        }
+
+        ++state.stats.hits;
+        state.entries.splice(state.entries.begin(), state.entries, iter->second);
+        return iter->second->response;
+    });
+}
+
+void ResponseCache::insert(const std::string& key,
+                           const std::string& invalidation_key,
+                           std::shared_ptr<const google::protobuf::Message> response,
+                           std::uint64_t generation) {
+    // Roughly what the entry costs, the bookkeeping around it is not counted
+    auto bytes = key.size() + invalidation_key.size() + response->SpaceUsedLong();
+    if (bytes > caching_.max_bytes) {
+        return;
+    }
+
+    auto expires = std::chrono::steady_clock::now() + caching_.max_age;
+
+    state_.use_safely([&](State& state) {
+        if (generation != state.generation) {
+            return;
+        }
+
+        // Another call for the same request may have finished first
+        auto iter = state.by_key.find(key);
+        if (iter != state.by_key.end()) {
+            erase(&state, iter->second);
+        }
+
+        while (state.stats.bytes + bytes > caching_.max_bytes) {
+            erase(&state, std::prev(state.entries.end()));
+            ++state.stats.evictions;
+        }
+
+        state.entries.push_front({key, invalidation_key, std::move(response), bytes, expires, {}});
+        auto entry = state.entries.begin();
+
+        state.by_key.emplace(key, entry);
+        if (not invalidation_key.empty()) {
+            auto& group = state.by_invalidation_key[invalidation_key];
+            entry->group_position = group.insert(group.end(), entry);
+        }
+
+        ++state.stats.entries;
+        state.stats.bytes += bytes;
+    });
+}
+
+void ResponseCache::invalidate(const std::string& invalidation_key) {
+    state_.use_safely([&](State& state) {
+        ++state.generation;
+
+        if (invalidation_key.empty()) {
+            state.stats.invalidations += state.entries.size();
+            state.entries.clear();
+            state.by_key.clear();
+            state.by_invalidation_key.clear();
+            state.stats.entries = 0u;
+            state.stats.bytes = 0u;
+            return;
+        }
+
+        auto iter = state.by_invalidation_key.find(invalidation_key);
+        if (iter == state.by_invalidation_key.end()) {
+            return;
+        }
+
+        // Erasing the last entry of a group erases the group so copy the entries first
+        auto group = iter->second;
+        for (auto entry : group) {
+            erase(&state, entry);
+            ++state.stats.invalidations;
+        }
+    });
+}
+
+ResponseCacheStats ResponseCache::stats() const {
+    return state_.use_safely([](const State& state) { return state.stats; });
+}
+
+void ResponseCache::erase(State* state, Entries::iterator entry) {
+    if (not entry->invalidation_key.empty()) {
+        auto group = state->by_invalidation_key.find(entry->invalidation_key);
+        group->second.erase(entry->group_position);
+
+        if (group->second.empty()) {
+            state->by_invalidation_key.erase(group);
+        }
+    }
+
+    state->by_key.erase(entry->key);
+    --state->stats.entries;
+    state->stats.bytes -= entry->bytes;
+    state->entries.erase(entry);
+}
+
+} // namespace detail
+} // namespace client
+} // namespace grpcw
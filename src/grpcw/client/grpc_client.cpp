@@ -22,6 +22,10 @@
 // ///////////////////////////////////////////////////////////////////////////////////////
 #include "grpcw/client/grpc_client.hpp"
 
+// standard
+#include <algorithm>
+#include <limits>
+
 namespace grpcw {
 namespace client {
 
@@ -31,5 +35,25 @@ auto default_channel_arguments() -> grpc::ChannelArguments {
     return arguments;
 }
 
+auto pooled_channel_arguments(int index) -> grpc::ChannelArguments {
+    auto arguments = default_channel_arguments();
+
+    // Channels only share subchannels (and connections) if their arguments match
+    arguments.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+    arguments.SetInt("grpcw.channel_pool_index", index);
+    return arguments;
+}
+
+void apply_reconnect_backoff(const ReconnectBackoff& backoff, grpc::ChannelArguments* arguments) {
+    auto milliseconds = [](std::chrono::milliseconds duration) {
+        return static_cast<int>(std::min<std::chrono::milliseconds::rep>(duration.count(),
+                                                                         std::numeric_limits<int>::max()));
+    };
+
+    arguments->SetInt(GRPC_ARG_INITIAL_RECONNECT_BACKOFF_MS, milliseconds(backoff.initial_backoff));
+    arguments->SetInt(GRPC_ARG_MAX_RECONNECT_BACKOFF_MS, milliseconds(backoff.max_backoff));
+    arguments->SetInt(GRPC_ARG_MIN_RECONNECT_BACKOFF_MS, milliseconds(backoff.min_connect_timeout));
+}
+
 } // namespace client
 } // namespace grpcw
@@ -0,0 +1,100 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/server/detail/batch_workers.hpp"
+
+// grpcw
+#include "grpcw/util/atomic_data.hpp"
+
+// standard
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+namespace grpcw {
+namespace server {
+namespace detail {
+
+BatchWorkers::BatchWorkers(int parallelism) {
+    if (parallelism < 1) {
+        throw std::invalid_argument("A batch needs at least one thread to handle it");
+    }
+
+    for (int i = 1; i < parallelism; ++i) {
+        threads_.emplace_back([this] {
+            while (auto job = jobs_.pop_front()) {
+                job();
+            }
+        });
+    }
+}
+
+BatchWorkers::~BatchWorkers() {
+    for (auto i = 0u; i < threads_.size(); ++i) {
+        jobs_.push_back(nullptr);
+    }
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void BatchWorkers::run(std::size_t item_count, const std::function<void(std::size_t)>& handle_item) {
+    struct Progress {
+        std::atomic<std::size_t> next_item{0u};
+        util::AtomicData<std::size_t> finished{0u};
+    };
+
+    // Workers can pick up a job after every item is handled so they only share 'progress'
+    auto progress = std::make_shared<Progress>();
+
+    auto handle_items = [&handle_item, item_count, progress] {
+        std::size_t handled = 0u;
+
+        for (auto item = progress->next_item++; item < item_count; item = progress->next_item++) {
+            handle_item(item);
+            ++handled;
+        }
+
+        if (handled > 0u) {
+            auto finished = progress->finished.use_safely([handled](std::size_t& finished) {
+                return finished += handled;
+            });
+            if (finished == item_count) {
+                progress->finished.notify_all();
+            }
+        }
+    };
+
+    auto helpers = std::min(threads_.size(), item_count - std::min(item_count, std::size_t{1u}));
+    for (auto i = 0u; i < helpers; ++i) {
+        jobs_.push_back(handle_items);
+    }
+
+    handle_items();
+    progress->finished.wait_to_use_safely([item_count](std::size_t finished) { return finished == item_count; },
+                                           [](std::size_t) {});
+}
+
+} // namespace detail
+} // namespace server
+} // namespace grpcw
@@ -0,0 +1,63 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/server/detail/callback_rpc_dispatcher.hpp"
+
+#ifdef LTB_GRPCW_ENABLE_CALLBACK_SERVER
+
+
+// standard
+#include <stdexcept>
+
+namespace grpcw {
+namespace server {
+namespace detail {
+
+void CallbackRpcDispatcher::add_handler(const std::string& method_path,
+                                        std::unique_ptr<CallbackRpcHandlerInterface> handler) {
+    bool added = handlers_.use_safely(
+        [&](HandlerMap& handlers) { return handlers.emplace(method_path, std::move(handler)).second; });
+
+    if (not added) {
+        throw std::invalid_argument("A handler is already registered for '" + method_path + "'");
+    }
+}
+
+grpc::ServerGenericBidiReactor* CallbackRpcDispatcher::CreateReactor(grpc::GenericCallbackServerContext* context) {
+    CallbackRpcHandlerInterface* handler = handlers_.use_safely([&](const HandlerMap& handlers) {
+        auto iter = handlers.find(context->method());
+        return iter == handlers.end() ? nullptr : iter->second.get();
+    });
+
+    if (handler) {
+        return handler->create_reactor(context);
+    }
+
+    // The default reactor finishes the call with UNIMPLEMENTED
+    return grpc::CallbackGenericService::CreateReactor(context);
+}
+
+} // namespace detail
+} // namespace server
+} // namespace grpcw
+
+#endif // LTB_GRPCW_ENABLE_CALLBACK_SERVER
@@ -0,0 +1,96 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/server/detail/queue_lag_monitor.hpp"
+
+// standard
+#include <algorithm>
+#include <stdexcept>
+
+namespace grpcw {
+namespace server {
+namespace detail {
+
+void QueueLagMonitor::start(grpc::CompletionQueue* queue, LoadShedding options) {
+    if (options.probe_interval <= std::chrono::milliseconds::zero()) {
+        throw std::invalid_argument("The queue lag probe interval must be positive");
+    }
+
+    state_.use_safely([&](State& state) {
+        if (state.queue) {
+            throw std::invalid_argument("Queue lag monitoring is already enabled");
+        }
+        state.queue = queue;
+        state.options = options;
+        schedule_probe(&state);
+    });
+}
+
+void QueueLagMonitor::stop() {
+    state_.use_safely([this](State& state) {
+        if (state.queue and not state.stopped) {
+            probe_alarm_.Cancel();
+        }
+        state.stopped = true;
+    });
+    overloaded_ = false;
+}
+
+bool QueueLagMonitor::is_probe(void* tag) const {
+    return tag == &probe_alarm_;
+}
+
+void QueueLagMonitor::on_probe(bool call_ok) {
+    state_.use_safely([&](State& state) {
+        // Cancelled probes only happen when stopping
+        if (not call_ok or state.stopped) {
+            return;
+        }
+
+        auto lag = std::max(std::chrono::system_clock::now() - state.deadline, std::chrono::system_clock::duration{});
+        auto lag_nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(lag);
+
+        // Updated before the gauge so anyone who reads a low lag also sees calls being accepted
+        overloaded_ = (state.options.max_queue_lag > std::chrono::milliseconds::zero()
+                       and lag_nanoseconds > state.options.max_queue_lag);
+        lag_nanoseconds_ = lag_nanoseconds.count();
+
+        schedule_probe(&state);
+    });
+}
+
+std::chrono::nanoseconds QueueLagMonitor::queue_lag() const {
+    return std::chrono::nanoseconds(lag_nanoseconds_.load());
+}
+
+bool QueueLagMonitor::overloaded() const {
+    return overloaded_;
+}
+
+void QueueLagMonitor::schedule_probe(State* state) {
+    state->deadline = std::chrono::system_clock::now() + state->options.probe_interval;
+    probe_alarm_.Set(state->queue, state->deadline, &probe_alarm_);
+}
+
+} // namespace detail
+} // namespace server
+} // namespace grpcw
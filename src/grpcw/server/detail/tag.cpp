@@ -44,6 +44,10 @@ Tag::Tag(void* d, TagLabel l) : data(d), label(l) {}
     case TagLabel::writing:
         os << "writing";
         break;
+
+    case TagLabel::flush:
+        os << "flush";
+        break;
     }
     return os << '}';
 }
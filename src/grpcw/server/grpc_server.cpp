@@ -27,6 +27,7 @@
 #include <grpc++/server_builder.h>
 
 // standard
+#include <stdexcept>
 #include <utility>
 
 namespace grpcw {
@@ -43,6 +44,10 @@ GrpcServer::GrpcServer(std::unique_ptr<grpc::Service> service, const std::string
         builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
     }
     server_ = builder.BuildAndStart();
+
+    if (not server_) {
+        throw std::runtime_error("Failed to start a server listening on '" + server_address + "'");
+    }
 }
 
 GrpcServer::~GrpcServer() = default;
@@ -59,5 +64,9 @@ auto GrpcServer::in_process_channel(const grpc::ChannelArguments& channel_argume
     return server_->InProcessChannel(channel_arguments);
 }
 
+grpc::Service* GrpcServer::service() {
+    return service_.get();
+}
+
 } // namespace server
 } // namespace grpcw
@@ -41,5 +41,9 @@ auto ScopedGrpcServer::in_process_channel(const grpc::ChannelArguments& channel_
     return server_.in_process_channel(channel_arguments);
 }
 
+grpc::Service* ScopedGrpcServer::service() {
+    return server_.service();
+}
+
 } // namespace server
 } // namespace grpcw
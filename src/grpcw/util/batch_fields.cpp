@@ -0,0 +1,107 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/util/batch_fields.hpp"
+
+// third-party
+#include <google/protobuf/descriptor.h>
+
+// standard
+#include <stdexcept>
+
+namespace grpcw {
+namespace util {
+
+namespace {
+
+bool is_single_field(const google::protobuf::FieldDescriptor* field, google::protobuf::FieldDescriptor::CppType type) {
+    return field and not field->is_repeated() and field->cpp_type() == type;
+}
+
+bool is_status(const google::protobuf::Descriptor* type) {
+    return type and type->name() == "Status"
+        and is_single_field(type->FindFieldByName("code"), google::protobuf::FieldDescriptor::CPPTYPE_INT32)
+        and is_single_field(type->FindFieldByName("message"), google::protobuf::FieldDescriptor::CPPTYPE_STRING);
+}
+
+} // namespace
+
+auto batch_field(const google::protobuf::Descriptor& batch, const google::protobuf::Descriptor& item)
+    -> const google::protobuf::FieldDescriptor* {
+    const google::protobuf::FieldDescriptor* found = nullptr;
+
+    for (int i = 0; i < batch.field_count(); ++i) {
+        const auto* field = batch.field(i);
+
+        if (field->is_repeated() and field->message_type() == &item) {
+            if (found) {
+                throw std::invalid_argument("'" + batch.full_name() + "' has more than one repeated '"
+                                            + item.full_name() + "' field");
+            }
+            found = field;
+        }
+    }
+
+    if (not found) {
+        throw std::invalid_argument("'" + batch.full_name() + "' has no repeated '" + item.full_name() + "' field");
+    }
+    return found;
+}
+
+auto batch_status_field(const google::protobuf::Descriptor& batch) -> const google::protobuf::FieldDescriptor* {
+    const google::protobuf::FieldDescriptor* found = nullptr;
+
+    for (int i = 0; i < batch.field_count(); ++i) {
+        const auto* field = batch.field(i);
+
+        if (field->is_repeated() and is_status(field->message_type())) {
+            if (found) {
+                throw std::invalid_argument("'" + batch.full_name() + "' has more than one repeated status field");
+            }
+            found = field;
+        }
+    }
+    return found;
+}
+
+void add_batch_status(google::protobuf::Message* batch,
+                      const google::protobuf::FieldDescriptor* field,
+                      const grpc::Status& status) {
+    auto* item = batch->GetReflection()->AddMessage(batch, field);
+    const auto* type = item->GetDescriptor();
+
+    item->GetReflection()->SetInt32(item, type->FindFieldByName("code"), static_cast<int>(status.error_code()));
+    item->GetReflection()->SetString(item, type->FindFieldByName("message"), status.error_message());
+}
+
+grpc::Status
+batch_status(const google::protobuf::Message& batch, const google::protobuf::FieldDescriptor* field, int index) {
+    const auto& item = batch.GetReflection()->GetRepeatedMessage(batch, field, index);
+    const auto* type = item.GetDescriptor();
+
+    auto code = item.GetReflection()->GetInt32(item, type->FindFieldByName("code"));
+    auto message = item.GetReflection()->GetString(item, type->FindFieldByName("message"));
+    return {static_cast<grpc::StatusCode>(code), message};
+}
+
+} // namespace util
+} // namespace grpcw
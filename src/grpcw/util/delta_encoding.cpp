@@ -0,0 +1,163 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/util/delta_encoding.hpp"
+
+// third-party
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/unknown_field_set.h>
+#include <google/protobuf/util/message_differencer.h>
+
+// standard
+#include <cassert>
+#include <set>
+
+namespace grpcw {
+namespace util {
+namespace {
+
+using google::protobuf::Message;
+using google::protobuf::util::MessageDifferencer;
+
+/// \brief Collects the top-level field numbers of every difference between two messages
+class ChangedFieldReporter : public MessageDifferencer::Reporter {
+public:
+    explicit ChangedFieldReporter(std::set<int>* changed_fields) : changed_fields_(changed_fields) {}
+
+    void ReportAdded(const Message&, const Message&, const std::vector<MessageDifferencer::SpecificField>& path) override {
+        add(path);
+    }
+
+    void
+    ReportDeleted(const Message&, const Message&, const std::vector<MessageDifferencer::SpecificField>& path) override {
+        add(path);
+    }
+
+    void
+    ReportModified(const Message&, const Message&, const std::vector<MessageDifferencer::SpecificField>& path) override {
+        add(path);
+    }
+
+private:
+    std::set<int>* changed_fields_;
+
+    void add(const std::vector<MessageDifferencer::SpecificField>& path) {
+        // Unknown fields have no descriptor and are never part of the delta
+        if (not path.empty() and path.front().field) {
+            changed_fields_->emplace(path.front().field->number());
+        }
+    }
+};
+
+const google::protobuf::UnknownField* find_delta_field(const Message& message) {
+    const google::protobuf::UnknownFieldSet& unknown_fields = message.GetReflection()->GetUnknownFields(message);
+
+    for (int i = 0; i < unknown_fields.field_count(); ++i) {
+        const google::protobuf::UnknownField& field = unknown_fields.field(i);
+
+        if (field.number() == delta_field_number
+            and field.type() == google::protobuf::UnknownField::TYPE_LENGTH_DELIMITED) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+void encode_delta(const Message& previous, const Message& current, Message* delta) {
+    assert(previous.GetDescriptor() == current.GetDescriptor());
+    assert(current.GetDescriptor() == delta->GetDescriptor());
+
+    std::set<int> changed_fields;
+    ChangedFieldReporter reporter(&changed_fields);
+
+    MessageDifferencer differencer;
+    differencer.ReportDifferencesTo(&reporter);
+    differencer.Compare(previous, current);
+
+    // Start with a full copy and remove everything that stayed the same
+    delta->CopyFrom(current);
+
+    const google::protobuf::Descriptor* descriptor = delta->GetDescriptor();
+    const google::protobuf::Reflection* reflection = delta->GetReflection();
+
+    for (int i = 0; i < descriptor->field_count(); ++i) {
+        const google::protobuf::FieldDescriptor* field = descriptor->field(i);
+
+        if (changed_fields.find(field->number()) == changed_fields.end()) {
+            reflection->ClearField(delta, field);
+        }
+    }
+
+    google::protobuf::UnknownFieldSet* unknown_fields = reflection->MutableUnknownFields(delta);
+    unknown_fields->Clear();
+
+    // Store the replaced field numbers as packed varints
+    std::string* replaced_fields = unknown_fields->AddLengthDelimited(delta_field_number);
+    {
+        google::protobuf::io::StringOutputStream string_stream(replaced_fields);
+        google::protobuf::io::CodedOutputStream coded_stream(&string_stream);
+
+        for (int field_number : changed_fields) {
+            coded_stream.WriteVarint32(static_cast<std::uint32_t>(field_number));
+        }
+    }
+}
+
+void apply_delta(const Message& delta, Message* message) {
+    assert(delta.GetDescriptor() == message->GetDescriptor());
+
+    const google::protobuf::UnknownField* delta_field = find_delta_field(delta);
+
+    if (not delta_field) {
+        message->CopyFrom(delta);
+        return;
+    }
+
+    const google::protobuf::Descriptor* descriptor = message->GetDescriptor();
+    const google::protobuf::Reflection* reflection = message->GetReflection();
+
+    // Clear every replaced field so removed values and repeated fields are not merged
+    const std::string& replaced_fields = delta_field->length_delimited();
+    google::protobuf::io::CodedInputStream coded_stream(reinterpret_cast<const std::uint8_t*>(replaced_fields.data()),
+                                                        static_cast<int>(replaced_fields.size()));
+
+    std::uint32_t field_number;
+    while (coded_stream.ReadVarint32(&field_number)) {
+        if (const google::protobuf::FieldDescriptor* field
+            = descriptor->FindFieldByNumber(static_cast<int>(field_number))) {
+            reflection->ClearField(message, field);
+        }
+    }
+
+    message->MergeFrom(delta);
+    reflection->MutableUnknownFields(message)->DeleteByNumber(delta_field_number);
+}
+
+bool is_delta(const Message& message) {
+    return find_delta_field(message) != nullptr;
+}
+
+} // namespace util
+} // namespace grpcw
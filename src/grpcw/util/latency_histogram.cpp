@@ -0,0 +1,282 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/util/latency_histogram.hpp"
+
+// standard
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <stdexcept>
+
+namespace grpcw {
+namespace util {
+namespace {
+
+/// Index of the highest set bit (value must be non-zero)
+int highest_bit(std::uint64_t value) {
+    int bit = 0;
+    while (value >>= 1u) {
+        ++bit;
+    }
+    return bit;
+}
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram(std::uint64_t highest_trackable_value, int significant_digits)
+    : highest_trackable_value_(highest_trackable_value), significant_digits_(significant_digits) {
+
+    if (significant_digits < 1 or significant_digits > 5) {
+        throw std::invalid_argument("LatencyHistogram significant digits must be between 1 and 5");
+    }
+    if (highest_trackable_value < 2u) {
+        throw std::invalid_argument("LatencyHistogram highest trackable value must be at least 2");
+    }
+
+    // Enough sub-buckets to tell apart values that differ in the last significant digit
+    auto largest_value_with_single_unit_resolution
+        = static_cast<std::uint64_t>(2.0 * std::pow(10.0, significant_digits));
+    int sub_bucket_count_magnitude = highest_bit(largest_value_with_single_unit_resolution - 1u) + 1;
+
+    sub_bucket_half_count_magnitude_ = std::max(sub_bucket_count_magnitude, 1) - 1;
+    sub_bucket_count_ = std::uint64_t{1} << static_cast<unsigned>(sub_bucket_half_count_magnitude_ + 1);
+    sub_bucket_half_count_ = sub_bucket_count_ / 2u;
+    sub_bucket_mask_ = sub_bucket_count_ - 1u;
+
+    // Every bucket doubles the range covered by the previous one
+    std::uint64_t smallest_untrackable_value = sub_bucket_count_;
+    bucket_count_ = 1;
+    while (smallest_untrackable_value <= highest_trackable_value_) {
+        if (smallest_untrackable_value > (UINT64_MAX >> 1u)) {
+            ++bucket_count_;
+            break;
+        }
+        smallest_untrackable_value <<= 1u;
+        ++bucket_count_;
+    }
+
+    counts_.resize(static_cast<std::size_t>(bucket_count_ + 1) * sub_bucket_half_count_);
+}
+
+void LatencyHistogram::record(std::uint64_t value, std::uint64_t count) {
+    value = std::min(value, highest_trackable_value_);
+
+    counts_[counts_index(value)] += count;
+    total_count_ += count;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+}
+
+void LatencyHistogram::add(const LatencyHistogram& other) {
+    if (other.highest_trackable_value_ != highest_trackable_value_
+        or other.significant_digits_ != significant_digits_) {
+        throw std::invalid_argument("Only histograms with the same range and precision can be added");
+    }
+
+    for (std::size_t i = 0u; i < counts_.size(); ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    total_count_ += other.total_count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+void LatencyHistogram::reset() {
+    std::fill(counts_.begin(), counts_.end(), 0u);
+    total_count_ = 0u;
+    min_ = UINT64_MAX;
+    max_ = 0u;
+}
+
+std::uint64_t LatencyHistogram::total_count() const {
+    return total_count_;
+}
+
+std::uint64_t LatencyHistogram::min() const {
+    return total_count_ == 0u ? 0u : min_;
+}
+
+std::uint64_t LatencyHistogram::max() const {
+    return max_;
+}
+
+double LatencyHistogram::mean() const {
+    if (total_count_ == 0u) {
+        return 0.0;
+    }
+
+    double total = 0.0;
+    for (std::size_t i = 0u; i < counts_.size(); ++i) {
+        if (counts_[i] > 0u) {
+            // The middle of the range of values this count stands for
+            auto value = value_from_index(i);
+            auto median_equivalent = (value + highest_equivalent_value(value)) / 2u;
+            total += static_cast<double>(median_equivalent) * static_cast<double>(counts_[i]);
+        }
+    }
+    return total / static_cast<double>(total_count_);
+}
+
+double LatencyHistogram::standard_deviation() const {
+    if (total_count_ == 0u) {
+        return 0.0;
+    }
+
+    double mean_value = mean();
+    double total_squared_deviation = 0.0;
+
+    for (std::size_t i = 0u; i < counts_.size(); ++i) {
+        if (counts_[i] > 0u) {
+            auto value = value_from_index(i);
+            auto median_equivalent = (value + highest_equivalent_value(value)) / 2u;
+            double deviation = static_cast<double>(median_equivalent) - mean_value;
+            total_squared_deviation += deviation * deviation * static_cast<double>(counts_[i]);
+        }
+    }
+    return std::sqrt(total_squared_deviation / static_cast<double>(total_count_));
+}
+
+std::uint64_t LatencyHistogram::value_at_percentile(double percentile) const {
+    if (total_count_ == 0u) {
+        return 0u;
+    }
+
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+    auto count_at_percentile
+        = static_cast<std::uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(total_count_)));
+    count_at_percentile = std::max(count_at_percentile, std::uint64_t{1});
+
+    std::uint64_t total = 0u;
+    for (std::size_t i = 0u; i < counts_.size(); ++i) {
+        total += counts_[i];
+        if (total >= count_at_percentile) {
+            return std::min(highest_equivalent_value(value_from_index(i)), max_);
+        }
+    }
+    return max_;
+}
+
+std::uint64_t LatencyHistogram::count_at_or_below(std::uint64_t value) const {
+    auto last_index = counts_index(std::min(value, highest_trackable_value_));
+
+    std::uint64_t total = 0u;
+    for (std::size_t i = 0u; i <= last_index; ++i) {
+        total += counts_[i];
+    }
+    return total;
+}
+
+void LatencyHistogram::write_percentile_distribution(std::ostream& os,
+                                                     double value_scale,
+                                                     int ticks_per_half) const {
+    auto flags = os.flags();
+    os << std::fixed;
+
+    os << std::setw(12) << "Value" << std::setw(15) << "Percentile" << std::setw(11) << "TotalCount" << ' '
+       << std::setw(14) << "1/(1-Percentile)"
+       << "\n\n";
+
+    auto write_line = [&](std::uint64_t value, double percentile, std::uint64_t count) {
+        os << std::setw(12) << std::setprecision(3) << static_cast<double>(value) / value_scale << std::setw(15)
+           << std::setprecision(12) << percentile / 100.0 << std::setw(11) << count;
+        if (percentile < 100.0) {
+            os << std::setw(15) << std::setprecision(2) << 1.0 / (1.0 - percentile / 100.0);
+        }
+        os << '\n';
+    };
+
+    if (total_count_ > 0u) {
+        double percentile_to_report = 0.0;
+        std::uint64_t total = 0u;
+
+        for (std::size_t i = 0u; i < counts_.size() and percentile_to_report <= 100.0; ++i) {
+            if (counts_[i] == 0u) {
+                continue;
+            }
+            total += counts_[i];
+            auto value = std::min(highest_equivalent_value(value_from_index(i)), max_);
+
+            // Report more often the closer the percentiles get to 100%
+            while (percentile_to_report < 100.0
+                   and 100.0 * static_cast<double>(total) / static_cast<double>(total_count_) >= percentile_to_report) {
+                write_line(value, percentile_to_report, total);
+
+                // The last value jumps straight to 100% instead of creeping towards it
+                if (total == total_count_) {
+                    break;
+                }
+
+                auto half_distance = std::pow(2.0, std::floor(std::log2(100.0 / (100.0 - percentile_to_report))) + 1.0);
+                percentile_to_report += 100.0 / (ticks_per_half * half_distance);
+            }
+
+            if (total == total_count_) {
+                write_line(max_, 100.0, total);
+                break;
+            }
+        }
+    }
+
+    os << std::setprecision(3);
+    os << "#[Mean    = " << std::setw(12) << mean() / value_scale << ", StdDeviation   = " << std::setw(12)
+       << standard_deviation() / value_scale << "]\n";
+    os << "#[Max     = " << std::setw(12) << static_cast<double>(max()) / value_scale
+       << ", Total count    = " << std::setw(12) << total_count_ << "]\n";
+    os << "#[Buckets = " << std::setw(12) << bucket_count_ << ", SubBuckets     = " << std::setw(12)
+       << sub_bucket_count_ << "]\n";
+
+    os.flags(flags);
+}
+
+std::size_t LatencyHistogram::counts_index(std::uint64_t value) const {
+    // The bucket is picked by magnitude and the sub-bucket by the value's top bits in that bucket
+    int bucket_index = highest_bit(value | sub_bucket_mask_) - sub_bucket_half_count_magnitude_;
+    auto sub_bucket_index = value >> static_cast<unsigned>(bucket_index);
+
+    auto bucket_base_index
+        = static_cast<std::uint64_t>(bucket_index + 1) << static_cast<unsigned>(sub_bucket_half_count_magnitude_);
+    return static_cast<std::size_t>(bucket_base_index + sub_bucket_index - sub_bucket_half_count_);
+}
+
+std::uint64_t LatencyHistogram::value_from_index(std::size_t index) const {
+    auto bucket_index = static_cast<int>(index >> static_cast<unsigned>(sub_bucket_half_count_magnitude_)) - 1;
+    auto sub_bucket_index = (index & (sub_bucket_half_count_ - 1u)) + sub_bucket_half_count_;
+
+    if (bucket_index < 0) {
+        sub_bucket_index -= sub_bucket_half_count_;
+        bucket_index = 0;
+    }
+    return static_cast<std::uint64_t>(sub_bucket_index) << static_cast<unsigned>(bucket_index);
+}
+
+std::uint64_t LatencyHistogram::highest_equivalent_value(std::uint64_t value) const {
+    int bucket_index = highest_bit(value | sub_bucket_mask_) - sub_bucket_half_count_magnitude_;
+    auto sub_bucket_index = value >> static_cast<unsigned>(bucket_index);
+
+    auto range_magnitude = (sub_bucket_index >= sub_bucket_count_) ? bucket_index + 1 : bucket_index;
+    auto lowest_equivalent = sub_bucket_index << static_cast<unsigned>(bucket_index);
+    return lowest_equivalent + (std::uint64_t{1} << static_cast<unsigned>(range_magnitude)) - 1u;
+}
+
+} // namespace util
+} // namespace grpcw
@@ -0,0 +1,61 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/util/method_path.hpp"
+
+// standard
+#include <stdexcept>
+
+namespace grpcw {
+namespace util {
+
+std::string method_path(const std::string& service_full_name,
+                        const std::string& method_name,
+                        const google::protobuf::Descriptor* request,
+                        const google::protobuf::Descriptor* response,
+                        bool server_streaming) {
+    const google::protobuf::ServiceDescriptor* service
+        = google::protobuf::DescriptorPool::generated_pool()->FindServiceByName(service_full_name);
+
+    if (not service) {
+        throw std::invalid_argument("Unknown service '" + service_full_name + "'");
+    }
+
+    const google::protobuf::MethodDescriptor* method = service->FindMethodByName(method_name);
+
+    if (not method) {
+        throw std::invalid_argument("'" + service_full_name + "' has no method named '" + method_name + "'");
+    }
+
+    if (method->input_type() != request or method->output_type() != response) {
+        throw std::invalid_argument("Request or response type does not match '" + method->full_name() + "'");
+    }
+
+    if (method->client_streaming() or method->server_streaming() != server_streaming) {
+        throw std::invalid_argument("Streaming type does not match '" + method->full_name() + "'");
+    }
+
+    return "/" + service_full_name + "/" + method->name();
+}
+
+} // namespace util
+} // namespace grpcw
@@ -0,0 +1,90 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/util/task.hpp"
+
+#ifdef __cpp_impl_coroutine
+
+namespace grpcw {
+namespace util {
+namespace {
+
+/// Starts running immediately and destroys its own frame when it finishes
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+DetachedTask run_detached(Task<void> task) {
+    co_await std::move(task);
+}
+
+} // namespace
+
+Task<void>::Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+Task<void>::Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+Task<void>& Task<void>::operator=(Task&& other) noexcept {
+    if (this != &other) {
+        if (handle_) {
+            handle_.destroy();
+        }
+        handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+}
+
+Task<void>::~Task() {
+    if (handle_) {
+        handle_.destroy();
+    }
+}
+
+bool Task<void>::await_ready() const noexcept {
+    return not handle_ or handle_.done();
+}
+
+std::coroutine_handle<> Task<void>::await_suspend(std::coroutine_handle<> awaiting) noexcept {
+    handle_.promise().continuation = awaiting;
+    return handle_;
+}
+
+void Task<void>::await_resume() {
+    if (handle_.promise().exception) {
+        std::rethrow_exception(handle_.promise().exception);
+    }
+}
+
+void spawn(Task<void> task) {
+    run_detached(std::move(task));
+}
+
+} // namespace util
+} // namespace grpcw
+
+#endif // __cpp_impl_coroutine
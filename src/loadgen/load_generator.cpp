@@ -0,0 +1,277 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "loadgen/load_generator.hpp"
+
+// grpcw
+#include "grpcw/client/grpc_client.hpp"
+#include "grpcw/util/atomic_data.hpp"
+
+// generated
+#include <testing.grpc.pb.h>
+
+// standard
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace grpcw {
+namespace loadgen {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Test = testing::protocol::Test;
+using TestMessage = testing::protocol::TestMessage;
+
+constexpr auto late_start_threshold = std::chrono::milliseconds(1);
+
+/// \brief Hands out the intended start time of every call across all the workers
+class Schedule {
+public:
+    Schedule(const LoadGeneratorConfig& config, Clock::time_point start)
+        : arrival_(config.arrival),
+          mean_gap_(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / config.rate))),
+          end_(start + config.duration),
+          data_(start, config.seed == 0u ? std::random_device{}() : config.seed) {}
+
+    /// \brief Returns false once the next start time is past the end of the run
+    bool next(Clock::time_point* intended_start) {
+        return data_.use_safely([&](Data& data) {
+            if (data.next_start >= end_) {
+                return false;
+            }
+            *intended_start = data.next_start;
+
+            if (arrival_ == Arrival::constant) {
+                data.next_start += mean_gap_;
+            } else {
+                auto gap = std::exponential_distribution<double>(1.0)(data.random) * mean_gap_.count();
+                data.next_start += Clock::duration(static_cast<Clock::rep>(gap));
+            }
+            return true;
+        });
+    }
+
+private:
+    struct Data {
+        Data(Clock::time_point start, std::uint64_t seed) : next_start(start), random(seed) {}
+
+        Clock::time_point next_start;
+        std::mt19937_64 random;
+    };
+
+    Arrival arrival_;
+    Clock::duration mean_gap_;
+    Clock::time_point end_;
+    util::AtomicData<Data> data_;
+};
+
+grpc::Status call_with_stub(Test::Stub& stub, const LoadGeneratorConfig& config, const TestMessage& request) {
+    grpc::ClientContext context;
+    TestMessage response;
+
+    switch (config.method) {
+    case Method::echo:
+        return stub.echo(&context, request, &response);
+
+    case Method::client_echo_stream: {
+        auto writer = stub.client_echo_stream(&context, &response);
+        for (int i = 0; i < config.messages_per_stream; ++i) {
+            if (not writer->Write(request)) {
+                break;
+            }
+        }
+        writer->WritesDone();
+        return writer->Finish();
+    }
+
+    case Method::server_echo_stream:
+    case Method::endless_echo_stream: {
+        auto reader = (config.method == Method::server_echo_stream) ? stub.server_echo_stream(&context, request)
+                                                                      : stub.endless_echo_stream(&context, request);
+        int received = 0;
+        while (received < config.messages_per_stream and reader->Read(&response)) {
+            ++received;
+        }
+
+        // Endless streams have to be cancelled once enough messages arrive
+        if (received == config.messages_per_stream) {
+            context.TryCancel();
+            reader->Finish();
+            return grpc::Status::OK;
+        }
+        return reader->Finish();
+    }
+
+    case Method::bidirectional_echo_stream: {
+        auto stream = stub.bidirectional_echo_stream(&context);
+        for (int i = 0; i < config.messages_per_stream; ++i) {
+            if (not stream->Write(request) or not stream->Read(&response)) {
+                break;
+            }
+        }
+        stream->WritesDone();
+        return stream->Finish();
+    }
+    }
+
+    throw std::invalid_argument("Invalid Method");
+}
+
+grpc::Status
+make_call(client::GrpcClient<Test>& client, const LoadGeneratorConfig& config, const TestMessage& request) {
+    if (config.method == Method::echo) {
+        TestMessage response;
+        return client.call(&Test::Stub::echo, &Test::Service::echo, request, &response);
+    }
+
+    grpc::Status status(grpc::StatusCode::UNAVAILABLE, "Client is not connected to a server");
+    client.use_stub([&](Test::Stub& stub) { status = call_with_stub(stub, config, request); });
+    return status;
+}
+
+void wait_until_connected(client::GrpcClient<Test>& client, const LoadGeneratorConfig& config) {
+    auto deadline = Clock::now() + config.connect_timeout;
+
+    while (client.get_state() != client::GrpcClientState::connected) {
+        if (Clock::now() > deadline) {
+            throw std::runtime_error("Failed to connect to '" + config.address + "'");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+/// \brief Make calls at the scheduled times until the schedule runs out
+void run_worker(client::GrpcClient<Test>& client,
+                const LoadGeneratorConfig& config,
+                Schedule& schedule,
+                LoadGeneratorResults* results) {
+    TestMessage request;
+    request.set_msg(std::string(config.payload_size, 'x'));
+
+    auto to_micros = [](Clock::duration duration) {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    };
+
+    Clock::time_point intended_start;
+
+    while (schedule.next(&intended_start)) {
+        std::this_thread::sleep_until(intended_start);
+
+        auto actual_start = Clock::now();
+        auto status = make_call(client, config, request);
+        auto end = Clock::now();
+
+        results->latency.record(to_micros(end - intended_start));
+        results->service_time.record(to_micros(end - actual_start));
+
+        if (status.ok()) {
+            ++results->succeeded;
+        } else {
+            ++results->failed;
+        }
+        if (actual_start - intended_start > late_start_threshold) {
+            ++results->started_late;
+        }
+    }
+}
+
+} // namespace
+
+Method parse_method(const std::string& name) {
+    if (name == "echo") {
+        return Method::echo;
+    }
+    if (name == "client_echo_stream") {
+        return Method::client_echo_stream;
+    }
+    if (name == "server_echo_stream") {
+        return Method::server_echo_stream;
+    }
+    if (name == "bidirectional_echo_stream") {
+        return Method::bidirectional_echo_stream;
+    }
+    if (name == "endless_echo_stream") {
+        return Method::endless_echo_stream;
+    }
+    throw std::invalid_argument("Unknown method '" + name + "'");
+}
+
+Arrival parse_arrival(const std::string& name) {
+    if (name == "constant") {
+        return Arrival::constant;
+    }
+    if (name == "poisson") {
+        return Arrival::poisson;
+    }
+    throw std::invalid_argument("Unknown arrival distribution '" + name + "'");
+}
+
+LoadGeneratorResults run_load(const LoadGeneratorConfig& config) {
+    if (config.rate <= 0.0 or config.concurrency < 1 or config.messages_per_stream < 1) {
+        throw std::invalid_argument("The rate, concurrency and messages per stream must be positive");
+    }
+
+    // Separate clients give each worker its own connection like independent callers would have
+    std::vector<std::unique_ptr<client::GrpcClient<Test>>> clients;
+    for (int i = 0; i < config.concurrency; ++i) {
+        clients.emplace_back(std::make_unique<client::GrpcClient<Test>>());
+        clients.back()->change_server(config.address, [](const client::GrpcClientState&) {});
+    }
+    for (auto& client : clients) {
+        wait_until_connected(*client, config);
+    }
+
+    std::vector<LoadGeneratorResults> worker_results(clients.size());
+    std::vector<std::thread> workers;
+
+    auto start = Clock::now();
+    Schedule schedule(config, start);
+
+    for (auto i = 0u; i < clients.size(); ++i) {
+        workers.emplace_back(run_worker,
+                             std::ref(*clients[i]),
+                             std::cref(config),
+                             std::ref(schedule),
+                             &worker_results[i]);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    LoadGeneratorResults results;
+    results.elapsed = Clock::now() - start;
+
+    for (const auto& worker_result : worker_results) {
+        results.latency.add(worker_result.latency);
+        results.service_time.add(worker_result.service_time);
+        results.succeeded += worker_result.succeeded;
+        results.failed += worker_result.failed;
+        results.started_late += worker_result.started_late;
+    }
+    return results;
+}
+
+} // namespace loadgen
+} // namespace grpcw
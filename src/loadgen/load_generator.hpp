@@ -0,0 +1,94 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// grpcw
+#include "grpcw/util/latency_histogram.hpp"
+
+// standard
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace grpcw {
+namespace loadgen {
+
+/// \brief The 'protos/testing/testing.proto' methods the load generator can call
+enum class Method {
+    echo,
+    client_echo_stream,
+    server_echo_stream,
+    bidirectional_echo_stream,
+    endless_echo_stream,
+};
+
+/// \brief How the intended start times of calls are spaced
+enum class Arrival {
+    constant, ///< Exactly 1 / rate apart
+    poisson, ///< Exponentially distributed gaps with a mean of 1 / rate
+};
+
+/// \brief Throws std::invalid_argument for unknown names
+Method parse_method(const std::string& name);
+Arrival parse_arrival(const std::string& name);
+
+struct LoadGeneratorConfig {
+    std::string address = "127.0.0.1:50051";
+    Method method = Method::echo;
+    Arrival arrival = Arrival::constant;
+    double rate = 1000.0; ///< Calls started per second
+    std::chrono::milliseconds duration = std::chrono::seconds(10);
+    int concurrency = 4; ///< Worker threads, each with its own client and connection
+    std::size_t payload_size = 64u; ///< Bytes in each message's 'msg' field
+    int messages_per_stream = 10; ///< Messages sent (or read) by each streaming call
+    std::chrono::milliseconds connect_timeout = std::chrono::seconds(5);
+    std::uint64_t seed = 0u; ///< Seeds the Poisson arrivals (0 picks a random seed)
+};
+
+struct LoadGeneratorResults {
+    /// \brief Microseconds from each call's intended start time to its completion
+    ///
+    /// Calls that start late because every worker was busy still count the time they
+    /// spent waiting so a stalled server can't hide its latency (coordinated omission).
+    util::LatencyHistogram latency;
+
+    /// \brief Microseconds from when each call actually started to its completion
+    util::LatencyHistogram service_time;
+
+    std::uint64_t succeeded = 0u;
+    std::uint64_t failed = 0u;
+    std::uint64_t started_late = 0u; ///< Calls that started more than 1ms after their intended start time
+    std::chrono::steady_clock::duration elapsed = {};
+};
+
+///
+/// \brief Drive the server at 'config.address' with an open-loop schedule of calls.
+///
+/// Intended start times are fixed by 'config.rate' and 'config.arrival' no matter how fast the server
+/// replies. Blocks for roughly 'config.duration' and throws std::runtime_error if a worker can't connect
+/// within 'config.connect_timeout'.
+///
+LoadGeneratorResults run_load(const LoadGeneratorConfig& config);
+
+} // namespace loadgen
+} // namespace grpcw
@@ -0,0 +1,156 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "loadgen/load_generator.hpp"
+
+// standard
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+using namespace grpcw;
+
+constexpr auto usage = R"(Usage: ltb_grpcw_loadgen [--option=value ...]
+
+Calls a 'grpcw.testing.protocol.Test' server on an open-loop schedule.
+
+Options:
+  --address=HOST:PORT       Server address, "unix:/path" also works (default: 127.0.0.1:50051)
+  --method=NAME             echo, client_echo_stream, server_echo_stream,
+                            bidirectional_echo_stream or endless_echo_stream (default: echo)
+  --rate=CALLS_PER_SECOND   Calls started per second (default: 1000)
+  --arrival=NAME            constant or poisson (default: constant)
+  --duration=SECONDS        How long to generate load for (default: 10)
+  --concurrency=N           Worker threads, each with its own connection (default: 4)
+  --payload=BYTES           Size of each message (default: 64)
+  --messages=N              Messages per streaming call (default: 10)
+  --seed=N                  Seed for poisson arrivals (default: random)
+  --output=FILE             Write the corrected latency histogram (in ms) in HdrHistogram's .hgrm format
+)";
+
+template <typename T>
+T parse_number(const std::string& key, const std::string& value) {
+    std::istringstream stream(value);
+    T number;
+    stream >> number;
+
+    if (stream.fail() or not stream.eof()) {
+        throw std::invalid_argument("Invalid value '" + value + "' for '--" + key + "'");
+    }
+    return number;
+}
+
+void print_summary(const loadgen::LoadGeneratorConfig& config, const loadgen::LoadGeneratorResults& results) {
+    auto seconds = std::chrono::duration<double>(results.elapsed).count();
+    auto total = results.succeeded + results.failed;
+
+    auto ms = [](std::uint64_t micros) { return static_cast<double>(micros) / 1000.0; };
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Calls:        " << total << " in " << seconds << "s (" << static_cast<double>(total) / seconds
+              << "/s, target " << config.rate << "/s)\n";
+    std::cout << "Failed:       " << results.failed << "\n";
+    std::cout << "Started late: " << results.started_late << "\n\n";
+
+    std::cout << std::setw(12) << "(ms)" << std::setw(12) << "Latency" << std::setw(14) << "Service time\n";
+    for (double percentile : {50.0, 90.0, 99.0, 99.9, 100.0}) {
+        std::cout << std::setw(11) << percentile << "%" << std::setw(12)
+                  << ms(results.latency.value_at_percentile(percentile)) << std::setw(13)
+                  << ms(results.service_time.value_at_percentile(percentile)) << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    loadgen::LoadGeneratorConfig config;
+    std::string output_file;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+
+            if (arg == "--help" or arg == "-h") {
+                std::cout << usage;
+                return EXIT_SUCCESS;
+            }
+
+            auto equals = arg.find('=');
+            if (arg.rfind("--", 0u) != 0u or equals == std::string::npos) {
+                throw std::invalid_argument("Expected '--option=value' but got '" + arg + "'");
+            }
+            auto key = arg.substr(2u, equals - 2u);
+            auto value = arg.substr(equals + 1u);
+
+            if (key == "address") {
+                config.address = value;
+            } else if (key == "method") {
+                config.method = loadgen::parse_method(value);
+            } else if (key == "rate") {
+                config.rate = parse_number<double>(key, value);
+            } else if (key == "arrival") {
+                config.arrival = loadgen::parse_arrival(value);
+            } else if (key == "duration") {
+                config.duration = std::chrono::milliseconds(static_cast<std::int64_t>(parse_number<double>(key, value) * 1000.0));
+            } else if (key == "concurrency") {
+                config.concurrency = parse_number<int>(key, value);
+            } else if (key == "payload") {
+                config.payload_size = parse_number<std::size_t>(key, value);
+            } else if (key == "messages") {
+                config.messages_per_stream = parse_number<int>(key, value);
+            } else if (key == "seed") {
+                config.seed = parse_number<std::uint64_t>(key, value);
+            } else if (key == "output") {
+                output_file = value;
+            } else {
+                throw std::invalid_argument("Unknown option '--" + key + "'");
+            }
+        }
+
+        auto results = loadgen::run_load(config);
+        print_summary(config, results);
+
+        if (not output_file.empty()) {
+            std::ofstream file(output_file);
+            if (not file) {
+                throw std::runtime_error("Failed to open '" + output_file + "'");
+            }
+            results.latency.write_percentile_distribution(file, 1000.0);
+        }
+
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "Error: " << e.what() << "\n\n" << usage;
+        return EXIT_FAILURE;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
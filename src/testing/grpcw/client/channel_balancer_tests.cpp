@@ -0,0 +1,200 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+
+// grpcw
+#include "grpcw/client/detail/call_outcome.hpp"
+#include "grpcw/client/detail/channel_balancer.hpp"
+
+// third-party
+#include <doctest/doctest.h>
+
+// standard
+#include <thread>
+
+namespace {
+using namespace grpcw;
+
+constexpr auto ejection_time = std::chrono::milliseconds(100);
+
+client::ChannelPool pool_options(client::ChannelSelection selection) {
+    client::ChannelPool options;
+    options.selection = selection;
+    options.failures_before_ejection = 2;
+    options.ejection_time = ejection_time;
+    return options;
+}
+
+/// \brief Acquire channels until 'index' is picked, releasing the others without an outcome
+void acquire_channel(client::detail::ChannelBalancer* balancer, std::size_t index) {
+    std::size_t acquired;
+    REQUIRE(balancer->acquire(&acquired));
+    while (acquired != index) {
+        balancer->release(acquired);
+        REQUIRE(balancer->acquire(&acquired));
+    }
+}
+
+/// \brief How many of 'count' calls go to each of the two channels
+std::pair<int, int> spread_calls(client::detail::ChannelBalancer* balancer, int count) {
+    std::pair<int, int> calls{0, 0};
+    for (int i = 0; i < count; ++i) {
+        std::size_t index;
+        REQUIRE(balancer->acquire(&index));
+        balancer->release(index);
+        ++(index == 0u ? calls.first : calls.second);
+    }
+    return calls;
+}
+
+TEST_CASE("[grpcw-client] channel_balancer_ejection") {
+    const grpc::Status unavailable{grpc::StatusCode::UNAVAILABLE, "down"};
+    const grpc::Status rejected = client::detail::circuit_rejection();
+
+    client::detail::ChannelBalancer balancer(2u, pool_options(client::ChannelSelection::round_robin));
+
+    // Nothing is picked until a channel is ready
+    std::size_t index;
+    CHECK_FALSE(balancer.acquire(&index));
+
+    balancer.set_ready(0u, true);
+    balancer.set_ready(1u, true);
+    CHECK(spread_calls(&balancer, 10) == std::make_pair(5, 5));
+
+    // A success resets the count and errors from the application don't count at all
+    acquire_channel(&balancer, 0u);
+    balancer.release(0u, unavailable, std::chrono::milliseconds(1));
+    acquire_channel(&balancer, 0u);
+    balancer.release(0u, grpc::Status::OK, std::chrono::milliseconds(1));
+    acquire_channel(&balancer, 0u);
+    balancer.release(0u, unavailable, std::chrono::milliseconds(1));
+    acquire_channel(&balancer, 0u);
+    balancer.release(0u, {grpc::StatusCode::NOT_FOUND, "no"}, std::chrono::milliseconds(1));
+    CHECK_FALSE(balancer.is_ejected(0u));
+
+    // Neither do calls failed by an open circuit since they never reached the server
+    for (int i = 0; i < 4; ++i) {
+        acquire_channel(&balancer, 0u);
+        balancer.release(0u, rejected, std::chrono::seconds(1));
+    }
+    CHECK_FALSE(balancer.is_ejected(0u));
+    CHECK(balancer.average_latency(0u) == std::chrono::milliseconds(1));
+
+    // Consecutive backend failures eject the channel
+    acquire_channel(&balancer, 0u);
+    balancer.release(0u, unavailable, std::chrono::milliseconds(1));
+    acquire_channel(&balancer, 0u);
+    balancer.release(0u, {grpc::StatusCode::DEADLINE_EXCEEDED, "slow"}, std::chrono::milliseconds(1));
+    CHECK(balancer.is_ejected(0u));
+    CHECK(spread_calls(&balancer, 10) == std::make_pair(0, 10));
+
+    // The channel is used again once the ejection expires
+    std::this_thread::sleep_for(ejection_time + std::chrono::milliseconds(20));
+    CHECK_FALSE(balancer.is_ejected(0u));
+    CHECK(spread_calls(&balancer, 10) == std::make_pair(5, 5));
+
+    // Ejected channels are still better than failing every call
+    for (auto channel : {0u, 1u}) {
+        for (int i = 0; i < 2; ++i) {
+            acquire_channel(&balancer, channel);
+            balancer.release(channel, unavailable, std::chrono::milliseconds(1));
+        }
+    }
+    CHECK(balancer.is_ejected(0u));
+    CHECK(balancer.is_ejected(1u));
+    CHECK(spread_calls(&balancer, 10) == std::make_pair(5, 5));
+
+    // But channels that aren't ready never are
+    balancer.set_ready(1u, false);
+    CHECK(spread_calls(&balancer, 10) == std::make_pair(10, 0));
+    balancer.set_ready(0u, false);
+    CHECK_FALSE(balancer.acquire(&index));
+
+    // Releasing without an outcome only ends the call
+    CHECK(balancer.calls_in_flight(0u) == 0);
+    CHECK(balancer.calls_in_flight(1u) == 0);
+}
+
+TEST_CASE("[grpcw-client] channel_balancer_power_of_two_choices") {
+    client::detail::ChannelBalancer balancer(2u, pool_options(client::ChannelSelection::power_of_two_choices));
+    balancer.set_ready(0u, true);
+    balancer.set_ready(1u, true);
+
+    // Channel 0 responds much more slowly
+    acquire_channel(&balancer, 0u);
+    balancer.release(0u, grpc::Status::OK, std::chrono::milliseconds(100));
+    acquire_channel(&balancer, 1u);
+    balancer.release(1u, grpc::Status::OK, std::chrono::milliseconds(1));
+    CHECK(balancer.average_latency(0u) > balancer.average_latency(1u));
+
+    // The slow channel is only picked when both random choices land on it (a quarter of the time)
+    auto calls = spread_calls(&balancer, 400);
+    CHECK(calls.second > 2 * calls.first);
+
+    // Calls in flight make a channel more expensive too
+    for (int i = 0; i < 1000; ++i) {
+        acquire_channel(&balancer, 1u);
+    }
+    calls = spread_calls(&balancer, 400);
+    CHECK(calls.first > 2 * calls.second);
+}
+
+TEST_CASE("[grpcw-client] channel_balancer_streams") {
+    client::detail::ChannelBalancer balancer(3u, pool_options(client::ChannelSelection::round_robin));
+
+    // Streams need a ready channel too, even when there is only one
+    std::size_t index;
+    CHECK_FALSE(balancer.acquire_stream(&index));
+
+    client::detail::ChannelBalancer single(1u, pool_options(client::ChannelSelection::round_robin));
+    CHECK_FALSE(single.acquire_stream(&index));
+    single.set_ready(0u, true);
+    CHECK(single.acquire_stream(&index));
+    CHECK(index == 0u);
+
+    // Streams go to the ready channel with the fewest of them
+    balancer.set_ready(0u, true);
+    balancer.set_ready(2u, true);
+    for (int i = 0; i < 6; ++i) {
+        REQUIRE(balancer.acquire_stream(&index));
+        CHECK(index != 1u);
+    }
+    CHECK(balancer.streams(0u) == 3);
+    CHECK(balancer.streams(2u) == 3);
+
+    // Calls in flight don't change where streams go
+    acquire_channel(&balancer, 0u);
+    balancer.release_stream(0u);
+    REQUIRE(balancer.acquire_stream(&index));
+    CHECK(index == 0u);
+    balancer.release(0u);
+
+    // A channel that connects later gets the next streams
+    balancer.set_ready(1u, true);
+    for (int i = 0; i < 3; ++i) {
+        REQUIRE(balancer.acquire_stream(&index));
+        CHECK(index == 1u);
+    }
+    CHECK(balancer.calls_in_flight(0u) == 0);
+}
+
+} // namespace
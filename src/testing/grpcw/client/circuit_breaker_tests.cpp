@@ -0,0 +1,180 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+
+// grpcw
+#include "grpcw/client/detail/call_outcome.hpp"
+#include "grpcw/client/detail/circuit_breaker.hpp"
+
+// third-party
+#include <doctest/doctest.h>
+
+namespace {
+using namespace grpcw;
+
+using Clock = client::detail::CircuitBreaker::Clock;
+
+const grpc::Status unavailable{grpc::StatusCode::UNAVAILABLE, "down"};
+constexpr auto fast = std::chrono::milliseconds(1);
+
+client::CircuitBreaking circuit_options() {
+    client::CircuitBreaking options;
+    options.window = std::chrono::seconds(10);
+    options.minimum_calls = 4;
+    options.failure_rate = 0.5;
+    options.open_time = std::chrono::seconds(5);
+    options.half_open_calls = 2;
+    return options;
+}
+
+/// \brief Sends calls through 'circuit' at 'now' and records their outcomes like the interceptor does
+struct CircuitCaller {
+    client::detail::CircuitBreaker* circuit;
+    Clock::time_point now;
+
+    bool call(const grpc::Status& status, std::chrono::nanoseconds latency, client::CircuitState* state) {
+        bool trial;
+        bool half_opened;
+        REQUIRE(circuit->try_acquire(now, &trial, &half_opened));
+        return circuit->record(status, latency, trial, now, state);
+    }
+
+    bool call(const grpc::Status& status, std::chrono::nanoseconds latency = fast) {
+        client::CircuitState state;
+        return call(status, latency, &state);
+    }
+
+    bool can_call(bool* half_opened = nullptr) {
+        bool trial;
+        bool opened;
+        bool acquired = circuit->try_acquire(now, &trial, &opened);
+        if (half_opened) {
+            *half_opened = opened;
+        }
+        return acquired;
+    }
+};
+
+TEST_CASE("[grpcw-client] circuit_breaker_failure_rate") {
+    client::detail::CircuitBreaker circuit(circuit_options());
+    CircuitCaller caller{&circuit, Clock::time_point{} + std::chrono::hours(1)};
+
+    // Errors from the application are not backend failures
+    CHECK_FALSE(caller.call(grpc::Status::OK));
+    CHECK_FALSE(caller.call({grpc::StatusCode::NOT_FOUND, "no"}));
+    CHECK_FALSE(caller.call(unavailable));
+    CHECK_FALSE(caller.call(grpc::Status::OK));
+    CHECK(circuit.state() == client::CircuitState::closed);
+
+    // Outcomes older than the window are forgotten so the failures don't add up
+    caller.now += std::chrono::seconds(11);
+    CHECK_FALSE(caller.call(unavailable));
+    CHECK_FALSE(caller.call(grpc::Status::OK));
+    CHECK_FALSE(caller.call(grpc::Status::OK));
+
+    // Half of the calls in the window failed
+    client::CircuitState state;
+    CHECK(caller.call({grpc::StatusCode::DEADLINE_EXCEEDED, "late"}, fast, &state));
+    CHECK(state == client::CircuitState::open);
+    CHECK(circuit.state() == client::CircuitState::open);
+
+    caller.now += std::chrono::seconds(4);
+    CHECK_FALSE(caller.can_call());
+
+    // A failed trial opens the circuit again
+    caller.now += std::chrono::seconds(1);
+    bool half_opened;
+    CHECK(caller.can_call(&half_opened));
+    CHECK(half_opened);
+    CHECK(circuit.state() == client::CircuitState::half_open);
+
+    CHECK(caller.call({grpc::StatusCode::RESOURCE_EXHAUSTED, "busy"}, fast, &state));
+    CHECK(state == client::CircuitState::open);
+
+    // All the trials have to succeed to close it and no other calls are let through meanwhile
+    caller.now += std::chrono::seconds(5);
+    bool first_trial;
+    bool second_trial;
+    CHECK(circuit.try_acquire(caller.now, &first_trial, &half_opened));
+    CHECK(circuit.try_acquire(caller.now, &second_trial, &half_opened));
+    CHECK_FALSE(caller.can_call());
+
+    CHECK_FALSE(circuit.record(grpc::Status::OK, fast, first_trial, caller.now, &state));
+    CHECK(circuit.record(grpc::Status::OK, fast, second_trial, caller.now, &state));
+    CHECK(state == client::CircuitState::closed);
+    CHECK(caller.can_call());
+}
+
+TEST_CASE("[grpcw-client] circuit_breaker_slow_calls") {
+    auto options = circuit_options();
+    options.slow_call_duration = std::chrono::milliseconds(100);
+    options.slow_call_rate = 0.5;
+
+    client::detail::CircuitBreaker circuit(options);
+    CircuitCaller caller{&circuit, Clock::time_point{} + std::chrono::hours(1)};
+
+    // Successful calls still count as slow
+    CHECK_FALSE(caller.call(grpc::Status::OK, std::chrono::milliseconds(100)));
+    CHECK_FALSE(caller.call(grpc::Status::OK, std::chrono::milliseconds(99)));
+    CHECK_FALSE(caller.call(grpc::Status::OK));
+
+    client::CircuitState state;
+    CHECK(caller.call(grpc::Status::OK, std::chrono::seconds(1), &state));
+    CHECK(state == client::CircuitState::open);
+
+    // A slow trial opens the circuit again
+    caller.now += options.open_time;
+    CHECK(caller.call(grpc::Status::OK, std::chrono::milliseconds(200), &state));
+    CHECK(state == client::CircuitState::open);
+}
+
+TEST_CASE("[grpcw-client] circuit_breaker_options") {
+    CHECK_NOTHROW(client::detail::CircuitBreaker{circuit_options()});
+
+    auto invalid = circuit_options();
+    invalid.window = std::chrono::milliseconds(0);
+    CHECK_THROWS_AS(client::detail::CircuitBreaker{invalid}, std::invalid_argument);
+
+    invalid = circuit_options();
+    invalid.half_open_calls = 0;
+    CHECK_THROWS_AS(client::detail::CircuitBreaker{invalid}, std::invalid_argument);
+
+    invalid = circuit_options();
+    invalid.failure_rate = 1.5;
+    CHECK_THROWS_AS(client::detail::CircuitBreakers(invalid, nullptr), std::invalid_argument);
+
+    invalid = circuit_options();
+    invalid.slow_call_duration = std::chrono::milliseconds(-1);
+    CHECK_THROWS_AS(client::detail::CircuitBreakers(invalid, nullptr), std::invalid_argument);
+
+    // Calls failed by an open circuit are told apart from the server's own UNAVAILABLE errors
+    auto rejection = client::detail::circuit_rejection();
+    CHECK(client::detail::is_circuit_rejection(rejection));
+    CHECK_FALSE(client::detail::is_circuit_rejection(unavailable));
+
+    // Even ones that copy the message
+    CHECK_FALSE(client::detail::is_circuit_rejection({grpc::StatusCode::UNAVAILABLE, rejection.error_message()}));
+    CHECK_FALSE(client::detail::is_circuit_rejection(
+        {grpc::StatusCode::UNAVAILABLE, rejection.error_message(), "grpcw-circuit-rejection"}));
+}
+
+} // namespace
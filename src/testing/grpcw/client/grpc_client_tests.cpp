@@ -22,7 +22,9 @@
 // ///////////////////////////////////////////////////////////////////////////////////////
 
 // grpcw
+#include "grpcw/client/detail/call_outcome.hpp"
 #include "grpcw/client/grpc_client.hpp"
+#include "grpcw/server/grpc_async_server.hpp"
 #include "grpcw/server/scoped_grpc_server.hpp"
 #include "grpcw/util/blocking_queue.hpp"
 #include "testing/test_service.hpp"
@@ -35,7 +37,13 @@
 #include <grpc++/create_channel.h>
 
 // standard
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <set>
 #include <sstream>
+#include <thread>
 
 namespace {
 using namespace grpcw;
@@ -180,6 +188,44 @@ TEST_CASE("[grpcw-client] already_running_server") {
     REQUIRE(updater.state_queue.empty());
 }
 
+TEST_CASE("[grpcw-client] unix_socket_server") {
+    StateUpdater updater;
+    std::string server_address = "unix:/tmp/grpcw_client_tests.sock";
+
+    {
+        client::GrpcClient<testing::protocol::Test> client;
+
+        {
+            server::ScopedGrpcServer server(std::make_unique<testing::TestService>(), server_address);
+
+            client.change_server(server_address,
+                                 std::bind(&StateUpdater::handle_state_change, &updater, std::placeholders::_1));
+
+            check_connects(updater.state_queue);
+
+            testing::protocol::TestMessage request, response;
+            request.set_msg("unix");
+            CHECK(client
+                      .call(&testing::protocol::Test::Stub::echo,
+                            &testing::protocol::Test::Service::echo,
+                            request,
+                            &response)
+                      .ok());
+            CHECK(response.msg() == "unix");
+        }
+
+        // The socket is gone so the client goes back to trying to connect
+        client::GrpcClientState state = updater.state_queue.pop_front();
+        if (state == client::GrpcClientState::not_connected) {
+            state = updater.state_queue.pop_front();
+        }
+        CHECK(state == client::GrpcClientState::attempting_to_connect);
+    }
+
+    REQUIRE(updater.state_queue.pop_front() == client::GrpcClientState::not_connected);
+    REQUIRE(updater.state_queue.empty());
+}
+
 // Switch between external servers
 TEST_CASE("[grpcw-client] multiple_addresses") {
     StateUpdater updater;
@@ -300,4 +346,1409 @@ TEST_CASE("[grpcw-client] external_to_inprocess_and_back") {
     REQUIRE(updater.state_queue.empty());
 }
 
+class AddressCheckingService : public testing::TestService {
+public:
+    grpc::Status echo(grpc::ServerContext* context,
+                      const testing::protocol::TestMessage* request,
+                      testing::protocol::TestMessage* response) override {
+        last_request = request;
+        if (request->msg() == "throw") {
+            throw std::runtime_error("handler failed");
+        }
+        return testing::TestService::echo(context, request, response);
+    }
+
+    const testing::protocol::TestMessage* last_request = nullptr;
+};
+
+TEST_CASE("[grpcw-client] direct_in_process_calls") {
+    auto service = std::make_unique<AddressCheckingService>();
+    auto* service_ptr = service.get();
+    server::ScopedGrpcServer server(std::move(service));
+
+    client::GrpcClient<testing::protocol::Test> client;
+
+    grpc::Service unrelated_service;
+    CHECK_THROWS_AS(client.change_server(server.in_process_channel(), &unrelated_service), std::invalid_argument);
+
+    client.change_server(server.in_process_channel(), server.service());
+    REQUIRE(client.get_state() == client::GrpcClientState::connected);
+
+    testing::protocol::TestMessage request, response;
+    request.set_msg("direct");
+
+    auto call = [&] {
+        return client.call(&testing::protocol::Test::Stub::echo,
+                           &testing::protocol::Test::Service::echo,
+                           request,
+                           &response);
+    };
+
+    // The handler sees the caller's request object so nothing was serialized or copied
+    CHECK(call().ok());
+    CHECK(service_ptr->last_request == &request);
+    CHECK(response.msg() == "direct");
+
+    request.set_msg("throw");
+    CHECK(call().error_code() == grpc::StatusCode::UNKNOWN);
+
+    // Plain in-process channels still work through the stub
+    client.change_server(server.in_process_channel());
+    request.set_msg("through the channel");
+    CHECK(call().ok());
+    CHECK(service_ptr->last_request != &request);
+    CHECK(response.msg() == "through the channel");
+
+    client.kill_streams_and_channel();
+    CHECK(call().error_code() == grpc::StatusCode::UNAVAILABLE);
+}
+
+/// \brief Only replies once 'expected_calls' calls are being handled at the same time
+class RendezvousService : public testing::TestService {
+public:
+    explicit RendezvousService(int expected_calls) : expected_calls_(expected_calls) {}
+
+    grpc::Status echo(grpc::ServerContext* context,
+                      const testing::protocol::TestMessage* request,
+                      testing::protocol::TestMessage* response) override {
+        ++in_flight_;
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (in_flight_ < expected_calls_) {
+            if (context->IsCancelled()) {
+                return grpc::Status::CANCELLED;
+            }
+            if (std::chrono::steady_clock::now() > deadline) {
+                return {grpc::StatusCode::DEADLINE_EXCEEDED, "The calls were not made concurrently"};
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return testing::TestService::echo(context, request, response);
+    }
+
+private:
+    int expected_calls_;
+    std::atomic_int in_flight_ = {0};
+};
+
+TEST_CASE("[grpcw-client] concurrent_calls_do_not_wait_on_each_other") {
+    constexpr int num_threads = 4;
+
+    server::ScopedGrpcServer server(std::make_unique<RendezvousService>(num_threads));
+
+    client::GrpcClient<testing::protocol::Test> client;
+    client.change_server(server.in_process_channel());
+
+    std::vector<grpc::Status> statuses(num_threads);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < num_threads; ++i) {
+        threads.emplace_back([&client, &status = statuses[i]] {
+            CHECK(client.use_stub([&status](testing::protocol::Test::Stub& stub) {
+                grpc::ClientContext context;
+                testing::protocol::TestMessage request, response;
+                status = stub.echo(&context, request, &response);
+            }));
+        });
+    }
+
+    // The client can still be queried while the calls are in flight
+    CHECK(client.get_state() == client::GrpcClientState::connected);
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& status : statuses) {
+        CHECK(status.ok());
+    }
+}
+
+TEST_CASE("[grpcw-client] async_calls") {
+    using Stub = testing::protocol::Test::Stub;
+    constexpr int num_calls = 1000;
+
+    server::ScopedGrpcServer server(std::make_unique<testing::TestService>());
+
+    client::GrpcClient<testing::protocol::Test> client(2);
+
+    testing::protocol::TestMessage request;
+    request.set_msg("async");
+
+    SUBCASE("not_connected") {
+        auto result = client.call_async(&Stub::Asyncecho, request).get();
+        CHECK(result.status.error_code() == grpc::StatusCode::UNAVAILABLE);
+    }
+
+    client.change_server(server.in_process_channel());
+
+    SUBCASE("callbacks") {
+        util::AtomicData<int> succeeded(0);
+
+        // Every call is in flight before any of them are waited on
+        for (int i = 0; i < num_calls; ++i) {
+            client.call_async(&Stub::Asyncecho,
+                              request,
+                              [&succeeded](grpc::Status status, testing::protocol::TestMessage response) {
+                                  if (status.ok() and response.msg() == "async") {
+                                      succeeded.use_safely([](int& count) { ++count; });
+                                  }
+                                  succeeded.notify_all();
+                              });
+        }
+
+        succeeded.wait_to_use_safely([](int count) { return count == num_calls; }, [](int) {});
+    }
+
+    SUBCASE("futures") {
+        std::vector<std::future<client::CallResult<testing::protocol::TestMessage>>> futures;
+        for (int i = 0; i < num_calls; ++i) {
+            futures.emplace_back(client.call_async(&Stub::Asyncecho, request));
+        }
+
+        for (auto& future : futures) {
+            auto result = future.get();
+            CHECK(result.status.ok());
+            CHECK(result.response.msg() == "async");
+        }
+    }
+}
+
+TEST_CASE("[grpcw-client] async_calls_are_cancelled_with_the_client") {
+    using Stub = testing::protocol::Test::Stub;
+
+    // The server never replies on its own because the second call never arrives
+    server::ScopedGrpcServer server(std::make_unique<RendezvousService>(2));
+
+    std::future<client::CallResult<testing::protocol::TestMessage>> future;
+    {
+        client::GrpcClient<testing::protocol::Test> client;
+        client.change_server(server.in_process_channel());
+
+        future = client.call_async(&Stub::Asyncecho, testing::protocol::TestMessage{});
+    }
+
+    REQUIRE(future.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    CHECK(future.get().status.error_code() == grpc::StatusCode::CANCELLED);
+}
+
+/// \brief Remembers the address of every client that called 'echo'
+class PeerRecordingService : public testing::TestService {
+public:
+    grpc::Status echo(grpc::ServerContext* context,
+                      const testing::protocol::TestMessage* request,
+                      testing::protocol::TestMessage* response) override {
+        peers.use_safely([context](std::set<std::string>& addresses) { addresses.insert(context->peer()); });
+        return testing::TestService::echo(context, request, response);
+    }
+
+    util::AtomicData<std::set<std::string>> peers;
+};
+
+TEST_CASE("[grpcw-client] channel_pool") {
+    constexpr int pool_size = 4;
+    std::string server_address = "0.0.0.0:50066";
+
+    auto service = std::make_unique<PeerRecordingService>();
+    auto* service_ptr = service.get();
+    server::ScopedGrpcServer server(std::move(service), server_address);
+
+    // Outlives the client because the client reports its last state change when it is destroyed
+    StateUpdater updater;
+    client::GrpcClient<testing::protocol::Test> client;
+
+    CHECK_THROWS_AS(client.change_server(server_address, [](auto) {}, client::ChannelPool{0}), std::invalid_argument);
+
+    client::ChannelPool pool;
+    pool.size = pool_size;
+
+    SUBCASE("round_robin") {
+        pool.selection = client::ChannelSelection::round_robin;
+    }
+    SUBCASE("least_loaded") {
+        pool.selection = client::ChannelSelection::least_loaded;
+    }
+
+    client.change_server(server_address,
+                         std::bind(&StateUpdater::handle_state_change, &updater, std::placeholders::_1),
+                         pool);
+    check_connects(updater.state_queue);
+
+    auto peer_count = [service_ptr] {
+        return service_ptr->peers.use_safely([](const std::set<std::string>& addresses) { return addresses.size(); });
+    };
+
+    // The other channels may still be connecting when the first one is ready
+    testing::protocol::TestMessage request, response;
+    for (int i = 0; i < 1000 and peer_count() < static_cast<std::size_t>(pool_size); ++i) {
+        CHECK(client.call(&testing::protocol::Test::Stub::echo,
+                          &testing::protocol::Test::Service::echo,
+                          request,
+                          &response)
+                  .ok());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Every channel has its own connection
+    CHECK(peer_count() == static_cast<std::size_t>(pool_size));
+}
+
+TEST_CASE("[grpcw-client] multiple_servers") {
+    constexpr int num_servers = 3;
+
+    std::vector<std::string> addresses;
+    std::vector<PeerRecordingService*> services;
+    std::vector<std::unique_ptr<server::ScopedGrpcServer>> servers;
+
+    for (int i = 0; i < num_servers; ++i) {
+        addresses.emplace_back("0.0.0.0:" + std::to_string(50067 + i));
+
+        auto service = std::make_unique<PeerRecordingService>();
+        services.emplace_back(service.get());
+        servers.emplace_back(std::make_unique<server::ScopedGrpcServer>(std::move(service), addresses.back()));
+    }
+
+    StateUpdater updater;
+    client::GrpcClient<testing::protocol::Test> client;
+
+    CHECK_THROWS_AS(client.change_server(std::vector<std::string>{}, [](auto) {}), std::invalid_argument);
+
+    client::ChannelPool pool;
+    pool.selection = client::ChannelSelection::power_of_two_choices;
+
+    client.change_server(addresses,
+                         std::bind(&StateUpdater::handle_state_change, &updater, std::placeholders::_1),
+                         pool);
+    check_connects(updater.state_queue);
+    CHECK(client.get_server_address() == "0.0.0.0:50067,0.0.0.0:50068,0.0.0.0:50069");
+
+    auto call = [&client] {
+        testing::protocol::TestMessage request, response;
+        return client.call(&testing::protocol::Test::Stub::echo,
+                           &testing::protocol::Test::Service::echo,
+                           request,
+                           &response);
+    };
+
+    auto servers_called = [&services] {
+        int called = 0;
+        for (auto* service : services) {
+            called += service->peers.use_safely([](const std::set<std::string>& peers) { return not peers.empty(); });
+        }
+        return called;
+    };
+
+    for (int i = 0; i < 1000 and servers_called() < num_servers; ++i) {
+        CHECK(call().ok());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(servers_called() == num_servers);
+
+    // Calls keep working with one of the servers gone
+    servers.front() = nullptr;
+
+    int consecutive_successes = 0;
+    for (int i = 0; i < 1000 and consecutive_successes < 100; ++i) {
+        consecutive_successes = call().ok() ? consecutive_successes + 1 : 0;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(consecutive_successes == 100);
+    CHECK(client.get_state() == client::GrpcClientState::connected);
+}
+
+TEST_CASE("[grpcw-client] streams_move_to_another_server") {
+    using AsyncService = testing::protocol::Test::AsyncService;
+    using Stub = testing::protocol::Test::Stub;
+
+    const std::vector<std::string> addresses = {"0.0.0.0:50083", "0.0.0.0:50084"};
+
+    // The index of the server each stream connects to
+    util::BlockingQueue<std::size_t> connections;
+
+    std::vector<std::unique_ptr<server::GrpcAsyncServer<AsyncService>>> servers;
+    for (auto i = 0u; i < addresses.size(); ++i) {
+        servers.emplace_back(
+            std::make_unique<server::GrpcAsyncServer<AsyncService>>(std::make_shared<AsyncService>(), addresses[i]));
+        servers.back()
+            ->register_async_stream(&AsyncService::Requestserver_echo_stream)
+            .on_connect([&connections, i](const testing::protocol::TestMessage&, server::ClientID) {
+                connections.push_back(i);
+            });
+    }
+
+    client::GrpcClient<testing::protocol::Test> client;
+    client.register_stream<testing::protocol::TestMessage>(
+        [](Stub& stub, grpc::ClientContext* context, grpc::CompletionQueue* queue) {
+            return stub.PrepareAsyncserver_echo_stream(context, {}, queue);
+        });
+
+    client.change_server(addresses, [](auto) {});
+    REQUIRE(client.connect_and_wait(std::chrono::system_clock::now() + std::chrono::seconds(5)));
+
+    auto first = connections.pop_front();
+
+    // The client stays connected through the other server so only the stream's channel changes state
+    servers[first] = nullptr;
+    CHECK(connections.pop_front() == 1u - first);
+    CHECK(client.get_state() == client::GrpcClientState::connected);
+}
+
+/// \brief Holds on to calls after 'stall_next_call' until they are cancelled or 'stall_time' passes
+class StallingService : public testing::TestService {
+public:
+    explicit StallingService(std::chrono::milliseconds stall_time) : stall_time_(stall_time) {}
+
+    grpc::Status echo(grpc::ServerContext* context,
+                      const testing::protocol::TestMessage* request,
+                      testing::protocol::TestMessage* response) override {
+        if (stall_next_.exchange(false)) {
+            auto deadline = std::chrono::steady_clock::now() + stall_time_;
+            while (std::chrono::steady_clock::now() < deadline) {
+                if (context->IsCancelled()) {
+                    ++stalled_calls_cancelled;
+                    return grpc::Status::CANCELLED;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        return testing::TestService::echo(context, request, response);
+    }
+
+    void stall_next_call() { stall_next_ = true; }
+
+    std::atomic_int stalled_calls_cancelled = {0};
+
+private:
+    std::chrono::milliseconds stall_time_;
+    std::atomic_bool stall_next_ = {false};
+};
+
+TEST_CASE("[grpcw-client] hedged_calls") {
+    using Stub = testing::protocol::Test::Stub;
+
+    auto service = std::make_unique<StallingService>(std::chrono::seconds(5));
+    auto* service_ptr = service.get();
+
+    server::ScopedGrpcServer server(std::move(service));
+
+    client::GrpcClient<testing::protocol::Test> client;
+    client.change_server(server.in_process_channel());
+
+    testing::protocol::TestMessage request;
+    request.set_msg("hedged");
+
+    auto wait_for_cancellation = [service_ptr] {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (service_ptr->stalled_calls_cancelled == 0 and std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return service_ptr->stalled_calls_cancelled.load();
+    };
+
+    SUBCASE("without_a_policy") {
+        auto result = client.call_hedged(&Stub::Asyncecho, request).get();
+        CHECK(result.status.ok());
+        CHECK(result.response.msg() == "hedged");
+        CHECK(client.hedging_stats().calls == 0u);
+    }
+
+    SUBCASE("invalid_policy") {
+        client::HedgingPolicy policy;
+        policy.delay_percentile = 0.0;
+        CHECK_THROWS_AS(client.set_hedging_policy(policy), std::invalid_argument);
+
+        policy = {};
+        policy.budget = -1.0;
+        CHECK_THROWS_AS(client.set_hedging_policy(policy), std::invalid_argument);
+    }
+
+    SUBCASE("fixed_delay") {
+        client::HedgingPolicy policy;
+        policy.delay = std::chrono::milliseconds(20);
+        policy.budget = 1.0;
+        client.set_hedging_policy(policy);
+
+        service_ptr->stall_next_call();
+
+        auto start = std::chrono::steady_clock::now();
+        auto result = client.call_hedged(&Stub::Asyncecho, request).get();
+
+        CHECK(result.status.ok());
+        CHECK(result.response.msg() == "hedged");
+        CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+        auto stats = client.hedging_stats();
+        CHECK(stats.calls == 1u);
+        CHECK(stats.hedges_sent == 1u);
+        CHECK(stats.hedges_won == 1u);
+        CHECK(stats.cancelled == 1u);
+
+        // The stalled copy is cancelled on the server too
+        CHECK(wait_for_cancellation() == 1);
+    }
+
+    SUBCASE("percentile_delay") {
+        client.set_hedging_policy(client::HedgingPolicy{});
+
+        // No hedges are sent until the delay is known
+        for (int i = 0; i < 100; ++i) {
+            CHECK(client.call_hedged(&Stub::Asyncecho, request).get().status.ok());
+        }
+        CHECK(client.hedging_stats().hedges_sent == 0u);
+
+        service_ptr->stall_next_call();
+        CHECK(client.call_hedged(&Stub::Asyncecho, request).get().status.ok());
+
+        auto stats = client.hedging_stats();
+        CHECK(stats.calls == 101u);
+        CHECK(stats.hedges_sent == 1u);
+        CHECK(stats.hedges_won == 1u);
+        CHECK(wait_for_cancellation() == 1);
+    }
+}
+
+TEST_CASE("[grpcw-client] hedge_budget") {
+    using Stub = testing::protocol::Test::Stub;
+
+    auto service = std::make_unique<StallingService>(std::chrono::milliseconds(100));
+    auto* service_ptr = service.get();
+
+    server::ScopedGrpcServer server(std::move(service));
+
+    client::GrpcClient<testing::protocol::Test> client;
+    client.change_server(server.in_process_channel());
+
+    client::HedgingPolicy policy;
+    policy.delay = std::chrono::milliseconds(10);
+    policy.budget = 0.5;
+    client.set_hedging_policy(policy);
+
+    // The first call only earns half a token so the stalled call finishes on its own
+    service_ptr->stall_next_call();
+    auto result = client.call_hedged(&Stub::Asyncecho, testing::protocol::TestMessage{}).get();
+    CHECK(result.status.ok());
+    CHECK(client.hedging_stats().hedges_sent == 0u);
+    CHECK(service_ptr->stalled_calls_cancelled == 0);
+
+    // The second call has a whole token
+    service_ptr->stall_next_call();
+    result = client.call_hedged(&Stub::Asyncecho, testing::protocol::TestMessage{}).get();
+    CHECK(result.status.ok());
+    CHECK(client.hedging_stats().hedges_sent == 1u);
+}
+
+TEST_CASE("[grpcw-client] async_streams") {
+    using AsyncService = testing::protocol::Test::AsyncService;
+    using Stub = testing::protocol::Test::Stub;
+    constexpr int num_streams = 200;
+
+    server::GrpcAsyncServer<AsyncService> server(std::make_shared<AsyncService>(), "0.0.0.0:50070");
+
+    util::BlockingQueue<server::ClientID> connections;
+    auto* stream = server.register_async_stream(&AsyncService::Requestserver_echo_stream)
+                       .on_connect([&](const testing::protocol::TestMessage&, server::ClientID client) {
+                           connections.push_back(client);
+                       })
+                       .stream();
+
+    util::BlockingQueue<std::string> updates;
+    util::BlockingQueue<grpc::StatusCode> finished;
+
+    // A single queue thread reads every stream
+    client::GrpcClient<testing::protocol::Test> client(1);
+    client.change_server(server.server().InProcessChannel(client::default_channel_arguments()));
+
+    for (int i = 0; i < num_streams; ++i) {
+        client
+            .register_stream<testing::protocol::TestMessage>(
+                [](Stub& stub, grpc::ClientContext* context, grpc::CompletionQueue* queue) {
+                    return stub.PrepareAsyncserver_echo_stream(context, {}, queue);
+                })
+            .on_update([&](testing::protocol::TestMessage&& update) { updates.push_back(update.msg()); })
+            .on_finish([&](const grpc::Status& status) { finished.push_back(status.error_code()); });
+    }
+
+    for (int i = 0; i < num_streams; ++i) {
+        connections.pop_front();
+    }
+
+    for (const std::string msg : {"first", "second"}) {
+        testing::protocol::TestMessage update;
+        update.set_msg(msg);
+        stream->write(update);
+
+        for (int i = 0; i < num_streams; ++i) {
+            CHECK(updates.pop_front() == msg);
+        }
+    }
+
+    SUBCASE("finished_by_the_server") {
+        stream->finish(grpc::Status::OK);
+
+        for (int i = 0; i < num_streams; ++i) {
+            CHECK(finished.pop_front() == grpc::StatusCode::OK);
+        }
+    }
+
+    SUBCASE("cancelled_by_the_client") {
+        client.kill_streams_and_channel();
+
+        for (int i = 0; i < num_streams; ++i) {
+            CHECK(finished.pop_front() == grpc::StatusCode::CANCELLED);
+        }
+    }
+}
+
+TEST_CASE("[grpcw-client] stream_update_batches") {
+    using AsyncService = testing::protocol::Test::AsyncService;
+    using Stub = testing::protocol::Test::Stub;
+
+    server::GrpcAsyncServer<AsyncService> server(std::make_shared<AsyncService>(), "0.0.0.0:50071");
+
+    util::BlockingQueue<server::ClientID> connections;
+    auto* stream = server.register_async_stream(&AsyncService::Requestserver_echo_stream)
+                       .on_connect([&](const testing::protocol::TestMessage&, server::ClientID client) {
+                           connections.push_back(client);
+                       })
+                       .stream();
+
+    // Every batch joined with commas, then "finished"
+    util::BlockingQueue<std::string> events;
+
+    client::GrpcClient<testing::protocol::Test> client;
+
+    auto on_update_batch = [&events](std::vector<testing::protocol::TestMessage>&& updates) {
+        std::string batch;
+        for (const auto& update : updates) {
+            batch += (batch.empty() ? "" : ",") + update.msg();
+        }
+        events.push_back(batch);
+    };
+    auto on_finish = [&events](const grpc::Status&) { events.push_back("finished"); };
+
+    client::UpdateBatching batching;
+    batching.max_batch_size = 4;
+
+    auto register_stream = [&](bool async) {
+        if (async) {
+            client
+                .register_stream<testing::protocol::TestMessage>(
+                    [](Stub& stub, grpc::ClientContext* context, grpc::CompletionQueue* queue) {
+                        return stub.PrepareAsyncserver_echo_stream(context, {}, queue);
+                    })
+                .on_update_batch(on_update_batch, batching)
+                .on_finish(on_finish);
+        } else {
+            client
+                .register_stream<testing::protocol::TestMessage>([](Stub& stub, grpc::ClientContext* context) {
+                    return stub.server_echo_stream(context, {});
+                })
+                .on_update_batch(on_update_batch, batching)
+                .on_finish(on_finish);
+        }
+    };
+
+    SUBCASE("blocking_stream_short_delay") {
+        batching.max_delay = std::chrono::milliseconds(100);
+        register_stream(false);
+    }
+    SUBCASE("blocking_stream_long_delay") {
+        batching.max_delay = std::chrono::seconds(60);
+        register_stream(false);
+    }
+    SUBCASE("async_stream_short_delay") {
+        batching.max_delay = std::chrono::milliseconds(100);
+        register_stream(true);
+    }
+    SUBCASE("async_stream_long_delay") {
+        batching.max_delay = std::chrono::seconds(60);
+        register_stream(true);
+    }
+
+    // Registered first so the streams start with batching enabled
+    client.change_server(server.server().InProcessChannel(client::default_channel_arguments()));
+    connections.pop_front();
+
+    for (int i = 0; i < 10; ++i) {
+        testing::protocol::TestMessage update;
+        update.set_msg(std::to_string(i));
+        stream->write(update);
+    }
+
+    // Full batches are delivered right away
+    CHECK(events.pop_front() == "0,1,2,3");
+    CHECK(events.pop_front() == "4,5,6,7");
+
+    if (batching.max_delay < std::chrono::seconds(1)) {
+        // The rest are delivered once the delay expires
+        CHECK(events.pop_front() == "8,9");
+        stream->finish(grpc::Status::OK);
+    } else {
+        // Or when the stream ends
+        stream->finish(grpc::Status::OK);
+        CHECK(events.pop_front() == "8,9");
+    }
+    CHECK(events.pop_front() == "finished");
+
+    CHECK_THROWS_AS(client::detail::UpdateBatcher<testing::protocol::TestMessage>(on_update_batch, {0u}, nullptr),
+                    std::invalid_argument);
+}
+
+TEST_CASE("[grpcw-client] batching_restarts_running_streams") {
+    using AsyncService = testing::protocol::Test::AsyncService;
+    using Stub = testing::protocol::Test::Stub;
+
+    server::GrpcAsyncServer<AsyncService> server(std::make_shared<AsyncService>(), "0.0.0.0:50085");
+
+    util::BlockingQueue<server::ClientID> connections;
+    auto* stream = server.register_async_stream(&AsyncService::Requestserver_echo_stream)
+                       .on_connect([&](const testing::protocol::TestMessage&, server::ClientID client) {
+                           connections.push_back(client);
+                       })
+                       .stream();
+
+    client::GrpcClient<testing::protocol::Test> client;
+    client.change_server(server.server().InProcessChannel(client::default_channel_arguments()));
+
+    // Single updates and batches joined with commas
+    util::BlockingQueue<std::string> events;
+
+    auto on_update = [&events](testing::protocol::TestMessage&& update) { events.push_back(update.msg()); };
+    auto on_update_batch = [&events](std::vector<testing::protocol::TestMessage>&& updates) {
+        events.push_back(updates.front().msg() + "," + updates.back().msg());
+    };
+
+    auto write = [stream](const std::string& msg) {
+        testing::protocol::TestMessage update;
+        update.set_msg(msg);
+        stream->write(update);
+    };
+
+    client::UpdateBatching batching;
+    batching.max_batch_size = 2;
+
+    auto batch_running_stream = [&](auto& setter) {
+        setter.on_update(on_update);
+
+        auto first = connections.pop_front();
+        write("a");
+        CHECK(events.pop_front() == "a");
+
+        // The stream reconnects and only the new one batches updates
+        setter.on_update_batch(on_update_batch, batching);
+        CHECK(connections.pop_front() != first);
+
+        write("b");
+        write("c");
+        CHECK(events.pop_front() == "b,c");
+    };
+
+    SUBCASE("blocking_stream") {
+        auto setter = client.register_stream<testing::protocol::TestMessage>(
+            [](Stub& stub, grpc::ClientContext* context) { return stub.server_echo_stream(context, {}); });
+        batch_running_stream(setter);
+    }
+    SUBCASE("async_stream") {
+        auto setter = client.register_stream<testing::protocol::TestMessage>(
+            [](Stub& stub, grpc::ClientContext* context, grpc::CompletionQueue* queue) {
+                return stub.PrepareAsyncserver_echo_stream(context, {}, queue);
+            });
+        batch_running_stream(setter);
+    }
+}
+
+TEST_CASE("[grpcw-client] async_stream_restarts_stay_on_one_queue") {
+    using AsyncService = testing::protocol::Test::AsyncService;
+    using Stub = testing::protocol::Test::Stub;
+
+    server::GrpcAsyncServer<AsyncService> server(std::make_shared<AsyncService>(), "0.0.0.0:50089");
+
+    util::BlockingQueue<server::ClientID> connections;
+    auto* stream = server.register_async_stream(&AsyncService::Requestserver_echo_stream)
+                       .on_connect([&](const testing::protocol::TestMessage&, server::ClientID client) {
+                           connections.push_back(client);
+                       })
+                       .stream();
+
+    // Declared before the client since its destructor still reports the end of the stream
+    util::BlockingQueue<std::string> events;
+    util::AtomicData<std::set<std::thread::id>> threads;
+
+    auto record = [&](const std::string& event) {
+        threads.use_safely([](std::set<std::thread::id>& ids) { ids.emplace(std::this_thread::get_id()); });
+        events.push_back(event);
+    };
+
+    // Without pinning, each new call of the stream would go to the next of the four queues
+    client::GrpcClient<testing::protocol::Test> client(4);
+    client.change_server(server.server().InProcessChannel(client::default_channel_arguments()));
+
+    auto setter = client.register_stream<testing::protocol::TestMessage>(
+        [](Stub& stub, grpc::ClientContext* context, grpc::CompletionQueue* queue) {
+            return stub.PrepareAsyncserver_echo_stream(context, {}, queue);
+        });
+    setter.on_update([&](testing::protocol::TestMessage&& update) { record(update.msg()); })
+        .on_finish([&](const grpc::Status& status) { record("finished " + std::to_string(status.error_code())); });
+    connections.pop_front();
+
+    client::UpdateBatching batching;
+    batching.max_batch_size = 1u;
+
+    for (int i = 0; i < 6; ++i) {
+        testing::protocol::TestMessage update;
+        update.set_msg(std::to_string(i));
+        stream->write(update);
+        CHECK(events.pop_front() == update.msg());
+
+        // Each change restarts the stream. The old call reports its end before the new call's updates.
+        setter.on_update_batch(
+            [&](std::vector<testing::protocol::TestMessage>&& updates) { record(updates.front().msg()); }, batching);
+        connections.pop_front();
+        CHECK(events.pop_front() == "finished " + std::to_string(grpc::StatusCode::CANCELLED));
+    }
+
+    threads.use_safely([](const std::set<std::thread::id>& ids) { CHECK(ids.size() == 1u); });
+}
+
+TEST_CASE("[grpcw-client] response_cache") {
+    using AsyncService = testing::protocol::Test::AsyncService;
+    using Stub = testing::protocol::Test::Stub;
+
+    server::GrpcAsyncServer<AsyncService> server(std::make_shared<AsyncService>(), "0.0.0.0:50072");
+
+    // Every response says how many calls reached the server so cached ones can be told apart
+    std::atomic<int> server_calls{0};
+    server.register_async(&AsyncService::Requestecho,
+                          [&](const testing::protocol::TestMessage& request, testing::protocol::TestMessage* response) {
+                              response->set_msg(request.msg() + ":" + std::to_string(++server_calls));
+                              return grpc::Status::OK;
+                          });
+
+    util::BlockingQueue<server::ClientID> connections;
+    auto* stream = server.register_async_stream(&AsyncService::Requestserver_echo_stream)
+                       .on_connect([&](const testing::protocol::TestMessage&, server::ClientID client) {
+                           connections.push_back(client);
+                       })
+                       .stream();
+
+    client::GrpcClient<testing::protocol::Test> client;
+    client.change_server(server.server().InProcessChannel(client::default_channel_arguments()));
+
+    auto call = [&](const std::string& msg, const std::string& invalidation_key = "") {
+        testing::protocol::TestMessage request, response;
+        request.set_msg(msg);
+
+        auto status = client.call_cached("echo",
+                                         &Stub::echo,
+                                         &testing::protocol::Test::Service::echo,
+                                         request,
+                                         &response,
+                                         invalidation_key);
+        CHECK(status.ok());
+        return response.msg();
+    };
+
+    auto wait_for_invalidations = [&](std::uint64_t invalidations) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (client.response_cache_stats().invalidations < invalidations
+               and std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return client.response_cache_stats().invalidations;
+    };
+
+    // Without a cache every call reaches the server
+    CHECK(call("a") == "a:1");
+    CHECK(call("a") == "a:2");
+
+    // The method name keys the cache so it has to match the call
+    testing::protocol::TestMessage request, response;
+    for (const auto* method_name : {"missing", "echo_batch", "server_echo_stream"}) {
+        CHECK_THROWS_AS(client.call_cached(method_name,
+                                           &Stub::echo,
+                                           &testing::protocol::Test::Service::echo,
+                                           request,
+                                           &response),
+                        std::invalid_argument);
+    }
+
+    CHECK_THROWS_AS(client.enable_response_cache({0u, std::chrono::seconds(1)}), std::invalid_argument);
+    CHECK_THROWS_AS(client.enable_response_cache({1024u, std::chrono::seconds(0)}), std::invalid_argument);
+
+    SUBCASE("invalidation") {
+        client.enable_response_cache();
+        client.register_cache_invalidation_stream<testing::protocol::TestMessage>(
+            [](Stub& stub, grpc::ClientContext* context) { return stub.server_echo_stream(context, {}); },
+            [](const testing::protocol::TestMessage& update) { return update.msg(); });
+        connections.pop_front();
+
+        CHECK(call("a", "config") == "a:3");
+        CHECK(call("b", "other") == "b:4");
+        CHECK(call("a", "config") == "a:3");
+        CHECK(call("b", "other") == "b:4");
+
+        auto stats = client.response_cache_stats();
+        CHECK(stats.hits == 2u);
+        CHECK(stats.misses == 2u);
+        CHECK(stats.entries == 2u);
+        CHECK(stats.bytes > 0u);
+
+        // The server says "config" changed
+        testing::protocol::TestMessage update;
+        update.set_msg("config");
+        stream->write(update);
+
+        CHECK(wait_for_invalidations(1u) == 1u);
+        CHECK(call("a", "config") == "a:5");
+        CHECK(call("b", "other") == "b:4");
+
+        client.invalidate_cache("other");
+        CHECK(call("b", "other") == "b:6");
+
+        // Invalidations can't be received once the stream ends so nothing cached is trusted
+        stream->finish(grpc::Status::OK);
+
+        CHECK(wait_for_invalidations(4u) == 4u);
+        CHECK(client.response_cache_stats().entries == 0u);
+        CHECK(call("a", "config") == "a:7");
+    }
+
+    SUBCASE("expiry") {
+        client.enable_response_cache({1024u * 1024u, std::chrono::milliseconds(50)});
+
+        CHECK(call("a") == "a:3");
+        CHECK(call("a") == "a:3");
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        CHECK(call("a") == "a:4");
+        CHECK(client.response_cache_stats().evictions == 1u);
+    }
+
+    SUBCASE("memory_budget") {
+        client.enable_response_cache();
+        CHECK(call("0") == "0:3");
+        auto entry_bytes = client.response_cache_stats().bytes;
+
+        // Room for two responses of the same size
+        client.enable_response_cache({entry_bytes * 5u / 2u, std::chrono::seconds(60)});
+
+        CHECK(call("1") == "1:4");
+        CHECK(call("2") == "2:5");
+        CHECK(call("1") == "1:4");
+
+        // Evicts "2", the least recently used
+        CHECK(call("3") == "3:6");
+        CHECK(call("1") == "1:4");
+        CHECK(call("2") == "2:7");
+
+        auto stats = client.response_cache_stats();
+        CHECK(stats.evictions == 2u);
+        CHECK(stats.entries == 2u);
+        CHECK(stats.bytes <= entry_bytes * 5u / 2u);
+    }
+}
+
+TEST_CASE("[grpcw-client] batched_calls") {
+    using AsyncService = testing::protocol::Test::AsyncService;
+    using testing::protocol::TestMessage;
+    using testing::protocol::TestMessageBatch;
+
+    server::GrpcAsyncServer<AsyncService> server(std::make_shared<AsyncService>(), "0.0.0.0:50074");
+
+    util::BlockingQueue<int> batch_sizes;
+    server.register_async(&AsyncService::Requestecho_batch,
+                          [&](const TestMessageBatch& request, TestMessageBatch* response) {
+                              batch_sizes.push_back(request.messages_size());
+
+                              for (const auto& message : request.messages()) {
+                                  if (message.msg() == "fail") {
+                                      return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "failed");
+                                  }
+                                  if (message.msg() != "missing") {
+                                      response->add_messages()->set_msg(message.msg() + "!");
+                                  }
+                              }
+                              return grpc::Status::OK;
+                          });
+    server.register_async_batch<TestMessage, TestMessage>(&AsyncService::Requestecho_batch_with_statuses,
+                                                          [](const TestMessage& request, TestMessage* response) {
+                                                              if (request.msg() == "fail") {
+                                                                  return grpc::Status(grpc::StatusCode::NOT_FOUND,
+                                                                                      "failed");
+                                                              }
+                                                              response->set_msg(request.msg() + "!");
+                                                              return grpc::Status::OK;
+                                                          });
+
+    client::GrpcClient<testing::protocol::Test> client;
+    client.change_server(server.server().InProcessChannel(client::default_channel_arguments()));
+
+    CHECK_THROWS_AS((client.batch_calls<TestMessage, TestMessage>(&testing::protocol::Test::Stub::Asyncecho_batch,
+                                                                  {0u, std::chrono::seconds(1)})),
+                    std::invalid_argument);
+    CHECK_THROWS_AS((client.batch_calls<testing::protocol::TestState, TestMessage>(
+                        &testing::protocol::Test::Stub::Asyncecho_batch)),
+                    std::invalid_argument);
+
+    auto request = [](const std::string& msg) {
+        TestMessage message;
+        message.set_msg(msg);
+        return message;
+    };
+
+    SUBCASE("full_batches") {
+        auto batcher = client.batch_calls<TestMessage, TestMessage>(&testing::protocol::Test::Stub::Asyncecho_batch,
+                                                                    {4u, std::chrono::seconds(60)});
+
+        std::vector<std::future<client::CallResult<TestMessage>>> results;
+        for (int i = 0; i < 10; ++i) {
+            results.emplace_back(batcher.call(request(std::to_string(i))));
+        }
+
+        CHECK(batch_sizes.pop_front() == 4);
+        CHECK(batch_sizes.pop_front() == 4);
+
+        // The last two wait for a full batch (or a flush)
+        batcher.flush();
+        CHECK(batch_sizes.pop_front() == 2);
+
+        for (int i = 0; i < 10; ++i) {
+            auto result = results[static_cast<std::size_t>(i)].get();
+            CHECK(result.status.ok());
+            CHECK(result.response.msg() == std::to_string(i) + "!");
+        }
+    }
+
+    SUBCASE("max_delay") {
+        auto batcher = client.batch_calls<TestMessage, TestMessage>(&testing::protocol::Test::Stub::Asyncecho_batch,
+                                                                    {4u, std::chrono::milliseconds(50)});
+
+        auto first = batcher.call(request("a"));
+        auto second = batcher.call(request("b"));
+
+        CHECK(batch_sizes.pop_front() == 2);
+        CHECK(first.get().response.msg() == "a!");
+        CHECK(second.get().response.msg() == "b!");
+    }
+
+    SUBCASE("failed_batches") {
+        auto batcher = client.batch_calls<TestMessage, TestMessage>(&testing::protocol::Test::Stub::Asyncecho_batch,
+                                                                    {2u, std::chrono::seconds(60)});
+
+        // Every call in a failed batch gets its status
+        auto ok = batcher.call(request("ok"));
+        auto failed = batcher.call(request("fail"));
+        CHECK(ok.get().status.error_code() == grpc::StatusCode::INVALID_ARGUMENT);
+        CHECK(failed.get().status.error_code() == grpc::StatusCode::INVALID_ARGUMENT);
+
+        // So does a batch without a response for every request
+        auto answered = batcher.call(request("ok"));
+        auto missing = batcher.call(request("missing"));
+        CHECK(answered.get().status.error_code() == grpc::StatusCode::INTERNAL);
+        CHECK(missing.get().status.error_code() == grpc::StatusCode::INTERNAL);
+    }
+
+    SUBCASE("per_call_statuses") {
+        auto batcher = client.batch_calls<TestMessage, TestMessage>(
+            &testing::protocol::Test::Stub::Asyncecho_batch_with_statuses,
+            {3u, std::chrono::seconds(60)});
+
+        // A failed call doesn't fail the others in its batch
+        auto first = batcher.call(request("a"));
+        auto failed = batcher.call(request("fail"));
+        auto last = batcher.call(request("b"));
+
+        auto result = first.get();
+        CHECK(result.status.ok());
+        CHECK(result.response.msg() == "a!");
+
+        result = failed.get();
+        CHECK(result.status.error_code() == grpc::StatusCode::NOT_FOUND);
+        CHECK(result.status.error_message() == "failed");
+
+        CHECK(last.get().response.msg() == "b!");
+    }
+
+    SUBCASE("waiting_calls_are_sent_when_the_batcher_is_destroyed") {
+        std::future<client::CallResult<TestMessage>> result;
+        {
+            auto batcher = client.batch_calls<TestMessage, TestMessage>(
+                &testing::protocol::Test::Stub::Asyncecho_batch,
+                {4u, std::chrono::seconds(60)});
+            result = batcher.call(request("last"));
+        }
+        CHECK(result.get().response.msg() == "last!");
+    }
+}
+
+TEST_CASE("[grpcw-client] staggered_stream_restarts") {
+    using AsyncService = testing::protocol::Test::AsyncService;
+    using Stub = testing::protocol::Test::Stub;
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int num_streams = 20;
+    constexpr auto restart_window = std::chrono::milliseconds(300);
+
+    util::BlockingQueue<Clock::time_point> connections;
+
+    auto start_server = [&connections] {
+        auto server = std::make_unique<server::GrpcAsyncServer<AsyncService>>(std::make_shared<AsyncService>(),
+                                                                              "0.0.0.0:50075");
+        server->register_async_stream(&AsyncService::Requestserver_echo_stream)
+            .on_connect([&connections](const testing::protocol::TestMessage&, server::ClientID) {
+                connections.push_back(Clock::now());
+            });
+        return server;
+    };
+
+    // How long it took every stream to connect and the time between the first and last one
+    auto wait_for_streams = [&connections](Clock::time_point since) {
+        auto first = Clock::time_point::max();
+        auto last = Clock::time_point::min();
+        for (int i = 0; i < num_streams; ++i) {
+            auto connected = connections.pop_front();
+            first = std::min(first, connected);
+            last = std::max(last, connected);
+        }
+        return std::make_pair(last - since, last - first);
+    };
+
+    StateUpdater updater;
+    client::GrpcClient<testing::protocol::Test> client;
+
+    CHECK_THROWS_AS(client.set_reconnect_backoff({std::chrono::milliseconds(0)}), std::invalid_argument);
+    CHECK_THROWS_AS(client.set_reconnect_backoff({std::chrono::seconds(2), std::chrono::seconds(1)}),
+                    std::invalid_argument);
+
+    client::ReconnectBackoff backoff;
+    backoff.initial_backoff = std::chrono::milliseconds(100);
+    backoff.max_backoff = std::chrono::seconds(1);
+    backoff.min_connect_timeout = std::chrono::seconds(1);
+    backoff.stream_restart_window = restart_window;
+    client.set_reconnect_backoff(backoff);
+
+    // Registered before connecting so they are all started when the client connects
+    for (int i = 0; i < num_streams; ++i) {
+        client.register_stream<testing::protocol::TestMessage>(
+            [](Stub& stub, grpc::ClientContext* context, grpc::CompletionQueue* queue) {
+                return stub.PrepareAsyncserver_echo_stream(context, {}, queue);
+            });
+    }
+
+    auto server = start_server();
+    auto start = Clock::now();
+    client.change_server("0.0.0.0:50075", [&updater](client::GrpcClientState state) {
+        updater.handle_state_change(state);
+    });
+    check_connects(updater.state_queue);
+
+    auto streams = wait_for_streams(start);
+    CHECK(streams.second > restart_window / 4);
+    CHECK(streams.first < restart_window + std::chrono::seconds(1));
+
+    // The client reconnects after a short backoff and spreads the restarts again
+    server = nullptr;
+    start = Clock::now();
+    server = start_server();
+
+    streams = wait_for_streams(start);
+    CHECK(streams.second > restart_window / 4);
+    CHECK(streams.first < restart_window + std::chrono::seconds(2));
+}
+
+TEST_CASE("[grpcw-client] stream_starts_do_not_block_the_client") {
+    using Stub = testing::protocol::Test::Stub;
+
+    std::promise<void> init_started;
+    std::promise<void> finish_init;
+
+    server::ScopedGrpcServer server(std::make_unique<testing::TestService>());
+    client::GrpcClient<testing::protocol::Test> client;
+    client.change_server(server.in_process_channel());
+
+    // Starting the stream waits on the test
+    auto registered = std::async(std::launch::async, [&] {
+        client.register_stream<testing::protocol::TestMessage>([&](Stub& stub, grpc::ClientContext* context) {
+            init_started.set_value();
+            finish_init.get_future().wait();
+            return stub.endless_echo_stream(context, {});
+        });
+    });
+    init_started.get_future().wait();
+
+    // But the rest of the client doesn't
+    CHECK(client.get_state() == client::GrpcClientState::connected);
+
+    testing::protocol::TestMessage request, response;
+    CHECK(client.call(&Stub::echo, &testing::protocol::Test::Service::echo, request, &response).ok());
+
+    finish_init.set_value();
+    registered.get();
+}
+
+TEST_CASE("[grpcw-client] connect_and_wait") {
+    constexpr int pool_size = 4;
+    std::string server_address = "0.0.0.0:50076";
+
+    StateUpdater updater;
+    client::GrpcClient<testing::protocol::Test> client;
+
+    // Nothing to connect to
+    CHECK_FALSE(client.connect_and_wait(std::chrono::steady_clock::now() + std::chrono::milliseconds(50)));
+
+    client::ReconnectBackoff backoff;
+    backoff.initial_backoff = std::chrono::milliseconds(100);
+    backoff.max_backoff = std::chrono::milliseconds(100);
+    client.set_reconnect_backoff(backoff);
+
+    client::ChannelPool pool;
+    pool.size = pool_size;
+
+    client.change_server(server_address,
+                         std::bind(&StateUpdater::handle_state_change, &updater, std::placeholders::_1),
+                         pool);
+
+    // The server isn't running yet
+    CHECK_FALSE(client.connect_and_wait(std::chrono::steady_clock::now() + std::chrono::milliseconds(100)));
+
+    auto service = std::make_unique<PeerRecordingService>();
+    auto* service_ptr = service.get();
+    server::ScopedGrpcServer server(std::move(service), server_address);
+
+    REQUIRE(client.connect_and_wait(std::chrono::system_clock::now() + std::chrono::seconds(5)));
+    CHECK(client.get_state() == client::GrpcClientState::connected);
+
+    // Every channel is ready so round robin calls use a different connection each
+    testing::protocol::TestMessage request, response;
+    for (int i = 0; i < pool_size; ++i) {
+        CHECK(client.call(&testing::protocol::Test::Stub::echo,
+                          &testing::protocol::Test::Service::echo,
+                          request,
+                          &response)
+                  .ok());
+    }
+    CHECK(service_ptr->peers.use_safely([](const std::set<std::string>& addresses) { return addresses.size(); })
+          == static_cast<std::size_t>(pool_size));
+
+    // In-process clients are always connected
+    client.change_server(server.in_process_channel());
+    CHECK(client.connect_and_wait(std::chrono::steady_clock::now()));
+}
+
+/// \brief Fails every call with UNAVAILABLE while 'failing' is set
+class FailingService : public testing::TestService {
+public:
+    grpc::Status echo(grpc::ServerContext* context,
+                      const testing::protocol::TestMessage* request,
+                      testing::protocol::TestMessage* response) override {
+        ++calls;
+        if (failing) {
+            return {grpc::StatusCode::UNAVAILABLE, "Failing on purpose"};
+        }
+        return testing::TestService::echo(context, request, response);
+    }
+
+    std::atomic_bool failing = {true};
+    std::atomic_int calls = {0};
+};
+
+TEST_CASE("[grpcw-client] circuit_breaker") {
+    using Stub = testing::protocol::Test::Stub;
+
+    std::string server_address = "0.0.0.0:50077";
+    std::string method = "/grpcw.testing.protocol.Test/echo";
+
+    auto service = std::make_unique<FailingService>();
+    auto* service_ptr = service.get();
+    server::ScopedGrpcServer server(std::move(service), server_address);
+
+    StateUpdater updater;
+    client::GrpcClient<testing::protocol::Test> client;
+    client.change_server(server_address,
+                         std::bind(&StateUpdater::handle_state_change, &updater, std::placeholders::_1));
+    check_connects(updater.state_queue);
+
+    client::CircuitBreaking breaking;
+    breaking.minimum_calls = 5;
+    breaking.open_time = std::chrono::milliseconds(200);
+    breaking.half_open_calls = 2;
+
+    client::CircuitBreaking invalid = breaking;
+    invalid.failure_rate = 0.0;
+    CHECK_THROWS_AS(client.set_circuit_breaking(invalid), std::invalid_argument);
+
+    util::BlockingQueue<client::CircuitState> changes;
+    client.set_circuit_breaking(breaking,
+                                [&](const std::string& changed_method, const std::string& address, auto state) {
+                                    CHECK(changed_method == method);
+                                    CHECK(address == server_address);
+                                    changes.push_back(state);
+                                });
+
+    testing::protocol::TestMessage request, response;
+    auto call = [&] { return client.call(&Stub::echo, &testing::protocol::Test::Service::echo, request, &response); };
+
+    // Enough failures open the circuit
+    for (int i = 0; i < breaking.minimum_calls; ++i) {
+        auto failure = call();
+        CHECK(failure.error_code() == grpc::StatusCode::UNAVAILABLE);
+        CHECK_FALSE(client::detail::is_circuit_rejection(failure));
+    }
+    CHECK(changes.pop_front() == client::CircuitState::open);
+    CHECK(client.get_circuit_state(method, server_address) == client::CircuitState::open);
+    CHECK(service_ptr->calls == breaking.minimum_calls);
+
+    // Calls fail without reaching the server while the circuit is open
+    auto status = call();
+    CHECK(status.error_code() == grpc::StatusCode::UNAVAILABLE);
+    CHECK(status.error_message() == "The circuit breaker is open");
+    CHECK(client::detail::is_circuit_rejection(status));
+    CHECK(client.call_async(&Stub::Asyncecho, request).get().status.error_code() == grpc::StatusCode::UNAVAILABLE);
+    CHECK(service_ptr->calls == breaking.minimum_calls);
+
+    // A failed trial call opens it again
+    std::this_thread::sleep_for(breaking.open_time);
+    CHECK(call().error_code() == grpc::StatusCode::UNAVAILABLE);
+    CHECK(changes.pop_front() == client::CircuitState::half_open);
+    CHECK(changes.pop_front() == client::CircuitState::open);
+    CHECK(service_ptr->calls == breaking.minimum_calls + 1);
+
+    // Successful trial calls close it
+    service_ptr->failing = false;
+    std::this_thread::sleep_for(breaking.open_time);
+    for (int i = 0; i < breaking.half_open_calls; ++i) {
+        CHECK(call().ok());
+    }
+    CHECK(changes.pop_front() == client::CircuitState::half_open);
+    CHECK(changes.pop_front() == client::CircuitState::closed);
+    CHECK(client.get_circuit_state(method, server_address) == client::CircuitState::closed);
+    CHECK(call().ok());
+
+    // Turning it off lets every call through
+    service_ptr->failing = true;
+    client.disable_circuit_breaking();
+    for (int i = 0; i < 2 * breaking.minimum_calls; ++i) {
+        CHECK(call().error_message() == "Failing on purpose");
+    }
+    CHECK(client.get_circuit_state(method, server_address) == client::CircuitState::closed);
+    CHECK(changes.empty());
+}
+
+TEST_CASE("[grpcw-client] call_metrics") {
+    using Stub = testing::protocol::Test::Stub;
+
+    std::string server_address = "0.0.0.0:50078";
+    std::string echo_method = "/grpcw.testing.protocol.Test/echo";
+    std::string stream_method = "/grpcw.testing.protocol.Test/endless_echo_stream";
+
+    auto service = std::make_unique<FailingService>();
+    auto* service_ptr = service.get();
+    server::ScopedGrpcServer server(std::move(service), server_address);
+
+    client::GrpcClient<testing::protocol::Test> client;
+    client.change_server(server_address, [](auto) {});
+    REQUIRE(client.connect_and_wait(std::chrono::steady_clock::now() + std::chrono::seconds(5)));
+
+    testing::protocol::TestMessage request, response;
+    auto call = [&] { return client.call(&Stub::echo, &testing::protocol::Test::Service::echo, request, &response); };
+
+    // Nothing is measured until metrics are enabled
+    CHECK(call().error_code() == grpc::StatusCode::UNAVAILABLE);
+    CHECK(client.call_metrics().empty());
+
+    client.enable_call_metrics();
+
+    service_ptr->failing = false;
+    for (int i = 0; i < 3; ++i) {
+        CHECK(call().ok());
+    }
+    service_ptr->failing = true;
+    for (int i = 0; i < 2; ++i) {
+        CHECK(call().error_code() == grpc::StatusCode::UNAVAILABLE);
+    }
+
+    // A stream that is still open is in flight
+    grpc::ClientContext stream_context;
+    std::unique_ptr<grpc::ClientReader<testing::protocol::TestMessage>> reader;
+    CHECK(client.use_stub([&](Stub& stub) { reader = stub.endless_echo_stream(&stream_context, request); }));
+    for (int i = 0; i < 3; ++i) {
+        CHECK(reader->Read(&response));
+    }
+
+    auto metrics = client.call_metrics();
+    REQUIRE(metrics.size() == 2u);
+
+    const auto& echo = metrics[0];
+    CHECK(echo.method == echo_method);
+    CHECK(echo.calls_started == 5u);
+    CHECK(echo.calls_in_flight == 0);
+    CHECK(echo.calls_finished.size() == 2u);
+    CHECK(echo.calls_finished.at(grpc::StatusCode::OK) == 3u);
+    CHECK(echo.calls_finished.at(grpc::StatusCode::UNAVAILABLE) == 2u);
+    CHECK(echo.first_message_latency.total_count() == 3u); // Failed calls have no response
+    CHECK(echo.total_latency.total_count() == 5u);
+
+    CHECK(metrics[1].method == stream_method);
+    CHECK(metrics[1].calls_started == 1u);
+    CHECK(metrics[1].calls_in_flight == 1);
+    CHECK(metrics[1].calls_finished.empty());
+
+    stream_context.TryCancel();
+    while (reader->Read(&response)) {
+    }
+    CHECK(reader->Finish().error_code() == grpc::StatusCode::CANCELLED);
+
+    metrics = client.call_metrics();
+    REQUIRE(metrics.size() == 2u);
+    CHECK(metrics[1].calls_in_flight == 0);
+    CHECK(metrics[1].calls_finished.at(grpc::StatusCode::CANCELLED) == 1u);
+    CHECK(metrics[1].first_message_latency.total_count() == 1u);
+    CHECK(metrics[1].total_latency.max() >= metrics[1].first_message_latency.max());
+
+    // Prometheus output
+    std::stringstream ss;
+    client::write_prometheus_metrics(ss, metrics);
+    auto output = ss.str();
+
+    CHECK(output.find("# TYPE grpcw_client_calls_started_total counter\n") != std::string::npos);
+    CHECK(output.find("grpcw_client_calls_started_total{method=\"" + echo_method + "\"} 5\n") != std::string::npos);
+    CHECK(output.find("grpcw_client_calls_in_flight{method=\"" + stream_method + "\"} 0\n") != std::string::npos);
+    CHECK(output.find("grpcw_client_calls_finished_total{method=\"" + echo_method + "\",code=\"UNAVAILABLE\"} 2\n")
+          != std::string::npos);
+    CHECK(output.find("# TYPE grpcw_client_call_seconds histogram\n") != std::string::npos);
+    CHECK(output.find("grpcw_client_call_seconds_bucket{method=\"" + echo_method + "\",le=\"+Inf\"} 5\n")
+          != std::string::npos);
+    CHECK(output.find("grpcw_client_first_message_seconds_count{method=\"" + echo_method + "\"} 3\n")
+          != std::string::npos);
+
+    auto path = "grpcw_call_metrics_test.prom";
+    client.write_call_metrics(path);
+    {
+        std::ifstream file(path);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        CHECK(contents.str().find("grpcw_client_calls_started_total{method=\"" + echo_method + "\"} 5\n")
+              != std::string::npos);
+    }
+    std::remove(path);
+
+    CHECK_THROWS_AS(client.write_call_metrics("no/such/directory/metrics.prom"), std::runtime_error);
+
+    // Calls failed by an open circuit are counted as well
+    client::CircuitBreaking breaking;
+    breaking.minimum_calls = 2;
+    client.set_circuit_breaking(breaking);
+
+    int server_calls = service_ptr->calls;
+    for (int i = 0; i < 4; ++i) {
+        CHECK(call().error_code() == grpc::StatusCode::UNAVAILABLE);
+    }
+    CHECK(service_ptr->calls == server_calls + breaking.minimum_calls);
+    CHECK(client.call_metrics()[0].calls_finished.at(grpc::StatusCode::UNAVAILABLE) == 6u);
+
+    // Enabling them again starts over
+    client.enable_call_metrics();
+    CHECK(client.call_metrics().empty());
+}
+
 } // namespace
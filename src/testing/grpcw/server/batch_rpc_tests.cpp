@@ -0,0 +1,159 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/server/grpc_async_server.hpp"
+
+// generated
+#include <testing.grpc.pb.h>
+
+// third-party
+#include <doctest/doctest.h>
+
+// standard
+#include <atomic>
+#include <thread>
+
+namespace {
+using namespace grpcw;
+
+using Service = testing::protocol::Test::AsyncService;
+using testing::protocol::TestMessage;
+using testing::protocol::TestMessageBatch;
+
+TEST_CASE("[grpcw-server] batch_requests_are_handled_in_parallel") {
+    constexpr int parallelism = 4;
+
+    server::GrpcAsyncServer<Service> server(std::make_shared<Service>(), "0.0.0.0:50073");
+
+    CHECK_THROWS_AS((server.register_async_batch<TestMessage, TestMessage>(
+                        &Service::Requestecho_batch,
+                        [](const TestMessage&, TestMessage*) { return grpc::Status::OK; },
+                        0)),
+                    std::invalid_argument);
+
+    // Only replies once a whole group of 'parallelism' requests is being handled at the same time
+    std::atomic<int> in_flight{0};
+    std::atomic_bool gave_up_waiting{false};
+    server.register_async_batch<TestMessage, TestMessage>(
+        &Service::Requestecho_batch,
+        [&](const TestMessage& request, TestMessage* response) {
+            if (request.msg() == "fail") {
+                return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "failed");
+            }
+            if (request.msg() == "throw") {
+                throw std::runtime_error("handler failed");
+            }
+
+            ++in_flight;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (in_flight < parallelism and std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            if (in_flight < parallelism) {
+                gave_up_waiting = true;
+            }
+
+            response->set_msg(request.msg() + "!");
+            return grpc::Status::OK;
+        },
+        parallelism);
+
+    auto stub = testing::protocol::Test::NewStub(server.server().InProcessChannel({}));
+
+    auto echo_batch = [&](const std::vector<std::string>& msgs, TestMessageBatch* response) {
+        TestMessageBatch request;
+        for (const auto& msg : msgs) {
+            request.add_messages()->set_msg(msg);
+        }
+        grpc::ClientContext context;
+        return stub->echo_batch(&context, request, response);
+    };
+
+    TestMessageBatch response;
+    REQUIRE(echo_batch({"a", "b", "c", "d"}, &response).ok());
+    CHECK_FALSE(gave_up_waiting);
+
+    // Responses keep the order of the requests
+    REQUIRE(response.messages_size() == 4);
+    CHECK(response.messages(0).msg() == "a!");
+    CHECK(response.messages(1).msg() == "b!");
+    CHECK(response.messages(2).msg() == "c!");
+    CHECK(response.messages(3).msg() == "d!");
+
+    response.Clear();
+    CHECK(echo_batch({}, &response).ok());
+    CHECK(response.messages_size() == 0);
+
+    CHECK(echo_batch({"fail"}, &response).error_code() == grpc::StatusCode::INVALID_ARGUMENT);
+    CHECK(echo_batch({"throw"}, &response).error_code() == grpc::StatusCode::UNKNOWN);
+}
+
+TEST_CASE("[grpcw-server] batch_responses_with_statuses") {
+    server::GrpcAsyncServer<Service> server(std::make_shared<Service>(), "0.0.0.0:50073");
+
+    server.register_async_batch<TestMessage, TestMessage>(
+        &Service::Requestecho_batch_with_statuses,
+        [](const TestMessage& request, TestMessage* response) {
+            if (request.msg() == "fail") {
+                return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "failed");
+            }
+            if (request.msg() == "throw") {
+                throw std::runtime_error("handler failed");
+            }
+            response->set_msg(request.msg() + "!");
+            return grpc::Status::OK;
+        });
+
+    auto stub = testing::protocol::Test::NewStub(server.server().InProcessChannel({}));
+
+    TestMessageBatch request;
+    for (const auto* msg : {"a", "fail", "throw", "b"}) {
+        request.add_messages()->set_msg(msg);
+    }
+
+    // Every request gets its own status instead of failing the batch
+    testing::protocol::TestMessageResults response;
+    grpc::ClientContext context;
+    REQUIRE(stub->echo_batch_with_statuses(&context, request, &response).ok());
+
+    REQUIRE(response.messages_size() == 4);
+    REQUIRE(response.statuses_size() == 4);
+    CHECK(response.statuses(0).code() == grpc::StatusCode::OK);
+    CHECK(response.messages(0).msg() == "a!");
+    CHECK(response.statuses(1).code() == grpc::StatusCode::INVALID_ARGUMENT);
+    CHECK(response.statuses(1).message() == "failed");
+    CHECK(response.statuses(2).code() == grpc::StatusCode::UNKNOWN);
+    CHECK(response.statuses(3).code() == grpc::StatusCode::OK);
+    CHECK(response.messages(3).msg() == "b!");
+}
+
+TEST_CASE("[grpcw-server] batch_rpcs_need_one_repeated_field_of_each_type") {
+    server::GrpcAsyncServer<Service> server(std::make_shared<Service>(), "0.0.0.0:50073");
+
+    // 'TestMessage' has no repeated 'TestState' field
+    CHECK_THROWS_AS((server.register_async_batch<testing::protocol::TestState, TestMessage>(
+                        &Service::Requestecho_batch,
+                        [](const testing::protocol::TestState&, TestMessage*) { return grpc::Status::OK; })),
+                    std::invalid_argument);
+}
+
+} // namespace
@@ -0,0 +1,221 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/server/compression_options.hpp"
+#include "grpcw/server/grpc_async_server.hpp"
+#include "grpcw/util/blocking_queue.hpp"
+
+// generated
+#include <testing.grpc.pb.h>
+
+// third-party
+#include <doctest/doctest.h>
+#include <grpc++/create_channel.h>
+#include <grpc++/generic/generic_stub.h>
+
+namespace {
+using namespace grpcw;
+
+TEST_CASE("[grpcw-server] compression_thresholds") {
+    server::CompressionOptions options;
+
+    SUBCASE("disabled_by_default") {
+        CHECK_FALSE(server::compression_enabled(options));
+        CHECK_FALSE(server::should_compress(options, 0));
+        CHECK_FALSE(server::should_compress(options, 1u << 20u));
+    }
+
+    SUBCASE("algorithm_with_threshold") {
+        options.algorithm = GRPC_COMPRESS_GZIP;
+        options.min_message_size = 1024;
+
+        CHECK(server::compression_enabled(options));
+        CHECK_FALSE(server::should_compress(options, 1023));
+        CHECK(server::should_compress(options, 1024));
+    }
+
+    SUBCASE("level_with_threshold") {
+        options.level = GRPC_COMPRESS_LEVEL_HIGH;
+        options.min_message_size = 16;
+
+        CHECK(server::compression_enabled(options));
+        CHECK_FALSE(server::should_compress(options, 15));
+        CHECK(server::should_compress(options, 16));
+    }
+}
+
+///
+/// \brief Receives messages with per-message decompression turned off.
+///
+/// A received message keeps the length it had on the wire, which shows whether the server compressed it.
+///
+class WireLengthClient {
+public:
+    explicit WireLengthClient(const std::string& address) : stub_(make_channel(address)) {}
+
+    ~WireLengthClient() {
+        queue_.Shutdown();
+
+        void* tag;
+        bool ok;
+        while (queue_.Next(&tag, &ok)) {
+        }
+    }
+
+    /// \brief The length of the unary 'echo' response as it was received
+    std::size_t echo(const testing::protocol::TestMessage& request) {
+        grpc::ClientContext context;
+        auto call = stub_.PrepareUnaryCall(&context, "/grpcw.testing.protocol.Test/echo", request, &queue_);
+        call->StartCall();
+
+        grpc::ByteBuffer buffer;
+        grpc::Status status;
+        call->Finish(&buffer, &status, this);
+        wait();
+
+        REQUIRE(status.ok());
+        return buffer.Length();
+    }
+
+    void start_stream() {
+        stream_ = stub_.PrepareCall(&stream_context_, "/grpcw.testing.protocol.Test/server_echo_stream", &queue_);
+        stream_->StartCall(this);
+        REQUIRE(wait());
+        stream_->Write({}, this);
+        REQUIRE(wait());
+        stream_->WritesDone(this);
+        REQUIRE(wait());
+    }
+
+    /// \brief The length of the next stream update as it was received
+    std::size_t read() {
+        grpc::ByteBuffer buffer;
+        stream_->Read(&buffer, this);
+        REQUIRE(wait());
+        return buffer.Length();
+    }
+
+    grpc::Status finish_stream() {
+        grpc::Status status;
+        stream_->Finish(&status, this);
+        wait();
+        return status;
+    }
+
+private:
+    grpc::CompletionQueue queue_;
+    grpc::TemplatedGenericStub<testing::protocol::TestMessage, grpc::ByteBuffer> stub_;
+    grpc::ClientContext stream_context_;
+    std::unique_ptr<grpc::ClientAsyncReaderWriter<testing::protocol::TestMessage, grpc::ByteBuffer>> stream_;
+
+    static std::shared_ptr<grpc::Channel> make_channel(const std::string& address) {
+        grpc::ChannelArguments arguments;
+        arguments.SetInt(GRPC_ARG_ENABLE_PER_MESSAGE_DECOMPRESSION, 0);
+        return grpc::CreateCustomChannel(address, grpc::InsecureChannelCredentials(), arguments);
+    }
+
+    bool wait() {
+        void* tag;
+        bool ok = false;
+        REQUIRE(queue_.Next(&tag, &ok));
+        REQUIRE(tag == this);
+        return ok;
+    }
+};
+
+TEST_CASE("[grpcw-server] compressed_unary_and_stream_round_trip") {
+    using Service = testing::protocol::Test::AsyncService;
+
+    std::string server_address = "0.0.0.0:50058";
+    server::GrpcAsyncServer<Service> server(std::make_shared<Service>(), server_address);
+
+    server::CompressionOptions compression;
+    compression.algorithm = GRPC_COMPRESS_GZIP;
+    compression.min_message_size = 64;
+
+    server.register_async(&Service::Requestecho,
+                          [](const testing::protocol::TestMessage& request, testing::protocol::TestMessage* response) {
+                              response->CopyFrom(request);
+                              return grpc::Status::OK;
+                          },
+                          compression);
+
+    util::BlockingQueue<server::ClientID> connections;
+    auto* stream = server.register_async_stream(&Service::Requestserver_echo_stream, compression)
+                       .on_connect([&](const testing::protocol::TestMessage&, server::ClientID client) {
+                           connections.push_back(client);
+                       })
+                       .stream();
+
+    auto channel = grpc::CreateChannel(server_address, grpc::InsecureChannelCredentials());
+    auto stub = testing::protocol::Test::NewStub(channel);
+    WireLengthClient wire_client(server_address);
+
+    // One message below the threshold and one (very compressible) message above it
+    const std::vector<std::string> messages = {"small", std::string(4096, 'a')};
+
+    // Only the message above the threshold should be compressed
+    auto check_wire_length = [&](const testing::protocol::TestMessage& message, std::size_t wire_length) {
+        if (message.ByteSizeLong() < compression.min_message_size) {
+            CHECK(wire_length == message.ByteSizeLong());
+        } else {
+            CHECK(wire_length < message.ByteSizeLong() / 10u);
+        }
+    };
+
+    for (const std::string& msg : messages) {
+        testing::protocol::TestMessage request, response;
+        request.set_msg(msg);
+
+        grpc::ClientContext context;
+        grpc::Status status = stub->echo(&context, request, &response);
+
+        CHECK(status.ok());
+        CHECK(response.msg() == msg);
+
+        check_wire_length(request, wire_client.echo(request));
+    }
+
+    grpc::ClientContext context;
+    auto reader = stub->server_echo_stream(&context, {});
+    connections.pop_front();
+    wire_client.start_stream();
+    connections.pop_front();
+
+    for (const std::string& msg : messages) {
+        testing::protocol::TestMessage update;
+        update.set_msg(msg);
+        stream->write(update);
+
+        testing::protocol::TestMessage response;
+        REQUIRE(reader->Read(&response));
+        CHECK(response.msg() == msg);
+
+        check_wire_length(update, wire_client.read());
+    }
+
+    stream->finish(grpc::Status::OK);
+    CHECK(reader->Finish().ok());
+    CHECK(wire_client.finish_stream().ok());
+}
+
+} // namespace
@@ -0,0 +1,203 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/server/grpc_callback_server.hpp"
+
+#ifdef LTB_GRPCW_ENABLE_CALLBACK_SERVER
+
+#include "grpcw/util/blocking_queue.hpp"
+
+// generated
+#include <testing.grpc.pb.h>
+
+// third-party
+#include <doctest/doctest.h>
+#include <grpc++/create_channel.h>
+
+// standard
+#include <stdexcept>
+
+namespace {
+using namespace grpcw;
+
+using testing::protocol::TestMessage;
+using testing::protocol::TestMessageBatch;
+
+TEST_CASE("[grpcw-server] callback_server_registration") {
+    server::GrpcCallbackServer<testing::protocol::Test> server("0.0.0.0:50061");
+
+    auto echo = [](const TestMessage& request, TestMessage* response) {
+        response->CopyFrom(request);
+        return grpc::Status::OK;
+    };
+
+    // Methods the service doesn't have
+    CHECK_THROWS_AS((server.register_async<TestMessage, TestMessage>("", echo)), std::invalid_argument);
+    CHECK_THROWS_AS((server.register_async<TestMessage, TestMessage>("Echo", echo)), std::invalid_argument);
+
+    // Methods registered with the wrong types or kind of streaming
+    auto echo_batch = [](const TestMessageBatch&, TestMessageBatch*) { return grpc::Status::OK; };
+    CHECK_THROWS_AS((server.register_async<TestMessageBatch, TestMessageBatch>("echo", echo_batch)),
+                    std::invalid_argument);
+    CHECK_THROWS_AS((server.register_async<TestMessage, TestMessage>("server_echo_stream", echo)),
+                    std::invalid_argument);
+    CHECK_THROWS_AS((server.register_async_stream<TestMessage, TestMessage>("echo")), std::invalid_argument);
+
+    server.register_async<TestMessage, TestMessage>("echo", echo);
+    CHECK_THROWS_AS((server.register_async<TestMessage, TestMessage>("echo", echo)), std::invalid_argument);
+
+    server.register_async<TestMessageBatch, TestMessageBatch>("echo_batch", echo_batch);
+    server.register_async_stream<TestMessage, TestMessage>("server_echo_stream");
+
+    // A stream must allow at least one pending update
+    auto setter = server.register_async_stream<TestMessage, TestMessageBatch>("batch_stream");
+    CHECK_THROWS_AS(setter.limit_pending_updates(0u), std::invalid_argument);
+}
+
+TEST_CASE("[grpcw-server] callback_server_unary_and_stream") {
+    std::string server_address = "0.0.0.0:50061";
+    server::GrpcCallbackServer<testing::protocol::Test> server(server_address);
+
+    server.register_async<TestMessage, TestMessage>("echo", [](const TestMessage& request, TestMessage* response) {
+        if (request.msg().empty()) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Empty message");
+        }
+        response->CopyFrom(request);
+        return grpc::Status::OK;
+    });
+
+    util::BlockingQueue<server::ClientID> connections;
+    util::BlockingQueue<server::ClientID> deletions;
+
+    auto* stream = server.register_async_stream<TestMessage, TestMessage>("server_echo_stream")
+                       .on_connect([&](const TestMessage&, server::ClientID client) { connections.push_back(client); })
+                       .on_delete([&](const TestMessage&, server::ClientID client) { deletions.push_back(client); })
+                       .stream();
+
+    auto channel = grpc::CreateChannel(server_address, grpc::InsecureChannelCredentials());
+    auto stub = testing::protocol::Test::NewStub(channel);
+
+    {
+        TestMessage request, response;
+        request.set_msg("echo");
+
+        grpc::ClientContext context;
+        CHECK(stub->echo(&context, request, &response).ok());
+        CHECK(response.msg() == "echo");
+    }
+
+    {
+        TestMessage response;
+        grpc::ClientContext context;
+        CHECK(stub->echo(&context, {}, &response).error_code() == grpc::StatusCode::INVALID_ARGUMENT);
+    }
+
+    {
+        // Methods without a handler are not implemented
+        grpc::ClientContext context;
+        auto reader = stub->endless_echo_stream(&context, {});
+
+        TestMessage response;
+        CHECK_FALSE(reader->Read(&response));
+        CHECK(reader->Finish().error_code() == grpc::StatusCode::UNIMPLEMENTED);
+    }
+
+    grpc::ClientContext context1, context2;
+    auto reader1 = stub->server_echo_stream(&context1, {});
+    auto reader2 = stub->server_echo_stream(&context2, {});
+
+    server::ClientID client1 = connections.pop_front();
+    server::ClientID client2 = connections.pop_front();
+    CHECK(client1 != client2);
+
+    // Updates written back to back are all received in order by every client
+    const std::vector<std::string> messages = {"first", "second", std::string(1024, 'a')};
+
+    for (const std::string& msg : messages) {
+        TestMessage update;
+        update.set_msg(msg);
+        CHECK(stream->write(update));
+    }
+
+    for (auto* reader : {reader1.get(), reader2.get()}) {
+        for (const std::string& msg : messages) {
+            TestMessage response;
+            REQUIRE(reader->Read(&response));
+            CHECK(response.msg() == msg);
+        }
+    }
+
+    // Finish a single client
+    CHECK(stream->finish(grpc::Status::OK, client1));
+    CHECK(reader1->Finish().ok());
+    CHECK(deletions.pop_front() == client1);
+
+    TestMessage update;
+    update.set_msg("only client 2");
+    CHECK_FALSE(stream->write(update, client1));
+    CHECK(stream->write(update, client2));
+
+    TestMessage response;
+    REQUIRE(reader2->Read(&response));
+    CHECK(response.msg() == update.msg());
+
+    stream->finish(grpc::Status::OK);
+    CHECK(reader2->Finish().ok());
+    CHECK(deletions.pop_front() == client2);
+}
+
+TEST_CASE("[grpcw-server] callback_server_pending_updates") {
+    std::string server_address = "0.0.0.0:50086";
+    server::GrpcCallbackServer<testing::protocol::Test> server(server_address);
+
+    util::BlockingQueue<server::ClientID> connections;
+
+    auto* stream = server.register_async_stream<TestMessage, TestMessage>("server_echo_stream")
+                       .limit_pending_updates(2u)
+                       .on_connect([&](const TestMessage&, server::ClientID client) { connections.push_back(client); })
+                       .stream();
+
+    auto channel = grpc::CreateChannel(server_address, grpc::InsecureChannelCredentials());
+    auto stub = testing::protocol::Test::NewStub(channel);
+
+    grpc::ClientContext context;
+    auto reader = stub->server_echo_stream(&context, {});
+    server::ClientID client = connections.pop_front();
+
+    // The client never reads so flow control eventually holds back the writes and the updates pile up
+    TestMessage update;
+    update.set_msg(std::string(64 * 1024, 'a'));
+
+    bool written = true;
+    for (int i = 0; i < 10000 and written; ++i) {
+        written = stream->write(update, client);
+    }
+    CHECK_FALSE(written);
+    CHECK_FALSE(stream->write(update));
+
+    context.TryCancel();
+    CHECK(reader->Finish().error_code() == grpc::StatusCode::CANCELLED);
+}
+
+} // namespace
+
+#endif // LTB_GRPCW_ENABLE_CALLBACK_SERVER
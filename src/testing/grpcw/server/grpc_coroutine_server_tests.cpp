@@ -0,0 +1,215 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/server/grpc_coroutine_server.hpp"
+
+#ifdef __cpp_impl_coroutine
+
+#include "grpcw/server/grpc_server.hpp"
+#include "testing/test_service.hpp"
+
+// generated
+#include <testing.grpc.pb.h>
+
+// third-party
+#include <doctest/doctest.h>
+#include <grpc++/create_channel.h>
+
+// standard
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+using namespace grpcw;
+
+using Service = testing::protocol::Test::AsyncService;
+using testing::protocol::TestMessage;
+
+TEST_CASE("[grpcw-server] coroutine_server_handlers") {
+    // A second service the coroutines can call
+    server::GrpcServer backend(std::make_unique<testing::TestService>());
+    std::thread backend_thread([&] { backend.run(); });
+    auto backend_stub = testing::protocol::Test::NewStub(backend.in_process_channel());
+
+    // A single queue thread has to be enough since suspended calls don't block it
+    std::string server_address = "0.0.0.0:50062";
+    server::GrpcCoroutineServer<Service> server(std::make_shared<Service>(), server_address, 1);
+
+    server.register_unary(&Service::Requestecho,
+                          [](server::CoroutineCall& call, const TestMessage& request, TestMessage* response)
+                              -> util::Task<grpc::Status> {
+                              if (request.msg().empty()) {
+                                  throw std::invalid_argument("Empty message");
+                              }
+                              co_await call.alarm(std::chrono::system_clock::now() + std::chrono::milliseconds(1));
+                              response->CopyFrom(request);
+                              co_return grpc::Status::OK;
+                          });
+
+    server.register_server_stream(
+        &Service::Requestserver_echo_stream,
+        [&](server::CoroutineWriter<TestMessage>& writer, const TestMessage& request) -> util::Task<grpc::Status> {
+            grpc::ClientContext client_context;
+            TestMessage reply;
+
+            grpc::Status status = co_await writer.unary(*backend_stub,
+                                                        &testing::protocol::Test::Stub::PrepareAsyncecho,
+                                                        &client_context,
+                                                        request,
+                                                        &reply);
+            if (not status.ok()) {
+                co_return status;
+            }
+
+            for (int i = 0; i < 3; ++i) {
+                if (not co_await writer.write(reply)) {
+                    co_return grpc::Status::CANCELLED;
+                }
+            }
+            co_return grpc::Status::OK;
+        });
+
+    server.register_bidi_stream(&Service::Requestbidirectional_echo_stream,
+                                [](server::CoroutineReaderWriter<TestMessage, TestMessage>& stream)
+                                    -> util::Task<grpc::Status> {
+                                    TestMessage message;
+                                    while (co_await stream.read(&message)) {
+                                        co_await stream.write(message);
+                                    }
+                                    co_return grpc::Status::OK;
+                                });
+
+    auto channel = grpc::CreateChannel(server_address, grpc::InsecureChannelCredentials());
+    auto stub = testing::protocol::Test::NewStub(channel);
+
+    {
+        TestMessage request, response;
+        request.set_msg("unary");
+
+        grpc::ClientContext context;
+        CHECK(stub->echo(&context, request, &response).ok());
+        CHECK(response.msg() == "unary");
+    }
+
+    {
+        // Exceptions thrown by handlers become errors
+        TestMessage response;
+        grpc::ClientContext context;
+        CHECK(stub->echo(&context, {}, &response).error_code() == grpc::StatusCode::INTERNAL);
+    }
+
+    {
+        TestMessage request;
+        request.set_msg("server stream");
+
+        grpc::ClientContext context;
+        auto reader = stub->server_echo_stream(&context, request);
+
+        TestMessage response;
+        int received = 0;
+        while (reader->Read(&response)) {
+            CHECK(response.msg() == "server stream");
+            ++received;
+        }
+        CHECK(received == 3);
+        CHECK(reader->Finish().ok());
+    }
+
+    {
+        grpc::ClientContext context;
+        auto stream = stub->bidirectional_echo_stream(&context);
+
+        for (const std::string& msg : std::vector<std::string>{"one", "two", "three"}) {
+            TestMessage request, response;
+            request.set_msg(msg);
+
+            REQUIRE(stream->Write(request));
+            REQUIRE(stream->Read(&response));
+            CHECK(response.msg() == msg);
+        }
+
+        stream->WritesDone();
+        CHECK(stream->Finish().ok());
+    }
+
+    backend.shutdown();
+    backend_thread.join();
+}
+
+TEST_CASE("[grpcw-server] coroutine_server_multiple_queue_threads") {
+    server::GrpcServer backend(std::make_unique<testing::TestService>());
+    std::thread backend_thread([&] { backend.run(); });
+    auto backend_stub = testing::protocol::Test::NewStub(backend.in_process_channel());
+
+    // Operations started on one queue thread can complete (and resume the coroutine) on another
+    std::string server_address = "0.0.0.0:50088";
+    server::GrpcCoroutineServer<Service> server(std::make_shared<Service>(), server_address, 4);
+
+    server.register_unary(&Service::Requestecho,
+                          [&](server::CoroutineCall& call, const TestMessage& request, TestMessage* response)
+                              -> util::Task<grpc::Status> {
+                              co_await call.alarm(std::chrono::system_clock::now());
+
+                              grpc::ClientContext client_context;
+                              co_return co_await call.unary(*backend_stub,
+                                                            &testing::protocol::Test::Stub::PrepareAsyncecho,
+                                                            &client_context,
+                                                            request,
+                                                            response);
+                          });
+
+    auto channel = grpc::CreateChannel(server_address, grpc::InsecureChannelCredentials());
+    auto stub = testing::protocol::Test::NewStub(channel);
+
+    constexpr int num_clients = 8;
+    constexpr int calls_per_client = 50;
+    std::atomic_int echoed{0};
+    std::vector<std::thread> clients;
+
+    for (int c = 0; c < num_clients; ++c) {
+        clients.emplace_back([&, c] {
+            for (int i = 0; i < calls_per_client; ++i) {
+                TestMessage request, response;
+                request.set_msg(std::to_string(c) + ":" + std::to_string(i));
+
+                grpc::ClientContext context;
+                if (stub->echo(&context, request, &response).ok() and response.msg() == request.msg()) {
+                    ++echoed;
+                }
+            }
+        });
+    }
+
+    for (auto& client : clients) {
+        client.join();
+    }
+    CHECK(echoed == num_clients * calls_per_client);
+
+    backend.shutdown();
+    backend_thread.join();
+}
+
+} // namespace
+
+#endif // __cpp_impl_coroutine
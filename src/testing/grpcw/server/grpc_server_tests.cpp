@@ -20,12 +20,23 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 // ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/server/grpc_async_server.hpp"
 #include "grpcw/server/grpc_server.hpp"
 #include "testing/test_service.hpp"
 
 #include <doctest/doctest.h>
 #include <grpc++/create_channel.h>
 
+// Only newer gRPC releases (1.41+) have this header. Older ones are treated as too old for abstract sockets.
+#if __has_include(<grpcpp/version_info.h>)
+#include <grpcpp/version_info.h>
+#endif
+
+// 'unix-abstract:' addresses were added in gRPC 1.34
+#if defined(GRPC_CPP_VERSION_MAJOR) && (GRPC_CPP_VERSION_MAJOR > 1 || GRPC_CPP_VERSION_MINOR >= 34)
+#define GRPCW_TEST_ABSTRACT_SOCKETS
+#endif
+
 #include <thread>
 
 using namespace grpcw;
@@ -90,3 +101,56 @@ TEST_CASE("[grpcw] run_inprocess_server_and_check_echo_rpc_call") {
     server.shutdown();
     run_thread.join();
 }
+
+TEST_CASE("[grpcw] run_unix_socket_servers_and_check_echo_rpc_calls") {
+    std::string test_msg = "sent over a unix domain socket";
+
+    auto check_echo = [&](const std::string& server_address) {
+        auto channel = grpc::CreateChannel(server_address, grpc::InsecureChannelCredentials());
+        auto stub = testing::protocol::Test::NewStub(channel);
+
+        testing::protocol::TestMessage request = {};
+        request.set_msg(test_msg);
+
+        grpc::ClientContext context;
+        testing::protocol::TestMessage response;
+
+        grpc::Status status = stub->echo(&context, request, &response);
+        CHECK(status.ok());
+        CHECK(response.msg() == test_msg);
+    };
+
+    SUBCASE("socket_file") {
+        std::string server_address = "unix:/tmp/grpcw_server_tests.sock";
+        server::GrpcServer server(std::make_unique<testing::TestService>(), server_address);
+        std::thread run_thread([&] { server.run(); });
+
+        check_echo(server_address);
+
+        server.shutdown();
+        run_thread.join();
+    }
+
+#ifdef GRPCW_TEST_ABSTRACT_SOCKETS
+    SUBCASE("abstract_socket") {
+        using Service = testing::protocol::Test::AsyncService;
+
+        std::string server_address = "unix-abstract:grpcw_server_tests";
+        server::GrpcAsyncServer<Service> server(std::make_shared<Service>(), server_address);
+
+        server.register_async(&Service::Requestecho,
+                              [](const testing::protocol::TestMessage& request,
+                                 testing::protocol::TestMessage* response) {
+                                  *response = request;
+                                  return grpc::Status::OK;
+                              });
+
+        check_echo(server_address);
+    }
+#endif
+}
+
+TEST_CASE("[grpcw] server_throws_if_it_cannot_listen") {
+    CHECK_THROWS_AS(server::GrpcServer(std::make_unique<testing::TestService>(), "unix:/no/such/dir/grpcw.sock"),
+                    std::runtime_error);
+}
@@ -0,0 +1,80 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/server/grpc_async_server.hpp"
+
+// generated
+#include <testing.grpc.pb.h>
+
+// third-party
+#include <doctest/doctest.h>
+
+// standard
+#include <thread>
+
+namespace {
+using namespace grpcw;
+
+using Service = testing::protocol::Test::AsyncService;
+
+TEST_CASE("[grpcw-server] unary_calls_are_shed_while_the_queue_lags") {
+    server::GrpcAsyncServer<Service> server(std::make_shared<Service>(), "0.0.0.0:50065");
+
+    server.register_async(&Service::Requestecho,
+                          [](const testing::protocol::TestMessage& request, testing::protocol::TestMessage* response) {
+                              // Blocks the queue thread so the next probe is handled late
+                              if (request.msg() == "slow") {
+                                  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+                              }
+                              *response = request;
+                              return grpc::Status::OK;
+                          });
+
+    CHECK(server.queue_lag() == std::chrono::nanoseconds::zero());
+
+    server.enable_load_shedding({std::chrono::milliseconds(100), std::chrono::milliseconds(50)});
+    CHECK_THROWS_AS(server.enable_load_shedding(), std::invalid_argument);
+
+    auto stub = testing::protocol::Test::NewStub(server.server().InProcessChannel({}));
+
+    auto echo = [&](const std::string& msg) {
+        grpc::ClientContext context;
+        testing::protocol::TestMessage request, response;
+        request.set_msg(msg);
+        return stub->echo(&context, request, &response);
+    };
+
+    CHECK(echo("slow").ok());
+
+    // The probe that fired during the slow call was handled about 200ms late
+    grpc::Status status = echo("fast");
+    CHECK(status.error_code() == grpc::StatusCode::UNAVAILABLE);
+    CHECK(server.queue_lag() > std::chrono::milliseconds(50));
+
+    // Calls are accepted again once a probe shows the queue has caught up
+    while (server.queue_lag() > std::chrono::milliseconds(50)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(echo("fast").ok());
+}
+
+} // namespace
@@ -0,0 +1,483 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/client/grpc_client.hpp"
+#include "grpcw/server/grpc_async_server.hpp"
+#include "grpcw/util/blocking_queue.hpp"
+
+// generated
+#include <testing.grpc.pb.h>
+
+// third-party
+#include <doctest/doctest.h>
+#include <grpc++/create_channel.h>
+
+// standard
+#include <atomic>
+#include <thread>
+
+namespace {
+using namespace grpcw;
+
+using Service = testing::protocol::Test::AsyncService;
+
+TEST_CASE("[grpcw-server] delta_encoded_stream_updates") {
+    server::GrpcAsyncServer<Service> server(std::make_shared<Service>(), "0.0.0.0:50059");
+
+    util::BlockingQueue<server::ClientID> connections;
+    auto* stream = server.register_async_stream(&Service::Requestserver_echo_stream)
+                       .on_connect([&](const testing::protocol::TestMessage&, server::ClientID client) {
+                           connections.push_back(client);
+                       })
+                       .enable_delta_encoding()
+                       .stream();
+
+    // Clients that don't ask for deltas keep receiving full updates
+    auto stub = testing::protocol::Test::NewStub(
+        server.server().InProcessChannel(client::default_channel_arguments()));
+    grpc::ClientContext plain_context;
+    auto plain_reader = stub->server_echo_stream(&plain_context, {});
+    connections.pop_front();
+
+    util::BlockingQueue<std::string> updates;
+
+    client::GrpcClient<testing::protocol::Test> client;
+    client.change_server(server.server().InProcessChannel(client::default_channel_arguments()));
+
+    auto callback_setter = client.register_stream<testing::protocol::TestMessage>(
+        [](testing::protocol::Test::Stub& stub, grpc::ClientContext* context) {
+            return stub.server_echo_stream(context, {});
+        });
+    connections.pop_front();
+
+    // The running stream is restarted so the server knows this client can decode deltas
+    callback_setter.on_update([&](testing::protocol::TestMessage&& update) { updates.push_back(update.msg()); })
+        .enable_delta_decoding();
+    connections.pop_front();
+
+    // Repeated and cleared values have to be rebuilt by the client
+    const std::vector<std::string> messages = {"first", "first", "second", "", "third"};
+
+    for (const std::string& msg : messages) {
+        testing::protocol::TestMessage update;
+        update.set_msg(msg);
+        stream->write(update);
+
+        CHECK(updates.pop_front() == msg);
+
+        testing::protocol::TestMessage plain_update;
+        REQUIRE(plain_reader->Read(&plain_update));
+        CHECK(plain_update.msg() == msg);
+        CHECK_FALSE(util::is_delta(plain_update));
+    }
+
+    stream->finish(grpc::Status::OK);
+    CHECK(plain_reader->Finish().ok());
+}
+
+TEST_CASE("[grpcw-server] batched_stream_updates") {
+    server::GrpcAsyncServer<Service> server(std::make_shared<Service>(), "0.0.0.0:50060");
+
+    util::BlockingQueue<server::ClientID> connections;
+    auto* stream = server.register_async_stream(&Service::Requestserver_echo_stream)
+                       .on_connect([&](const testing::protocol::TestMessage&, server::ClientID client) {
+                           connections.push_back(client);
+                       })
+                       .enable_write_batching({4, std::chrono::milliseconds(5)})
+                       .stream();
+
+    util::BlockingQueue<std::string> updates;
+
+    client::GrpcClient<testing::protocol::Test> client;
+    client.change_server(server.server().InProcessChannel(client::default_channel_arguments()));
+
+    client
+        .register_stream<testing::protocol::TestMessage>(
+            [](testing::protocol::Test::Stub& stub, grpc::ClientContext* context) {
+                return stub.server_echo_stream(context, {});
+            })
+        .on_update([&](testing::protocol::TestMessage&& update) { updates.push_back(update.msg()); });
+
+    connections.pop_front();
+
+    // Two full batches are sent right away and the remaining updates are sent when the delay expires
+    constexpr int total_updates = 10;
+
+    for (int i = 0; i < total_updates; ++i) {
+        testing::protocol::TestMessage update;
+        update.set_msg(std::to_string(i));
+        CHECK(stream->write(update));
+    }
+
+    for (int i = 0; i < total_updates; ++i) {
+        CHECK(updates.pop_front() == std::to_string(i));
+    }
+
+    stream->finish(grpc::Status::OK);
+}
+
+TEST_CASE("[grpcw-server] batched_stream_updates_over_tcp") {
+    // Unlike in-process channels, a real transport holds back writes until the batch is flushed
+    std::string server_address = "0.0.0.0:50079";
+    server::GrpcAsyncServer<Service> server(std::make_shared<Service>(), server_address);
+
+    util::BlockingQueue<server::ClientID> connections;
+    auto* stream = server.register_async_stream(&Service::Requestserver_echo_stream)
+                       .on_connect([&](const testing::protocol::TestMessage&, server::ClientID client) {
+                           connections.push_back(client);
+                       })
+                       .enable_write_batching({4, std::chrono::milliseconds(5)})
+                       .stream();
+
+    auto channel = grpc::CreateChannel(server_address, grpc::InsecureChannelCredentials());
+    auto stub = testing::protocol::Test::NewStub(channel);
+
+    // Fails instead of hanging if a batch is never flushed
+    grpc::ClientContext context;
+    context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(10));
+    auto reader = stub->server_echo_stream(&context, {});
+    connections.pop_front();
+
+    // A full batch, a partial batch sent when the delay expires, and a single update
+    for (int count : {4, 3, 1}) {
+        std::vector<std::string> sent;
+
+        for (int i = 0; i < count; ++i) {
+            testing::protocol::TestMessage update;
+            update.set_msg(std::to_string(count) + "." + std::to_string(i));
+            CHECK(stream->write(update));
+            sent.emplace_back(update.msg());
+        }
+
+        for (const std::string& msg : sent) {
+            testing::protocol::TestMessage update;
+            REQUIRE(reader->Read(&update));
+            CHECK(update.msg() == msg);
+        }
+    }
+
+    stream->finish(grpc::Status::OK);
+    CHECK(reader->Finish().ok());
+}
+
+TEST_CASE("[grpcw-server] merged_batches_share_one_message") {
+    std::string server_address = "0.0.0.0:50080";
+    server::GrpcAsyncServer<Service> server(std::make_shared<Service>(), server_address);
+
+    server::WriteBatching batching;
+    batching.max_batch_size = 4;
+    batching.max_delay = std::chrono::milliseconds(5);
+    batching.merge_updates = true;
+
+    util::BlockingQueue<server::ClientID> connections;
+    auto* stream = server.register_async_stream(&Service::Requestbatch_stream)
+                       .on_connect([&](const testing::protocol::TestMessage&, server::ClientID client) {
+                           connections.push_back(client);
+                       })
+                       .enable_write_batching(batching)
+                       .stream();
+
+    auto channel = grpc::CreateChannel(server_address, grpc::InsecureChannelCredentials());
+    auto stub = testing::protocol::Test::NewStub(channel);
+
+    grpc::ClientContext context;
+    context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(10));
+    auto reader = stub->batch_stream(&context, {});
+    connections.pop_front();
+
+    constexpr int total_updates = 10;
+
+    for (int i = 0; i < total_updates; ++i) {
+        testing::protocol::TestMessageBatch update;
+        update.add_messages()->set_msg(std::to_string(i));
+        CHECK(stream->write(update));
+    }
+
+    // Every update arrives in order but packed into fewer messages
+    std::vector<std::string> received;
+    int messages = 0;
+
+    while (received.size() < total_updates) {
+        testing::protocol::TestMessageBatch batch;
+        REQUIRE(reader->Read(&batch));
+        ++messages;
+
+        for (const auto& message : batch.messages()) {
+            received.emplace_back(message.msg());
+        }
+    }
+
+    for (int i = 0; i < total_updates; ++i) {
+        CHECK(received.at(i) == std::to_string(i));
+    }
+    CHECK(messages < total_updates);
+
+    stream->finish(grpc::Status::OK);
+    CHECK(reader->Finish().ok());
+}
+
+TEST_CASE("[grpcw-server] batched_writes_wait_for_slow_clients") {
+    std::string server_address = "0.0.0.0:50081";
+    server::GrpcAsyncServer<Service> server(std::make_shared<Service>(), server_address);
+
+    server::WriteBatching batching;
+    batching.max_pending_updates = 2;
+
+    util::BlockingQueue<server::ClientID> connections;
+    auto* stream = server.register_async_stream(&Service::Requestserver_echo_stream)
+                       .on_connect([&](const testing::protocol::TestMessage&, server::ClientID client) {
+                           connections.push_back(client);
+                       })
+                       .enable_write_batching(batching)
+                       .stream();
+
+    auto channel = grpc::CreateChannel(server_address, grpc::InsecureChannelCredentials());
+    auto stub = testing::protocol::Test::NewStub(channel);
+
+    grpc::ClientContext context;
+    auto reader = stub->server_echo_stream(&context, {});
+    connections.pop_front();
+
+    // Much more than the transport buffers while the client isn't reading
+    constexpr int total_updates = 32;
+    testing::protocol::TestMessage large_update;
+    large_update.set_msg(std::string(1u << 20u, 'a'));
+
+    std::atomic_int written{0};
+    std::thread writer([&] {
+        for (int i = 0; i < total_updates; ++i) {
+            stream->write(large_update);
+            ++written;
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    CHECK(written < total_updates);
+
+    for (int i = 0; i < total_updates; ++i) {
+        testing::protocol::TestMessage update;
+        REQUIRE(reader->Read(&update));
+    }
+    writer.join();
+    CHECK(written == total_updates);
+
+    stream->finish(grpc::Status::OK);
+    CHECK(reader->Finish().ok());
+}
+
+TEST_CASE("[grpcw-server] write_batching_needs_room_for_updates") {
+    server::GrpcAsyncServer<Service> server(std::make_shared<Service>(), "0.0.0.0:50082");
+
+    server::WriteBatching batching;
+    batching.max_pending_updates = 0;
+
+    CHECK_THROWS_AS(server.register_async_stream(&Service::Requestserver_echo_stream).enable_write_batching(batching),
+                    std::invalid_argument);
+}
+
+TEST_CASE("[grpcw-server] published_updates_only_reach_subscribers") {
+    std::string server_address = "0.0.0.0:50063";
+    server::GrpcAsyncServer<Service> server(std::make_shared<Service>(), server_address);
+
+    util::BlockingQueue<server::ClientID> connections;
+    auto* stream = server.register_async_stream(&Service::Requestserver_echo_stream)
+                       .on_connect([&](const testing::protocol::TestMessage&, server::ClientID client) {
+                           connections.push_back(client);
+                       })
+                       .on_subscribe([](const testing::protocol::TestMessage& request) {
+                           // Every client joins its own room and the lobby
+                           return std::vector<std::string>{request.msg(), "lobby"};
+                       })
+                       .stream();
+
+    auto channel = grpc::CreateChannel(server_address, grpc::InsecureChannelCredentials());
+    auto stub = testing::protocol::Test::NewStub(channel);
+
+    const std::vector<std::string> rooms = {"a", "b", "a"};
+    std::vector<std::unique_ptr<grpc::ClientContext>> contexts;
+    std::vector<std::unique_ptr<grpc::ClientReader<testing::protocol::TestMessage>>> readers;
+
+    for (const std::string& room : rooms) {
+        testing::protocol::TestMessage request;
+        request.set_msg(room);
+
+        contexts.emplace_back(std::make_unique<grpc::ClientContext>());
+        readers.emplace_back(stub->server_echo_stream(contexts.back().get(), request));
+        connections.pop_front();
+    }
+
+    auto publish = [&](const std::string& topic, const std::string& msg) {
+        testing::protocol::TestMessage update;
+        update.set_msg(msg);
+        CHECK(stream->publish(topic, update));
+    };
+
+    auto next_message = [&](std::size_t client) {
+        testing::protocol::TestMessage update;
+        REQUIRE(readers.at(client)->Read(&update));
+        return update.msg();
+    };
+
+    publish("a", "to a");
+    publish("b", "to b");
+    publish("nobody", "ignored");
+    publish("lobby", "to everyone");
+
+    CHECK(next_message(0) == "to a");
+    CHECK(next_message(0) == "to everyone");
+
+    CHECK(next_message(1) == "to b");
+    CHECK(next_message(1) == "to everyone");
+
+    CHECK(next_message(2) == "to a");
+    CHECK(next_message(2) == "to everyone");
+
+    stream->finish(grpc::Status::OK);
+
+    for (auto& reader : readers) {
+        CHECK(reader->Finish().ok());
+    }
+}
+
+TEST_CASE("[grpcw-server] submission_queue_stream_updates") {
+    std::string server_address = "0.0.0.0:50064";
+    server::GrpcAsyncServer<Service> server(std::make_shared<Service>(), server_address);
+
+    util::BlockingQueue<server::ClientID> connections;
+    util::BlockingQueue<server::ClientID> deletions;
+    auto* stream = server.register_async_stream(&Service::Requestserver_echo_stream)
+                       .on_connect([&](const testing::protocol::TestMessage&, server::ClientID client) {
+                           connections.push_back(client);
+                       })
+                       .on_delete([&](const testing::protocol::TestMessage&, server::ClientID client) {
+                           deletions.push_back(client);
+                       })
+                       .enable_submission_queue()
+                       .stream();
+
+    auto channel = grpc::CreateChannel(server_address, grpc::InsecureChannelCredentials());
+    auto stub = testing::protocol::Test::NewStub(channel);
+
+    grpc::ClientContext context;
+    auto reader = stub->server_echo_stream(&context, {});
+    auto client = connections.pop_front();
+
+    constexpr int num_producers = 4;
+    constexpr int updates_per_producer = 250;
+    std::vector<std::thread> producers;
+
+    for (int p = 0; p < num_producers; ++p) {
+        producers.emplace_back([stream, client, p] {
+            for (int i = 0; i < updates_per_producer; ++i) {
+                testing::protocol::TestMessage update;
+                update.set_msg(std::to_string(p) + ":" + std::to_string(i));
+                stream->write(update, client);
+            }
+        });
+    }
+
+    // Updates from different producers interleave but each producer's updates arrive in order
+    std::vector<int> next_update(num_producers, 0);
+
+    for (int i = 0; i < num_producers * updates_per_producer; ++i) {
+        testing::protocol::TestMessage update;
+        REQUIRE(reader->Read(&update));
+
+        auto separator = update.msg().find(':');
+        int producer = std::stoi(update.msg().substr(0, separator));
+        CHECK(std::stoi(update.msg().substr(separator + 1)) == next_update.at(producer)++);
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    // Targeted writes still report clients that are not connected
+    int not_a_client = 0;
+    CHECK_FALSE(stream->write({}, &not_a_client));
+
+    context.TryCancel();
+    CHECK(deletions.pop_front() == client);
+    CHECK_FALSE(stream->write({}, client));
+
+    CHECK(reader->Finish().error_code() == grpc::StatusCode::CANCELLED);
+}
+
+TEST_CASE("[grpcw-server] submission_queue_drops_updates_for_slow_clients") {
+    std::string server_address = "0.0.0.0:50087";
+    server::GrpcAsyncServer<Service> server(std::make_shared<Service>(), server_address);
+
+    server::WriteBatching batching;
+    batching.max_pending_updates = 2;
+
+    util::BlockingQueue<server::ClientID> connections;
+    auto* stream = server.register_async_stream(&Service::Requestserver_echo_stream)
+                       .on_connect([&](const testing::protocol::TestMessage&, server::ClientID client) {
+                           connections.push_back(client);
+                       })
+                       .enable_write_batching(batching)
+                       .enable_submission_queue()
+                       .stream();
+
+    auto channel = grpc::CreateChannel(server_address, grpc::InsecureChannelCredentials());
+    auto stub = testing::protocol::Test::NewStub(channel);
+
+    grpc::ClientContext context;
+    auto reader = stub->server_echo_stream(&context, {});
+    auto client = connections.pop_front();
+
+    // Much more than the transport buffers while the client isn't reading. Writes never wait for the client.
+    constexpr int total_updates = 64;
+    const std::string payload(1u << 20u, 'a');
+
+    for (int i = 0; i < total_updates; ++i) {
+        testing::protocol::TestMessage update;
+        update.set_msg(std::to_string(i) + ":" + payload);
+        stream->write(update, client);
+    }
+
+    // The newest update is never the one dropped (the submission queue may still be full for a moment)
+    testing::protocol::TestMessage last_update;
+    last_update.set_msg("last");
+    while (not stream->write(last_update, client)) {
+        std::this_thread::yield();
+    }
+
+    // The updates that are left still arrive in order
+    int received = 0;
+    int previous = -1;
+    testing::protocol::TestMessage update;
+
+    while (reader->Read(&update) and update.msg() != "last") {
+        int index = std::stoi(update.msg().substr(0, update.msg().find(':')));
+        CHECK(index > previous);
+        previous = index;
+        ++received;
+    }
+    CHECK(update.msg() == "last");
+    CHECK(received < total_updates);
+
+    stream->finish(grpc::Status::OK);
+    CHECK(reader->Finish().ok());
+}
+
+} // namespace
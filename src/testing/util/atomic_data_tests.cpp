@@ -26,6 +26,7 @@
 #include <doctest/doctest.h>
 
 // standard
+#include <chrono>
 #include <condition_variable>
 #include <numeric>
 #include <thread>
@@ -148,6 +149,33 @@ TEST_CASE("[grpcw-util] atomic_data_notify_all") {
     shared_data.use_safely([&](const SharedData& data) { CHECK(data.num_threads == threads.size()); });
 }
 
+TEST_CASE("[grpcw-util] atomic_data_wait_until") {
+    util::AtomicData<int> shared_data(0);
+    int used = 0;
+
+    // Nobody sets the value so the wait times out without using the data
+    CHECK_FALSE(shared_data.wait_to_use_safely_until(std::chrono::steady_clock::now() + std::chrono::milliseconds(10),
+                                                     [](int value) { return value == 1; },
+                                                     [&used](int) { ++used; }));
+    CHECK(used == 0);
+
+    std::thread thread([&] {
+        shared_data.use_safely([](int& value) { value = 1; });
+        shared_data.notify_all();
+    });
+
+    CHECK(shared_data.wait_to_use_safely_until(std::chrono::steady_clock::now() + std::chrono::seconds(5),
+                                               [](int value) { return value == 1; },
+                                               [&used](int& value) {
+                                                   ++used;
+                                                   value = 2;
+                                               }));
+    thread.join();
+
+    CHECK(used == 1);
+    CHECK(shared_data.use_safely([](int value) { return value; }) == 2);
+}
+
 TEST_CASE_TEMPLATE("[grpcw-util] interleaved_atomic_data", T, short, int, unsigned, float, double) {
     struct SharedData {
         T current_number = 0;
@@ -0,0 +1,91 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/util/atomic_shared_ptr.hpp"
+
+// third-party
+#include <doctest/doctest.h>
+
+// standard
+#include <array>
+#include <thread>
+
+namespace {
+using namespace grpcw;
+
+TEST_CASE("[grpcw-util] atomic_shared_ptr_keeps_loaded_values_alive") {
+    util::AtomicSharedPtr<const int> ptr;
+    CHECK(ptr.load() == nullptr);
+
+    ptr.store(std::make_shared<const int>(1));
+    auto first = ptr.load();
+    REQUIRE(first);
+
+    ptr.store(std::make_shared<const int>(2));
+
+    // The old value is still valid for whoever loaded it
+    CHECK(*first == 1);
+    CHECK(*ptr.load() == 2);
+
+    ptr.store(nullptr);
+    CHECK(ptr.load() == nullptr);
+}
+
+TEST_CASE("[grpcw-util] atomic_shared_ptr_concurrent_loads_and_stores") {
+    constexpr int num_readers = 8;
+    constexpr int num_stores = 10000;
+
+    util::AtomicSharedPtr<const int> ptr(std::make_shared<const int>(0));
+
+    std::array<std::thread, num_readers> readers;
+    std::array<bool, num_readers> values_increased = {};
+
+    for (int r = 0; r < num_readers; ++r) {
+        readers[r] = std::thread([&ptr, &increased = values_increased[r]] {
+            int last_value = 0;
+            increased = true;
+
+            // Each reader must only ever see values that were stored, in order
+            while (last_value < num_stores) {
+                auto value = ptr.load();
+                if (*value < last_value) {
+                    increased = false;
+                }
+                last_value = *value;
+            }
+        });
+    }
+
+    for (int i = 1; i <= num_stores; ++i) {
+        ptr.store(std::make_shared<const int>(i));
+    }
+
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    for (bool increased : values_increased) {
+        CHECK(increased);
+    }
+}
+
+} // namespace
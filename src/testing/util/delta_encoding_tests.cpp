@@ -0,0 +1,115 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/util/delta_encoding.hpp"
+#include "testing/test_proto_util.hpp"
+
+// generated
+#include <testing.pb.h>
+
+// third-party
+#include <doctest/doctest.h>
+
+namespace {
+using namespace grpcw;
+
+testing::protocol::TestState make_state() {
+    testing::protocol::TestState state;
+    state.set_name(std::string(256, 'n'));
+    state.set_counter(1);
+    state.add_values(1);
+    state.add_values(2);
+    state.add_values(3);
+    state.mutable_nested()->set_msg("nested");
+    state.set_text("text");
+    return state;
+}
+
+TEST_CASE("[grpcw-util] full_updates_replace_the_previous_state") {
+    testing::protocol::TestState state = make_state();
+    testing::protocol::TestState full_update;
+    full_update.set_counter(42);
+
+    CHECK_FALSE(util::is_delta(full_update));
+
+    util::apply_delta(full_update, &state);
+    CHECK(state == full_update);
+}
+
+TEST_CASE("[grpcw-util] deltas_only_contain_changed_fields") {
+    testing::protocol::TestState previous = make_state();
+    testing::protocol::TestState current = previous;
+    current.set_counter(2);
+
+    testing::protocol::TestState delta;
+    util::encode_delta(previous, current, &delta);
+
+    CHECK(util::is_delta(delta));
+    CHECK(delta.counter() == 2);
+    CHECK(delta.name().empty());
+    CHECK(delta.values().empty());
+    CHECK_FALSE(delta.has_nested());
+    CHECK(delta.ByteSizeLong() * 10 < current.ByteSizeLong());
+
+    testing::protocol::TestState rebuilt = previous;
+    util::apply_delta(delta, &rebuilt);
+    CHECK(rebuilt == current);
+    CHECK_FALSE(util::is_delta(rebuilt));
+}
+
+TEST_CASE("[grpcw-util] deltas_rebuild_every_kind_of_change") {
+    testing::protocol::TestState previous = make_state();
+    testing::protocol::TestState current = previous;
+
+    SUBCASE("cleared_scalar") {
+        current.clear_name();
+        current.set_counter(0);
+    }
+
+    SUBCASE("shrunk_repeated_field") {
+        current.clear_values();
+        current.add_values(7);
+    }
+
+    SUBCASE("changed_nested_message") {
+        current.mutable_nested()->clear_msg();
+    }
+
+    SUBCASE("cleared_nested_message") {
+        current.clear_nested();
+    }
+
+    SUBCASE("switched_oneof") {
+        current.set_number(12);
+    }
+
+    SUBCASE("no_change") {}
+
+    testing::protocol::TestState delta;
+    util::encode_delta(previous, current, &delta);
+
+    testing::protocol::TestState rebuilt = previous;
+    util::apply_delta(delta, &rebuilt);
+    CHECK(rebuilt == current);
+}
+
+} // namespace
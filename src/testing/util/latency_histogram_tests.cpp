@@ -0,0 +1,133 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/util/latency_histogram.hpp"
+
+// third-party
+#include <doctest/doctest.h>
+
+// standard
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+using namespace grpcw;
+
+TEST_CASE("[grpcw-util] latency_histogram_rejects_invalid_layouts") {
+    CHECK_THROWS_AS(util::LatencyHistogram(1000u, 0), std::invalid_argument);
+    CHECK_THROWS_AS(util::LatencyHistogram(1000u, 6), std::invalid_argument);
+    CHECK_THROWS_AS(util::LatencyHistogram(1u, 3), std::invalid_argument);
+
+    util::LatencyHistogram histogram(1000u, 3);
+    CHECK_THROWS_AS(histogram.add(util::LatencyHistogram(1000u, 2)), std::invalid_argument);
+}
+
+TEST_CASE("[grpcw-util] latency_histogram_percentiles_are_within_precision") {
+    util::LatencyHistogram histogram(3'600'000'000u, 3);
+
+    CHECK(histogram.total_count() == 0u);
+    CHECK(histogram.value_at_percentile(50.0) == 0u);
+
+    for (std::uint64_t value = 1u; value <= 100'000u; ++value) {
+        histogram.record(value);
+    }
+
+    CHECK(histogram.total_count() == 100'000u);
+    CHECK(histogram.min() == 1u);
+    CHECK(histogram.max() == 100'000u);
+    CHECK(histogram.mean() == doctest::Approx(50'000.5).epsilon(0.001));
+
+    // Three significant digits means a relative error of at most 0.1%
+    CHECK(histogram.value_at_percentile(50.0) == doctest::Approx(50'000.0).epsilon(0.001));
+    CHECK(histogram.value_at_percentile(90.0) == doctest::Approx(90'000.0).epsilon(0.001));
+    CHECK(histogram.value_at_percentile(99.0) == doctest::Approx(99'000.0).epsilon(0.001));
+    CHECK(histogram.value_at_percentile(100.0) == 100'000u);
+
+    // Small values are exact
+    util::LatencyHistogram small;
+    small.record(7u, 3u);
+    small.record(1500u);
+    CHECK(small.value_at_percentile(75.0) == 7u);
+    CHECK(small.value_at_percentile(100.0) == 1500u);
+
+    // Values beyond the trackable range are clamped
+    small.record(UINT64_MAX);
+    CHECK(small.max() == 3'600'000'000u);
+}
+
+TEST_CASE("[grpcw-util] latency_histogram_add_merges_counts") {
+    util::LatencyHistogram a;
+    util::LatencyHistogram b;
+
+    a.record(10u, 5u);
+    b.record(1000u, 5u);
+    a.add(b);
+
+    CHECK(a.total_count() == 10u);
+    CHECK(a.min() == 10u);
+    CHECK(a.max() == 1000u);
+    CHECK(a.value_at_percentile(50.0) == 10u);
+    CHECK(a.value_at_percentile(60.0) == 1000u);
+
+    a.reset();
+    CHECK(a.total_count() == 0u);
+    CHECK(a.max() == 0u);
+}
+
+TEST_CASE("[grpcw-util] latency_histogram_counts_values_at_or_below") {
+    util::LatencyHistogram histogram(60'000'000u, 2);
+    CHECK(histogram.count_at_or_below(1000u) == 0u);
+
+    histogram.record(5u, 2u);
+    histogram.record(1000u);
+    histogram.record(50'000u, 3u);
+    histogram.record(UINT64_MAX);
+
+    CHECK(histogram.count_at_or_below(0u) == 0u);
+    CHECK(histogram.count_at_or_below(5u) == 2u);
+    CHECK(histogram.count_at_or_below(999u) == 2u);
+    CHECK(histogram.count_at_or_below(1000u) == 3u);
+    CHECK(histogram.count_at_or_below(49'000u) == 3u);
+    CHECK(histogram.count_at_or_below(50'000u) == 6u);
+
+    // Clamped values count as the highest trackable value
+    CHECK(histogram.count_at_or_below(59'000'000u) == 6u);
+    CHECK(histogram.count_at_or_below(UINT64_MAX) == 7u);
+}
+
+TEST_CASE("[grpcw-util] latency_histogram_writes_hgrm_output") {
+    util::LatencyHistogram histogram;
+    for (std::uint64_t value = 1u; value <= 1000u; ++value) {
+        histogram.record(value * 1000u);
+    }
+
+    std::stringstream ss;
+    histogram.write_percentile_distribution(ss, 1000.0);
+    auto output = ss.str();
+
+    CHECK(output.find("Value     Percentile TotalCount 1/(1-Percentile)") != std::string::npos);
+    CHECK(output.find("1.000000000000") != std::string::npos);
+    CHECK(output.find("#[Mean    =      500.5") != std::string::npos);
+    CHECK(output.find("#[Max     =     1000.000, Total count    =         1000]") != std::string::npos);
+}
+
+} // namespace
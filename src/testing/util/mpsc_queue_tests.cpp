@@ -0,0 +1,101 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/util/mpsc_queue.hpp"
+
+// third-party
+#include <doctest/doctest.h>
+
+// standard
+#include <array>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+using namespace grpcw;
+
+TEST_CASE("[grpcw-util] mpsc_queue_is_fifo") {
+    util::MpscQueue<std::unique_ptr<int>> queue;
+
+    std::unique_ptr<int> value;
+    CHECK_FALSE(queue.pop(&value));
+
+    for (int i = 0; i < 10; ++i) {
+        queue.push(std::make_unique<int>(i));
+    }
+
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(queue.pop(&value));
+        CHECK(*value == i);
+    }
+    CHECK_FALSE(queue.pop(&value));
+
+    // Values left in the queue are cleaned up by the destructor
+    queue.push(std::make_unique<int>(42));
+}
+
+TEST_CASE("[grpcw-util] mpsc_queue_keeps_the_order_of_each_producer") {
+    constexpr int num_producers = 8;
+    constexpr int values_per_producer = 10000;
+
+    util::MpscQueue<std::pair<int, int>> queue;
+
+    std::array<std::thread, num_producers> producers;
+
+    for (int p = 0; p < num_producers; ++p) {
+        producers[p] = std::thread([&queue, p] {
+            for (int i = 0; i < values_per_producer; ++i) {
+                queue.push({p, i});
+            }
+        });
+    }
+
+    std::vector<int> next_expected(num_producers, 0);
+    int received = 0;
+    bool in_order = true;
+
+    // Consume while the producers are still running
+    while (received < num_producers * values_per_producer) {
+        std::pair<int, int> value;
+
+        if (queue.pop(&value)) {
+            in_order &= (value.second == next_expected[value.first]);
+            next_expected[value.first] = value.second + 1;
+            ++received;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    CHECK(in_order);
+    CHECK(next_expected == std::vector<int>(num_producers, values_per_producer));
+
+    std::pair<int, int> value;
+    CHECK_FALSE(queue.pop(&value));
+}
+
+} // namespace
@@ -0,0 +1,104 @@
+// ///////////////////////////////////////////////////////////////////////////////////////
+// gRPC Wrapper
+// Copyright (c) 2019 Logan Barnes - All Rights Reserved
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ///////////////////////////////////////////////////////////////////////////////////////
+#include "grpcw/util/subscriber_index.hpp"
+
+// third-party
+#include <doctest/doctest.h>
+
+// standard
+#include <algorithm>
+
+namespace {
+using namespace grpcw;
+
+std::vector<int> subscribers_of(const util::SubscriberIndex<int>& index, const std::string& topic) {
+    std::vector<int> subscribers;
+    index.for_each_subscriber(topic, [&](int subscriber) { subscribers.emplace_back(subscriber); });
+    std::sort(subscribers.begin(), subscribers.end());
+    return subscribers;
+}
+
+TEST_CASE("[grpcw-util] subscribers_only_match_their_topics") {
+    util::SubscriberIndex<int> index;
+
+    index.subscribe(1, {"a"});
+    index.subscribe(2, {"a", "b"});
+    index.subscribe(3, {"b", "b"}); // duplicates are ignored
+
+    CHECK(subscribers_of(index, "a") == std::vector<int>{1, 2});
+    CHECK(subscribers_of(index, "b") == std::vector<int>{2, 3});
+    CHECK(subscribers_of(index, "c").empty());
+
+    CHECK(index.subscriber_count("a") == 2);
+    CHECK(index.subscriber_count("b") == 2);
+    CHECK(index.topic_count() == 2);
+
+    // Subscribing again adds topics
+    index.subscribe(1, {"c"});
+    CHECK(subscribers_of(index, "c") == std::vector<int>{1});
+
+    index.unsubscribe(2);
+    CHECK(subscribers_of(index, "a") == std::vector<int>{1});
+    CHECK(subscribers_of(index, "b") == std::vector<int>{3});
+
+    // Topics without subscribers are removed
+    index.unsubscribe(3);
+    CHECK(index.subscriber_count("b") == 0);
+    CHECK(index.topic_count() == 2);
+
+    // Unknown subscribers are ignored
+    index.unsubscribe(42);
+}
+
+TEST_CASE("[grpcw-util] subscriber_slots_span_multiple_words_and_are_reused") {
+    util::SubscriberIndex<int> index;
+
+    constexpr int total_subscribers = 200;
+
+    for (int i = 0; i < total_subscribers; ++i) {
+        index.subscribe(i, {i % 2 == 0 ? "even" : "odd", "all"});
+    }
+
+    CHECK(index.subscriber_count("all") == total_subscribers);
+    CHECK(subscribers_of(index, "even").size() == total_subscribers / 2);
+
+    std::vector<int> odd = subscribers_of(index, "odd");
+    CHECK(odd.front() == 1);
+    CHECK(odd.back() == total_subscribers - 1);
+
+    for (int i = 0; i < total_subscribers; i += 3) {
+        index.unsubscribe(i);
+    }
+
+    // New subscribers take the freed slots
+    index.subscribe(1000, {"new"});
+    index.subscribe(1001, {"all"});
+
+    std::vector<int> all = subscribers_of(index, "all");
+    CHECK(all.size() == index.subscriber_count("all"));
+    CHECK(std::find(all.begin(), all.end(), 1001) != all.end());
+    CHECK(std::find(all.begin(), all.end(), 0) == all.end());
+    CHECK(subscribers_of(index, "new") == std::vector<int>{1000});
+}
+
+} // namespace